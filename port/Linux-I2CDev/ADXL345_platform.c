@@ -0,0 +1,165 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_platform.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 driver platform dependent part (Linux i2c-dev)
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Feature Test Macros ----------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+
+/* Includes ---------------------------------------------------------------------*/
+#include "ADXL345_platform.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+
+
+/* Private Variables ------------------------------------------------------------*/
+static const char *Platform_Bus = ADXL345_I2C_DEV;
+static int Platform_Fd = -1;
+static int Platform_Users = 0;
+static int Platform_Address = -1;
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static int8_t
+Platform_SetAddress(uint8_t Address)
+{
+  if (Platform_Fd < 0)
+    return -1;
+
+  if (Platform_Address == Address)
+    return 0;
+
+  if (ioctl(Platform_Fd, I2C_SLAVE, (unsigned long)Address) < 0)
+  {
+    Platform_Address = -1;
+    return -1;
+  }
+
+  Platform_Address = Address;
+  return 0;
+}
+
+
+static int8_t
+Platform_Init(void)
+{
+  if (Platform_Users++)
+    return 0;
+
+  Platform_Fd = open(Platform_Bus, O_RDWR | O_CLOEXEC);
+  if (Platform_Fd < 0)
+  {
+    Platform_Users = 0;
+    return -1;
+  }
+
+  Platform_Address = -1;
+  return 0;
+}
+
+
+static int8_t
+Platform_DeInit(void)
+{
+  if (!Platform_Users || --Platform_Users)
+    return 0;
+
+  close(Platform_Fd);
+  Platform_Fd = -1;
+  Platform_Address = -1;
+
+  return 0;
+}
+
+
+static int8_t
+Platform_WriteData(uint8_t Address, uint8_t *Data, uint8_t DataLen)
+{
+  if (Platform_SetAddress(Address) != 0)
+    return -1;
+
+  if (write(Platform_Fd, Data, DataLen) != DataLen)
+    return -1;
+
+  return 0;
+}
+
+
+static int8_t
+Platform_ReadData(uint8_t Address, uint8_t *Data, uint8_t DataLen)
+{
+  if (Platform_SetAddress(Address) != 0)
+    return -1;
+
+  if (read(Platform_Fd, Data, DataLen) != DataLen)
+    return -1;
+
+  return 0;
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize platform device to communicate ADXL345.
+ * @param  Handler: Pointer to handler
+ * @retval None
+ */
+void
+ADXL345_Platform_Init(ADXL345_Handler_t *Handler)
+{
+  Handler->PlatformI2CInit = Platform_Init;
+  Handler->PlatformI2CDeInit = Platform_DeInit;
+  Handler->PlatformI2CSend = Platform_WriteData;
+  Handler->PlatformI2CReceive = Platform_ReadData;
+}
+
+
+/**
+ * @brief  Select the I2C adapter
+ * @param  Path: Path of the adapter (e.g. "/dev/i2c-0"). Must stay valid.
+ * @retval None
+ */
+void
+ADXL345_Platform_SetBus(const char *Path)
+{
+  Platform_Bus = Path;
+}
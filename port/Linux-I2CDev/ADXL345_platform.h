@@ -0,0 +1,81 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_platform.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 driver platform dependent part (Linux i2c-dev)
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef	_ADXL345_PLATFORM_H_
+#define _ADXL345_PLATFORM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include "ADXL345.h"
+
+
+/* Functionality Options --------------------------------------------------------*/
+// Default I2C adapter. It can be changed by ADXL345_Platform_SetBus.
+#define ADXL345_I2C_DEV   "/dev/i2c-1"
+
+
+
+/**
+ ==================================================================================
+                             ##### Functions #####                                 
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize platform device to communicate ADXL345.
+ * @note   All handlers share one opened adapter. The slave address is set
+ *         with I2C_SLAVE only when it differs from the previous transaction.
+ * @param  Handler: Pointer to handler
+ * @retval None
+ */
+void
+ADXL345_Platform_Init(ADXL345_Handler_t *Handler);
+
+/**
+ * @brief  Select the I2C adapter
+ * @note   Call this function before ADXL345_Init.
+ * @param  Path: Path of the adapter (e.g. "/dev/i2c-0"). Must stay valid.
+ * @retval None
+ */
+void
+ADXL345_Platform_SetBus(const char *Path);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _ADXL345_PLATFORM_H_
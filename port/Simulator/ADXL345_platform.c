@@ -0,0 +1,614 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_platform.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 driver platform dependent part (simulated devices)
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include "ADXL345_platform.h"
+#include <string.h>
+#include <math.h>
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define SIM_NONE            0xFF
+#define SIM_MUX_BASE        0x70
+#define SIM_MUX_COUNT       8
+// FIFO entries plus the data registers
+#define SIM_CAPACITY        33
+
+#define SIM_REG_DEVID       0x00
+#define SIM_REG_BW_RATE     0x2C
+#define SIM_REG_POWER_CTL   0x2D
+#define SIM_REG_INT_ENABLE  0x2E
+#define SIM_REG_INT_MAP     0x2F
+#define SIM_REG_INT_SOURCE  0x30
+#define SIM_REG_DATA_FORMAT 0x31
+#define SIM_REG_DATAX0      0x32
+#define SIM_REG_DATAZ1      0x37
+#define SIM_REG_FIFO_CTL    0x38
+#define SIM_REG_FIFO_STATUS 0x39
+
+#define SIM_PI              3.14159265358979323846
+
+
+/* Private Macro ----------------------------------------------------------------*/
+#define SIM_FIFO_MODE(Dev)  ((Dev)->Regs[SIM_REG_FIFO_CTL] >> 6)
+// FIFO mode and trigger mode after its trigger keep the oldest samples
+#define SIM_KEEPS_OLDEST(Dev) \
+  (SIM_FIFO_MODE(Dev) == 1 || (Dev)->Triggered)
+
+
+/* Private Data Types -----------------------------------------------------------*/
+typedef struct Sim_Device_s
+{
+  uint8_t AddressI2C;
+  uint8_t Mux;              // index of mux, SIM_NONE if on the bus
+  uint8_t MuxChannel;
+  uint32_t SignalMilliHz;
+  uint8_t Regs[64];
+  uint8_t Pointer;
+  int16_t Fifo[SIM_CAPACITY][3];
+  uint8_t Head;
+  uint8_t Count;
+  int16_t Last[3];
+  uint8_t Overrun;
+  uint8_t Events;           // latched INT_SOURCE event bits
+  uint8_t NextEvents;       // event bits raised with the next sample
+  uint8_t Triggered;        // trigger mode has seen its trigger
+  uint64_t NextNs;          // time of the next sample
+  uint64_t SampleIndex;
+  ADXL345_SimStats_t Stats;
+} Sim_Device_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static Sim_Device_t Sim_Device[ADXL345_SIM_MAX_DEVICES];
+static uint16_t Sim_Devices = 0;
+static uint8_t Sim_MuxMask[SIM_MUX_COUNT];
+static uint64_t Sim_NowNs = 0;
+static ADXL345_SimBusStats_t Sim_BusStats;
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static uint64_t
+Sim_PeriodNs(Sim_Device_t *Dev)
+{
+  uint8_t Rate = Dev->Regs[SIM_REG_BW_RATE] & 0x0F;
+
+  // 3200 Hz at rate code 15, halved for each code below
+  return 312500ULL << (15 - Rate);
+}
+
+static int16_t
+Sim_Value(Sim_Device_t *Dev, double Milli_g)
+{
+  uint8_t Format = Dev->Regs[SIM_REG_DATA_FORMAT];
+  uint8_t Range = Format & 0x03;
+  double LsbPerG = (Format & 0x08) ? 256.0 : (256.0 / (1 << Range));
+  int32_t Max = (Format & 0x08) ? ((512 << Range) - 1) : 511;
+  int32_t Value = (int32_t)lround(Milli_g * LsbPerG / 1000.0);
+
+  if (Value > Max)
+    Value = Max;
+  if (Value < -Max - 1)
+    Value = -Max - 1;
+
+  return (int16_t)Value;
+}
+
+/**
+ * In trigger mode an interrupt on the pin chosen by the trigger bit keeps
+ * the newest "samples bits" entries and switches FIFO to FIFO mode
+ */
+static void
+Sim_Event(Sim_Device_t *Dev, uint8_t Events)
+{
+  uint8_t Ctl = Dev->Regs[SIM_REG_FIFO_CTL];
+  uint8_t Pin = Events & Dev->Regs[SIM_REG_INT_ENABLE];
+  uint8_t Keep = Ctl & 0x1F;
+
+  Dev->Events |= Events;
+
+  if (SIM_FIFO_MODE(Dev) != 3 || Dev->Triggered)
+    return;
+
+  Pin &= (Ctl & 0x20) ? Dev->Regs[SIM_REG_INT_MAP] :
+                        (uint8_t)~Dev->Regs[SIM_REG_INT_MAP];
+  if (!Pin)
+    return;
+
+  Dev->Triggered = 1;
+  Dev->Stats.Triggers++;
+  Dev->Stats.TriggerAt = (uint32_t)(Dev->SampleIndex - 1);
+
+  if (Dev->Count > Keep)
+  {
+    Dev->Head = (Dev->Head + Dev->Count - Keep) % SIM_CAPACITY;
+    Dev->Count = Keep;
+  }
+}
+
+static void
+Sim_Generate(Sim_Device_t *Dev)
+{
+  double Time = (double)Dev->SampleIndex * (double)Sim_PeriodNs(Dev) / 1e9;
+  double Phase = 2.0 * SIM_PI * (Dev->SignalMilliHz / 1000.0) * Time;
+  uint8_t Capacity = SIM_FIFO_MODE(Dev) ? SIM_CAPACITY : 1;
+  uint8_t Tail = 0;
+
+  Dev->SampleIndex++;
+  Dev->Stats.Generated++;
+
+  if (Dev->Count == Capacity)
+  {
+    Dev->Overrun = 1;
+    Dev->Stats.Lost++;
+    // FIFO mode stops collecting, the others drop the oldest entry
+    if (!SIM_KEEPS_OLDEST(Dev))
+    {
+      Dev->Head = (Dev->Head + 1) % SIM_CAPACITY;
+      Dev->Count--;
+    }
+  }
+
+  if (Dev->Count < Capacity)
+  {
+    Tail = (Dev->Head + Dev->Count) % SIM_CAPACITY;
+    Dev->Fifo[Tail][0] =
+        Sim_Value(Dev, ADXL345_SIM_AMPLITUDE_MG * sin(Phase));
+    Dev->Fifo[Tail][1] =
+        Sim_Value(Dev, ADXL345_SIM_AMPLITUDE_MG * cos(Phase));
+    Dev->Fifo[Tail][2] =
+        Sim_Value(Dev, 1000.0 + ADXL345_SIM_AMPLITUDE_MG * sin(Phase));
+    Dev->Count++;
+  }
+
+  if (Dev->NextEvents)
+  {
+    Sim_Event(Dev, Dev->NextEvents);
+    Dev->NextEvents = 0;
+  }
+}
+
+static void
+Sim_Update(Sim_Device_t *Dev)
+{
+  uint64_t PeriodNs = Sim_PeriodNs(Dev);
+  uint64_t Due = 0;
+  uint64_t Skip = 0;
+  uint8_t Free = 0;
+
+  if (!(Dev->Regs[SIM_REG_POWER_CTL] & 0x08) || Sim_NowNs < Dev->NextNs)
+    return;
+
+  Due = (Sim_NowNs - Dev->NextNs) / PeriodNs + 1;
+
+  // Samples that would be dropped anyway are only counted. FIFO mode keeps
+  // the oldest samples, the other modes keep the newest ones.
+  if (SIM_KEEPS_OLDEST(Dev))
+  {
+    Free = SIM_CAPACITY - Dev->Count;
+    if (Due > Free)
+    {
+      Skip = Due - Free;
+      Due = Free;
+    }
+    while (Due--)
+      Sim_Generate(Dev);
+    Dev->SampleIndex += Skip;
+  }
+  else
+  {
+    if (Due > SIM_CAPACITY)
+    {
+      Skip = Due - SIM_CAPACITY;
+      Due = SIM_CAPACITY;
+      Dev->Stats.Lost += Dev->Count;
+      Dev->Count = 0;
+    }
+    Dev->SampleIndex += Skip;
+    while (Due--)
+      Sim_Generate(Dev);
+  }
+
+  if (Skip)
+  {
+    Dev->Overrun = 1;
+    Dev->Stats.Generated += (uint32_t)Skip;
+    Dev->Stats.Lost += (uint32_t)Skip;
+  }
+
+  Dev->NextNs += ((Sim_NowNs - Dev->NextNs) / PeriodNs + 1) * PeriodNs;
+}
+
+static uint8_t
+Sim_IntSource(Sim_Device_t *Dev)
+{
+  uint8_t Source = Dev->Events;
+
+  if (Dev->Count)
+    Source |= 0x80;
+  if (SIM_FIFO_MODE(Dev) &&
+      Dev->Count > (Dev->Regs[SIM_REG_FIFO_CTL] & 0x1F))
+    Source |= 0x02;
+  if (Dev->Overrun)
+    Source |= 0x01;
+
+  return Source;
+}
+
+static uint8_t
+Sim_ReadReg(Sim_Device_t *Dev, uint8_t Reg)
+{
+  int16_t *Sample = Dev->Count ? Dev->Fifo[Dev->Head] : Dev->Last;
+  int16_t Value = 0;
+
+  if (Reg >= SIM_REG_DATAX0 && Reg <= SIM_REG_DATAZ1)
+  {
+    Value = Sample[(Reg - SIM_REG_DATAX0) / 2];
+    return (Reg & 1) ? (uint8_t)((uint16_t)Value >> 8) : (uint8_t)Value;
+  }
+
+  if (Reg == SIM_REG_INT_SOURCE)
+    return Sim_IntSource(Dev);
+
+  if (Reg == SIM_REG_FIFO_STATUS)
+    return ((Dev->Count > 32) ? 32 : Dev->Count) | (Dev->Triggered << 7);
+
+  return (Reg < sizeof(Dev->Regs)) ? Dev->Regs[Reg] : 0;
+}
+
+static void
+Sim_WriteReg(Sim_Device_t *Dev, uint8_t Reg, uint8_t Value)
+{
+  uint8_t Old = 0;
+
+  if (Reg >= sizeof(Dev->Regs) || Reg == SIM_REG_DEVID ||
+      (Reg >= 0x2B && Reg != SIM_REG_BW_RATE && Reg != SIM_REG_POWER_CTL &&
+       Reg != SIM_REG_INT_ENABLE && Reg != SIM_REG_INT_MAP &&
+       Reg != SIM_REG_DATA_FORMAT && Reg != SIM_REG_FIFO_CTL))
+    return;
+
+  Old = Dev->Regs[Reg];
+  Dev->Regs[Reg] = Value;
+
+  if (Reg == SIM_REG_BW_RATE ||
+      (Reg == SIM_REG_POWER_CTL && (Value & 0x08) && !(Old & 0x08)))
+    Dev->NextNs = Sim_NowNs + Sim_PeriodNs(Dev);
+
+  // Leaving trigger mode resets the trigger
+  if (Reg == SIM_REG_FIFO_CTL && SIM_FIFO_MODE(Dev) != 3)
+    Dev->Triggered = 0;
+
+  // Bypass mode keeps only the newest sample
+  if (Reg == SIM_REG_FIFO_CTL && !SIM_FIFO_MODE(Dev) && Dev->Count > 1)
+  {
+    Dev->Head = (Dev->Head + Dev->Count - 1) % SIM_CAPACITY;
+    Dev->Count = 1;
+  }
+}
+
+static void
+Sim_Wire(uint8_t Bytes)
+{
+  // Start, address byte and data bytes with ACK, stop
+  uint32_t Bits = 2 + 9 * (1 + (uint32_t)Bytes);
+  uint64_t Ns = (uint64_t)Bits * 1000000000ULL / ADXL345_SIM_I2C_RATE;
+
+  Sim_NowNs += Ns;
+  Sim_BusStats.BusyNs += Ns;
+  Sim_BusStats.Transactions++;
+}
+
+static Sim_Device_t*
+Sim_Find(uint8_t Address)
+{
+  Sim_Device_t *Found = NULL;
+  Sim_Device_t *Dev = NULL;
+  uint16_t i = 0;
+
+  for (i = 0; i < Sim_Devices; i++)
+  {
+    Dev = &Sim_Device[i];
+    if (Dev->AddressI2C != Address)
+      continue;
+    if (Dev->Mux != SIM_NONE &&
+        !(Sim_MuxMask[Dev->Mux] & (1 << Dev->MuxChannel)))
+      continue;
+    // Two devices answering the same address corrupt the transfer
+    if (Found)
+      return NULL;
+    Found = Dev;
+  }
+
+  return Found;
+}
+
+static int8_t
+Platform_Init(void)
+{
+  return 0;
+}
+
+static int8_t
+Platform_DeInit(void)
+{
+  return 0;
+}
+
+static int8_t
+Platform_WriteData(uint8_t Address, uint8_t *Data, uint8_t DataLen)
+{
+  Sim_Device_t *Dev = NULL;
+  uint8_t i = 0;
+
+  Sim_Wire(DataLen);
+
+  if (Address >= SIM_MUX_BASE && Address < SIM_MUX_BASE + SIM_MUX_COUNT)
+  {
+    if (DataLen)
+      Sim_MuxMask[Address - SIM_MUX_BASE] = Data[DataLen - 1];
+    return 0;
+  }
+
+  Dev = Sim_Find(Address);
+  if (!Dev || !DataLen)
+  {
+    Sim_BusStats.Nacks++;
+    return -1;
+  }
+
+  Sim_Update(Dev);
+  Dev->Pointer = Data[0];
+  for (i = 1; i < DataLen; i++)
+    Sim_WriteReg(Dev, Dev->Pointer++, Data[i]);
+
+  return 0;
+}
+
+static int8_t
+Platform_ReadData(uint8_t Address, uint8_t *Data, uint8_t DataLen)
+{
+  Sim_Device_t *Dev = NULL;
+  uint8_t DataRead = 0;
+  uint8_t SourceRead = 0;
+  uint8_t i = 0;
+
+  Sim_Wire(DataLen);
+
+  if (Address >= SIM_MUX_BASE && Address < SIM_MUX_BASE + SIM_MUX_COUNT)
+  {
+    for (i = 0; i < DataLen; i++)
+      Data[i] = Sim_MuxMask[Address - SIM_MUX_BASE];
+    return 0;
+  }
+
+  Dev = Sim_Find(Address);
+  if (!Dev)
+  {
+    Sim_BusStats.Nacks++;
+    return -1;
+  }
+
+  Sim_Update(Dev);
+  for (i = 0; i < DataLen; i++)
+  {
+    if (Dev->Pointer >= SIM_REG_DATAX0 && Dev->Pointer <= SIM_REG_DATAZ1)
+      DataRead = 1;
+    if (Dev->Pointer == SIM_REG_INT_SOURCE)
+      SourceRead = 1;
+    Data[i] = Sim_ReadReg(Dev, Dev->Pointer++);
+  }
+
+  // Reading INT_SOURCE clears the latched events
+  if (SourceRead)
+    Dev->Events = 0;
+
+  // Reading the data registers pops one FIFO entry into them
+  if (DataRead && Dev->Count)
+  {
+    memcpy(Dev->Last, Dev->Fifo[Dev->Head], sizeof(Dev->Last));
+    Dev->Head = (Dev->Head + 1) % SIM_CAPACITY;
+    Dev->Count--;
+    Dev->Overrun = 0;
+    Dev->Stats.Read++;
+  }
+
+  return 0;
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize platform device to communicate ADXL345.
+ * @note   All handlers share one simulated I2C bus. Devices with the same
+ *         address must be placed behind TCA9548A style muxes (0x70..0x77).
+ * @param  Handler: Pointer to handler
+ * @retval None
+ */
+void
+ADXL345_Platform_Init(ADXL345_Handler_t *Handler)
+{
+  Handler->PlatformI2CInit = Platform_Init;
+  Handler->PlatformI2CDeInit = Platform_DeInit;
+  Handler->PlatformI2CSend = Platform_WriteData;
+  Handler->PlatformI2CReceive = Platform_ReadData;
+}
+
+/**
+ * @brief  Add a simulated device to the bus
+ * @note   The device outputs a sine vibration of SignalMilliHz on X and Y
+ *         and 1g plus the vibration on Z, sampled at its ODR.
+ * @param  AddressI2C: I2C address (0x53 or 0x1D)
+ * @param  MuxAddress: Address of the mux (0 if the device is on the bus)
+ * @param  MuxChannel: Channel of the mux (0..7)
+ * @param  SignalMilliHz: Frequency of the vibration in mHz
+ * @retval Index of the device, -1 if there is no room or bad parameter
+ */
+int16_t
+ADXL345_Sim_AddDevice(uint8_t AddressI2C, uint8_t MuxAddress,
+                      uint8_t MuxChannel, uint32_t SignalMilliHz)
+{
+  Sim_Device_t *Dev = NULL;
+
+  if (Sim_Devices >= ADXL345_SIM_MAX_DEVICES || MuxChannel > 7)
+    return -1;
+
+  if (MuxAddress &&
+      (MuxAddress < SIM_MUX_BASE || MuxAddress >= SIM_MUX_BASE + SIM_MUX_COUNT))
+    return -1;
+
+  Dev = &Sim_Device[Sim_Devices];
+  memset(Dev, 0, sizeof(Sim_Device_t));
+  Dev->AddressI2C = AddressI2C;
+  Dev->Mux = MuxAddress ? (uint8_t)(MuxAddress - SIM_MUX_BASE) : SIM_NONE;
+  Dev->MuxChannel = MuxChannel;
+  Dev->SignalMilliHz = SignalMilliHz;
+  Dev->Regs[SIM_REG_DEVID] = 0xE5;
+  Dev->Regs[SIM_REG_BW_RATE] = 0x0A;
+
+  return (int16_t)Sim_Devices++;
+}
+
+/**
+ * @brief  Remove all simulated devices and clear mux and bus statistics
+ * @retval None
+ */
+void
+ADXL345_Sim_Reset(void)
+{
+  Sim_Devices = 0;
+  memset(Sim_MuxMask, 0, sizeof(Sim_MuxMask));
+  memset(&Sim_BusStats, 0, sizeof(ADXL345_SimBusStats_t));
+}
+
+/**
+ * @brief  Get simulated time in us
+ * @note   Time advances with the wire time of every bus transaction and with
+ *         ADXL345_Sim_AdvanceUs. It can be used as GetTimeUs of the
+ *         streaming engine and the manager.
+ * @retval Time in us
+ */
+uint32_t
+ADXL345_Sim_GetTimeUs(void)
+{
+  return (uint32_t)(Sim_NowNs / 1000);
+}
+
+/**
+ * @brief  Advance simulated time
+ * @param  Us: Time in us (e.g. idle time or processing time of the host)
+ * @retval None
+ */
+void
+ADXL345_Sim_AdvanceUs(uint32_t Us)
+{
+  Sim_NowNs += (uint64_t)Us * 1000;
+}
+
+/**
+ * @brief  Get level of an interrupt pin of a simulated device
+ * @param  Device: Index of the device
+ * @param  Pin: 1 for INT1, 2 for INT2
+ * @retval 1 if the pin is active, otherwise 0
+ */
+uint8_t
+ADXL345_Sim_IntPin(int16_t Device, uint8_t Pin)
+{
+  Sim_Device_t *Dev = NULL;
+  uint8_t Active = 0;
+
+  if (Device < 0 || Device >= Sim_Devices)
+    return 0;
+
+  Dev = &Sim_Device[Device];
+  Sim_Update(Dev);
+  Active = Sim_IntSource(Dev) & Dev->Regs[SIM_REG_INT_ENABLE];
+  if (Pin == 2)
+    Active &= Dev->Regs[SIM_REG_INT_MAP];
+  else
+    Active &= ~Dev->Regs[SIM_REG_INT_MAP];
+
+  return Active ? 1 : 0;
+}
+
+/**
+ * @brief  Raise interrupt events of a simulated device
+ * @note   The events are latched in INT_SOURCE with the next sample, so that
+ *         sample is the one that fires the trigger in trigger mode.
+ * @param  Device: Index of the device
+ * @param  Events: INT_SOURCE bits (e.g. 0x10 for Activity)
+ * @retval None
+ */
+void
+ADXL345_Sim_RaiseEvents(int16_t Device, uint8_t Events)
+{
+  if (Device < 0 || Device >= Sim_Devices)
+    return;
+
+  Sim_Update(&Sim_Device[Device]);
+  Sim_Device[Device].NextEvents |= Events & 0x7C;
+}
+
+/**
+ * @brief  Get statistics of a simulated device
+ * @param  Device: Index of the device
+ * @param  Stats: Pointer to statistics
+ * @retval None
+ */
+void
+ADXL345_Sim_GetStats(int16_t Device, ADXL345_SimStats_t *Stats)
+{
+  if (Device < 0 || Device >= Sim_Devices)
+    return;
+
+  Sim_Update(&Sim_Device[Device]);
+  *Stats = Sim_Device[Device].Stats;
+}
+
+/**
+ * @brief  Get statistics of the simulated bus
+ * @param  Stats: Pointer to statistics
+ * @retval None
+ */
+void
+ADXL345_Sim_GetBusStats(ADXL345_SimBusStats_t *Stats)
+{
+  *Stats = Sim_BusStats;
+}
@@ -0,0 +1,177 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_platform.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 driver platform dependent part (simulated devices)
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef	_ADXL345_PLATFORM_H_
+#define _ADXL345_PLATFORM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "ADXL345.h"
+
+
+/* Functionality Options --------------------------------------------------------*/
+#define ADXL345_SIM_MAX_DEVICES   128
+#define ADXL345_SIM_I2C_RATE      400000
+// Amplitude of the simulated vibration in mg
+#define ADXL345_SIM_AMPLITUDE_MG  500
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Simulated device statistics
+ */
+typedef struct ADXL345_SimStats_s
+{
+  uint32_t Generated;   // samples produced at ODR
+  uint32_t Read;        // samples read from data registers
+  uint32_t Lost;        // samples lost to FIFO overrun
+  uint32_t Triggers;    // trigger mode triggers
+  uint32_t TriggerAt;   // index of the sample that fired the last trigger
+} ADXL345_SimStats_t;
+
+/**
+ * @brief  Simulated bus statistics
+ */
+typedef struct ADXL345_SimBusStats_s
+{
+  uint32_t Transactions;
+  uint32_t Nacks;
+  uint64_t BusyNs;      // time the bus was busy on the wire
+} ADXL345_SimBusStats_t;
+
+
+
+/**
+ ==================================================================================
+                             ##### Functions #####                                 
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize platform device to communicate ADXL345.
+ * @note   All handlers share one simulated I2C bus. Devices with the same
+ *         address must be placed behind TCA9548A style muxes (0x70..0x77).
+ * @param  Handler: Pointer to handler
+ * @retval None
+ */
+void
+ADXL345_Platform_Init(ADXL345_Handler_t *Handler);
+
+/**
+ * @brief  Add a simulated device to the bus
+ * @note   The device outputs a sine vibration of SignalMilliHz on X and Y
+ *         and 1g plus the vibration on Z, sampled at its ODR.
+ * @param  AddressI2C: I2C address (0x53 or 0x1D)
+ * @param  MuxAddress: Address of the mux (0 if the device is on the bus)
+ * @param  MuxChannel: Channel of the mux (0..7)
+ * @param  SignalMilliHz: Frequency of the vibration in mHz
+ * @retval Index of the device, -1 if there is no room or bad parameter
+ */
+int16_t
+ADXL345_Sim_AddDevice(uint8_t AddressI2C, uint8_t MuxAddress,
+                      uint8_t MuxChannel, uint32_t SignalMilliHz);
+
+/**
+ * @brief  Remove all simulated devices and clear mux and bus statistics
+ * @note   Simulated time keeps running, so handlers and streams of a previous
+ *         run must not be used afterwards.
+ * @retval None
+ */
+void
+ADXL345_Sim_Reset(void);
+
+/**
+ * @brief  Get simulated time in us
+ * @note   Time advances with the wire time of every bus transaction and with
+ *         ADXL345_Sim_AdvanceUs. It can be used as GetTimeUs of the
+ *         streaming engine and the manager.
+ * @retval Time in us
+ */
+uint32_t
+ADXL345_Sim_GetTimeUs(void);
+
+/**
+ * @brief  Advance simulated time
+ * @param  Us: Time in us (e.g. idle time or processing time of the host)
+ * @retval None
+ */
+void
+ADXL345_Sim_AdvanceUs(uint32_t Us);
+
+/**
+ * @brief  Get level of an interrupt pin of a simulated device
+ * @param  Device: Index of the device
+ * @param  Pin: 1 for INT1, 2 for INT2
+ * @retval 1 if the pin is active, otherwise 0
+ */
+uint8_t
+ADXL345_Sim_IntPin(int16_t Device, uint8_t Pin);
+
+/**
+ * @brief  Raise interrupt events of a simulated device
+ * @note   The events are latched in INT_SOURCE with the next sample, so that
+ *         sample is the one that fires the trigger in trigger mode.
+ * @param  Device: Index of the device
+ * @param  Events: INT_SOURCE bits (e.g. 0x10 for Activity)
+ * @retval None
+ */
+void
+ADXL345_Sim_RaiseEvents(int16_t Device, uint8_t Events);
+
+/**
+ * @brief  Get statistics of a simulated device
+ * @param  Device: Index of the device
+ * @param  Stats: Pointer to statistics
+ * @retval None
+ */
+void
+ADXL345_Sim_GetStats(int16_t Device, ADXL345_SimStats_t *Stats);
+
+/**
+ * @brief  Get statistics of the simulated bus
+ * @param  Stats: Pointer to statistics
+ * @retval None
+ */
+void
+ADXL345_Sim_GetBusStats(ADXL345_SimBusStats_t *Stats);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _ADXL345_PLATFORM_H_
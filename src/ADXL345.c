@@ -98,14 +98,61 @@
  ==================================================================================
  */
 
+static void
+ADXL345_Lock(ADXL345_Handler_t *Handler)
+{
+  if (Handler->PlatformLock)
+    Handler->PlatformLock();
+}
+
+static void
+ADXL345_Unlock(ADXL345_Handler_t *Handler)
+{
+  if (Handler->PlatformUnlock)
+    Handler->PlatformUnlock();
+}
+
 static ADXL345_Result_t
-ADXL345_WriteRegs(ADXL345_Handler_t *Handler,
-                  uint8_t StartReg, uint8_t *Data, uint8_t BytesCount)
+ADXL345_Mux_SelectNoLock(ADXL345_Handler_t *Handler)
+{
+  ADXL345_Mux_t *Mux = Handler->Mux;
+  uint8_t Mask = 0;
+
+  if (!Mux)
+    return ADXL345_OK;
+
+  if (Mux->Channel == Handler->MuxChannel)
+  {
+    Mux->Stats.Skipped++;
+    return ADXL345_OK;
+  }
+
+  Mask = 1 << Handler->MuxChannel;
+  if (Handler->PlatformI2CSend(Mux->AddressI2C, &Mask, 1) != 0)
+  {
+    // State of the mux is unknown after a failed write
+    Mux->Channel = ADXL345_MUX_CHANNEL_NONE;
+    Mux->Stats.Errors++;
+    return ADXL345_FAIL;
+  }
+
+  Mux->Channel = Handler->MuxChannel;
+  Mux->Stats.Switches++;
+
+  return ADXL345_OK;
+}
+
+static ADXL345_Result_t
+ADXL345_WriteRegsNoLock(ADXL345_Handler_t *Handler,
+                        uint8_t StartReg, uint8_t *Data, uint8_t BytesCount)
 {
   const uint8_t ADXL345_SEND_BUFFER_SIZE = 9;
   uint8_t Buffer[ADXL345_SEND_BUFFER_SIZE];
   uint8_t Len = 0;
 
+  if (Handler->Mux && ADXL345_Mux_SelectNoLock(Handler) != ADXL345_OK)
+    return ADXL345_FAIL;
+
   Buffer[0] = StartReg; // send register address to set RTC pointer
   while (BytesCount)
   {
@@ -113,7 +160,12 @@ ADXL345_WriteRegs(ADXL345_Handler_t *Handler,
     memcpy((void*)(Buffer+1), (const void*)Data, Len);
 
     if (Handler->PlatformI2CSend(Handler->AddressI2C, Buffer, Len+1) != 0)
+    {
+      Handler->Stats.Errors++;
       return ADXL345_FAIL;
+    }
+    Handler->Stats.Transfers++;
+    Handler->Stats.Bytes += Len + 1;
 
     Data += Len;
     Buffer[0] += Len;
@@ -124,18 +176,198 @@ ADXL345_WriteRegs(ADXL345_Handler_t *Handler,
 }
 
 static ADXL345_Result_t
-ADXL345_ReadRegs(ADXL345_Handler_t *Handler,
-                 uint8_t StartReg, uint8_t *Data, uint8_t BytesCount)
+ADXL345_ReadRegsNoLock(ADXL345_Handler_t *Handler,
+                       uint8_t StartReg, uint8_t *Data, uint8_t BytesCount)
 {
+  if (Handler->Mux && ADXL345_Mux_SelectNoLock(Handler) != ADXL345_OK)
+    return ADXL345_FAIL;
+
   if (Handler->PlatformI2CSend(Handler->AddressI2C, &StartReg, 1) != 0)
+  {
+    Handler->Stats.Errors++;
     return ADXL345_FAIL;
+  }
+  Handler->Stats.Transfers++;
+  Handler->Stats.Bytes += 1;
 
   if (Handler->PlatformI2CReceive(Handler->AddressI2C, Data, BytesCount) != 0)
+  {
+    Handler->Stats.Errors++;
     return ADXL345_FAIL;
+  }
+  Handler->Stats.Transfers++;
+  Handler->Stats.Bytes += BytesCount;
 
   return ADXL345_OK;
 }
 
+// Single register accesses are atomic: mux select, register pointer write
+// and data transfer are done under the lock.
+static ADXL345_Result_t
+ADXL345_WriteRegs(ADXL345_Handler_t *Handler,
+                  uint8_t StartReg, uint8_t *Data, uint8_t BytesCount)
+{
+  ADXL345_Result_t Result = ADXL345_OK;
+
+  ADXL345_Lock(Handler);
+  Result = ADXL345_WriteRegsNoLock(Handler, StartReg, Data, BytesCount);
+  ADXL345_Unlock(Handler);
+
+  return Result;
+}
+
+static ADXL345_Result_t
+ADXL345_ReadRegs(ADXL345_Handler_t *Handler,
+                 uint8_t StartReg, uint8_t *Data, uint8_t BytesCount)
+{
+  ADXL345_Result_t Result = ADXL345_OK;
+
+  ADXL345_Lock(Handler);
+  Result = ADXL345_ReadRegsNoLock(Handler, StartReg, Data, BytesCount);
+  ADXL345_Unlock(Handler);
+
+  return Result;
+}
+
+
+static void
+ADXL345_Decode_TapAxes(uint8_t Reg, ADXL345_TapConfig_t *TapConfig)
+{
+  TapConfig->TapAxis.TapEnableZ = (Reg & 0x01) ? 1 : 0;
+  TapConfig->TapAxis.TapEnableY = (Reg & 0x02) ? 1 : 0;
+  TapConfig->TapAxis.TapEnableX = (Reg & 0x04) ? 1 : 0;
+  TapConfig->TapAxis.Suppress   = (Reg & 0x08) ? 1 : 0;
+}
+
+static void
+ADXL345_Decode_ActTapStatus(uint8_t Reg, ADXL345_ActTapStatus_t *Status)
+{
+  memset(Status, 0, sizeof(ADXL345_ActTapStatus_t));
+
+  if (Reg & 0x01)
+    Status->TapZ = 1;
+  if (Reg & 0x02)
+    Status->TapY = 1;
+  if (Reg & 0x04)
+    Status->TapX = 1;
+
+  if (Reg & 0x08)
+    Status->Asleep = 1;
+
+  if (Reg & 0x10)
+    Status->ActZ = 1;
+  if (Reg & 0x20)
+    Status->ActY = 1;
+  if (Reg & 0x40)
+    Status->ActX = 1;
+}
+
+static void
+ADXL345_Decode_ActivityInactivity(uint8_t *Buffer,
+                                  ADXL345_ActivityInactivity_t *ActivityInactivity)
+{
+  memset(ActivityInactivity, 0, sizeof(ADXL345_ActivityInactivity_t));
+
+  ActivityInactivity->ActivityThreshold = Buffer[0];
+  ActivityInactivity->InactivityThreshold = Buffer[1];
+  ActivityInactivity->InactivityTime = Buffer[2];
+
+  if (Buffer[3] & 0x01)
+    ActivityInactivity->Control.InactivityEnableZ = 1;
+  if (Buffer[3] & 0x02)
+    ActivityInactivity->Control.InactivityEnableY = 1;
+  if (Buffer[3] & 0x04)
+    ActivityInactivity->Control.InactivityEnableX = 1;
+  if (Buffer[3] & 0x08)
+    ActivityInactivity->Control.InactivityCoupled = 1;
+
+  if (Buffer[3] & 0x10)
+    ActivityInactivity->Control.ActivityEnableZ = 1;
+  if (Buffer[3] & 0x20)
+    ActivityInactivity->Control.ActivityEnableY = 1;
+  if (Buffer[3] & 0x40)
+    ActivityInactivity->Control.ActivityEnableX = 1;
+  if (Buffer[3] & 0x80)
+    ActivityInactivity->Control.ActivityCoupled = 1;
+}
+
+static void
+ADXL345_Decode_InterruptReg(uint8_t Reg, ADXL345_InterruptReg_t *Interrupt)
+{
+  memset(Interrupt, 0, sizeof(ADXL345_InterruptReg_t));
+
+  if (Reg & 0x01)
+    Interrupt->Overrun = 1;
+  if (Reg & 0x02)
+    Interrupt->Watermark = 1;
+  if (Reg & 0x04)
+    Interrupt->FreeFall = 1;
+  if (Reg & 0x08)
+    Interrupt->Inactivity = 1;
+  if (Reg & 0x10)
+    Interrupt->Activity = 1;
+  if (Reg & 0x20)
+    Interrupt->DoubleTap = 1;
+  if (Reg & 0x40)
+    Interrupt->SingleTap = 1;
+  if (Reg & 0x80)
+    Interrupt->DataReady = 1;
+}
+
+static void
+ADXL345_Decode_DataFormat(uint8_t Reg, ADXL345_DataFormat_t *DataFormat)
+{
+  memset(DataFormat, 0, sizeof(ADXL345_DataFormat_t));
+
+  DataFormat->Range = (ADXL345_Range_t) (Reg & 0x03);
+
+  if (Reg & 0x04)
+    DataFormat->JustifyLeft = 1;
+
+  if (Reg & 0x08)
+    DataFormat->FullResolution = 1;
+}
+
+static void
+ADXL345_Decode_FifoConfig(uint8_t Reg, ADXL345_FifoConfig_t *Config)
+{
+  memset(Config, 0, sizeof(ADXL345_FifoConfig_t));
+
+  Config->WatermarkSamples = (Reg & 0x1F);
+
+  if (Reg & 0x20)
+    Config->Trigger = 1;
+
+  Config->Mode = Reg >> 6;
+}
+
+static void
+ADXL345_Decode_FifoStatus(uint8_t Reg, ADXL345_FifoStatus_t *Status)
+{
+  memset(Status, 0, sizeof(ADXL345_FifoStatus_t));
+
+  Status->Entries = (Reg & 0x3F);
+
+  if (Reg & 0x80)
+    Status->Trigger = 1;
+}
+
+static void
+ADXL345_Decode_PowerControl(uint8_t Reg, ADXL345_PowerControl_t *PowerControl)
+{
+  memset(PowerControl, 0, sizeof(ADXL345_PowerControl_t));
+
+  PowerControl->Wakeup = Reg & 0x03;
+
+  if (Reg & 0x04)
+    PowerControl->Sleep = 1;
+  if (Reg & 0x08)
+    PowerControl->Measure = 1;
+  if (Reg & 0x10)
+    PowerControl->AutoSleep = 1;
+  if (Reg & 0x20)
+    PowerControl->Link = 1;
+}
 
 
 /**
@@ -174,32 +406,25 @@ ADXL345_Get_Offset(ADXL345_Handler_t *Handler, int8_t *X, int8_t *Y, int8_t *Z)
 }
 
 
-/**
- * @brief  Set tap configuration
- * @param  Handler: Pointer to handler
- * @param  TapConfig: Pointer to tap status
- * @retval ADXL345_Result_t
- *         - ADXL345_OK: Operation was successful.
- *         - ADXL345_FAIL: Failed to send or receive data.
- */
-ADXL345_Result_t
-ADXL345_Set_TapConfig(ADXL345_Handler_t *Handler,
-                      ADXL345_TapConfig_t *TapConfig)
+static ADXL345_Result_t
+ADXL345_Set_TapConfig_NoLock(ADXL345_Handler_t *Handler,
+                             ADXL345_TapConfig_t *TapConfig)
 {
   uint8_t Buffer[3];
 
   Buffer[0] = TapConfig->TapThreshold;
 
-  if (ADXL345_WriteRegs(Handler, ADXL345_REG_THRESH_TAP, Buffer, 1) != ADXL345_OK)
+  if (ADXL345_WriteRegsNoLock(Handler, ADXL345_REG_THRESH_TAP, Buffer, 1) != ADXL345_OK)
     return ADXL345_FAIL;
 
   Buffer[0] = TapConfig->Duration;
   Buffer[1] = TapConfig->Latent;
   Buffer[2] = TapConfig->Window;
 
-  if (ADXL345_WriteRegs(Handler, ADXL345_REG_DUR, Buffer, 3) != ADXL345_OK)
+  if (ADXL345_WriteRegsNoLock(Handler, ADXL345_REG_DUR, Buffer, 3) != ADXL345_OK)
     return ADXL345_FAIL;
 
+  Buffer[0] = 0;
   if (TapConfig->TapAxis.TapEnableZ)
     Buffer[0] |= 0x01;
   if (TapConfig->TapAxis.TapEnableY)
@@ -209,11 +434,11 @@ ADXL345_Set_TapConfig(ADXL345_Handler_t *Handler,
   if (TapConfig->TapAxis.Suppress)
     Buffer[0] |= 0x08;
 
-  return ADXL345_WriteRegs(Handler, ADXL345_REG_TAP_AXES, Buffer, 1);
+  return ADXL345_WriteRegsNoLock(Handler, ADXL345_REG_TAP_AXES, Buffer, 1);
 }
 
 /**
- * @brief  Get tap configuration
+ * @brief  Set tap configuration
  * @param  Handler: Pointer to handler
  * @param  TapConfig: Pointer to tap status
  * @retval ADXL345_Result_t
@@ -221,40 +446,67 @@ ADXL345_Set_TapConfig(ADXL345_Handler_t *Handler,
  *         - ADXL345_FAIL: Failed to send or receive data.
  */
 ADXL345_Result_t
-ADXL345_Get_TapConfig(ADXL345_Handler_t *Handler,
+ADXL345_Set_TapConfig(ADXL345_Handler_t *Handler,
                       ADXL345_TapConfig_t *TapConfig)
+{
+  ADXL345_Result_t Result = ADXL345_OK;
+
+  ADXL345_Lock(Handler);
+  Result = ADXL345_Set_TapConfig_NoLock(Handler, TapConfig);
+  ADXL345_Unlock(Handler);
+
+  return Result;
+}
+
+static ADXL345_Result_t
+ADXL345_Get_TapConfig_NoLock(ADXL345_Handler_t *Handler,
+                             ADXL345_TapConfig_t *TapConfig)
 {
   uint8_t Buffer[3];
 
   memset(TapConfig, 0, sizeof(ADXL345_TapConfig_t));
 
-  if (ADXL345_ReadRegs(Handler, ADXL345_REG_THRESH_TAP, Buffer, 1) != ADXL345_OK)
+  if (ADXL345_ReadRegsNoLock(Handler, ADXL345_REG_THRESH_TAP, Buffer, 1) != ADXL345_OK)
     return ADXL345_FAIL;
 
   TapConfig->TapThreshold = Buffer[0];
 
-  if (ADXL345_ReadRegs(Handler, ADXL345_REG_DUR, Buffer, 3) != ADXL345_OK)
+  if (ADXL345_ReadRegsNoLock(Handler, ADXL345_REG_DUR, Buffer, 3) != ADXL345_OK)
     return ADXL345_FAIL;
 
   TapConfig->Duration = Buffer[0];
   TapConfig->Latent = Buffer[1];
   TapConfig->Window = Buffer[2];
 
-  if (ADXL345_ReadRegs(Handler, ADXL345_REG_TAP_AXES, Buffer, 1) != ADXL345_OK)
+  if (ADXL345_ReadRegsNoLock(Handler, ADXL345_REG_TAP_AXES, Buffer, 1) != ADXL345_OK)
     return ADXL345_FAIL;
 
-  if (Buffer[0] & 0x01)
-    TapConfig->TapAxis.TapEnableZ = 1;
-  if (Buffer[0] & 0x02)
-    TapConfig->TapAxis.TapEnableY = 1;
-  if (Buffer[0] & 0x04)
-    TapConfig->TapAxis.TapEnableX = 1;
-  if (Buffer[0] & 0x08)
-    TapConfig->TapAxis.Suppress = 1;
+  ADXL345_Decode_TapAxes(Buffer[0], TapConfig);
 
   return ADXL345_OK;
 }
 
+/**
+ * @brief  Get tap configuration
+ * @param  Handler: Pointer to handler
+ * @param  TapConfig: Pointer to tap status
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Get_TapConfig(ADXL345_Handler_t *Handler,
+                      ADXL345_TapConfig_t *TapConfig)
+{
+  ADXL345_Result_t Result = ADXL345_OK;
+
+  ADXL345_Lock(Handler);
+  Result = ADXL345_Get_TapConfig_NoLock(Handler, TapConfig);
+  ADXL345_Unlock(Handler);
+
+  return Result;
+}
+
 /**
  * @brief  Get activity and tap status
  * @param  Handler: Pointer to handler
@@ -272,22 +524,7 @@ ADXL345_Get_ActTapStatus(ADXL345_Handler_t *Handler,
   if (ADXL345_ReadRegs(Handler, ADXL345_REG_ACT_TAP_STATUS, &Reg, 1) != ADXL345_OK)
     return ADXL345_FAIL;
 
-  if (Reg & 0x01)
-    Status->TapZ = 1;
-  if (Reg & 0x02)
-    Status->TapY = 1;
-  if (Reg & 0x04)
-    Status->TapX = 1;
-
-  if (Reg & 0x08)
-    Status->Asleep = 1;
-
-  if (Reg & 0x10)
-    Status->ActZ = 1;
-  if (Reg & 0x20)
-    Status->ActY = 1;
-  if (Reg & 0x40)
-    Status->ActX = 1;
+  ADXL345_Decode_ActTapStatus(Reg, Status);
 
   return ADXL345_OK;
 }
@@ -353,30 +590,8 @@ ADXL345_Get_ActivityInactivity(ADXL345_Handler_t *Handler,
   if (ADXL345_ReadRegs(Handler, ADXL345_REG_THRESH_ACT, Buffer, 4) != ADXL345_OK)
     return ADXL345_FAIL;
 
-  memset(ActivityInactivity, 0, sizeof(ADXL345_ActivityInactivity_t));
-
-  ActivityInactivity->ActivityThreshold = Buffer[0];
-  ActivityInactivity->InactivityThreshold = Buffer[1];
-  ActivityInactivity->InactivityTime = Buffer[2];
-
-  if (Buffer[3] & 0x01)
-    ActivityInactivity->Control.InactivityEnableZ = 1;
-  if (Buffer[3] & 0x02)
-    ActivityInactivity->Control.InactivityEnableY = 1;
-  if (Buffer[3] & 0x04)
-    ActivityInactivity->Control.InactivityEnableX = 1;
-  if (Buffer[3] & 0x08)
-    ActivityInactivity->Control.InactivityCoupled = 1;
+  ADXL345_Decode_ActivityInactivity(Buffer, ActivityInactivity);
 
-  if (Buffer[3] & 0x10)
-    ActivityInactivity->Control.ActivityEnableZ = 1;
-  if (Buffer[3] & 0x20)
-    ActivityInactivity->Control.ActivityEnableY = 1;
-  if (Buffer[3] & 0x40)
-    ActivityInactivity->Control.ActivityEnableX = 1;
-  if (Buffer[3] & 0x80)
-    ActivityInactivity->Control.ActivityCoupled = 1;
-  
   return ADXL345_OK;
 }
 
@@ -428,6 +643,21 @@ ADXL345_Get_FreeFall(ADXL345_Handler_t *Handler,
 }
 
 
+static ADXL345_Result_t
+ADXL345_Set_Rate_NoLock(ADXL345_Handler_t *Handler, ADXL345_Rate_t Rate)
+{
+  uint8_t Reg = 0;
+
+  if (ADXL345_ReadRegsNoLock(Handler,
+                             ADXL345_REG_BW_RATE, &Reg, 1) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  Reg &= ~(0x1F);
+  Reg |= Rate;
+
+  return ADXL345_WriteRegsNoLock(Handler, ADXL345_REG_BW_RATE, &Reg, 1);
+}
+
 /**
  * @brief  Set Data Rate
  * @param  Handler: Pointer to handler
@@ -439,16 +669,13 @@ ADXL345_Get_FreeFall(ADXL345_Handler_t *Handler,
 ADXL345_Result_t
 ADXL345_Set_Rate(ADXL345_Handler_t *Handler, ADXL345_Rate_t Rate)
 {
-  uint8_t Reg = 0;
+  ADXL345_Result_t Result = ADXL345_OK;
 
-  if (ADXL345_ReadRegs(Handler,
-                       ADXL345_REG_BW_RATE, &Reg, 1) != ADXL345_OK)
-    return ADXL345_FAIL;
-
-  Reg &= ~(0x1F);
-  Reg |= Rate;
+  ADXL345_Lock(Handler);
+  Result = ADXL345_Set_Rate_NoLock(Handler, Rate);
+  ADXL345_Unlock(Handler);
 
-  return ADXL345_WriteRegs(Handler, ADXL345_REG_BW_RATE, &Reg, 1);
+  return Result;
 }
 
 /**
@@ -475,17 +702,9 @@ ADXL345_Get_Rate(ADXL345_Handler_t *Handler, ADXL345_Rate_t *Rate)
 }
 
 
-/**
- * @brief  Set Interrupt Configuration
- * @param  Handler: Pointer to handler
- * @param  Config: Pointer to Interrupt Configuration structure
- * @retval ADXL345_Result_t
- *         - ADXL345_OK: Operation was successful.
- *         - ADXL345_FAIL: Failed to send or receive data.
- */
-ADXL345_Result_t
-ADXL345_Set_InterruptConfig(ADXL345_Handler_t *Handler,
-                            ADXL345_InterruptConfig_t *Config)
+static ADXL345_Result_t
+ADXL345_Set_InterruptConfig_NoLock(ADXL345_Handler_t *Handler,
+                                   ADXL345_InterruptConfig_t *Config)
 {
   uint8_t Buffer[2] = {0};
 
@@ -523,18 +742,39 @@ ADXL345_Set_InterruptConfig(ADXL345_Handler_t *Handler,
   if (Config->Map.DataReady)
     Buffer[1] |= 0x80;
 
-  if (ADXL345_WriteRegs(Handler,
-                        ADXL345_REG_INT_ENABLE, Buffer, 2) != ADXL345_OK)
+  if (ADXL345_WriteRegsNoLock(Handler,
+                              ADXL345_REG_INT_ENABLE, Buffer, 2) != ADXL345_OK)
     return ADXL345_FAIL;
 
-  if (ADXL345_ReadRegs(Handler,
-                       ADXL345_REG_DATA_FORMAT, Buffer, 1) != ADXL345_OK)
+  if (ADXL345_ReadRegsNoLock(Handler,
+                             ADXL345_REG_DATA_FORMAT, Buffer, 1) != ADXL345_OK)
     return ADXL345_FAIL;
 
   if (Config->ActiveLow)
     Buffer[0] |= 0x20;
 
-  return ADXL345_WriteRegs(Handler, ADXL345_REG_DATA_FORMAT, Buffer, 1);
+  return ADXL345_WriteRegsNoLock(Handler, ADXL345_REG_DATA_FORMAT, Buffer, 1);
+}
+
+/**
+ * @brief  Set Interrupt Configuration
+ * @param  Handler: Pointer to handler
+ * @param  Config: Pointer to Interrupt Configuration structure
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Set_InterruptConfig(ADXL345_Handler_t *Handler,
+                            ADXL345_InterruptConfig_t *Config)
+{
+  ADXL345_Result_t Result = ADXL345_OK;
+
+  ADXL345_Lock(Handler);
+  Result = ADXL345_Set_InterruptConfig_NoLock(Handler, Config);
+  ADXL345_Unlock(Handler);
+
+  return Result;
 }
 
 /**
@@ -557,39 +797,8 @@ ADXL345_Get_InterruptConfig(ADXL345_Handler_t *Handler,
 
   memset(Config, 0, sizeof(ADXL345_InterruptConfig_t));
 
-  if (Buffer[0] & 0x01)
-    Config->Enable.Overrun = 1;
-  if (Buffer[0] & 0x02)
-    Config->Enable.Watermark = 1;
-  if (Buffer[0] & 0x04)
-    Config->Enable.FreeFall = 1;
-  if (Buffer[0] & 0x08)
-    Config->Enable.Inactivity = 1;
-  if (Buffer[0] & 0x10)
-    Config->Enable.Activity = 1;
-  if (Buffer[0] & 0x20)
-    Config->Enable.DoubleTap = 1;
-  if (Buffer[0] & 0x40)
-    Config->Enable.SingleTap = 1;
-  if (Buffer[0] & 0x80)
-    Config->Enable.DataReady = 1;
-
-  if (Buffer[1] & 0x01)
-    Config->Map.Overrun = 1;
-  if (Buffer[1] & 0x02)
-    Config->Map.Watermark = 1;
-  if (Buffer[1] & 0x04)
-    Config->Map.FreeFall = 1;
-  if (Buffer[1] & 0x08)
-    Config->Map.Inactivity = 1;
-  if (Buffer[1] & 0x10)
-    Config->Map.Activity = 1;
-  if (Buffer[1] & 0x20)
-    Config->Map.DoubleTap = 1;
-  if (Buffer[1] & 0x40)
-    Config->Map.SingleTap = 1;
-  if (Buffer[1] & 0x80)
-    Config->Map.DataReady = 1;
+  ADXL345_Decode_InterruptReg(Buffer[0], &Config->Enable);
+  ADXL345_Decode_InterruptReg(Buffer[1], &Config->Map);
 
   return ADXL345_OK;
 }
@@ -612,45 +821,47 @@ ADXL345_Get_InterruptSource(ADXL345_Handler_t *Handler,
                        ADXL345_REG_INT_SOURCE, &Reg, 1) != ADXL345_OK)
     return ADXL345_FAIL;
 
-  memset(Source, 0, sizeof(ADXL345_InterruptReg_t));
-
-  if (Reg & 0x01)
-    Source->Overrun = 1;
-  if (Reg & 0x02)
-    Source->Watermark = 1;
-  if (Reg & 0x04)
-    Source->FreeFall = 1;
-  if (Reg & 0x08)
-    Source->Inactivity = 1;
-  if (Reg & 0x10)
-    Source->Activity = 1;
-  if (Reg & 0x20)
-    Source->DoubleTap = 1;
-  if (Reg & 0x40)
-    Source->SingleTap = 1;
-  if (Reg & 0x80)
-    Source->DataReady = 1;
+  ADXL345_Decode_InterruptReg(Reg, Source);
 
   return ADXL345_OK;
 }
 
-
 /**
- * @brief  Set Data Format settings
+ * @brief  Get Interrupt Source and read the data registers in one burst
  * @param  Handler: Pointer to handler
- * @param  DataFormat: Pointer to Data Format settings structure
+ * @param  Source: Pointer to Interrupt Source structure
+ * @param  Buffer: Pointer to 6-byte buffer (DATAX0 to DATAZ1)
  * @retval ADXL345_Result_t
  *         - ADXL345_OK: Operation was successful.
  *         - ADXL345_FAIL: Failed to send or receive data.
  */
 ADXL345_Result_t
-ADXL345_Set_DataFormat(ADXL345_Handler_t *Handler,
-                       ADXL345_DataFormat_t *DataFormat)
+ADXL345_Get_InterruptSourceSample(ADXL345_Handler_t *Handler,
+                                  ADXL345_InterruptReg_t *Source,
+                                  uint8_t *Buffer)
+{
+  uint8_t Reg[ADXL345_REG_DATAZ1 - ADXL345_REG_INT_SOURCE + 1] = {0};
+
+  // DATA_FORMAT sits between INT_SOURCE and DATAX0 and is read along
+  if (ADXL345_ReadRegs(Handler, ADXL345_REG_INT_SOURCE,
+                       Reg, sizeof(Reg)) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  ADXL345_Decode_InterruptReg(Reg[0], Source);
+  memcpy(Buffer, &Reg[ADXL345_REG_DATAX0 - ADXL345_REG_INT_SOURCE], 6);
+
+  return ADXL345_OK;
+}
+
+
+static ADXL345_Result_t
+ADXL345_Set_DataFormat_NoLock(ADXL345_Handler_t *Handler,
+                              ADXL345_DataFormat_t *DataFormat)
 {
   uint8_t Reg = 0;
 
-  if (ADXL345_ReadRegs(Handler,
-                       ADXL345_REG_DATA_FORMAT, &Reg, 1) != ADXL345_OK)
+  if (ADXL345_ReadRegsNoLock(Handler,
+                             ADXL345_REG_DATA_FORMAT, &Reg, 1) != ADXL345_OK)
     return ADXL345_FAIL;
 
   Reg &= 0xF0;
@@ -663,11 +874,11 @@ ADXL345_Set_DataFormat(ADXL345_Handler_t *Handler,
   if (DataFormat->FullResolution)
     Reg |= 0x08;
 
-  return ADXL345_WriteRegs(Handler, ADXL345_REG_DATA_FORMAT, &Reg, 1);
+  return ADXL345_WriteRegsNoLock(Handler, ADXL345_REG_DATA_FORMAT, &Reg, 1);
 }
 
 /**
- * @brief  Get Data Format settings
+ * @brief  Set Data Format settings
  * @param  Handler: Pointer to handler
  * @param  DataFormat: Pointer to Data Format settings structure
  * @retval ADXL345_Result_t
@@ -675,26 +886,54 @@ ADXL345_Set_DataFormat(ADXL345_Handler_t *Handler,
  *         - ADXL345_FAIL: Failed to send or receive data.
  */
 ADXL345_Result_t
-ADXL345_Get_DataFormat(ADXL345_Handler_t *Handler,
+ADXL345_Set_DataFormat(ADXL345_Handler_t *Handler,
                        ADXL345_DataFormat_t *DataFormat)
+{
+  ADXL345_Result_t Result = ADXL345_OK;
+
+  ADXL345_Lock(Handler);
+  Result = ADXL345_Set_DataFormat_NoLock(Handler, DataFormat);
+  ADXL345_Unlock(Handler);
+
+  return Result;
+}
+
+static ADXL345_Result_t
+ADXL345_Get_DataFormat_NoLock(ADXL345_Handler_t *Handler,
+                              ADXL345_DataFormat_t *DataFormat)
 {
   uint8_t Reg = 0;
 
   memset(DataFormat, 0, sizeof(ADXL345_DataFormat_t));
 
-  if (ADXL345_ReadRegs(Handler,
-                       ADXL345_REG_DATA_FORMAT, &Reg, 1) != ADXL345_OK)
+  if (ADXL345_ReadRegsNoLock(Handler,
+                             ADXL345_REG_DATA_FORMAT, &Reg, 1) != ADXL345_OK)
     return ADXL345_FAIL;
 
-  DataFormat->Range = (ADXL345_Range_t) (Reg & 0x03);
+  ADXL345_Decode_DataFormat(Reg, DataFormat);
 
-  if (Reg & 0x04)
-    DataFormat->JustifyLeft = 1;
+  return ADXL345_OK;
+}
 
-  if (Reg & 0x08)
-    DataFormat->FullResolution = 1;
+/**
+ * @brief  Get Data Format settings
+ * @param  Handler: Pointer to handler
+ * @param  DataFormat: Pointer to Data Format settings structure
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Get_DataFormat(ADXL345_Handler_t *Handler,
+                       ADXL345_DataFormat_t *DataFormat)
+{
+  ADXL345_Result_t Result = ADXL345_OK;
 
-  return ADXL345_OK;
+  ADXL345_Lock(Handler);
+  Result = ADXL345_Get_DataFormat_NoLock(Handler, DataFormat);
+  ADXL345_Unlock(Handler);
+
+  return Result;
 }
 
 
@@ -722,6 +961,21 @@ ADXL345_Set_FifoConfig(ADXL345_Handler_t *Handler,
   return ADXL345_WriteRegs(Handler, ADXL345_REG_FIFO_CTL, &Reg, 1);
 }
 
+static ADXL345_Result_t
+ADXL345_Get_FifoConfig_NoLock(ADXL345_Handler_t *Handler,
+                              ADXL345_FifoConfig_t *Config)
+{
+  uint8_t Reg = 0;
+
+  if (ADXL345_ReadRegsNoLock(Handler,
+                             ADXL345_REG_FIFO_CTL, &Reg, 1) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  ADXL345_Decode_FifoConfig(Reg, Config);
+
+  return ADXL345_OK;
+}
+
 /**
  * @brief  Get FIFO Configurations
  * @param  Handler: Pointer to handler
@@ -734,20 +988,26 @@ ADXL345_Result_t
 ADXL345_Get_FifoConfig(ADXL345_Handler_t *Handler,
                        ADXL345_FifoConfig_t *Config)
 {
-  uint8_t Reg = 0;
+  ADXL345_Result_t Result = ADXL345_OK;
 
-  if (ADXL345_ReadRegs(Handler,
-                       ADXL345_REG_FIFO_CTL, &Reg, 1) != ADXL345_OK)
-    return ADXL345_FAIL;
+  ADXL345_Lock(Handler);
+  Result = ADXL345_Get_FifoConfig_NoLock(Handler, Config);
+  ADXL345_Unlock(Handler);
 
-  memset(Config, 0, sizeof(ADXL345_FifoConfig_t));
+  return Result;
+}
 
-  Config->WatermarkSamples = (Reg & 0x1F);
+static ADXL345_Result_t
+ADXL345_Get_FifoStatus_NoLock(ADXL345_Handler_t *Handler,
+                              ADXL345_FifoStatus_t *Status)
+{
+  uint8_t Reg = 0;
 
-  if (Reg & 0x20)
-    Config->Trigger = 1;
+  if (ADXL345_ReadRegsNoLock(Handler,
+                             ADXL345_REG_FIFO_STATUS, &Reg, 1) != ADXL345_OK)
+    return ADXL345_FAIL;
 
-  Config->Mode = Reg >> 6;
+  ADXL345_Decode_FifoStatus(Reg, Status);
 
   return ADXL345_OK;
 }
@@ -764,22 +1024,35 @@ ADXL345_Result_t
 ADXL345_Get_FifoStatus(ADXL345_Handler_t *Handler,
                        ADXL345_FifoStatus_t *Status)
 {
-  uint8_t Reg = 0;
+  ADXL345_Result_t Result = ADXL345_OK;
 
-  if (ADXL345_ReadRegs(Handler,
-                       ADXL345_REG_FIFO_STATUS, &Reg, 1) != ADXL345_OK)
-    return ADXL345_FAIL;
+  ADXL345_Lock(Handler);
+  Result = ADXL345_Get_FifoStatus_NoLock(Handler, Status);
+  ADXL345_Unlock(Handler);
 
-  memset(Status, 0, sizeof(ADXL345_FifoStatus_t));
+  return Result;
+}
 
-  Status->Entries = (Reg & 0x3F);
 
-  if (Reg & 0x80)
-    Status->Trigger = 1;
+static ADXL345_Result_t
+ADXL345_Set_PowerControl_NoLock(ADXL345_Handler_t *Handler,
+                                ADXL345_PowerControl_t *PowerControl)
+{
+  uint8_t Reg = 0;
 
-  return ADXL345_OK;
-}
+  Reg |= PowerControl->Wakeup & 0x03;
 
+  if (PowerControl->Sleep)
+    Reg |= 0x04;
+  if (PowerControl->Measure)
+    Reg |= 0x08;
+  if (PowerControl->AutoSleep)
+    Reg |= 0x10;
+  if (PowerControl->Link)
+    Reg |= 0x20;
+
+  return ADXL345_WriteRegsNoLock(Handler, ADXL345_REG_POWER_CTL, &Reg, 1);
+}
 
 /**
  * @brief  Set Power Settings
@@ -792,21 +1065,29 @@ ADXL345_Get_FifoStatus(ADXL345_Handler_t *Handler,
 ADXL345_Result_t
 ADXL345_Set_PowerControl(ADXL345_Handler_t *Handler,
                          ADXL345_PowerControl_t *PowerControl)
+{
+  ADXL345_Result_t Result = ADXL345_OK;
+
+  ADXL345_Lock(Handler);
+  Result = ADXL345_Set_PowerControl_NoLock(Handler, PowerControl);
+  ADXL345_Unlock(Handler);
+
+  return Result;
+}
+
+static ADXL345_Result_t
+ADXL345_Get_PowerControl_NoLock(ADXL345_Handler_t *Handler,
+                                ADXL345_PowerControl_t *PowerControl)
 {
   uint8_t Reg = 0;
 
-  Reg |= PowerControl->Wakeup & 0x03;
+  if (ADXL345_ReadRegsNoLock(Handler,
+                             ADXL345_REG_POWER_CTL, &Reg, 1) != ADXL345_OK)
+    return ADXL345_FAIL;
 
-  if (PowerControl->Sleep)
-    Reg |= 0x04;
-  if (PowerControl->Measure)
-    Reg |= 0x08;
-  if (PowerControl->AutoSleep)
-    Reg |= 0x10;
-  if (PowerControl->Link)
-    Reg |= 0x20;
+  ADXL345_Decode_PowerControl(Reg, PowerControl);
 
-  return ADXL345_WriteRegs(Handler, ADXL345_REG_POWER_CTL, &Reg, 1);
+  return ADXL345_OK;
 }
 
 /**
@@ -821,43 +1102,156 @@ ADXL345_Result_t
 ADXL345_Get_PowerControl(ADXL345_Handler_t *Handler,
                          ADXL345_PowerControl_t *PowerControl)
 {
-  uint8_t Reg = 0;
+  ADXL345_Result_t Result = ADXL345_OK;
 
-  if (ADXL345_ReadRegs(Handler,
-                       ADXL345_REG_POWER_CTL, &Reg, 1) != ADXL345_OK)
+  ADXL345_Lock(Handler);
+  Result = ADXL345_Get_PowerControl_NoLock(Handler, PowerControl);
+  ADXL345_Unlock(Handler);
+
+  return Result;
+}
+
+
+static ADXL345_Result_t
+ADXL345_Get_Snapshot_NoLock(ADXL345_Handler_t *Handler,
+                            ADXL345_Snapshot_t *Snapshot)
+{
+  uint8_t Reg[ADXL345_REG_FIFO_STATUS + 1] = {0};
+
+  if (ADXL345_ReadRegsNoLock(Handler, ADXL345_REG_THRESH_TAP,
+                             &Reg[ADXL345_REG_THRESH_TAP],
+                             ADXL345_REG_INT_MAP - ADXL345_REG_THRESH_TAP + 1) != ADXL345_OK)
     return ADXL345_FAIL;
 
-  memset(PowerControl, 0, sizeof(ADXL345_PowerControl_t));
+  if (ADXL345_ReadRegsNoLock(Handler, ADXL345_REG_DATA_FORMAT,
+                             &Reg[ADXL345_REG_DATA_FORMAT], 1) != ADXL345_OK)
+    return ADXL345_FAIL;
 
-  PowerControl->Wakeup = Reg & 0x03;
+  if (ADXL345_ReadRegsNoLock(Handler, ADXL345_REG_FIFO_CTL,
+                             &Reg[ADXL345_REG_FIFO_CTL], 2) != ADXL345_OK)
+    return ADXL345_FAIL;
 
-  if (Reg & 0x04)
-    PowerControl->Sleep = 1;
-  if (Reg & 0x08)
-    PowerControl->Measure = 1;
-  if (Reg & 0x10)
-    PowerControl->AutoSleep = 1;
-  if (Reg & 0x20)
-    PowerControl->Link = 1;
+  memset(Snapshot, 0, sizeof(ADXL345_Snapshot_t));
+
+  Snapshot->TapConfig.TapThreshold = Reg[ADXL345_REG_THRESH_TAP];
+  Snapshot->TapConfig.Duration = Reg[ADXL345_REG_DUR];
+  Snapshot->TapConfig.Latent = Reg[ADXL345_REG_LATENT];
+  Snapshot->TapConfig.Window = Reg[ADXL345_REG_WINDOW];
+  ADXL345_Decode_TapAxes(Reg[ADXL345_REG_TAP_AXES], &Snapshot->TapConfig);
+
+  Snapshot->OffsetX = (int8_t)Reg[ADXL345_REG_OFSX];
+  Snapshot->OffsetY = (int8_t)Reg[ADXL345_REG_OFSY];
+  Snapshot->OffsetZ = (int8_t)Reg[ADXL345_REG_OFSZ];
+
+  ADXL345_Decode_ActivityInactivity(&Reg[ADXL345_REG_THRESH_ACT],
+                                    &Snapshot->ActivityInactivity);
+
+  Snapshot->FreeFallThreshold = Reg[ADXL345_REG_THRESH_FF];
+  Snapshot->FreeFallTime = Reg[ADXL345_REG_TIME_FF];
+
+  ADXL345_Decode_ActTapStatus(Reg[ADXL345_REG_ACT_TAP_STATUS],
+                              &Snapshot->ActTapStatus);
+
+  Snapshot->Rate = (ADXL345_Rate_t)(Reg[ADXL345_REG_BW_RATE] & 0x1F);
+
+  ADXL345_Decode_PowerControl(Reg[ADXL345_REG_POWER_CTL],
+                              &Snapshot->PowerControl);
+
+  ADXL345_Decode_InterruptReg(Reg[ADXL345_REG_INT_ENABLE],
+                              &Snapshot->InterruptConfig.Enable);
+  ADXL345_Decode_InterruptReg(Reg[ADXL345_REG_INT_MAP],
+                              &Snapshot->InterruptConfig.Map);
+  if (Reg[ADXL345_REG_DATA_FORMAT] & 0x20)
+    Snapshot->InterruptConfig.ActiveLow = 1;
+
+  ADXL345_Decode_DataFormat(Reg[ADXL345_REG_DATA_FORMAT],
+                            &Snapshot->DataFormat);
+
+  ADXL345_Decode_FifoConfig(Reg[ADXL345_REG_FIFO_CTL],
+                            &Snapshot->FifoConfig);
+  ADXL345_Decode_FifoStatus(Reg[ADXL345_REG_FIFO_STATUS],
+                            &Snapshot->FifoStatus);
 
   return ADXL345_OK;
 }
 
+/**
+ * @brief  Read all configuration and status registers with a few burst reads
+ *         and decode them into configuration structures
+ * @note   INT_SOURCE and DATAX0..DATAZ1 are skipped. Reading them would clear
+ *         latched interrupts and pop a FIFO entry. So the register map is read
+ *         in 3 bursts: THRESH_TAP..INT_MAP, DATA_FORMAT and
+ *         FIFO_CTL..FIFO_STATUS.
+ * @param  Handler: Pointer to handler
+ * @param  Snapshot: Pointer to snapshot structure
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Get_Snapshot(ADXL345_Handler_t *Handler,
+                     ADXL345_Snapshot_t *Snapshot)
+{
+  ADXL345_Result_t Result = ADXL345_OK;
+
+  ADXL345_Lock(Handler);
+  Result = ADXL345_Get_Snapshot_NoLock(Handler, Snapshot);
+  ADXL345_Unlock(Handler);
+
+  return Result;
+}
+
+
+static ADXL345_Result_t
+ADXL345_ReadRawSamples_NoLock(ADXL345_Handler_t *Handler,
+                              uint8_t *Buffer, uint8_t Entries)
+{
+  // Each FIFO entry must be read with a separate 6-byte burst starting from
+  // DATAX0. The register pointer does not wrap after DATAZ1.
+  for (uint8_t i = 0; i < Entries; i++)
+  {
+    if (ADXL345_ReadRegsNoLock(Handler,
+                               ADXL345_REG_DATAX0, Buffer + 6 * i, 6) != ADXL345_OK)
+      return ADXL345_FAIL;
+  }
+
+  return ADXL345_OK;
+}
 
 /**
- * @brief  
+ * @brief  Read raw samples from FIFO
+ * @note   Each FIFO entry takes 6 bytes in Buffer (DATAX0 to DATAZ1)
  * @param  Handler: Pointer to handler
- * @param  Samples: Pointer to Samples array
- * @param  SamplesBufferLen: Sample buffer capacity in terms of number of samples
- * @param  ReadSamples: Number of samples read
+ * @param  Buffer: Pointer to buffer with at least 6 * Entries bytes
+ * @param  Entries: Number of FIFO entries to read
  * @retval ADXL345_Result_t
  *         - ADXL345_OK: Operation was successful.
  *         - ADXL345_FAIL: Failed to send or receive data.
  */
 ADXL345_Result_t
-ADXL345_ReadSamples(ADXL345_Handler_t *Handler,
-                    ADXL345_Sample_t *Samples,
-                    uint8_t SamplesBufferLen, uint8_t *ReadSamples)
+ADXL345_ReadRawSamples(ADXL345_Handler_t *Handler,
+                       uint8_t *Buffer, uint8_t Entries)
+{
+  ADXL345_Result_t Result = ADXL345_OK;
+
+  ADXL345_Lock(Handler);
+  Result = ADXL345_ReadRawSamples_NoLock(Handler, Buffer, Entries);
+  ADXL345_Unlock(Handler);
+
+  return Result;
+}
+
+/**
+ * @brief  Decode raw samples read by ADXL345_ReadRawSamples
+ * @param  DataFormat: Pointer to Data Format settings used for the samples
+ * @param  Buffer: Pointer to raw samples
+ * @param  Samples: Pointer to Samples array
+ * @param  Count: Number of samples to decode
+ * @retval None
+ */
+void
+ADXL345_DecodeSamples(ADXL345_DataFormat_t *DataFormat, uint8_t *Buffer,
+                      ADXL345_Sample_t *Samples, uint8_t Count)
 {
   typedef union U16toI16_u
   {
@@ -865,58 +1259,37 @@ ADXL345_ReadSamples(ADXL345_Handler_t *Handler,
     uint16_t U16;
   } U16toI16_t;
   
-  const static int16_t TwosCompliment[4] = {64, 32, 16, 8};
+  static const int16_t TwosCompliment[4] = {64, 32, 16, 8};
 
-  ADXL345_FifoConfig_t FifoConfig;
-  ADXL345_DataFormat_t DataFormat;
-  uint8_t Buffer[32 * 6];
   float Factor = 0.0f;
   U16toI16_t RawX = {0};
   U16toI16_t RawY = {0};
   U16toI16_t RawZ = {0};
 
-  ADXL345_Get_FifoConfig(Handler, &FifoConfig);
-  ADXL345_Get_DataFormat(Handler, &DataFormat);
-
-  if (FifoConfig.Mode == ADXL345_MODE_BYPASS)
-    *ReadSamples = 1;
-  else
-  {
-    ADXL345_FifoStatus_t FifoStatus;
-    ADXL345_Get_FifoStatus(Handler, &FifoStatus);
-
-    *ReadSamples = MIN(SamplesBufferLen, FifoStatus.Entries);
-  }
-
-  if (ADXL345_ReadRegs(Handler,
-                       ADXL345_REG_DATAX0, Buffer,
-                       6 * (*ReadSamples)) != ADXL345_OK)
-    return ADXL345_FAIL;
-
-  for (uint8_t i = 0; i < (*ReadSamples); i++)
+  for (uint8_t i = 0; i < Count; i++)
   {
     RawX.U16 = (Buffer[1+i*6] << 8) | Buffer[0+i*6];
     RawY.U16 = (Buffer[3+i*6] << 8) | Buffer[2+i*6];
     RawZ.U16 = (Buffer[5+i*6] << 8) | Buffer[4+i*6];
 
-    if (DataFormat.FullResolution)
+    if (DataFormat->FullResolution)
     {
-      if (DataFormat.JustifyLeft == 0)
+      if (DataFormat->JustifyLeft == 0)
       {
-        RawX.U16 <<= 6 - DataFormat.Range;
-        RawY.U16 <<= 6 - DataFormat.Range;
-        RawZ.U16 <<= 6 - DataFormat.Range;
+        RawX.U16 <<= 6 - DataFormat->Range;
+        RawY.U16 <<= 6 - DataFormat->Range;
+        RawZ.U16 <<= 6 - DataFormat->Range;
       }
 
-      Samples[i].RawX = RawX.I16 / TwosCompliment[DataFormat.Range];
-      Samples[i].RawY = RawY.I16 / TwosCompliment[DataFormat.Range];
-      Samples[i].RawZ = RawZ.I16 / TwosCompliment[DataFormat.Range];
+      Samples[i].RawX = RawX.I16 / TwosCompliment[DataFormat->Range];
+      Samples[i].RawY = RawY.I16 / TwosCompliment[DataFormat->Range];
+      Samples[i].RawZ = RawZ.I16 / TwosCompliment[DataFormat->Range];
 
       Factor = 0.004f;
     }
     else
     {
-      if (DataFormat.JustifyLeft == 0)
+      if (DataFormat->JustifyLeft == 0)
       {
         RawX.U16 <<= 6;
         RawY.U16 <<= 6;
@@ -927,7 +1300,7 @@ ADXL345_ReadSamples(ADXL345_Handler_t *Handler,
       Samples[i].RawY = RawY.I16 / TwosCompliment[ADXL345_RANGE_2G];
       Samples[i].RawZ = RawZ.I16 / TwosCompliment[ADXL345_RANGE_2G];
 
-      switch (DataFormat.Range)
+      switch (DataFormat->Range)
       {
       case ADXL345_RANGE_2G:
         Factor = 0.0039f;
@@ -950,10 +1323,141 @@ ADXL345_ReadSamples(ADXL345_Handler_t *Handler,
     Samples[i].AccelY = (float)(Samples[i].RawY) * Factor;
     Samples[i].AccelZ = (float)(Samples[i].RawZ) * Factor;
   }
+}
+
+static ADXL345_Result_t
+ADXL345_ReadSamples_NoLock(ADXL345_Handler_t *Handler,
+                           ADXL345_Sample_t *Samples,
+                           uint8_t SamplesBufferLen, uint8_t *ReadSamples)
+{
+  ADXL345_FifoConfig_t FifoConfig;
+  ADXL345_DataFormat_t DataFormat;
+  ADXL345_FifoStatus_t FifoStatus;
+  uint8_t Buffer[ADXL345_FIFO_SIZE * 6];
+
+  *ReadSamples = 0;
+
+  if (ADXL345_Get_FifoConfig_NoLock(Handler, &FifoConfig) != ADXL345_OK)
+    return ADXL345_FAIL;
+  if (ADXL345_Get_DataFormat_NoLock(Handler, &DataFormat) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  if (FifoConfig.Mode == ADXL345_MODE_BYPASS)
+    *ReadSamples = MIN(SamplesBufferLen, 1);
+  else
+  {
+    if (ADXL345_Get_FifoStatus_NoLock(Handler, &FifoStatus) != ADXL345_OK)
+      return ADXL345_FAIL;
+
+    *ReadSamples = MIN(SamplesBufferLen, FifoStatus.Entries);
+  }
+  *ReadSamples = MIN(*ReadSamples, ADXL345_FIFO_SIZE);
+
+  if (ADXL345_ReadRawSamples_NoLock(Handler, Buffer, *ReadSamples) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  ADXL345_DecodeSamples(&DataFormat, Buffer, Samples, *ReadSamples);
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Read samples from FIFO
+ * @param  Handler: Pointer to handler
+ * @param  Samples: Pointer to Samples array
+ * @param  SamplesBufferLen: Sample buffer capacity in terms of number of samples
+ * @param  ReadSamples: Number of samples read
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_ReadSamples(ADXL345_Handler_t *Handler,
+                    ADXL345_Sample_t *Samples,
+                    uint8_t SamplesBufferLen, uint8_t *ReadSamples)
+{
+  ADXL345_Result_t Result = ADXL345_OK;
+
+  ADXL345_Lock(Handler);
+  Result = ADXL345_ReadSamples_NoLock(Handler, Samples, SamplesBufferLen, ReadSamples);
+  ADXL345_Unlock(Handler);
+
+  return Result;
+}
+
+static ADXL345_Result_t
+ADXL345_ReadSamplesWatermark_NoLock(ADXL345_Handler_t *Handler,
+                                    ADXL345_Sample_t *Samples,
+                                    uint8_t SamplesBufferLen,
+                                    uint8_t WatermarkSamples, uint8_t *ReadSamples)
+{
+  ADXL345_DataFormat_t DataFormat;
+  ADXL345_FifoStatus_t FifoStatus;
+  uint8_t Buffer[ADXL345_FIFO_SIZE * 6];
+  uint8_t Count = 0;
+  uint8_t TopUp = 0;
+
+  *ReadSamples = 0;
+
+  Count = MIN(SamplesBufferLen, WatermarkSamples);
+  Count = MIN(Count, ADXL345_FIFO_SIZE);
+
+  if (ADXL345_ReadRawSamples_NoLock(Handler, Buffer, Count) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  if (Count < MIN(SamplesBufferLen, ADXL345_FIFO_SIZE))
+  {
+    if (ADXL345_Get_FifoStatus_NoLock(Handler, &FifoStatus) != ADXL345_OK)
+      return ADXL345_FAIL;
+
+    TopUp = MIN(SamplesBufferLen, ADXL345_FIFO_SIZE) - Count;
+    TopUp = MIN(TopUp, FifoStatus.Entries);
+
+    if (ADXL345_ReadRawSamples_NoLock(Handler, Buffer + 6 * Count, TopUp) != ADXL345_OK)
+      return ADXL345_FAIL;
+
+    Count += TopUp;
+  }
+
+  if (ADXL345_Get_DataFormat_NoLock(Handler, &DataFormat) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  ADXL345_DecodeSamples(&DataFormat, Buffer, Samples, Count);
+  *ReadSamples = Count;
 
   return ADXL345_OK;
 }
 
+/**
+ * @brief  Read samples from FIFO after a watermark interrupt
+ * @note   WatermarkSamples entries are known to be in the FIFO when the
+ *         watermark interrupt fires. So they are read immediately and
+ *         FIFO_STATUS is read afterwards only to top up the samples that
+ *         arrived in the meantime. FIFO configuration is not read at all.
+ * @param  Handler: Pointer to handler
+ * @param  Samples: Pointer to Samples array
+ * @param  SamplesBufferLen: Sample buffer capacity in terms of number of samples
+ * @param  WatermarkSamples: Number of samples known to be in FIFO
+ * @param  ReadSamples: Number of samples read
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_ReadSamplesWatermark(ADXL345_Handler_t *Handler,
+                             ADXL345_Sample_t *Samples,
+                             uint8_t SamplesBufferLen,
+                             uint8_t WatermarkSamples, uint8_t *ReadSamples)
+{
+  ADXL345_Result_t Result = ADXL345_OK;
+
+  ADXL345_Lock(Handler);
+  Result = ADXL345_ReadSamplesWatermark_NoLock(Handler, Samples, SamplesBufferLen, WatermarkSamples, ReadSamples);
+  ADXL345_Unlock(Handler);
+
+  return Result;
+}
+
 /**
  * @brief  IRQ Handler
  * @note   Put this function in ISR. This function will call
@@ -1019,6 +1523,9 @@ ADXL345_Init(ADXL345_Handler_t *Handler)
     return ADXL345_FAIL;
 
   ADXL345_SetAddressI2C(Handler, 0);
+  Handler->Mux = NULL;
+  Handler->MuxChannel = 0;
+  memset(&Handler->Stats, 0, sizeof(Handler->Stats));
 
   if (Handler->PlatformI2CInit() != 0)
     return ADXL345_FAIL;
@@ -1037,12 +1544,19 @@ ADXL345_Result_t
 ADXL345_DeInit(ADXL345_Handler_t *Handler)
 {
   ADXL345_PowerControl_t PowerControl;
+  ADXL345_Result_t Result = ADXL345_OK;
 
-  if (ADXL345_Get_PowerControl(Handler, &PowerControl) != ADXL345_OK)
-    return ADXL345_FAIL;
-  PowerControl.Sleep = 1;
-  PowerControl.Measure = 0;
-  if (ADXL345_Set_PowerControl(Handler, &PowerControl) != ADXL345_OK)
+  ADXL345_Lock(Handler);
+  Result = ADXL345_Get_PowerControl_NoLock(Handler, &PowerControl);
+  if (Result == ADXL345_OK)
+  {
+    PowerControl.Sleep = 1;
+    PowerControl.Measure = 0;
+    Result = ADXL345_Set_PowerControl_NoLock(Handler, &PowerControl);
+  }
+  ADXL345_Unlock(Handler);
+
+  if (Result != ADXL345_OK)
     return ADXL345_FAIL;
 
   if (Handler->PlatformI2CDeInit() != 0)
@@ -1073,6 +1587,81 @@ ADXL345_SetAddressI2C(ADXL345_Handler_t *Handler, uint8_t Address)
   return ADXL345_OK;
 }
 
+/**
+ * @brief  Initialize I2C multiplexer
+ * @param  Mux: Pointer to mux
+ * @param  AddressI2C: Address of the mux (0x70 to 0x77 for TCA9548A)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid address.
+ */
+ADXL345_Result_t
+ADXL345_Mux_Init(ADXL345_Mux_t *Mux, uint8_t AddressI2C)
+{
+  if (AddressI2C > 127)
+    return ADXL345_INVALID_PARAM;
+
+  memset(Mux, 0, sizeof(ADXL345_Mux_t));
+  Mux->AddressI2C = AddressI2C;
+  Mux->Channel = ADXL345_MUX_CHANNEL_NONE;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Put the device behind a channel of an I2C multiplexer
+ * @param  Handler: Pointer to handler
+ * @param  Mux: Pointer to mux. NULL to access the device directly.
+ * @param  Channel: Mux channel of the device (0 to 7)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid channel.
+ */
+ADXL345_Result_t
+ADXL345_SetMux(ADXL345_Handler_t *Handler, ADXL345_Mux_t *Mux, uint8_t Channel)
+{
+  if (Channel > 7)
+    return ADXL345_INVALID_PARAM;
+
+  Handler->Mux = Mux;
+  Handler->MuxChannel = Channel;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Select the mux channel of the device if it is not selected
+ * @param  Handler: Pointer to handler
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send data.
+ */
+ADXL345_Result_t
+ADXL345_Mux_Select(ADXL345_Handler_t *Handler)
+{
+  ADXL345_Result_t Result = ADXL345_OK;
+
+  ADXL345_Lock(Handler);
+  Result = ADXL345_Mux_SelectNoLock(Handler);
+  ADXL345_Unlock(Handler);
+
+  return Result;
+}
+
+/**
+ * @brief  Check if accessing the device needs a mux channel switch
+ * @param  Handler: Pointer to handler
+ * @retval 1 if a switch is needed, otherwise 0
+ */
+uint8_t
+ADXL345_Mux_NeedSwitch(ADXL345_Handler_t *Handler)
+{
+  if (!Handler->Mux)
+    return 0;
+
+  return (Handler->Mux->Channel != Handler->MuxChannel) ? 1 : 0;
+}
+
 
 /**
  * @brief  Check the DEVID register to ensure the correctness of the connection
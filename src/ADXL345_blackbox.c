@@ -0,0 +1,388 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_blackbox.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 crash-safe black-box recorder on a memory-mapped circular file (POSIX)
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Feature Test Macros ----------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+
+/* Includes ---------------------------------------------------------------------*/
+#include "ADXL345_blackbox.h"
+#include "ADXL345_log.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define ADXL345_BLACKBOX_MAGIC          "AXBB"
+#define ADXL345_BLACKBOX_VERSION        1
+#define ADXL345_BLACKBOX_SLOT_MAGIC0    0xB5
+#define ADXL345_BLACKBOX_SLOT_MAGIC1    0x7E
+#define ADXL345_BLACKBOX_SLOT_HEADER    16
+#define ADXL345_BLACKBOX_SLOT_CRC       (ADXL345_BLACKBOX_SLOT_LEN - 2)
+
+
+
+/* Private Macro ----------------------------------------------------------------*/
+#define ADXL345_BLACKBOX_SLOT(Box, Seq) \
+  ((Box)->Map + ADXL345_BLACKBOX_HEADER_LEN + \
+   (uint64_t)((Seq) % (Box)->Slots) * ADXL345_BLACKBOX_SLOT_LEN)
+
+// Wrap-around safe sequence comparison
+#define ADXL345_BLACKBOX_AFTER(a, b)  ((int32_t)((a) - (b)) > 0)
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static uint32_t
+ADXL345_Blackbox_Get32(const uint8_t *Data)
+{
+  return (uint32_t)Data[0] | ((uint32_t)Data[1] << 8) |
+         ((uint32_t)Data[2] << 16) | ((uint32_t)Data[3] << 24);
+}
+
+static void
+ADXL345_Blackbox_Put32(uint8_t *Data, uint32_t Value)
+{
+  Data[0] = (uint8_t)Value;
+  Data[1] = (uint8_t)(Value >> 8);
+  Data[2] = (uint8_t)(Value >> 16);
+  Data[3] = (uint8_t)(Value >> 24);
+}
+
+static uint8_t
+ADXL345_Blackbox_HasRecord(const uint8_t *Slot)
+{
+  return (Slot[0] == ADXL345_BLACKBOX_SLOT_MAGIC0 &&
+          Slot[1] == ADXL345_BLACKBOX_SLOT_MAGIC1 &&
+          Slot[2] && Slot[2] <= ADXL345_BLACKBOX_MAX_ENTRIES) ? 1 : 0;
+}
+
+static uint8_t
+ADXL345_Blackbox_Valid(ADXL345_Blackbox_t *Box, uint32_t Sequence)
+{
+  const uint8_t *Slot = ADXL345_BLACKBOX_SLOT(Box, Sequence);
+  uint16_t Crc = 0;
+
+  if (!ADXL345_Blackbox_HasRecord(Slot) ||
+      ADXL345_Blackbox_Get32(&Slot[4]) != Sequence)
+    return 0;
+
+  Crc = (uint16_t)(Slot[ADXL345_BLACKBOX_SLOT_CRC] |
+                   (Slot[ADXL345_BLACKBOX_SLOT_CRC + 1] << 8));
+
+  return (Crc == ADXL345_Log_Crc16(Slot, ADXL345_BLACKBOX_SLOT_HEADER +
+                                          6 * (uint32_t)Slot[2])) ? 1 : 0;
+}
+
+static void
+ADXL345_Blackbox_Recover(ADXL345_Blackbox_t *Box)
+{
+  const uint8_t *Slot = NULL;
+  uint32_t Newest = 0;
+  uint32_t Sequence = 0;
+  uint32_t Damaged = 0;
+  uint8_t Found = 0;
+  uint32_t i = 0;
+
+  Box->Empty = 1;
+  Box->Next = 0;
+
+  // Newest record by headers only. Record N can only be in slot N % Slots.
+  for (i = 0; i < Box->Slots; i++)
+  {
+    Slot = Box->Map + ADXL345_BLACKBOX_HEADER_LEN +
+           (uint64_t)i * ADXL345_BLACKBOX_SLOT_LEN;
+    if (!ADXL345_Blackbox_HasRecord(Slot))
+      continue;
+
+    Sequence = ADXL345_Blackbox_Get32(&Slot[4]);
+    if (Sequence % Box->Slots != i)
+      continue;
+
+    if (!Found || ADXL345_BLACKBOX_AFTER(Sequence, Newest))
+      Newest = Sequence;
+    Found = 1;
+  }
+
+  if (!Found)
+    return;
+
+  // New records never reuse a number seen in the file
+  Box->Next = Newest + 1;
+
+  // Check CRCs of the window from the newest record back. Damaged records
+  // are counted only between the newest and the oldest valid ones.
+  for (i = 0; i < Box->Slots; i++)
+  {
+    Sequence = Newest - i;
+    if (!ADXL345_Blackbox_Valid(Box, Sequence))
+    {
+      if (!Box->Empty)
+        Damaged++;
+      continue;
+    }
+
+    if (Box->Empty)
+      Box->Head = Sequence;
+    Box->Tail = Sequence;
+    Box->Empty = 0;
+    Box->Stats.Recovered++;
+    Box->Stats.Invalid += Damaged;
+    Damaged = 0;
+  }
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                            
+ ==================================================================================
+ */
+
+/**
+ * @brief  Open or create a black-box file and recover its records
+ * @note   A file of another slot count is cleared.
+ * @param  Box: Pointer to recorder
+ * @param  Path: Path of the file
+ * @param  Slots: Number of records kept (>= 2)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to create or map the file.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Blackbox_Open(ADXL345_Blackbox_t *Box, const char *Path,
+                      uint32_t Slots)
+{
+  struct stat Stat;
+  uint64_t Size = 0;
+  uint8_t Fresh = 0;
+  void *Map = NULL;
+
+  if (!Box || !Path || Slots < 2)
+    return ADXL345_INVALID_PARAM;
+
+  memset(Box, 0, sizeof(ADXL345_Blackbox_t));
+  Box->Slots = Slots;
+  Box->Empty = 1;
+  Size = ADXL345_BLACKBOX_HEADER_LEN + (uint64_t)Slots * ADXL345_BLACKBOX_SLOT_LEN;
+
+  Box->Fd = open(Path, O_RDWR | O_CREAT, 0644);
+  if (Box->Fd < 0)
+    return ADXL345_FAIL;
+
+  if (fstat(Box->Fd, &Stat) != 0)
+  {
+    close(Box->Fd);
+    return ADXL345_FAIL;
+  }
+
+  if ((uint64_t)Stat.st_size != Size)
+  {
+    // Truncating first zeroes every slot
+    if (ftruncate(Box->Fd, 0) != 0 || ftruncate(Box->Fd, (off_t)Size) != 0)
+    {
+      close(Box->Fd);
+      return ADXL345_FAIL;
+    }
+    Fresh = 1;
+  }
+
+  Map = mmap(NULL, (size_t)Size, PROT_READ | PROT_WRITE, MAP_SHARED, Box->Fd, 0);
+  if (Map == MAP_FAILED)
+  {
+    close(Box->Fd);
+    return ADXL345_FAIL;
+  }
+  Box->Map = (uint8_t *)Map;
+  Box->Size = Size;
+
+  if (!Fresh &&
+      (memcmp(Box->Map, ADXL345_BLACKBOX_MAGIC, 4) != 0 ||
+       Box->Map[4] != ADXL345_BLACKBOX_VERSION ||
+       ADXL345_Blackbox_Get32(&Box->Map[8]) != Slots))
+  {
+    memset(Box->Map, 0, (size_t)Size);
+    Fresh = 1;
+  }
+
+  if (Fresh)
+  {
+    memcpy(Box->Map, ADXL345_BLACKBOX_MAGIC, 4);
+    Box->Map[4] = ADXL345_BLACKBOX_VERSION;
+    ADXL345_Blackbox_Put32(&Box->Map[8], Slots);
+    return ADXL345_OK;
+  }
+
+  ADXL345_Blackbox_Recover(Box);
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Unmap and close the file
+ * @note   Data is written back by the kernel. No sync is forced.
+ * @param  Box: Pointer to recorder
+ * @retval None
+ */
+void
+ADXL345_Blackbox_Close(ADXL345_Blackbox_t *Box)
+{
+  if (Box->Map)
+    munmap(Box->Map, (size_t)Box->Size);
+  if (Box->Fd >= 0)
+    close(Box->Fd);
+
+  Box->Map = NULL;
+  Box->Fd = -1;
+}
+
+/**
+ * @brief  Append a raw FIFO burst
+ * @note   Only memory is written, there is no system call on this path.
+ *         The oldest record is overwritten when the file is full.
+ * @param  Box: Pointer to recorder
+ * @param  DataFormat: Data format the burst was read with
+ * @param  Raw: Raw FIFO entries (6 bytes each, as by ADXL345_ReadRawSamples)
+ * @param  Entries: Number of entries (1..ADXL345_BLACKBOX_MAX_ENTRIES)
+ * @param  Gap: Samples lost right before the burst
+ * @param  TimestampUs: Timestamp of the first entry
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Blackbox_Append(ADXL345_Blackbox_t *Box,
+                        const ADXL345_DataFormat_t *DataFormat,
+                        const uint8_t *Raw, uint8_t Entries,
+                        uint32_t Gap, uint32_t TimestampUs)
+{
+  uint32_t Sequence = Box->Next;
+  uint8_t *Slot = NULL;
+  uint16_t Crc = 0;
+
+  if (!Box->Map || !DataFormat || !Raw ||
+      !Entries || Entries > ADXL345_BLACKBOX_MAX_ENTRIES)
+    return ADXL345_INVALID_PARAM;
+
+  Slot = ADXL345_BLACKBOX_SLOT(Box, Sequence);
+
+  // Body first and CRC last. A record cut by a crash fails its CRC.
+  memcpy(&Slot[ADXL345_BLACKBOX_SLOT_HEADER], Raw, 6 * (size_t)Entries);
+  Slot[0] = ADXL345_BLACKBOX_SLOT_MAGIC0;
+  Slot[1] = ADXL345_BLACKBOX_SLOT_MAGIC1;
+  Slot[2] = Entries;
+  Slot[3] = (uint8_t)((DataFormat->Range & 0x03) |
+                      (DataFormat->JustifyLeft ? 0x04 : 0) |
+                      (DataFormat->FullResolution ? 0x08 : 0));
+  ADXL345_Blackbox_Put32(&Slot[4], Sequence);
+  ADXL345_Blackbox_Put32(&Slot[8], TimestampUs);
+  ADXL345_Blackbox_Put32(&Slot[12], Gap);
+  Crc = ADXL345_Log_Crc16(Slot,
+                          ADXL345_BLACKBOX_SLOT_HEADER + 6 * (uint32_t)Entries);
+  Slot[ADXL345_BLACKBOX_SLOT_CRC] = (uint8_t)Crc;
+  Slot[ADXL345_BLACKBOX_SLOT_CRC + 1] = (uint8_t)(Crc >> 8);
+
+  Box->Next = Sequence + 1;
+  Box->Head = Sequence;
+  if (Box->Empty)
+    Box->Tail = Sequence;
+  else if (Box->Head - Box->Tail >= Box->Slots)
+    Box->Tail = Box->Head - (Box->Slots - 1);
+  Box->Empty = 0;
+  Box->Stats.Appended++;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Read a record
+ * @param  Box: Pointer to recorder
+ * @param  Sequence: Sequence number of the record (Tail..Head)
+ * @param  Record: Pointer to record
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Record is overwritten or damaged.
+ */
+ADXL345_Result_t
+ADXL345_Blackbox_Read(ADXL345_Blackbox_t *Box, uint32_t Sequence,
+                      ADXL345_BlackboxRecord_t *Record)
+{
+  const uint8_t *Slot = NULL;
+
+  if (!Box->Map || Box->Empty ||
+      ADXL345_BLACKBOX_AFTER(Box->Tail, Sequence) ||
+      ADXL345_BLACKBOX_AFTER(Sequence, Box->Head) ||
+      !ADXL345_Blackbox_Valid(Box, Sequence))
+    return ADXL345_FAIL;
+
+  Slot = ADXL345_BLACKBOX_SLOT(Box, Sequence);
+  Record->Sequence = Sequence;
+  Record->Entries = Slot[2];
+  Record->DataFormat.Range = (ADXL345_Range_t)(Slot[3] & 0x03);
+  Record->DataFormat.JustifyLeft = (Slot[3] & 0x04) ? 1 : 0;
+  Record->DataFormat.FullResolution = (Slot[3] & 0x08) ? 1 : 0;
+  Record->TimestampUs = ADXL345_Blackbox_Get32(&Slot[8]);
+  Record->Gap = ADXL345_Blackbox_Get32(&Slot[12]);
+  Record->Raw = &Slot[ADXL345_BLACKBOX_SLOT_HEADER];
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Ask the kernel to write back the file
+ * @note   Call it from a slow path (e.g. once a second) to bound the data
+ *         lost on power failure.
+ * @param  Box: Pointer to recorder
+ * @param  Wait: 1 to wait until data is on the disk
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to sync.
+ */
+ADXL345_Result_t
+ADXL345_Blackbox_Sync(ADXL345_Blackbox_t *Box, uint8_t Wait)
+{
+  if (!Box->Map)
+    return ADXL345_FAIL;
+
+  if (msync(Box->Map, (size_t)Box->Size, Wait ? MS_SYNC : MS_ASYNC) != 0)
+    return ADXL345_FAIL;
+
+  return ADXL345_OK;
+}
@@ -0,0 +1,622 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_capture.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 trigger mode event capture
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include "ADXL345_capture.h"
+#include <string.h>
+
+
+
+/* Private Constants ------------------------------------------------------------*/
+/**
+ * @brief  Capture engine states
+ */
+#define ADXL345_CAPTURE_STATE_IDLE    0
+#define ADXL345_CAPTURE_STATE_ARMED   1
+#define ADXL345_CAPTURE_STATE_POST    2
+
+
+/* Private Macro ----------------------------------------------------------------*/
+#ifndef MIN
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * Returns 1 if the pre-trigger part is longer than the entries FIFO keeps at
+ * the trigger, so FIFO is drained into the history while armed
+ */
+static uint8_t
+ADXL345_Capture_UsesHistory(ADXL345_Capture_t *Capture)
+{
+  return Capture->Config.PreSamples > Capture->Config.FifoSamples;
+}
+
+static ADXL345_Result_t
+ADXL345_Capture_SetFifo(ADXL345_Capture_t *Capture)
+{
+  ADXL345_FifoConfig_t FifoConfig = {0};
+
+  // Going through bypass mode flushes FIFO and clears the trigger
+  FifoConfig.Mode = ADXL345_MODE_BYPASS;
+  if (ADXL345_Set_FifoConfig(Capture->Handler, &FifoConfig) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  FifoConfig.Mode = ADXL345_MODE_TRIGGER;
+  FifoConfig.Trigger = Capture->Config.Pin;
+  // In trigger mode the samples bits are both the entries kept at the
+  // trigger and the watermark
+  FifoConfig.WatermarkSamples = Capture->Config.FifoSamples;
+
+  return ADXL345_Set_FifoConfig(Capture->Handler, &FifoConfig);
+}
+
+static ADXL345_Result_t
+ADXL345_Capture_SetInterrupts(ADXL345_Capture_t *Capture, uint8_t Enable)
+{
+  ADXL345_InterruptConfig_t InterruptConfig;
+  ADXL345_InterruptReg_t *Events = &Capture->Config.Events;
+  uint8_t Pin = (Capture->Config.Pin == ADXL345_INTERRUPT_PIN2);
+  uint8_t Fifo = 0;
+
+  if (ADXL345_Get_InterruptConfig(Capture->Handler,
+                                  &InterruptConfig) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  // Without history FIFO runs as a ring until the trigger, so watermark and
+  // overrun are needed after it only
+  Fifo = Enable && (ADXL345_Capture_UsesHistory(Capture) ||
+                    Capture->State == ADXL345_CAPTURE_STATE_POST);
+  InterruptConfig.Enable.Overrun = Fifo;
+  InterruptConfig.Enable.Watermark = Fifo;
+  InterruptConfig.Map.Overrun = Pin;
+  InterruptConfig.Map.Watermark = Pin;
+
+  // Trigger events must be routed to the trigger pin
+  if (Events->FreeFall)
+  {
+    InterruptConfig.Enable.FreeFall = Enable ? 1 : 0;
+    InterruptConfig.Map.FreeFall = Pin;
+  }
+  if (Events->Activity)
+  {
+    InterruptConfig.Enable.Activity = Enable ? 1 : 0;
+    InterruptConfig.Map.Activity = Pin;
+  }
+  if (Events->DoubleTap)
+  {
+    InterruptConfig.Enable.DoubleTap = Enable ? 1 : 0;
+    InterruptConfig.Map.DoubleTap = Pin;
+  }
+  if (Events->SingleTap)
+  {
+    InterruptConfig.Enable.SingleTap = Enable ? 1 : 0;
+    InterruptConfig.Map.SingleTap = Pin;
+  }
+
+  return ADXL345_Set_InterruptConfig(Capture->Handler, &InterruptConfig);
+}
+
+static ADXL345_Result_t
+ADXL345_Capture_SetFifoInterrupts(ADXL345_Capture_t *Capture, uint8_t Enable)
+{
+  ADXL345_InterruptConfig_t InterruptConfig;
+
+  if (ADXL345_Get_InterruptConfig(Capture->Handler,
+                                  &InterruptConfig) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  if (InterruptConfig.Enable.Watermark == Enable)
+    return ADXL345_OK;
+
+  InterruptConfig.Enable.Overrun = Enable;
+  InterruptConfig.Enable.Watermark = Enable;
+
+  return ADXL345_Set_InterruptConfig(Capture->Handler, &InterruptConfig);
+}
+
+static ADXL345_Result_t
+ADXL345_Capture_SetMeasure(ADXL345_Capture_t *Capture, uint8_t Measure)
+{
+  ADXL345_PowerControl_t PowerControl;
+
+  if (ADXL345_Get_PowerControl(Capture->Handler, &PowerControl) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  PowerControl.Measure = Measure ? 1 : 0;
+  if (Measure)
+    PowerControl.Sleep = 0;
+
+  return ADXL345_Set_PowerControl(Capture->Handler, &PowerControl);
+}
+
+/**
+ * @brief  Read up to MaxEntries FIFO entries
+ */
+static ADXL345_Result_t
+ADXL345_Capture_ReadFifo(ADXL345_Capture_t *Capture, uint8_t *Raw,
+                         uint16_t MaxEntries, uint8_t *Count)
+{
+  ADXL345_FifoStatus_t FifoStatus;
+
+  *Count = 0;
+
+  if (ADXL345_Get_FifoStatus(Capture->Handler, &FifoStatus) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  *Count = (uint8_t)MIN(FifoStatus.Entries, MaxEntries);
+
+  return ADXL345_ReadRawSamples(Capture->Handler, Raw, *Count);
+}
+
+/**
+ * @brief  Decode raw samples into history ring
+ */
+static void
+ADXL345_Capture_PushHistory(ADXL345_Capture_t *Capture, uint8_t *Raw,
+                            uint8_t Count)
+{
+  uint16_t Capacity = Capture->Config.PreSamples;
+  uint8_t Done = 0;
+  uint8_t Part = 0;
+
+  if (Capacity == 0)
+    return;
+
+  // Only the newest Capacity samples are kept
+  if (Count > Capacity)
+  {
+    Done = Count - Capacity;
+    Count = Capacity;
+  }
+
+  while (Count)
+  {
+    Part = MIN(Count, Capacity - Capture->HistoryHead);
+    ADXL345_DecodeSamples(&Capture->DataFormat, Raw + 6 * Done,
+                          &Capture->History[Capture->HistoryHead], Part);
+
+    Capture->HistoryHead += Part;
+    if (Capture->HistoryHead == Capacity)
+      Capture->HistoryHead = 0;
+
+    Capture->HistoryCount = MIN(Capture->HistoryCount + Part, Capacity);
+    Done += Part;
+    Count -= Part;
+  }
+}
+
+/**
+ * @brief  Drain FIFO into post-trigger part of the window
+ */
+static ADXL345_Result_t
+ADXL345_Capture_DrainPost(ADXL345_Capture_t *Capture)
+{
+  uint8_t Raw[ADXL345_FIFO_SIZE * 6];
+  ADXL345_CaptureWindow_t *Window = &Capture->Window;
+  uint16_t Needed = Capture->Config.PostSamples - Window->PostCount;
+  uint8_t Count = 0;
+
+  if (ADXL345_Capture_ReadFifo(Capture, Raw, Needed, &Count) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  ADXL345_DecodeSamples(&Capture->DataFormat, Raw,
+                        &Window->Samples[Window->PreCount + Window->PostCount],
+                        Count);
+
+  Window->PostCount += Count;
+  Capture->Sequence += Count;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Copy the history ring into the pre-trigger part of the window
+ */
+static void
+ADXL345_Capture_OpenWindow(ADXL345_Capture_t *Capture,
+                           ADXL345_InterruptReg_t *Source, uint32_t TriggerUs)
+{
+  ADXL345_CaptureWindow_t *Window = &Capture->Window;
+  uint32_t PeriodUs = ADXL345_ConvToData_RatePeriodUs(Capture->Config.Rate);
+  uint16_t Capacity = Capture->Config.PreSamples;
+  uint16_t Start = 0;
+  uint16_t Part = 0;
+
+  memset(Window, 0, sizeof(ADXL345_CaptureWindow_t));
+  Window->Samples = Capture->Buffer;
+  Window->Source = *Source;
+  Window->PreCount = Capture->HistoryCount;
+  Window->Sequence = Capture->Sequence - Window->PreCount;
+  // The sample that fired the trigger is the last pre-trigger sample
+  Window->TriggerTimestampUs = TriggerUs;
+  Window->TimestampUs = TriggerUs + PeriodUs -
+                        (uint32_t)Window->PreCount * PeriodUs;
+
+  if (Window->PreCount == 0)
+    return;
+
+  Start = (Capture->HistoryHead + Capacity - Capture->HistoryCount) % Capacity;
+  Part = MIN(Window->PreCount, Capacity - Start);
+  memcpy(&Window->Samples[0], &Capture->History[Start],
+         Part * sizeof(ADXL345_Sample_t));
+  memcpy(&Window->Samples[Part], &Capture->History[0],
+         (Window->PreCount - Part) * sizeof(ADXL345_Sample_t));
+}
+
+/**
+ * @brief  Flush FIFO and arm trigger mode again
+ */
+static ADXL345_Result_t
+ADXL345_Capture_Rearm(ADXL345_Capture_t *Capture)
+{
+  // Samples flushed by bypass mode break the history continuity
+  Capture->HistoryHead = 0;
+  Capture->HistoryCount = 0;
+
+  if (!ADXL345_Capture_UsesHistory(Capture) &&
+      Capture->State == ADXL345_CAPTURE_STATE_POST &&
+      ADXL345_Capture_SetFifoInterrupts(Capture, 0) != ADXL345_OK)
+    return ADXL345_FAIL;
+  Capture->State = ADXL345_CAPTURE_STATE_ARMED;
+
+  if (ADXL345_Capture_SetFifo(Capture) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  if (Capture->GetTimeUs)
+    Capture->EmptyUs = Capture->GetTimeUs();
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Drain FIFO while armed and open the window on trigger
+ */
+static ADXL345_Result_t
+ADXL345_Capture_Armed(ADXL345_Capture_t *Capture,
+                      ADXL345_InterruptReg_t *Source, uint32_t InterruptUs)
+{
+  uint8_t Raw[ADXL345_FIFO_SIZE * 6];
+  ADXL345_FifoStatus_t FifoStatus;
+  ADXL345_CaptureWindow_t *Window = &Capture->Window;
+  uint32_t PeriodUs = ADXL345_ConvToData_RatePeriodUs(Capture->Config.Rate);
+  uint8_t Retained = Capture->Config.FifoSamples;
+  uint32_t StatusUs = 0;
+  uint32_t Post = 0;
+  uint8_t Entries = 0;
+  uint8_t Pre = 0;
+
+  if (ADXL345_Get_FifoStatus(Capture->Handler, &FifoStatus) != ADXL345_OK)
+    return ADXL345_FAIL;
+  if (Capture->GetTimeUs)
+    StatusUs = Capture->GetTimeUs();
+  Entries = FifoStatus.Entries;
+
+  // FIFO_TRIG is set by the device, so it also covers a trigger that came
+  // after INT_SOURCE was read
+  if (!FifoStatus.Trigger)
+  {
+    if (!ADXL345_Capture_UsesHistory(Capture))
+      return ADXL345_OK;
+
+    if (ADXL345_ReadRawSamples(Capture->Handler, Raw, Entries) != ADXL345_OK)
+      return ADXL345_FAIL;
+    Capture->Sequence += Entries;
+    Capture->EmptyUs = StatusUs;
+    ADXL345_Capture_PushHistory(Capture, Raw, Entries);
+    return ADXL345_OK;
+  }
+
+  if (Capture->Ready)
+  {
+    // Window buffer is still in use. Re-arming flushes FIFO, so the history
+    // starts over.
+    Capture->Stats.MissedTriggers++;
+    return ADXL345_Capture_Rearm(Capture);
+  }
+
+  // FIFO holds up to Retained entries from before the trigger, the one that
+  // fired it last, followed by the samples that came after the interrupt
+  if (Capture->GetTimeUs && (int32_t)(StatusUs - InterruptUs) > 0)
+    Post = (uint32_t)((uint64_t)(StatusUs - InterruptUs) *
+                      ADXL345_ConvToData_RateMilliHz(Capture->Config.Rate) /
+                      1000000000ULL);
+  Pre = (uint8_t)MIN(Entries - MIN(Post, Entries), Retained);
+
+  // FIFO stops collecting when full, so later samples were dropped
+  if (Post > (uint32_t)(Entries - Pre))
+    Capture->Stats.Overruns++;
+
+  // With more than Retained entries at the trigger, the device dropped the
+  // oldest ones, which came right after the history. The ODR can be a few
+  // percent off, so the limit is taken 1/8 period early.
+  if (Capture->GetTimeUs && Pre == Retained &&
+      InterruptUs - Capture->EmptyUs + PeriodUs / 8 >= Retained * PeriodUs)
+    Capture->HistoryCount = 0;
+
+  if (ADXL345_ReadRawSamples(Capture->Handler, Raw, Entries) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  ADXL345_Capture_PushHistory(Capture, Raw, Pre);
+  Capture->Sequence += Pre;
+  ADXL345_Capture_OpenWindow(Capture, Source, InterruptUs);
+
+  Window->PostCount = (uint16_t)MIN(Entries - Pre, Capture->Config.PostSamples);
+  ADXL345_DecodeSamples(&Capture->DataFormat, Raw + 6 * Pre,
+                        &Window->Samples[Window->PreCount], Window->PostCount);
+  Capture->Sequence += Entries - Pre;
+  Capture->State = ADXL345_CAPTURE_STATE_POST;
+
+  if (Window->PostCount == Capture->Config.PostSamples)
+  {
+    Capture->Ready = 1;
+    return ADXL345_Capture_Rearm(Capture);
+  }
+
+  if (ADXL345_Capture_UsesHistory(Capture))
+    return ADXL345_OK;
+
+  return ADXL345_Capture_SetFifoInterrupts(Capture, 1);
+}
+
+static void
+ADXL345_Capture_Forward(ADXL345_Capture_t *Capture,
+                        ADXL345_InterruptReg_t *Interrupt)
+{
+  ADXL345_Handler_t *Handler = Capture->Handler;
+  ADXL345_InterruptReg_t *Events = &Capture->Config.Events;
+
+  if (Handler->InterruptCallback == NULL)
+    return;
+
+  if (Interrupt->FreeFall && !Events->FreeFall)
+    Handler->InterruptCallback(ADXL345_INTERRUPT_FREE_FALL);
+  if (Interrupt->Inactivity)
+    Handler->InterruptCallback(ADXL345_INTERRUPT_INACTIVITY);
+  if (Interrupt->Activity && !Events->Activity)
+    Handler->InterruptCallback(ADXL345_INTERRUPT_ACTIVITY);
+  if (Interrupt->DoubleTap && !Events->DoubleTap)
+    Handler->InterruptCallback(ADXL345_INTERRUPT_DOUBLE_TAP);
+  if (Interrupt->SingleTap && !Events->SingleTap)
+    Handler->InterruptCallback(ADXL345_INTERRUPT_SINGLE_TAP);
+  if (Interrupt->DataReady)
+    Handler->InterruptCallback(ADXL345_INTERRUPT_DATA_READY);
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize capture engine
+ * @param  Capture: Pointer to capture engine
+ * @param  Handler: Pointer to initialized handler
+ * @param  Config: Pointer to capture configuration
+ * @param  History: Pointer to history array with Config->PreSamples capacity.
+ *                  It can be NULL if PreSamples is 0.
+ * @param  Buffer: Pointer to window array with
+ *                 Config->PreSamples + Config->PostSamples capacity
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid configuration.
+ */
+ADXL345_Result_t
+ADXL345_Capture_Init(ADXL345_Capture_t *Capture, ADXL345_Handler_t *Handler,
+                     ADXL345_CaptureConfig_t *Config,
+                     ADXL345_Sample_t *History, ADXL345_Sample_t *Buffer)
+{
+  if ((Config->FifoSamples == 0) || (Config->FifoSamples > 31))
+    return ADXL345_INVALID_PARAM;
+
+  // When FIFO is drained into history, FifoSamples is the watermark and must
+  // leave room in FIFO for the service latency
+  if ((Config->PreSamples > Config->FifoSamples) &&
+      (Config->FifoSamples > ADXL345_FIFO_SIZE / 2))
+    return ADXL345_INVALID_PARAM;
+
+  if ((Config->PostSamples == 0) || (Buffer == NULL))
+    return ADXL345_INVALID_PARAM;
+
+  if (Config->PreSamples && (History == NULL))
+    return ADXL345_INVALID_PARAM;
+
+  memset(Capture, 0, sizeof(ADXL345_Capture_t));
+  Capture->Handler = Handler;
+  Capture->Config = *Config;
+  Capture->History = History;
+  Capture->Buffer = Buffer;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Configure the device and arm trigger mode
+ * @param  Capture: Pointer to capture engine
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ *         - ADXL345_INVALID_PARAM: Callback is not set.
+ */
+ADXL345_Result_t
+ADXL345_Capture_Start(ADXL345_Capture_t *Capture)
+{
+  if (Capture->Callback == NULL)
+    return ADXL345_INVALID_PARAM;
+
+  Capture->State = ADXL345_CAPTURE_STATE_IDLE;
+  Capture->Ready = 0;
+
+  if (ADXL345_Capture_SetMeasure(Capture, 0) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  if (ADXL345_Set_Rate(Capture->Handler, Capture->Config.Rate) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  memset(&Capture->DataFormat, 0, sizeof(ADXL345_DataFormat_t));
+  Capture->DataFormat.Range = Capture->Config.Range;
+  Capture->DataFormat.FullResolution = Capture->Config.FullResolution ? 1 : 0;
+  if (ADXL345_Set_DataFormat(Capture->Handler,
+                             &Capture->DataFormat) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  if (ADXL345_Capture_Rearm(Capture) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  if (ADXL345_Capture_SetInterrupts(Capture, 1) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  return ADXL345_Capture_SetMeasure(Capture, 1);
+}
+
+/**
+ * @brief  Stop capturing
+ * @param  Capture: Pointer to capture engine
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Capture_Stop(ADXL345_Capture_t *Capture)
+{
+  Capture->State = ADXL345_CAPTURE_STATE_IDLE;
+
+  if (ADXL345_Capture_SetMeasure(Capture, 0) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  return ADXL345_Capture_SetInterrupts(Capture, 0);
+}
+
+/**
+ * @brief  Capture IRQ Handler
+ * @param  Capture: Pointer to capture engine
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Capture_IRQ(ADXL345_Capture_t *Capture)
+{
+  uint32_t InterruptUs = 0;
+
+  if (Capture->GetTimeUs)
+    InterruptUs = Capture->GetTimeUs();
+
+  return ADXL345_Capture_IRQAt(Capture, InterruptUs);
+}
+
+/**
+ * @brief  Capture IRQ Handler with the time of the interrupt
+ * @param  Capture: Pointer to capture engine
+ * @param  InterruptUs: Time the interrupt was raised in us (same clock as
+ *                      GetTimeUs)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Capture_IRQAt(ADXL345_Capture_t *Capture, uint32_t InterruptUs)
+{
+  ADXL345_InterruptReg_t Source;
+  ADXL345_Result_t Result = ADXL345_OK;
+
+  if (ADXL345_Get_InterruptSource(Capture->Handler, &Source) != ADXL345_OK)
+  {
+    Capture->Stats.BusErrors++;
+    return ADXL345_FAIL;
+  }
+
+  // Without history FIFO overruns as a ring while armed, which loses nothing
+  if (Source.Overrun && (ADXL345_Capture_UsesHistory(Capture) ||
+                         Capture->State != ADXL345_CAPTURE_STATE_ARMED))
+  {
+    Capture->Stats.Overruns++;
+    // The oldest entries are gone, so the history is not contiguous
+    if (Capture->State == ADXL345_CAPTURE_STATE_ARMED)
+      Capture->HistoryCount = 0;
+  }
+
+  switch (Capture->State)
+  {
+  case ADXL345_CAPTURE_STATE_ARMED:
+    Result = ADXL345_Capture_Armed(Capture, &Source, InterruptUs);
+    break;
+
+  case ADXL345_CAPTURE_STATE_POST:
+    Result = ADXL345_Capture_DrainPost(Capture);
+    if (Result != ADXL345_OK)
+      break;
+
+    if (Capture->Window.PostCount == Capture->Config.PostSamples)
+    {
+      Capture->Ready = 1;
+      Result = ADXL345_Capture_Rearm(Capture);
+    }
+    break;
+
+  default:
+    break;
+  }
+
+  if (Result != ADXL345_OK)
+    Capture->Stats.BusErrors++;
+
+  ADXL345_Capture_Forward(Capture, &Source);
+
+  return Result;
+}
+
+/**
+ * @brief  Deliver the completed window to Callback
+ * @param  Capture: Pointer to capture engine
+ * @retval 1 if a window was delivered, otherwise 0
+ */
+uint8_t
+ADXL345_Capture_Process(ADXL345_Capture_t *Capture)
+{
+  if (Capture->Ready == 0)
+    return 0;
+
+  Capture->Callback(Capture->Context, &Capture->Window);
+  Capture->Stats.Captures++;
+  Capture->Ready = 0;
+
+  return 1;
+}
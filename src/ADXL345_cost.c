@@ -0,0 +1,308 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_cost.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 bus and energy cost model
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include "ADXL345_cost.h"
+#include <string.h>
+#include <math.h>
+
+
+/* Private Constants ------------------------------------------------------------*/
+// FIFO entries plus the data registers
+#define ADXL345_COST_CAPACITY       ADXL345_FIFO_SIZE
+#define ADXL345_COST_MAX_WATERMARK  31
+// INT_SOURCE, FIFO_STATUS and mux control are single bytes
+#define ADXL345_COST_ENTRY_BYTES    6
+// Bypass reads INT_SOURCE through DATAZ1 in one burst
+#define ADXL345_COST_BYPASS_BYTES   8
+
+
+/* Private Data Types -----------------------------------------------------------*/
+typedef struct ADXL345_CostDrain_s
+{
+  double Entries;       // FIFO entries read
+  double Ns;            // Bus time including host overhead
+  double Transfers;
+  double Bytes;
+  double PeakEntries;   // Stored entries when the first one is read
+} ADXL345_CostDrain_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+// Typical supply current in uA at VS = 2.5 V by rate code (datasheet,
+// current consumption vs. data rate in normal and low power operation)
+static const uint8_t ADXL345_Cost_SupplyUa[16] =
+{
+  23, 23, 23, 23, 34, 40, 45, 50, 60, 90, 140, 140, 140, 140, 90, 140
+};
+
+static const uint8_t ADXL345_Cost_LowPowerSupplyUa[16] =
+{
+  0, 0, 0, 0, 0, 0, 0, 34, 40, 45, 50, 60, 90, 0, 0, 0
+};
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static double
+ADXL345_Cost_TransferNs(const ADXL345_CostConfig_t *Config, uint8_t Bytes)
+{
+  uint32_t Bits = 8 * (uint32_t)Bytes;
+
+  // Start, address byte and data bytes with ACK, stop
+  if (Config->Bus == ADXL345_COST_I2C)
+    Bits = 2 + 9 * (1 + (uint32_t)Bytes);
+
+  return Bits * 1e9 / Config->ClockHz + Config->TransferOverheadUs * 1e3;
+}
+
+static double
+ADXL345_Cost_AccessNs(const ADXL345_CostConfig_t *Config, uint8_t Bytes)
+{
+  if (Config->Bus == ADXL345_COST_SPI)
+    return ADXL345_Cost_TransferNs(Config, 1 + Bytes);
+
+  return ADXL345_Cost_TransferNs(Config, 1) +
+         ADXL345_Cost_TransferNs(Config, Bytes);
+}
+
+/**
+ * Samples keep arriving at ODR after the interrupt. The worst case counts
+ * whole periods of a sensor whose watermark is reached exactly at time 0;
+ * the average uses the fraction.
+ */
+static double
+ADXL345_Cost_Arrived(double Ns, double PeriodNs, uint8_t Worst)
+{
+  return Worst ? floor(Ns / PeriodNs) : Ns / PeriodNs;
+}
+
+static void
+ADXL345_Cost_Drain(const ADXL345_CostConfig_t *Config, double WaitNs,
+                   uint8_t Worst, ADXL345_CostDrain_t *Drain)
+{
+  double PeriodNs = ADXL345_ConvToData_RatePeriodUs(Config->Rate) * 1e3;
+  double RegNs = ADXL345_Cost_AccessNs(Config, 1);
+  double EntryNs = ADXL345_Cost_AccessNs(Config, ADXL345_COST_ENTRY_BYTES);
+  double AccessTransfers = (Config->Bus == ADXL345_COST_SPI) ? 1 : 2;
+  double SelectNs = 0;
+  double StatusNs = 0;
+  double Known = Config->WatermarkSamples;
+  double TopUp = 0;
+
+  // Muxed sensors need a channel switch before each drain
+  if (Config->Bus == ADXL345_COST_I2C && Config->Muxed && Config->Sensors > 1)
+    SelectNs = ADXL345_Cost_TransferNs(Config, 1);
+
+  // Bypass mode reads INT_SOURCE and the data registers in one access, on
+  // DATA_READY
+  if (Config->Mode == ADXL345_MODE_BYPASS)
+  {
+    Drain->Entries = 1;
+    Drain->Ns = SelectNs +
+                ADXL345_Cost_AccessNs(Config, ADXL345_COST_BYPASS_BYTES);
+    Drain->Transfers = AccessTransfers;
+    Drain->Bytes = 1 + ADXL345_COST_BYPASS_BYTES;
+    Drain->PeakEntries = 1 + ADXL345_Cost_Arrived(WaitNs + SelectNs,
+                                                  PeriodNs, Worst);
+    return;
+  }
+
+  // The interrupt is raised when one entry more than the watermark is stored.
+  // Watermark entries are read before FIFO_STATUS, the rest after it.
+  StatusNs = WaitNs + SelectNs + RegNs + Known * EntryNs + RegNs;
+  TopUp = 1 + ADXL345_Cost_Arrived(StatusNs, PeriodNs, Worst);
+  if (TopUp > ADXL345_COST_CAPACITY - Known)
+    TopUp = ADXL345_COST_CAPACITY - Known;
+
+  Drain->Entries = Known + TopUp;
+  Drain->Ns = SelectNs + 2 * RegNs + Drain->Entries * EntryNs;
+  Drain->Transfers = (2 + Drain->Entries) * AccessTransfers;
+  Drain->Bytes = 2 * 2 + Drain->Entries * (1 + ADXL345_COST_ENTRY_BYTES);
+  Drain->PeakEntries = Known + 1 +
+                       ADXL345_Cost_Arrived(WaitNs + SelectNs + RegNs,
+                                            PeriodNs, Worst);
+}
+
+static uint8_t
+ADXL345_Cost_Meets(const ADXL345_CostConfig_t *Config,
+                   const ADXL345_CostLimits_t *Limits, ADXL345_Cost_t *Cost)
+{
+  int16_t MinMargin = Limits->MinMarginSamples;
+
+  // The data registers hold a single sample in bypass mode
+  if (Config->Mode == ADXL345_MODE_BYPASS)
+    MinMargin = 0;
+
+  if (ADXL345_Cost_Estimate(Config, Cost) != ADXL345_OK || !Cost->Feasible)
+    return 0;
+
+  if (Cost->BusUtilisation > Limits->MaxUtilisation ||
+      Cost->MarginSamples < MinMargin)
+    return 0;
+
+  if (Limits->LatencyBudgetUs && Cost->OldestAgeUs > Limits->LatencyBudgetUs)
+    return 0;
+
+  return 1;
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Estimate the bus cost of streaming with a setting
+ * @param  Config: Pointer to configuration
+ * @param  Cost: Pointer to result
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid configuration.
+ */
+ADXL345_Result_t
+ADXL345_Cost_Estimate(const ADXL345_CostConfig_t *Config, ADXL345_Cost_t *Cost)
+{
+  ADXL345_CostDrain_t Drain;
+  double PeriodNs = 0;
+  double OdrHz = 0;
+  double DrainsPerSec = 0;
+  double StartNs = 0;
+  double PeakEntries = 0;
+  uint8_t Capacity = ADXL345_COST_CAPACITY;
+  uint8_t LowPower = (Config->Rate & 0x10) ? 1 : 0;
+  uint8_t i = 0;
+
+  if (Config->Sensors == 0 || Config->ClockHz == 0 ||
+      Config->Mode == ADXL345_MODE_TRIGGER)
+    return ADXL345_INVALID_PARAM;
+
+  if (Config->Mode != ADXL345_MODE_BYPASS &&
+      (Config->WatermarkSamples == 0 ||
+       Config->WatermarkSamples > ADXL345_COST_MAX_WATERMARK))
+    return ADXL345_INVALID_PARAM;
+
+  memset(Cost, 0, sizeof(ADXL345_Cost_t));
+  PeriodNs = ADXL345_ConvToData_RatePeriodUs(Config->Rate) * 1e3;
+  OdrHz = ADXL345_ConvToData_RateMilliHz(Config->Rate) / 1e3;
+
+  // Average: every drain starts after the service latency
+  ADXL345_Cost_Drain(Config, Config->ServiceLatencyUs * 1e3, 0, &Drain);
+  DrainsPerSec = OdrHz / Drain.Entries;
+  Cost->SamplesPerDrain = (float)Drain.Entries;
+  Cost->InterruptsPerSec = (float)(DrainsPerSec * Config->Sensors);
+  Cost->TransfersPerSec = (float)(Cost->InterruptsPerSec * Drain.Transfers);
+  Cost->BytesPerSec = (float)(Cost->InterruptsPerSec * Drain.Bytes);
+  Cost->BusUtilisation = (float)(Cost->InterruptsPerSec * Drain.Ns / 1e9);
+  Cost->DrainUs = (uint32_t)(Drain.Ns / 1e3 + 0.5);
+
+  // Worst case: the last sensor waits for the drains of all others
+  StartNs = Config->ServiceLatencyUs * 1e3;
+  for (i = 0; i < Config->Sensors; i++)
+  {
+    ADXL345_Cost_Drain(Config, StartNs, 1, &Drain);
+    if (Drain.PeakEntries > PeakEntries)
+      PeakEntries = Drain.PeakEntries;
+    StartNs += Drain.Ns;
+  }
+
+  Cost->WorstLatencyUs = (uint32_t)(StartNs / 1e3 + 0.5);
+
+  // The oldest entry was stored Watermark periods before the interrupt
+  if (Config->Mode == ADXL345_MODE_BYPASS)
+    Capacity = 1;
+  else
+    StartNs += Config->WatermarkSamples * PeriodNs;
+
+  Cost->OldestAgeUs = (uint32_t)(StartNs / 1e3 + 0.5);
+  Cost->MarginSamples = (int16_t)(Capacity - (int16_t)PeakEntries);
+  Cost->MarginUs = (int32_t)(Cost->MarginSamples * (PeriodNs / 1e3));
+
+  Cost->SupplyUa = LowPower ? ADXL345_Cost_LowPowerSupplyUa[Config->Rate & 0x0F] :
+                              ADXL345_Cost_SupplyUa[Config->Rate & 0x0F];
+
+  Cost->Feasible = (Cost->MarginSamples >= 0 && Cost->BusUtilisation < 1.0f);
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Find the FIFO mode and watermark with the fewest interrupts that
+ *         meets the limits at Config->Rate
+ * @param  Config: Pointer to configuration
+ * @param  Limits: Pointer to limits
+ * @param  Cost: Pointer to result of the recommended setting
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: No setting meets the limits at this rate.
+ *         - ADXL345_INVALID_PARAM: Invalid configuration.
+ */
+ADXL345_Result_t
+ADXL345_Cost_Recommend(ADXL345_CostConfig_t *Config,
+                       const ADXL345_CostLimits_t *Limits,
+                       ADXL345_Cost_t *Cost)
+{
+  ADXL345_CostConfig_t Candidate = *Config;
+  uint8_t Watermark = 0;
+
+  Candidate.WatermarkSamples = 1;
+  if (Config->Mode != ADXL345_MODE_FIFO)
+    Candidate.Mode = ADXL345_MODE_STREAM;
+  if (ADXL345_Cost_Estimate(&Candidate, Cost) != ADXL345_OK)
+    return ADXL345_INVALID_PARAM;
+
+  // Interrupt rate falls with the watermark, margin and latency get worse
+  for (Watermark = ADXL345_COST_MAX_WATERMARK; Watermark > 0; Watermark--)
+  {
+    Candidate.WatermarkSamples = Watermark;
+    if (ADXL345_Cost_Meets(&Candidate, Limits, Cost))
+    {
+      *Config = Candidate;
+      return ADXL345_OK;
+    }
+  }
+
+  Candidate.Mode = ADXL345_MODE_BYPASS;
+  if (ADXL345_Cost_Meets(&Candidate, Limits, Cost))
+  {
+    *Config = Candidate;
+    return ADXL345_OK;
+  }
+
+  return ADXL345_FAIL;
+}
@@ -0,0 +1,220 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_decim.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 multi-rate decimation stage
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include "ADXL345_decim.h"
+#include <string.h>
+
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define ADXL345_DECIM_CENTER      ((ADXL345_DECIM_TAPS - 1) / 2)
+
+/**
+ * @brief  Odd taps of the half-band filter (Q15), from the center outwards
+ * @note   Kaiser windowed sinc (beta = 7). Even taps are zero and the center
+ *         tap is 0.5. The sum of all taps is exactly 1 (no DC error).
+ */
+static const int16_t ADXL345_Decim_Coef[(ADXL345_DECIM_CENTER + 1) / 2] =
+{
+  10023, -2403, 706, -141, 7
+};
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static int16_t
+ADXL345_Decim_Filter(const int16_t *Taps)
+{
+  const int16_t *Center = &Taps[ADXL345_DECIM_CENTER];
+  int32_t Acc = (int32_t)Center[0] * 16384;
+  uint8_t i = 0;
+
+  for (i = 0; i < (ADXL345_DECIM_CENTER + 1) / 2; i++)
+    Acc += (int32_t)ADXL345_Decim_Coef[i] *
+           ((int32_t)Center[-(2 * i + 1)] + Center[2 * i + 1]);
+
+  Acc = (Acc + 16384) >> 15;
+  if (Acc > INT16_MAX)
+    Acc = INT16_MAX;
+  else if (Acc < INT16_MIN)
+    Acc = INT16_MIN;
+
+  return (int16_t)Acc;
+}
+
+static void
+ADXL345_Decim_Feed(ADXL345_Decimator_t *Decimator, ADXL345_DecimSample_t *Sample)
+{
+  struct ADXL345_DecimStage_s *Stage = NULL;
+  uint8_t s = 0;
+
+  for (s = 0; s < Decimator->Stages; s++)
+  {
+    Stage = &Decimator->Stage[s];
+
+    Stage->Delay[0][Stage->Index] = Sample->X;
+    Stage->Delay[0][Stage->Index + ADXL345_DECIM_TAPS] = Sample->X;
+    Stage->Delay[1][Stage->Index] = Sample->Y;
+    Stage->Delay[1][Stage->Index + ADXL345_DECIM_TAPS] = Sample->Y;
+    Stage->Delay[2][Stage->Index] = Sample->Z;
+    Stage->Delay[2][Stage->Index + ADXL345_DECIM_TAPS] = Sample->Z;
+    Stage->Index++;
+    if (Stage->Index >= ADXL345_DECIM_TAPS)
+      Stage->Index = 0;
+
+    // Output on every second input
+    Stage->Phase ^= 1;
+    if (Stage->Phase)
+      break;
+
+    // Oldest sample is at Index and newest is at Index + TAPS - 1
+    Sample->X = ADXL345_Decim_Filter(&Stage->Delay[0][Stage->Index]);
+    Sample->Y = ADXL345_Decim_Filter(&Stage->Delay[1][Stage->Index]);
+    Sample->Z = ADXL345_Decim_Filter(&Stage->Delay[2][Stage->Index]);
+
+    if (Decimator->OutputMask & (1U << s))
+    {
+      Decimator->Stats.Output[s]++;
+      if (Decimator->Sink)
+        Decimator->Sink(Decimator->SinkContext, s, Sample);
+    }
+  }
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize decimator
+ * @param  Decimator: Pointer to decimator
+ * @param  OutputMask: Bit N enables output of stage N (input rate / 2^(N+1))
+ * @param  Sink: Output function
+ * @param  SinkContext: User context passed to Sink
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Decim_Init(ADXL345_Decimator_t *Decimator, uint8_t OutputMask,
+                   void (*Sink)(void *Context, uint8_t Stage,
+                                const ADXL345_DecimSample_t *Sample),
+                   void *SinkContext)
+{
+  uint8_t Stages = 0;
+
+  if (!OutputMask)
+    return ADXL345_INVALID_PARAM;
+
+  while ((OutputMask >> Stages) > 1)
+    Stages++;
+  Stages++;
+
+  if (Stages > ADXL345_DECIM_MAX_STAGES)
+    return ADXL345_INVALID_PARAM;
+
+  memset(Decimator, 0, sizeof(ADXL345_Decimator_t));
+  Decimator->Stages = Stages;
+  Decimator->OutputMask = OutputMask;
+  Decimator->Sink = Sink;
+  Decimator->SinkContext = SinkContext;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Clear filter states
+ * @param  Decimator: Pointer to decimator
+ * @retval None
+ */
+void
+ADXL345_Decim_Reset(ADXL345_Decimator_t *Decimator)
+{
+  memset(Decimator->Stage, 0, sizeof(Decimator->Stage));
+}
+
+/**
+ * @brief  Feed samples (RawX, RawY and RawZ are used)
+ * @param  Decimator: Pointer to decimator
+ * @param  Samples: Pointer to samples
+ * @param  Count: Number of samples
+ * @retval None
+ */
+void
+ADXL345_Decim_Push(ADXL345_Decimator_t *Decimator,
+                   const ADXL345_Sample_t *Samples, uint16_t Count)
+{
+  ADXL345_DecimSample_t Sample;
+  uint16_t i = 0;
+
+  for (i = 0; i < Count; i++)
+  {
+    Sample.X = Samples[i].RawX;
+    Sample.Y = Samples[i].RawY;
+    Sample.Z = Samples[i].RawZ;
+    ADXL345_Decim_Feed(Decimator, &Sample);
+  }
+
+  Decimator->Stats.Input += Count;
+}
+
+/**
+ * @brief  Output data rate of a stage
+ * @param  Rate: Input data rate
+ * @param  Stage: Stage index (0 => Rate / 2)
+ * @param  StageRate: Pointer to output data rate of the stage
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Stage is out of range, or its rate is
+ *                                  below the lowest Data Rate of the device.
+ */
+ADXL345_Result_t
+ADXL345_Decim_StageRate(ADXL345_Rate_t Rate, uint8_t Stage,
+                        ADXL345_Rate_t *StageRate)
+{
+  // Each Data Rate code is half of the next one
+  if ((Stage >= ADXL345_DECIM_MAX_STAGES) ||
+      ((uint8_t)Rate > ADXL345_RATE_3200) || ((uint8_t)Rate <= Stage))
+    return ADXL345_INVALID_PARAM;
+
+  *StageRate = (ADXL345_Rate_t)((uint8_t)Rate - Stage - 1);
+
+  return ADXL345_OK;
+}
@@ -0,0 +1,339 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_event.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Pollable file descriptor integration for event loops (Linux)
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Feature Test Macros ----------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+
+/* Includes ---------------------------------------------------------------------*/
+#include "ADXL345_event.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/timerfd.h>
+#include <linux/gpio.h>
+
+
+
+/* Private Constants ------------------------------------------------------------*/
+// Edge events consumed per read
+#define ADXL345_EVENT_BATCH   16
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * Consume all pending notifications. Returns the number of notifications,
+ * 0 if there were none and -1 on error.
+ */
+static int32_t
+ADXL345_Event_Consume(ADXL345_Event_t *Event)
+{
+  struct gpioevent_data Edges[ADXL345_EVENT_BATCH];
+  uint64_t Expirations = 0;
+  int32_t Pending = 0;
+  ssize_t Len = 0;
+
+  if (Event->Source == ADXL345_EVENT_TIMER)
+  {
+    Len = read(Event->Fd, &Expirations, sizeof(Expirations));
+    if (Len == sizeof(Expirations))
+      return Expirations ? 1 : 0;
+    return (Len < 0 && errno == EAGAIN) ? 0 : -1;
+  }
+
+  for (;;)
+  {
+    Len = read(Event->Fd, Edges, sizeof(Edges));
+    if (Len < 0)
+      return (errno == EAGAIN) ? Pending : -1;
+
+    Pending += (int32_t)(Len / sizeof(struct gpioevent_data));
+    if (Len < (ssize_t)sizeof(Edges))
+      return Pending;
+  }
+}
+
+
+/**
+ * Returns 1 if the INT line is active, 0 if not and -1 on error
+ */
+static int8_t
+ADXL345_Event_LineActive(ADXL345_Event_t *Event)
+{
+  struct gpiohandle_data Data;
+
+  if (ioctl(Event->Fd, GPIOHANDLE_GET_LINE_VALUES_IOCTL, &Data) < 0)
+    return -1;
+
+  return (Data.values[0] ? 1 : 0) ^ Event->ActiveLow;
+}
+
+
+static ADXL345_Result_t
+ADXL345_Event_Dispatch(ADXL345_Event_t *Event)
+{
+  Event->Stats.Services++;
+
+  if (Event->Stream)
+  {
+    if (ADXL345_Stream_IRQ(Event->Stream) != ADXL345_OK)
+      return ADXL345_FAIL;
+    ADXL345_Stream_Process(Event->Stream);
+    return ADXL345_OK;
+  }
+
+  return ADXL345_IRQ_Handler(Event->Handler);
+}
+
+
+static void
+ADXL345_Event_Setup(ADXL345_Event_t *Event, ADXL345_Handler_t *Handler,
+                    ADXL345_Stream_t *Stream, ADXL345_EventSource_t Source)
+{
+  memset(Event, 0, sizeof(ADXL345_Event_t));
+  Event->Fd = -1;
+  Event->Source = Source;
+  Event->Handler = Handler;
+  Event->Stream = Stream;
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Create an event backed by the INT line of the sensor
+ * @param  Event: Pointer to event
+ * @param  Handler: Pointer to initialized handler
+ * @param  Stream: Pointer to streaming engine (NULL to use
+ *                 ADXL345_IRQ_Handler)
+ * @param  Chip: Path of the GPIO character device
+ * @param  Line: Line offset on the chip
+ * @param  ActiveLow: 1 if INT_INVERT is set in DATA_FORMAT
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to open the chip or request the line.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Event_OpenGpio(ADXL345_Event_t *Event, ADXL345_Handler_t *Handler,
+                       ADXL345_Stream_t *Stream, const char *Chip,
+                       uint32_t Line, uint8_t ActiveLow)
+{
+  struct gpioevent_request Request;
+  int ChipFd = -1;
+  int Flags = 0;
+
+  if (Handler == NULL || Chip == NULL)
+    return ADXL345_INVALID_PARAM;
+
+  ADXL345_Event_Setup(Event, Handler, Stream, ADXL345_EVENT_GPIO);
+  Event->ActiveLow = ActiveLow ? 1 : 0;
+
+  ChipFd = open(Chip, O_RDONLY | O_CLOEXEC);
+  if (ChipFd < 0)
+    return ADXL345_FAIL;
+
+  memset(&Request, 0, sizeof(Request));
+  Request.lineoffset = Line;
+  Request.handleflags = GPIOHANDLE_REQUEST_INPUT;
+  Request.eventflags = Event->ActiveLow ? GPIOEVENT_REQUEST_FALLING_EDGE :
+                                          GPIOEVENT_REQUEST_RISING_EDGE;
+  strncpy(Request.consumer_label, "adxl345", sizeof(Request.consumer_label));
+
+  if (ioctl(ChipFd, GPIO_GET_LINEEVENT_IOCTL, &Request) < 0)
+  {
+    close(ChipFd);
+    return ADXL345_FAIL;
+  }
+  close(ChipFd);
+
+  Event->Fd = Request.fd;
+  Flags = fcntl(Event->Fd, F_GETFL);
+  if (Flags < 0 || fcntl(Event->Fd, F_SETFL, Flags | O_NONBLOCK) < 0)
+  {
+    ADXL345_Event_Close(Event);
+    return ADXL345_FAIL;
+  }
+
+  return ADXL345_OK;
+}
+
+
+/**
+ * @brief  Create an event backed by a periodic timer
+ * @param  Event: Pointer to event
+ * @param  Handler: Pointer to initialized handler
+ * @param  Stream: Pointer to streaming engine (NULL to use
+ *                 ADXL345_IRQ_Handler)
+ * @param  PeriodUs: Timer period in us
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to create the timer.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Event_OpenTimer(ADXL345_Event_t *Event, ADXL345_Handler_t *Handler,
+                        ADXL345_Stream_t *Stream, uint32_t PeriodUs)
+{
+  if (Handler == NULL)
+    return ADXL345_INVALID_PARAM;
+
+  ADXL345_Event_Setup(Event, Handler, Stream, ADXL345_EVENT_TIMER);
+
+  Event->Fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (Event->Fd < 0)
+    return ADXL345_FAIL;
+
+  if (ADXL345_Event_ArmTimer(Event, PeriodUs, PeriodUs) != ADXL345_OK)
+  {
+    ADXL345_Event_Close(Event);
+    return ADXL345_FAIL;
+  }
+
+  return ADXL345_OK;
+}
+
+
+/**
+ * @brief  Arm the timer of a timer event
+ * @param  Event: Pointer to event
+ * @param  FirstUs: Time to the first expiry in us (0 disarms the timer)
+ * @param  PeriodUs: Period after the first expiry in us (0 for one shot)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to set the timer.
+ *         - ADXL345_INVALID_PARAM: Event is not a timer event.
+ */
+ADXL345_Result_t
+ADXL345_Event_ArmTimer(ADXL345_Event_t *Event,
+                       uint32_t FirstUs, uint32_t PeriodUs)
+{
+  struct itimerspec Spec;
+
+  if (Event->Source != ADXL345_EVENT_TIMER || Event->Fd < 0)
+    return ADXL345_INVALID_PARAM;
+
+  Spec.it_value.tv_sec = FirstUs / 1000000;
+  Spec.it_value.tv_nsec = (long)(FirstUs % 1000000) * 1000;
+  Spec.it_interval.tv_sec = PeriodUs / 1000000;
+  Spec.it_interval.tv_nsec = (long)(PeriodUs % 1000000) * 1000;
+
+  if (timerfd_settime(Event->Fd, 0, &Spec, NULL) < 0)
+    return ADXL345_FAIL;
+
+  return ADXL345_OK;
+}
+
+
+/**
+ * @brief  Close the file descriptor of the event
+ * @param  Event: Pointer to event
+ * @retval None
+ */
+void
+ADXL345_Event_Close(ADXL345_Event_t *Event)
+{
+  if (Event->Fd >= 0)
+    close(Event->Fd);
+  Event->Fd = -1;
+}
+
+
+/**
+ * @brief  Service the sensor if its event is pending
+ * @param  Event: Pointer to event
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful (or nothing was pending).
+ *         - ADXL345_FAIL: Failed to read Fd or to service the sensor.
+ */
+ADXL345_Result_t
+ADXL345_Event_Service(ADXL345_Event_t *Event)
+{
+  int32_t Pending = 0;
+  uint8_t Round = 0;
+  int8_t Active = 0;
+
+  Pending = ADXL345_Event_Consume(Event);
+  if (Pending < 0)
+  {
+    Event->Stats.Errors++;
+    return ADXL345_FAIL;
+  }
+
+  if (Pending == 0 && !Event->Again)
+  {
+    Event->Stats.Spurious++;
+    return ADXL345_OK;
+  }
+  Event->Stats.Wakeups += (uint32_t)Pending;
+  Event->Again = 0;
+
+  for (Round = 0; Round < ADXL345_EVENT_MAX_ROUNDS; Round++)
+  {
+    if (ADXL345_Event_Dispatch(Event) != ADXL345_OK)
+    {
+      Event->Stats.Errors++;
+      return ADXL345_FAIL;
+    }
+
+    if (Event->Source != ADXL345_EVENT_GPIO)
+      return ADXL345_OK;
+
+    Active = ADXL345_Event_LineActive(Event);
+    if (Active < 0)
+    {
+      Event->Stats.Errors++;
+      return ADXL345_FAIL;
+    }
+    if (!Active)
+      return ADXL345_OK;
+
+    // Edges of a line that stayed active are covered by the next round
+    Pending = ADXL345_Event_Consume(Event);
+    if (Pending > 0)
+      Event->Stats.Wakeups += (uint32_t)Pending;
+    Event->Stats.Rounds++;
+  }
+
+  Event->Again = 1;
+  return ADXL345_OK;
+}
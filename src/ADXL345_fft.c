@@ -0,0 +1,671 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_fft.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 real FFT spectrum stage
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include "ADXL345_fft.h"
+#include <string.h>
+#include <math.h>
+
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define ADXL345_FFT_PI            3.14159265358979f
+
+// Raw samples are scaled by 4 before windowing. Complex magnitude of a 13-bit
+// sample stays below 2^15 after each scaled stage.
+#define ADXL345_FFT_Q15_SHIFT     2
+#define ADXL345_FFT_Q15_LIMIT     ((1 << (13 + ADXL345_FFT_Q15_SHIFT)) - 1)
+
+
+
+/* Private Macro ----------------------------------------------------------------*/
+#define ADXL345_FFT_MULQ15(a, b)  ((int16_t)((((int32_t)(a) * (b)) + 0x4000) >> 15))
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static uint8_t
+ADXL345_Fft_Log2(uint16_t Points)
+{
+  uint8_t Log2 = 0;
+
+  if ((Points < ADXL345_FFT_MIN_POINTS) || (Points > ADXL345_FFT_MAX_POINTS))
+    return 0;
+  if (Points & (Points - 1))
+    return 0;
+
+  while ((1U << Log2) < Points)
+    Log2++;
+
+  return Log2;
+}
+
+static float
+ADXL345_Fft_WindowValue(ADXL345_FftWindow_t Window, uint16_t n, uint16_t Points)
+{
+  float Phase = 2.0f * ADXL345_FFT_PI * (float)n / (float)Points;
+
+  // Periodic windows (spectral analysis form)
+  switch (Window)
+  {
+  case ADXL345_FFT_WINDOW_HANN:
+    return 0.5f - 0.5f * cosf(Phase);
+
+  case ADXL345_FFT_WINDOW_HAMMING:
+    return 0.54f - 0.46f * cosf(Phase);
+
+  case ADXL345_FFT_WINDOW_BLACKMAN:
+    return 0.42f - 0.5f * cosf(Phase) + 0.08f * cosf(2.0f * Phase);
+
+  case ADXL345_FFT_WINDOW_FLATTOP:
+    return 0.21557895f - 0.41663158f * cosf(Phase) +
+           0.277263158f * cosf(2.0f * Phase) -
+           0.083578947f * cosf(3.0f * Phase) +
+           0.006947368f * cosf(4.0f * Phase);
+
+  default:
+    return 1.0f;
+  }
+}
+
+static int16_t
+ADXL345_Fft_ToQ15(float Value)
+{
+  int32_t Result = (int32_t)lrintf(Value * 32768.0f);
+
+  if (Result > 32767)
+    Result = 32767;
+  else if (Result < -32768)
+    Result = -32768;
+
+  return (int16_t)Result;
+}
+
+static void
+ADXL345_Fft_BitReverse(uint16_t Points, uint16_t *Swap, uint8_t ElemSize,
+                       void *Data)
+{
+  uint16_t i = 0;
+  uint16_t j = 0;
+  uint16_t Bit = 0;
+  uint8_t *Buffer = (uint8_t *)Data;
+
+  for (i = 1; i < Points; i++)
+  {
+    Bit = Points >> 1;
+    while (j & Bit)
+    {
+      j ^= Bit;
+      Bit >>= 1;
+    }
+    j |= Bit;
+
+    if (i < j)
+    {
+      memcpy(Swap, &Buffer[i * ElemSize], ElemSize);
+      memcpy(&Buffer[i * ElemSize], &Buffer[j * ElemSize], ElemSize);
+      memcpy(&Buffer[j * ElemSize], Swap, ElemSize);
+    }
+  }
+}
+
+static uint32_t
+ADXL345_Fft_Sqrt32(uint32_t Value)
+{
+  uint32_t Result = 0;
+  uint32_t Bit = (uint32_t)1 << 30;
+
+  while (Bit > Value)
+    Bit >>= 2;
+
+  while (Bit)
+  {
+    if (Value >= Result + Bit)
+    {
+      Value -= Result + Bit;
+      Result = (Result >> 1) + Bit;
+    }
+    else
+      Result >>= 1;
+    Bit >>= 2;
+  }
+
+  return Result;
+}
+
+/**
+ * @brief  In-place complex FFT of Points/2 samples (Q15, scaled by 1/2 per
+ *         stage), then split to the spectrum of Points real samples
+ */
+static void
+ADXL345_FftQ15_Transform(const ADXL345_FftTableQ15_t *Table, int16_t *Data)
+{
+  uint16_t Half = Table->Points >> 1;
+  uint16_t Len = 0;
+  uint16_t Step = 0;
+  uint16_t i = 0;
+  uint16_t j = 0;
+  uint16_t a = 0;
+  uint16_t b = 0;
+  int16_t Wr = 0;
+  int16_t Wi = 0;
+  int32_t Tr = 0;
+  int32_t Ti = 0;
+  int32_t Er = 0;
+  int32_t Ei = 0;
+  int32_t Or = 0;
+  int32_t Oi = 0;
+  uint16_t Swap[2];
+
+  ADXL345_Fft_BitReverse(Half, Swap, 2 * sizeof(int16_t), Data);
+
+  for (Len = 2; Len <= Half; Len <<= 1)
+  {
+    Step = Table->Points / Len;
+    for (j = 0; j < (Len >> 1); j++)
+    {
+      Wr = Table->Twiddle[2 * (j * Step)];
+      Wi = Table->Twiddle[2 * (j * Step) + 1];
+      for (i = j; i < Half; i += Len)
+      {
+        a = 2 * i;
+        b = 2 * (i + (Len >> 1));
+        Tr = (int32_t)ADXL345_FFT_MULQ15(Wr, Data[b]) -
+             ADXL345_FFT_MULQ15(Wi, Data[b + 1]);
+        Ti = (int32_t)ADXL345_FFT_MULQ15(Wr, Data[b + 1]) +
+             ADXL345_FFT_MULQ15(Wi, Data[b]);
+        Data[b]     = (int16_t)((Data[a] - Tr) >> 1);
+        Data[b + 1] = (int16_t)((Data[a + 1] - Ti) >> 1);
+        Data[a]     = (int16_t)((Data[a] + Tr) >> 1);
+        Data[a + 1] = (int16_t)((Data[a + 1] + Ti) >> 1);
+      }
+    }
+  }
+
+  // X[k] = E + W^k * O and X[Half-k] = conj(E - W^k * O)
+  // E = (Z[k] + conj(Z[Half-k])) / 2, O = -j * (Z[k] - conj(Z[Half-k])) / 2
+  Er = Data[0];
+  Ei = Data[1];
+  Data[0] = (int16_t)((Er + Ei) >> 1);  // DC
+  Data[1] = (int16_t)((Er - Ei) >> 1);  // Nyquist
+  Data[Half] = (int16_t)(Data[Half] >> 1);
+  Data[Half + 1] = (int16_t)(-Data[Half + 1] >> 1);
+
+  for (i = 1; i < (Half >> 1); i++)
+  {
+    a = 2 * i;
+    b = 2 * (Half - i);
+    Er = ((int32_t)Data[a] + Data[b]) >> 1;
+    Ei = ((int32_t)Data[a + 1] - Data[b + 1]) >> 1;
+    Or = ((int32_t)Data[a + 1] + Data[b + 1]) >> 1;
+    Oi = ((int32_t)Data[b] - Data[a]) >> 1;
+    Wr = Table->Twiddle[2 * i];
+    Wi = Table->Twiddle[2 * i + 1];
+    Tr = (int32_t)ADXL345_FFT_MULQ15(Wr, Or) - ADXL345_FFT_MULQ15(Wi, Oi);
+    Ti = (int32_t)ADXL345_FFT_MULQ15(Wr, Oi) + ADXL345_FFT_MULQ15(Wi, Or);
+    Data[a]     = (int16_t)((Er + Tr) >> 1);
+    Data[a + 1] = (int16_t)((Ei + Ti) >> 1);
+    Data[b]     = (int16_t)((Er - Tr) >> 1);
+    Data[b + 1] = (int16_t)((Ti - Ei) >> 1);
+  }
+}
+
+/**
+ * @brief  In-place complex FFT of Points/2 samples, then split to the
+ *         spectrum of Points real samples
+ */
+static void
+ADXL345_FftF_Transform(const ADXL345_FftTableF_t *Table, float *Data)
+{
+  uint16_t Half = Table->Points >> 1;
+  uint16_t Len = 0;
+  uint16_t Step = 0;
+  uint16_t i = 0;
+  uint16_t j = 0;
+  uint16_t a = 0;
+  uint16_t b = 0;
+  float Wr = 0;
+  float Wi = 0;
+  float Tr = 0;
+  float Ti = 0;
+  float Er = 0;
+  float Ei = 0;
+  float Or = 0;
+  float Oi = 0;
+  uint16_t Swap[4];
+
+  ADXL345_Fft_BitReverse(Half, Swap, 2 * sizeof(float), Data);
+
+  for (Len = 2; Len <= Half; Len <<= 1)
+  {
+    Step = Table->Points / Len;
+    for (j = 0; j < (Len >> 1); j++)
+    {
+      Wr = Table->Twiddle[2 * (j * Step)];
+      Wi = Table->Twiddle[2 * (j * Step) + 1];
+      for (i = j; i < Half; i += Len)
+      {
+        a = 2 * i;
+        b = 2 * (i + (Len >> 1));
+        Tr = Wr * Data[b] - Wi * Data[b + 1];
+        Ti = Wr * Data[b + 1] + Wi * Data[b];
+        Data[b]     = Data[a] - Tr;
+        Data[b + 1] = Data[a + 1] - Ti;
+        Data[a]     += Tr;
+        Data[a + 1] += Ti;
+      }
+    }
+  }
+
+  Er = Data[0];
+  Ei = Data[1];
+  Data[0] = Er + Ei;
+  Data[1] = Er - Ei;
+  Data[Half + 1] = -Data[Half + 1];
+
+  for (i = 1; i < (Half >> 1); i++)
+  {
+    a = 2 * i;
+    b = 2 * (Half - i);
+    Er = 0.5f * (Data[a] + Data[b]);
+    Ei = 0.5f * (Data[a + 1] - Data[b + 1]);
+    Or = 0.5f * (Data[a + 1] + Data[b + 1]);
+    Oi = 0.5f * (Data[b] - Data[a]);
+    Wr = Table->Twiddle[2 * i];
+    Wi = Table->Twiddle[2 * i + 1];
+    Tr = Wr * Or - Wi * Oi;
+    Ti = Wr * Oi + Wi * Or;
+    Data[a]     = Er + Tr;
+    Data[a + 1] = Ei + Ti;
+    Data[b]     = Er - Tr;
+    Data[b + 1] = Ti - Ei;
+  }
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize Q15 twiddle and window tables
+ * @note   Uses floating-point math once. Call it at startup.
+ * @param  Table: Pointer to table
+ * @param  Points: Number of points (power of 2, ADXL345_FFT_MIN_POINTS to
+ *                 ADXL345_FFT_MAX_POINTS)
+ * @param  Window: Window function
+ * @param  Twiddle: Buffer of ADXL345_FFT_TWIDDLE_LEN(Points) elements
+ * @param  WindowCoef: Buffer of ADXL345_FFT_WINDOW_LEN(Points) elements
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_FftQ15_InitTable(ADXL345_FftTableQ15_t *Table, uint16_t Points,
+                         ADXL345_FftWindow_t Window,
+                         int16_t *Twiddle, int16_t *WindowCoef)
+{
+  uint8_t Log2 = ADXL345_Fft_Log2(Points);
+  uint16_t i = 0;
+  float Phase = 0;
+  float Sum = 0;
+
+  if (!Log2 || !Twiddle || !WindowCoef || Window > ADXL345_FFT_WINDOW_FLATTOP)
+    return ADXL345_INVALID_PARAM;
+
+  memset(Table, 0, sizeof(ADXL345_FftTableQ15_t));
+  Table->Points = Points;
+  Table->Log2Points = Log2;
+  Table->Window = Window;
+  Table->Twiddle = Twiddle;
+  Table->WindowCoef = WindowCoef;
+
+  for (i = 0; i < (Points >> 1); i++)
+  {
+    Phase = 2.0f * ADXL345_FFT_PI * (float)i / (float)Points;
+    Twiddle[2 * i] = ADXL345_Fft_ToQ15(cosf(Phase));
+    Twiddle[2 * i + 1] = ADXL345_Fft_ToQ15(-sinf(Phase));
+  }
+
+  for (i = 0; i < Points; i++)
+  {
+    WindowCoef[i] = ADXL345_Fft_ToQ15(ADXL345_Fft_WindowValue(Window, i, Points));
+    Sum += (float)WindowCoef[i] / 32768.0f;
+  }
+
+  // Amplitude = 2 * |X| / (N * CG), X is scaled by 4/N => 2 * |X'| / (4 * CG)
+  // in LSB, 8 * |X'| / CG in Q4 LSB
+  Table->AmplitudeGain = (uint32_t)lrintf(8.0f * 256.0f * (float)Points / Sum);
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Initialize Q15 FFT instance
+ * @param  Fft: Pointer to FFT instance
+ * @param  Table: Pointer to initialized table
+ * @param  Axis: Axis of the samples
+ * @param  RemoveMean: 1 to remove the mean (gravity) of the window before
+ *                     windowing
+ * @param  Work: Buffer of ADXL345_FFT_WORK_LEN(Points) elements
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_FftQ15_Init(ADXL345_FftQ15_t *Fft, const ADXL345_FftTableQ15_t *Table,
+                    ADXL345_FftAxis_t Axis, uint8_t RemoveMean, int16_t *Work)
+{
+  if (!Table || !Table->Points || !Work || Axis > ADXL345_FFT_AXIS_Z)
+    return ADXL345_INVALID_PARAM;
+
+  memset(Fft, 0, sizeof(ADXL345_FftQ15_t));
+  Fft->Table = Table;
+  Fft->Axis = Axis;
+  Fft->RemoveMean = RemoveMean;
+  Fft->Work = Work;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Restart the current window
+ * @param  Fft: Pointer to FFT instance
+ * @retval None
+ */
+void
+ADXL345_FftQ15_Reset(ADXL345_FftQ15_t *Fft)
+{
+  Fft->Fill = 0;
+}
+
+/**
+ * @brief  Add one sample (RawX, RawY or RawZ is used)
+ * @param  Fft: Pointer to FFT instance
+ * @param  Sample: Pointer to sample
+ * @retval 1 if the window is full and ADXL345_FftQ15_Compute must be called,
+ *         otherwise 0
+ */
+uint8_t
+ADXL345_FftQ15_Push(ADXL345_FftQ15_t *Fft, const ADXL345_Sample_t *Sample)
+{
+  if (Fft->Fill < Fft->Table->Points)
+  {
+    switch (Fft->Axis)
+    {
+    case ADXL345_FFT_AXIS_X:
+      Fft->Work[Fft->Fill] = Sample->RawX;
+      break;
+    case ADXL345_FFT_AXIS_Y:
+      Fft->Work[Fft->Fill] = Sample->RawY;
+      break;
+    default:
+      Fft->Work[Fft->Fill] = Sample->RawZ;
+      break;
+    }
+    Fft->Fill++;
+  }
+
+  return (Fft->Fill == Fft->Table->Points) ? 1 : 0;
+}
+
+/**
+ * @brief  Compute amplitude spectrum of the full window
+ * @param  Fft: Pointer to FFT instance
+ * @param  Amplitude: Buffer of ADXL345_FFT_AMPLITUDE_LEN(Points) elements
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Window is not full.
+ */
+ADXL345_Result_t
+ADXL345_FftQ15_Compute(ADXL345_FftQ15_t *Fft, uint32_t *Amplitude)
+{
+  const ADXL345_FftTableQ15_t *Table = Fft->Table;
+  uint16_t Points = Table->Points;
+  uint16_t Half = Points >> 1;
+  int16_t *Data = Fft->Work;
+  int32_t Mean = 0;
+  int32_t Value = 0;
+  uint32_t Power = 0;
+  uint16_t i = 0;
+
+  if (Fft->Fill != Points)
+    return ADXL345_FAIL;
+
+  if (Fft->RemoveMean)
+  {
+    for (i = 0; i < Points; i++)
+      Mean += Data[i];
+    Mean /= (int32_t)Points;
+  }
+
+  for (i = 0; i < Points; i++)
+  {
+    Value = ((int32_t)Data[i] - Mean) * (1 << ADXL345_FFT_Q15_SHIFT);
+    if (Value > ADXL345_FFT_Q15_LIMIT)
+      Value = ADXL345_FFT_Q15_LIMIT;
+    else if (Value < -ADXL345_FFT_Q15_LIMIT)
+      Value = -ADXL345_FFT_Q15_LIMIT;
+    Data[i] = ADXL345_FFT_MULQ15(Value, Table->WindowCoef[i]);
+  }
+
+  ADXL345_FftQ15_Transform(Table, Data);
+
+  // DC and Nyquist are real and not doubled
+  Power = (uint32_t)((int32_t)Data[0] * Data[0]);
+  Amplitude[0] = ((ADXL345_Fft_Sqrt32(Power) * Table->AmplitudeGain) + 256) >> 9;
+  Power = (uint32_t)((int32_t)Data[1] * Data[1]);
+  Amplitude[Half] = ((ADXL345_Fft_Sqrt32(Power) * Table->AmplitudeGain) + 256) >> 9;
+
+  for (i = 1; i < Half; i++)
+  {
+    Power = (uint32_t)((int32_t)Data[2 * i] * Data[2 * i]) +
+            (uint32_t)((int32_t)Data[2 * i + 1] * Data[2 * i + 1]);
+    Amplitude[i] = ((ADXL345_Fft_Sqrt32(Power) * Table->AmplitudeGain) + 128) >> 8;
+  }
+
+  Fft->Fill = 0;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Initialize floating-point twiddle and window tables
+ * @param  Table: Pointer to table
+ * @param  Points: Number of points (power of 2, ADXL345_FFT_MIN_POINTS to
+ *                 ADXL345_FFT_MAX_POINTS)
+ * @param  Window: Window function
+ * @param  Twiddle: Buffer of ADXL345_FFT_TWIDDLE_LEN(Points) elements
+ * @param  WindowCoef: Buffer of ADXL345_FFT_WINDOW_LEN(Points) elements
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_FftF_InitTable(ADXL345_FftTableF_t *Table, uint16_t Points,
+                       ADXL345_FftWindow_t Window,
+                       float *Twiddle, float *WindowCoef)
+{
+  uint8_t Log2 = ADXL345_Fft_Log2(Points);
+  uint16_t i = 0;
+  float Phase = 0;
+  float Sum = 0;
+
+  if (!Log2 || !Twiddle || !WindowCoef || Window > ADXL345_FFT_WINDOW_FLATTOP)
+    return ADXL345_INVALID_PARAM;
+
+  memset(Table, 0, sizeof(ADXL345_FftTableF_t));
+  Table->Points = Points;
+  Table->Log2Points = Log2;
+  Table->Window = Window;
+  Table->Twiddle = Twiddle;
+  Table->WindowCoef = WindowCoef;
+
+  for (i = 0; i < (Points >> 1); i++)
+  {
+    Phase = 2.0f * ADXL345_FFT_PI * (float)i / (float)Points;
+    Twiddle[2 * i] = cosf(Phase);
+    Twiddle[2 * i + 1] = -sinf(Phase);
+  }
+
+  for (i = 0; i < Points; i++)
+  {
+    WindowCoef[i] = ADXL345_Fft_WindowValue(Window, i, Points);
+    Sum += WindowCoef[i];
+  }
+
+  // Amplitude = 2 * |X| / (N * CG) = 2 * |X| / Sum
+  Table->AmplitudeGain = 2.0f / Sum;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Initialize floating-point FFT instance
+ * @param  Fft: Pointer to FFT instance
+ * @param  Table: Pointer to initialized table
+ * @param  Axis: Axis of the samples
+ * @param  RemoveMean: 1 to remove the mean (gravity) of the window before
+ *                     windowing
+ * @param  Work: Buffer of ADXL345_FFT_WORK_LEN(Points) elements
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_FftF_Init(ADXL345_FftF_t *Fft, const ADXL345_FftTableF_t *Table,
+                  ADXL345_FftAxis_t Axis, uint8_t RemoveMean, float *Work)
+{
+  if (!Table || !Table->Points || !Work || Axis > ADXL345_FFT_AXIS_Z)
+    return ADXL345_INVALID_PARAM;
+
+  memset(Fft, 0, sizeof(ADXL345_FftF_t));
+  Fft->Table = Table;
+  Fft->Axis = Axis;
+  Fft->RemoveMean = RemoveMean;
+  Fft->Work = Work;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Restart the current window
+ * @param  Fft: Pointer to FFT instance
+ * @retval None
+ */
+void
+ADXL345_FftF_Reset(ADXL345_FftF_t *Fft)
+{
+  Fft->Fill = 0;
+}
+
+/**
+ * @brief  Add one sample (AccelX, AccelY or AccelZ is used)
+ * @param  Fft: Pointer to FFT instance
+ * @param  Sample: Pointer to sample
+ * @retval 1 if the window is full and ADXL345_FftF_Compute must be called,
+ *         otherwise 0
+ */
+uint8_t
+ADXL345_FftF_Push(ADXL345_FftF_t *Fft, const ADXL345_Sample_t *Sample)
+{
+  if (Fft->Fill < Fft->Table->Points)
+  {
+    switch (Fft->Axis)
+    {
+    case ADXL345_FFT_AXIS_X:
+      Fft->Work[Fft->Fill] = Sample->AccelX;
+      break;
+    case ADXL345_FFT_AXIS_Y:
+      Fft->Work[Fft->Fill] = Sample->AccelY;
+      break;
+    default:
+      Fft->Work[Fft->Fill] = Sample->AccelZ;
+      break;
+    }
+    Fft->Fill++;
+  }
+
+  return (Fft->Fill == Fft->Table->Points) ? 1 : 0;
+}
+
+/**
+ * @brief  Compute amplitude spectrum of the full window
+ * @param  Fft: Pointer to FFT instance
+ * @param  Amplitude: Buffer of ADXL345_FFT_AMPLITUDE_LEN(Points) elements
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Window is not full.
+ */
+ADXL345_Result_t
+ADXL345_FftF_Compute(ADXL345_FftF_t *Fft, float *Amplitude)
+{
+  const ADXL345_FftTableF_t *Table = Fft->Table;
+  uint16_t Points = Table->Points;
+  uint16_t Half = Points >> 1;
+  float *Data = Fft->Work;
+  float Mean = 0;
+  uint16_t i = 0;
+
+  if (Fft->Fill != Points)
+    return ADXL345_FAIL;
+
+  if (Fft->RemoveMean)
+  {
+    for (i = 0; i < Points; i++)
+      Mean += Data[i];
+    Mean /= (float)Points;
+  }
+
+  for (i = 0; i < Points; i++)
+    Data[i] = (Data[i] - Mean) * Table->WindowCoef[i];
+
+  ADXL345_FftF_Transform(Table, Data);
+
+  // DC and Nyquist are real and not doubled
+  Amplitude[0] = 0.5f * fabsf(Data[0]) * Table->AmplitudeGain;
+  Amplitude[Half] = 0.5f * fabsf(Data[1]) * Table->AmplitudeGain;
+
+  for (i = 1; i < Half; i++)
+    Amplitude[i] = sqrtf(Data[2 * i] * Data[2 * i] +
+                         Data[2 * i + 1] * Data[2 * i + 1]) * Table->AmplitudeGain;
+
+  Fft->Fill = 0;
+
+  return ADXL345_OK;
+}
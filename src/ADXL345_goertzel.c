@@ -0,0 +1,180 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_goertzel.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 Goertzel frequency bin tracking
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include "ADXL345_goertzel.h"
+#include <string.h>
+#include <math.h>
+
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define ADXL345_GOERTZEL_PI   3.14159265358979f
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize Goertzel bank
+ * @param  Goertzel: Pointer to Goertzel bank
+ * @param  Rate: Output data rate of the samples
+ * @param  WindowSamples: Number of samples per window (> 1)
+ * @param  FreqMilliHz: Array of tracked frequencies in mHz
+ * @param  Bins: Number of tracked frequencies (1..ADXL345_GOERTZEL_MAX_BINS)
+ * @param  WindowCoef: Window coefficients of WindowSamples elements or NULL
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_GoertzelF_Init(ADXL345_GoertzelF_t *Goertzel, ADXL345_Rate_t Rate,
+                       uint16_t WindowSamples, const uint32_t *FreqMilliHz,
+                       uint8_t Bins, const float *WindowCoef)
+{
+  uint32_t RateMilliHz = ADXL345_ConvToData_RateMilliHz(Rate);
+  float Sum = 0;
+  uint16_t i = 0;
+
+  if (WindowSamples < 2 || !Bins || Bins > ADXL345_GOERTZEL_MAX_BINS)
+    return ADXL345_INVALID_PARAM;
+
+  for (i = 0; i < Bins; i++)
+  {
+    if (!FreqMilliHz[i] || FreqMilliHz[i] >= (RateMilliHz >> 1))
+      return ADXL345_INVALID_PARAM;
+  }
+
+  memset(Goertzel, 0, sizeof(ADXL345_GoertzelF_t));
+  Goertzel->WindowSamples = WindowSamples;
+  Goertzel->Bins = Bins;
+  Goertzel->WindowCoef = WindowCoef;
+
+  for (i = 0; i < Bins; i++)
+    Goertzel->Coef[i] = 2.0f * cosf(2.0f * ADXL345_GOERTZEL_PI *
+                                    (float)FreqMilliHz[i] / (float)RateMilliHz);
+
+  if (WindowCoef)
+  {
+    for (i = 0; i < WindowSamples; i++)
+      Sum += WindowCoef[i];
+  }
+  else
+    Sum = (float)WindowSamples;
+
+  // Single-sided peak amplitude = 2 * |X| / sum(w), same as the FFT stage
+  Goertzel->AmplitudeGain = (Sum > 0.0f) ? (2.0f / Sum) : 0.0f;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Restart the current window
+ * @param  Goertzel: Pointer to Goertzel bank
+ * @retval None
+ */
+void
+ADXL345_GoertzelF_Reset(ADXL345_GoertzelF_t *Goertzel)
+{
+  Goertzel->Count = 0;
+  memset(Goertzel->S1, 0, sizeof(Goertzel->S1));
+  memset(Goertzel->S2, 0, sizeof(Goertzel->S2));
+}
+
+/**
+ * @brief  Add one sample (AccelX, AccelY and AccelZ are used)
+ * @param  Goertzel: Pointer to Goertzel bank
+ * @param  Sample: Pointer to sample
+ * @retval 1 if the window is completed and Goertzel->Result is updated,
+ *         otherwise 0
+ */
+uint8_t
+ADXL345_GoertzelF_Push(ADXL345_GoertzelF_t *Goertzel,
+                       const ADXL345_Sample_t *Sample)
+{
+  float Value[3];
+  float W = 1.0f;
+  float S0 = 0;
+  float Power = 0;
+  uint8_t Axis = 0;
+  uint8_t i = 0;
+
+  Value[0] = Sample->AccelX;
+  Value[1] = Sample->AccelY;
+  Value[2] = Sample->AccelZ;
+
+  if (Goertzel->Count == 0)
+  {
+    Goertzel->Ref[0] = Value[0];
+    Goertzel->Ref[1] = Value[1];
+    Goertzel->Ref[2] = Value[2];
+  }
+
+  if (Goertzel->WindowCoef)
+    W = Goertzel->WindowCoef[Goertzel->Count];
+
+  for (Axis = 0; Axis < 3; Axis++)
+  {
+    Value[Axis] = (Value[Axis] - Goertzel->Ref[Axis]) * W;
+    for (i = 0; i < Goertzel->Bins; i++)
+    {
+      S0 = Value[Axis] + Goertzel->Coef[i] * Goertzel->S1[Axis][i] -
+           Goertzel->S2[Axis][i];
+      Goertzel->S2[Axis][i] = Goertzel->S1[Axis][i];
+      Goertzel->S1[Axis][i] = S0;
+    }
+  }
+
+  Goertzel->Count++;
+  if (Goertzel->Count < Goertzel->WindowSamples)
+    return 0;
+
+  for (Axis = 0; Axis < 3; Axis++)
+  {
+    for (i = 0; i < Goertzel->Bins; i++)
+    {
+      Power = Goertzel->S1[Axis][i] * Goertzel->S1[Axis][i] +
+              Goertzel->S2[Axis][i] * Goertzel->S2[Axis][i] -
+              Goertzel->Coef[i] * Goertzel->S1[Axis][i] * Goertzel->S2[Axis][i];
+      if (Power < 0.0f)
+        Power = 0.0f;
+      Goertzel->Result.Amplitude[Axis][i] = sqrtf(Power) * Goertzel->AmplitudeGain;
+    }
+  }
+  Goertzel->Result.Samples = Goertzel->Count;
+
+  ADXL345_GoertzelF_Reset(Goertzel);
+
+  return 1;
+}
@@ -0,0 +1,456 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_log.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 compact binary sample log (delta + zigzag varint)
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Feature Test Macros ----------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+
+/* Includes ---------------------------------------------------------------------*/
+#include "ADXL345_log.h"
+#include <string.h>
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static void
+ADXL345_Log_Put16(uint8_t *Data, uint16_t Value)
+{
+  Data[0] = (uint8_t)Value;
+  Data[1] = (uint8_t)(Value >> 8);
+}
+
+static void
+ADXL345_Log_Put32(uint8_t *Data, uint32_t Value)
+{
+  Data[0] = (uint8_t)Value;
+  Data[1] = (uint8_t)(Value >> 8);
+  Data[2] = (uint8_t)(Value >> 16);
+  Data[3] = (uint8_t)(Value >> 24);
+}
+
+static uint16_t
+ADXL345_Log_Get16(const uint8_t *Data)
+{
+  return (uint16_t)(Data[0] | (Data[1] << 8));
+}
+
+static uint32_t
+ADXL345_Log_Get32(const uint8_t *Data)
+{
+  return (uint32_t)Data[0] | ((uint32_t)Data[1] << 8) |
+         ((uint32_t)Data[2] << 16) | ((uint32_t)Data[3] << 24);
+}
+
+static void
+ADXL345_Log_OpenBlock(ADXL345_LogWriter_t *Writer, uint32_t Gap,
+                      uint32_t Sequence, uint32_t TimestampUs)
+{
+  uint8_t *Block = Writer->Block;
+
+  Block[0] = ADXL345_LOG_BLOCK_SYNC;
+  Block[1] = Gap ? ADXL345_LOG_FLAG_GAP : 0;
+  ADXL345_Log_Put32(&Block[6], TimestampUs);
+  ADXL345_Log_Put32(&Block[10], Sequence);
+  ADXL345_Log_Put32(&Block[14], Gap);
+
+  Writer->Length = ADXL345_LOG_BLOCK_HEADER_LEN;
+  Writer->Count = 0;
+  memset(Writer->Last, 0, sizeof(Writer->Last));
+
+  if (Gap)
+    Writer->Stats.Gaps++;
+}
+
+static uint8_t
+ADXL345_Log_PutVarint(uint8_t *Data, int16_t Value, int16_t Last)
+{
+  int32_t Delta = (int32_t)Value - (int32_t)Last;
+  uint32_t ZigZag = ((uint32_t)Delta << 1) ^ (uint32_t)(Delta >> 31);
+  uint8_t Len = 0;
+
+  while (ZigZag >= 0x80)
+  {
+    Data[Len++] = (uint8_t)(ZigZag | 0x80);
+    ZigZag >>= 7;
+  }
+  Data[Len++] = (uint8_t)ZigZag;
+
+  return Len;
+}
+
+static int16_t
+ADXL345_Log_GetVarint(const uint8_t **Data, int16_t Last)
+{
+  const uint8_t *Ptr = *Data;
+  uint32_t ZigZag = *Ptr & 0x7F;
+
+  // At most 3 bytes, because a delta of int16 values fits in 17 bits
+  if (*Ptr++ & 0x80)
+  {
+    ZigZag |= (uint32_t)(*Ptr & 0x7F) << 7;
+    if (*Ptr++ & 0x80)
+      ZigZag |= (uint32_t)(*Ptr++ & 0x7F) << 14;
+  }
+  *Data = Ptr;
+
+  return (int16_t)((int32_t)Last + (int32_t)((ZigZag >> 1) ^ (0U - (ZigZag & 1))));
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                            
+ ==================================================================================
+ */
+
+/**
+ * @brief  Compute CRC-16/CCITT-FALSE used by log headers and blocks
+ * @param  Data: Pointer to data
+ * @param  Len: Number of bytes
+ * @retval CRC
+ */
+uint16_t
+ADXL345_Log_Crc16(const uint8_t *Data, uint32_t Len)
+{
+  static const uint16_t Table[16] =
+  {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+  };
+  uint16_t Crc = 0xFFFF;
+
+  while (Len--)
+  {
+    Crc = (uint16_t)((Crc << 4) ^ Table[(Crc >> 12) ^ (*Data >> 4)]);
+    Crc = (uint16_t)((Crc << 4) ^ Table[(Crc >> 12) ^ (*Data & 0x0F)]);
+    Data++;
+  }
+
+  return Crc;
+}
+
+/**
+ * @brief  Initialize log writer and write the file header
+ * @param  Writer: Pointer to writer
+ * @param  Info: Pointer to log file information
+ * @param  Block: Block buffer (at least ADXL345_LOG_BLOCK_LEN(1) bytes)
+ * @param  BlockSize: Size of Block in bytes
+ * @param  Write: Write function of the output
+ * @param  Context: Context of write function
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to write the header.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Log_WriterInit(ADXL345_LogWriter_t *Writer,
+                       const ADXL345_LogInfo_t *Info,
+                       uint8_t *Block, uint16_t BlockSize,
+                       ADXL345_LogWriteFn_t Write, void *Context)
+{
+  uint8_t Header[ADXL345_LOG_FILE_HEADER_LEN];
+
+  if (!Writer || !Info || !Block || !Write ||
+      BlockSize < ADXL345_LOG_BLOCK_LEN(1))
+    return ADXL345_INVALID_PARAM;
+
+  memset(Writer, 0, sizeof(ADXL345_LogWriter_t));
+  Writer->Write = Write;
+  Writer->Context = Context;
+  Writer->Block = Block;
+  Writer->BlockSize = BlockSize;
+  Writer->PeriodUs = ADXL345_ConvToData_RatePeriodUs(Info->Rate);
+
+  memcpy(Header, ADXL345_LOG_MAGIC, 4);
+  Header[4] = ADXL345_LOG_VERSION;
+  Header[5] = Info->DeviceId;
+  Header[6] = (uint8_t)Info->Range;
+  Header[7] = Info->FullResolution ? 1 : 0;
+  Header[8] = (uint8_t)Info->Rate;
+  Header[9] = 0;
+  ADXL345_Log_Put32(&Header[10], ADXL345_ConvToData_RateMilliHz(Info->Rate));
+  ADXL345_Log_Put16(&Header[14], ADXL345_Log_Crc16(Header, 14));
+
+  if (Write(Context, Header, sizeof(Header)) != 0)
+    return ADXL345_FAIL;
+
+  Writer->Stats.Bytes = sizeof(Header);
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Append a batch of samples to the log
+ * @note   Only raw values of the samples are stored. A new block with the
+ *         gap flag is started when Batch->Gap is not zero or its sequence
+ *         does not follow the previous batch.
+ * @param  Writer: Pointer to writer
+ * @param  Batch: Pointer to batch
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to write a block. Its samples are dropped.
+ */
+ADXL345_Result_t
+ADXL345_Log_Write(ADXL345_LogWriter_t *Writer, const ADXL345_Batch_t *Batch)
+{
+  ADXL345_Result_t Result = ADXL345_OK;
+  const ADXL345_Sample_t *Sample = NULL;
+  uint8_t *Data = NULL;
+  uint32_t Gap = Batch->Gap;
+  uint8_t i = 0;
+
+  if (!Gap && Writer->Started && Batch->Sequence != Writer->NextSequence)
+    Gap = Batch->Sequence - Writer->NextSequence;
+
+  if (Gap && Writer->Length && ADXL345_Log_Flush(Writer) != ADXL345_OK)
+    Result = ADXL345_FAIL;
+
+  for (i = 0; i < Batch->Count; i++)
+  {
+    if (!Writer->Length)
+    {
+      ADXL345_Log_OpenBlock(Writer, Gap, Batch->Sequence + i,
+                            Batch->TimestampUs + i * Writer->PeriodUs);
+      Gap = 0;
+    }
+
+    Sample = &Batch->Samples[i];
+    Data = &Writer->Block[Writer->Length];
+    Data += ADXL345_Log_PutVarint(Data, Sample->RawX, Writer->Last[0]);
+    Data += ADXL345_Log_PutVarint(Data, Sample->RawY, Writer->Last[1]);
+    Data += ADXL345_Log_PutVarint(Data, Sample->RawZ, Writer->Last[2]);
+    Writer->Length = (uint16_t)(Data - Writer->Block);
+    Writer->Last[0] = Sample->RawX;
+    Writer->Last[1] = Sample->RawY;
+    Writer->Last[2] = Sample->RawZ;
+    Writer->Count++;
+
+    if (Writer->Length + ADXL345_LOG_SAMPLE_MAX_LEN +
+        ADXL345_LOG_BLOCK_CRC_LEN > Writer->BlockSize ||
+        Writer->Count == 0xFFFF)
+    {
+      if (ADXL345_Log_Flush(Writer) != ADXL345_OK)
+        Result = ADXL345_FAIL;
+    }
+  }
+
+  Writer->NextSequence = Batch->Sequence + Batch->Count;
+  Writer->Started = 1;
+
+  return Result;
+}
+
+/**
+ * @brief  Streaming engine sink that appends each batch to the log
+ * @note   Set Stream->Sink to this function and Stream->SinkContext to the
+ *         writer.
+ * @param  SinkContext: Pointer to writer
+ * @param  Batch: Pointer to batch
+ * @retval None
+ */
+void
+ADXL345_Log_Sink(void *SinkContext, ADXL345_Batch_t *Batch)
+{
+  ADXL345_Log_Write((ADXL345_LogWriter_t *)SinkContext, Batch);
+}
+
+/**
+ * @brief  Write the open block
+ * @param  Writer: Pointer to writer
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to write the block. Its samples are dropped.
+ */
+ADXL345_Result_t
+ADXL345_Log_Flush(ADXL345_LogWriter_t *Writer)
+{
+  uint8_t *Block = Writer->Block;
+  uint16_t Length = Writer->Length;
+
+  if (!Length)
+    return ADXL345_OK;
+
+  Writer->Length = 0;
+
+  ADXL345_Log_Put16(&Block[2], Writer->Count);
+  ADXL345_Log_Put16(&Block[4], Length - ADXL345_LOG_BLOCK_HEADER_LEN);
+  ADXL345_Log_Put16(&Block[Length], ADXL345_Log_Crc16(Block, Length));
+  Length += ADXL345_LOG_BLOCK_CRC_LEN;
+
+  if (Writer->Write(Writer->Context, Block, Length) != 0)
+  {
+    Writer->Stats.Errors++;
+    return ADXL345_FAIL;
+  }
+
+  Writer->Stats.Blocks++;
+  Writer->Stats.Samples += Writer->Count;
+  Writer->Stats.Bytes += Length;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Read log file information from the file header
+ * @param  Data: Pointer to the start of the log
+ * @param  Len: Number of available bytes
+ * @param  Info: Pointer to log file information
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Not a valid log header.
+ */
+ADXL345_Result_t
+ADXL345_Log_ReadInfo(const uint8_t *Data, uint32_t Len,
+                     ADXL345_LogInfo_t *Info)
+{
+  if (Len < ADXL345_LOG_FILE_HEADER_LEN ||
+      memcmp(Data, ADXL345_LOG_MAGIC, 4) != 0 ||
+      Data[4] != ADXL345_LOG_VERSION ||
+      ADXL345_Log_Get16(&Data[14]) != ADXL345_Log_Crc16(Data, 14))
+    return ADXL345_FAIL;
+
+  Info->DeviceId = Data[5];
+  Info->Range = (ADXL345_Range_t)(Data[6] & 0x03);
+  Info->FullResolution = Data[7] ? 1 : 0;
+  Info->Rate = (ADXL345_Rate_t)(Data[8] & 0x0F);
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Parse the block at Data
+ * @note   Total size of the block is ADXL345_LOG_BLOCK_HEADER_LEN +
+ *         Block->PayloadLen + ADXL345_LOG_BLOCK_CRC_LEN.
+ * @param  Data: Pointer to the block
+ * @param  Len: Number of available bytes
+ * @param  CheckCrc: 1 to verify the CRC of the block
+ * @param  Block: Pointer to parsed block
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Not a valid block.
+ */
+ADXL345_Result_t
+ADXL345_Log_ParseBlock(const uint8_t *Data, uint32_t Len, uint8_t CheckCrc,
+                       ADXL345_LogBlock_t *Block)
+{
+  uint32_t Length = 0;
+
+  if (Len < ADXL345_LOG_BLOCK_HEADER_LEN + ADXL345_LOG_BLOCK_CRC_LEN ||
+      Data[0] != ADXL345_LOG_BLOCK_SYNC)
+    return ADXL345_FAIL;
+
+  Block->Flags = Data[1];
+  Block->Count = ADXL345_Log_Get16(&Data[2]);
+  Block->PayloadLen = ADXL345_Log_Get16(&Data[4]);
+  Block->TimestampUs = ADXL345_Log_Get32(&Data[6]);
+  Block->Sequence = ADXL345_Log_Get32(&Data[10]);
+  Block->Gap = ADXL345_Log_Get32(&Data[14]);
+  Block->Payload = &Data[ADXL345_LOG_BLOCK_HEADER_LEN];
+
+  Length = ADXL345_LOG_BLOCK_HEADER_LEN + Block->PayloadLen;
+  if (Length + ADXL345_LOG_BLOCK_CRC_LEN > Len ||
+      Block->PayloadLen < 3 * (uint32_t)Block->Count ||
+      Block->PayloadLen > ADXL345_LOG_SAMPLE_MAX_LEN * (uint32_t)Block->Count)
+    return ADXL345_FAIL;
+
+  if (CheckCrc &&
+      ADXL345_Log_Get16(&Data[Length]) != ADXL345_Log_Crc16(Data, Length))
+    return ADXL345_FAIL;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Decode samples of a parsed block into separate axis arrays
+ * @note   Samples before First are decoded but not stored.
+ * @param  Block: Pointer to parsed block
+ * @param  First: Index of the first sample to store
+ * @param  Count: Max number of samples to store
+ * @param  X: X values (NULL if not needed)
+ * @param  Y: Y values (NULL if not needed)
+ * @param  Z: Z values (NULL if not needed)
+ * @retval Number of stored samples
+ */
+uint16_t
+ADXL345_Log_DecodeBlock(const ADXL345_LogBlock_t *Block,
+                        uint16_t First, uint16_t Count,
+                        int16_t *X, int16_t *Y, int16_t *Z)
+{
+  const uint8_t *Data = Block->Payload;
+  const uint8_t *End = Block->Payload + Block->PayloadLen;
+  const uint8_t *Start = NULL;
+  const uint8_t *Ptr = NULL;
+  uint8_t Tail[ADXL345_LOG_SAMPLE_MAX_LEN];
+  int16_t Last[3] = {0};
+  uint16_t Stored = 0;
+  uint16_t i = 0;
+
+  if (First >= Block->Count)
+    return 0;
+  if (Count > Block->Count - First)
+    Count = Block->Count - First;
+
+  for (i = 0; i < First + Count; i++)
+  {
+    // Near the end of payload decode from a padded copy, so a corrupted
+    // payload is never read past its end
+    Start = Data;
+    if (End - Data < ADXL345_LOG_SAMPLE_MAX_LEN)
+    {
+      memset(Tail, 0, sizeof(Tail));
+      memcpy(Tail, Data, (size_t)(End - Data));
+      Start = Tail;
+    }
+    Ptr = Start;
+    Last[0] = ADXL345_Log_GetVarint(&Ptr, Last[0]);
+    Last[1] = ADXL345_Log_GetVarint(&Ptr, Last[1]);
+    Last[2] = ADXL345_Log_GetVarint(&Ptr, Last[2]);
+    Data += Ptr - Start;
+    if (Data > End)
+      break;
+    if (i < First)
+      continue;
+
+    if (X)
+      X[Stored] = Last[0];
+    if (Y)
+      Y[Stored] = Last[1];
+    if (Z)
+      Z[Stored] = Last[2];
+    Stored++;
+  }
+
+  return Stored;
+}
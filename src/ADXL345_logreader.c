@@ -0,0 +1,508 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_logreader.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 memory-mapped log reader with sparse time index (POSIX)
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Feature Test Macros ----------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+
+/* Includes ---------------------------------------------------------------------*/
+#include "ADXL345_logreader.h"
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define ADXL345_LOGREADER_INDEX_MAGIC   "AXLI"
+#define ADXL345_LOGREADER_INDEX_VERSION 1
+
+
+
+/* Private Macro ----------------------------------------------------------------*/
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+
+
+
+/* Private Data Types -----------------------------------------------------------*/
+typedef struct ADXL345_LogIndexHeader_s
+{
+  char Magic[4];
+  uint32_t Version;
+  uint64_t LogSize;
+  uint64_t DurationUs;
+  uint32_t Count;
+  uint32_t Stride;
+  uint32_t Blocks;
+  uint32_t Samples;
+  uint32_t Gaps;
+  uint32_t BadBytes;
+} ADXL345_LogIndexHeader_t;
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static uint32_t
+ADXL345_LogReader_BlockLen(const ADXL345_LogBlock_t *Block)
+{
+  return ADXL345_LOG_BLOCK_HEADER_LEN + Block->PayloadLen +
+         ADXL345_LOG_BLOCK_CRC_LEN;
+}
+
+static uint8_t
+ADXL345_LogReader_Next(ADXL345_LogReader_t *Reader, uint64_t *Offset,
+                       uint8_t CheckCrc, ADXL345_LogBlock_t *Block)
+{
+  uint8_t Resync = 0;
+
+  while (*Offset + ADXL345_LOG_BLOCK_HEADER_LEN +
+         ADXL345_LOG_BLOCK_CRC_LEN <= Reader->Size)
+  {
+    // A sync byte inside a damaged area is accepted only with a valid CRC
+    if (ADXL345_Log_ParseBlock(Reader->Data + *Offset,
+                               (uint32_t)MIN(Reader->Size - *Offset, 0xFFFFFFFFULL),
+                               CheckCrc || Resync, Block) == ADXL345_OK)
+      return 1;
+
+    (*Offset)++;
+    Resync = 1;
+  }
+
+  return 0;
+}
+
+static void
+ADXL345_LogReader_Build(ADXL345_LogReader_t *Reader)
+{
+  ADXL345_LogBlock_t Block;
+  uint64_t Offset = ADXL345_LOG_FILE_HEADER_LEN;
+  uint64_t Start = Offset;
+  uint64_t TimeUs = 0;
+  uint32_t LastTimestampUs = 0;
+  uint32_t Blocks = 0;
+  uint32_t i = 0;
+
+  while (ADXL345_LogReader_Next(Reader, &Offset, 0, &Block))
+  {
+    Reader->Stats.BadBytes += (uint32_t)(Offset - Start);
+    if (Blocks)
+      TimeUs += (uint32_t)(Block.TimestampUs - LastTimestampUs);
+    LastTimestampUs = Block.TimestampUs;
+
+    if (Blocks % Reader->Stride == 0)
+    {
+      if (Reader->IndexCount == Reader->IndexLen)
+      {
+        // Keep every other entry and index half as many blocks from now on
+        for (i = 0; 2 * i < Reader->IndexCount; i++)
+          Reader->Index[i] = Reader->Index[2 * i];
+        Reader->IndexCount = i;
+        Reader->Stride *= 2;
+      }
+      if (Blocks % Reader->Stride == 0)
+      {
+        Reader->Index[Reader->IndexCount].Offset = Offset;
+        Reader->Index[Reader->IndexCount].TimeUs = TimeUs;
+        Reader->IndexCount++;
+      }
+    }
+
+    Blocks++;
+    Reader->Stats.Blocks++;
+    Reader->Stats.Samples += Block.Count;
+    if (Block.Flags & ADXL345_LOG_FLAG_GAP)
+      Reader->Stats.Gaps++;
+    Reader->DurationUs = TimeUs + (Block.Count * Reader->PeriodNs) / 1000;
+
+    Offset += ADXL345_LogReader_BlockLen(&Block);
+    Start = Offset;
+  }
+}
+
+static ADXL345_Result_t
+ADXL345_LogReader_Load(ADXL345_LogReader_t *Reader, const char *IndexPath)
+{
+  ADXL345_LogIndexHeader_t Header;
+  ADXL345_Result_t Result = ADXL345_FAIL;
+  FILE *File = fopen(IndexPath, "rb");
+
+  if (!File)
+    return ADXL345_FAIL;
+
+  if (fread(&Header, sizeof(Header), 1, File) == 1 &&
+      memcmp(Header.Magic, ADXL345_LOGREADER_INDEX_MAGIC, 4) == 0 &&
+      Header.Version == ADXL345_LOGREADER_INDEX_VERSION &&
+      Header.LogSize == Reader->Size &&
+      Header.Count && Header.Count <= Reader->IndexLen &&
+      fread(Reader->Index, sizeof(ADXL345_LogIndexEntry_t),
+            Header.Count, File) == Header.Count)
+  {
+    Reader->IndexCount = Header.Count;
+    Reader->Stride = Header.Stride;
+    Reader->DurationUs = Header.DurationUs;
+    Reader->Stats.Blocks = Header.Blocks;
+    Reader->Stats.Samples = Header.Samples;
+    Reader->Stats.Gaps = Header.Gaps;
+    Reader->Stats.BadBytes = Header.BadBytes;
+    Result = ADXL345_OK;
+  }
+
+  fclose(File);
+
+  return Result;
+}
+
+static void
+ADXL345_LogReader_Save(ADXL345_LogReader_t *Reader, const char *IndexPath)
+{
+  ADXL345_LogIndexHeader_t Header;
+  FILE *File = NULL;
+
+  if (!Reader->IndexCount)
+    return;
+
+  memset(&Header, 0, sizeof(Header));
+  memcpy(Header.Magic, ADXL345_LOGREADER_INDEX_MAGIC, 4);
+  Header.Version = ADXL345_LOGREADER_INDEX_VERSION;
+  Header.LogSize = Reader->Size;
+  Header.DurationUs = Reader->DurationUs;
+  Header.Count = Reader->IndexCount;
+  Header.Stride = Reader->Stride;
+  Header.Blocks = Reader->Stats.Blocks;
+  Header.Samples = Reader->Stats.Samples;
+  Header.Gaps = Reader->Stats.Gaps;
+  Header.BadBytes = Reader->Stats.BadBytes;
+
+  // The index is only a cache, so a failed write is not an error
+  File = fopen(IndexPath, "wb");
+  if (!File)
+    return;
+  if (fwrite(&Header, sizeof(Header), 1, File) != 1 ||
+      fwrite(Reader->Index, sizeof(ADXL345_LogIndexEntry_t),
+             Reader->IndexCount, File) != Reader->IndexCount)
+  {
+    fclose(File);
+    remove(IndexPath);
+    return;
+  }
+  fclose(File);
+}
+
+static ADXL345_Result_t
+ADXL345_LogReader_Range(ADXL345_LogReader_t *Reader,
+                        uint64_t FromUs, uint64_t ToUs,
+                        int16_t *X, int16_t *Y, int16_t *Z,
+                        float *FX, float *FY, float *FZ,
+                        uint32_t MaxSamples, uint32_t *Count,
+                        uint64_t *FirstUs)
+{
+  static const float Factor[4] = {0.0039f, 0.0078f, 0.0156f, 0.0312f};
+  int16_t Raw[3][ADXL345_LOGREADER_CHUNK];
+  ADXL345_LogBlock_t Block;
+  uint64_t Offset = 0;
+  uint64_t TimeUs = 0;
+  uint64_t BlockUs = 0;
+  uint64_t EndUs = 0;
+  uint32_t LastTimestampUs = 0;
+  uint32_t Low = 0;
+  uint32_t High = 0;
+  uint32_t Stored = 0;
+  uint64_t First = 0;
+  uint64_t Last = 0;
+  uint16_t Want = 0;
+  uint16_t Got = 0;
+  uint8_t Started = 0;
+  float Scale = 0.0f;
+  uint16_t i = 0;
+
+  if (!Reader || !Reader->Data || !Count || ToUs < FromUs)
+    return ADXL345_INVALID_PARAM;
+
+  *Count = 0;
+  if (!Reader->IndexCount)
+    return ADXL345_OK;
+
+  Scale = Reader->Info.FullResolution ? 0.004f : Factor[Reader->Info.Range];
+
+  // Last index entry at or before FromUs
+  High = Reader->IndexCount;
+  while (High - Low > 1)
+  {
+    if (Reader->Index[(Low + High) / 2].TimeUs <= FromUs)
+      Low = (Low + High) / 2;
+    else
+      High = (Low + High) / 2;
+  }
+  Offset = Reader->Index[Low].Offset;
+  TimeUs = Reader->Index[Low].TimeUs;
+
+  // Blocks before the range are skipped by their headers only
+  while (Stored < MaxSamples &&
+         ADXL345_LogReader_Next(Reader, &Offset, 0, &Block))
+  {
+    BlockUs = TimeUs;
+    if (Started)
+      BlockUs += (uint32_t)(Block.TimestampUs - LastTimestampUs);
+
+    if (BlockUs >= ToUs)
+      break;
+
+    EndUs = BlockUs + (Block.Count * Reader->PeriodNs) / 1000;
+    if (EndUs > FromUs && Reader->CheckCrc &&
+        ADXL345_Log_ParseBlock(Reader->Data + Offset,
+                               ADXL345_LogReader_BlockLen(&Block), 1,
+                               &Block) != ADXL345_OK)
+    {
+      Offset++;
+      continue;
+    }
+
+    TimeUs = BlockUs;
+    LastTimestampUs = Block.TimestampUs;
+    Started = 1;
+
+    if (EndUs > FromUs)
+    {
+      First = (FromUs > TimeUs) ?
+              ((FromUs - TimeUs) * 1000 + Reader->PeriodNs - 1) / Reader->PeriodNs : 0;
+      // Compared in us first, so a far ToUs does not overflow the product
+      Last = Block.Count;
+      if (ToUs < EndUs)
+        Last = ((ToUs - TimeUs) * 1000 + Reader->PeriodNs - 1) /
+               Reader->PeriodNs;
+      Last = MIN(Last, Block.Count);
+
+      while (First < Last && Stored < MaxSamples)
+      {
+        Want = (uint16_t)MIN(Last - First, MaxSamples - Stored);
+        if (FX || FY || FZ)
+        {
+          Want = MIN(Want, ADXL345_LOGREADER_CHUNK);
+          Got = ADXL345_Log_DecodeBlock(&Block, (uint16_t)First, Want,
+                                        Raw[0], Raw[1], Raw[2]);
+          for (i = 0; i < Got; i++)
+          {
+            if (FX)
+              FX[Stored + i] = (float)Raw[0][i] * Scale;
+            if (FY)
+              FY[Stored + i] = (float)Raw[1][i] * Scale;
+            if (FZ)
+              FZ[Stored + i] = (float)Raw[2][i] * Scale;
+          }
+        }
+        else
+        {
+          Got = ADXL345_Log_DecodeBlock(&Block, (uint16_t)First, Want,
+                                        X ? X + Stored : NULL,
+                                        Y ? Y + Stored : NULL,
+                                        Z ? Z + Stored : NULL);
+        }
+
+        if (!Stored && Got && FirstUs)
+          *FirstUs = TimeUs + (First * Reader->PeriodNs) / 1000;
+        Stored += Got;
+        First += Got;
+        if (Got < Want)
+          break;
+      }
+    }
+
+    Offset += ADXL345_LogReader_BlockLen(&Block);
+  }
+
+  *Count = Stored;
+
+  return ADXL345_OK;
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                            
+ ==================================================================================
+ */
+
+/**
+ * @brief  Map a log file and build or load its index
+ * @note   If IndexPath is not NULL, the index is loaded from it when it
+ *         matches the log, otherwise it is built by a scan of block headers
+ *         and saved there.
+ * @param  Reader: Pointer to reader
+ * @param  Path: Path of the log file
+ * @param  IndexPath: Path of the index file (NULL if not used)
+ * @param  Index: Index array
+ * @param  IndexLen: Number of entries of Index (>= 2)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to open or map the file or not a log.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_LogReader_Open(ADXL345_LogReader_t *Reader, const char *Path,
+                       const char *IndexPath,
+                       ADXL345_LogIndexEntry_t *Index, uint32_t IndexLen)
+{
+  struct stat Stat;
+  void *Map = NULL;
+
+  if (!Reader || !Path || !Index || IndexLen < 2)
+    return ADXL345_INVALID_PARAM;
+
+  memset(Reader, 0, sizeof(ADXL345_LogReader_t));
+  Reader->Index = Index;
+  Reader->IndexLen = IndexLen;
+  Reader->Stride = 1;
+  Reader->CheckCrc = 1;
+
+  Reader->Fd = open(Path, O_RDONLY);
+  if (Reader->Fd < 0)
+    return ADXL345_FAIL;
+
+  if (fstat(Reader->Fd, &Stat) != 0 ||
+      Stat.st_size < ADXL345_LOG_FILE_HEADER_LEN)
+  {
+    close(Reader->Fd);
+    return ADXL345_FAIL;
+  }
+
+  Map = mmap(NULL, (size_t)Stat.st_size, PROT_READ, MAP_SHARED, Reader->Fd, 0);
+  if (Map == MAP_FAILED)
+  {
+    close(Reader->Fd);
+    return ADXL345_FAIL;
+  }
+  Reader->Data = (const uint8_t *)Map;
+  Reader->Size = (uint64_t)Stat.st_size;
+
+  if (ADXL345_Log_ReadInfo(Reader->Data, (uint32_t)MIN(Reader->Size, 0xFFFFFFFFULL),
+                           &Reader->Info) != ADXL345_OK)
+  {
+    ADXL345_LogReader_Close(Reader);
+    return ADXL345_FAIL;
+  }
+  Reader->PeriodNs =
+      1000000000000ULL / ADXL345_ConvToData_RateMilliHz(Reader->Info.Rate);
+
+  if (!IndexPath || ADXL345_LogReader_Load(Reader, IndexPath) != ADXL345_OK)
+  {
+    // Only block headers are touched while building the index
+    posix_madvise(Map, (size_t)Reader->Size, POSIX_MADV_RANDOM);
+    ADXL345_LogReader_Build(Reader);
+    posix_madvise(Map, (size_t)Reader->Size, POSIX_MADV_NORMAL);
+    if (IndexPath)
+      ADXL345_LogReader_Save(Reader, IndexPath);
+  }
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Unmap the log file
+ * @param  Reader: Pointer to reader
+ * @retval None
+ */
+void
+ADXL345_LogReader_Close(ADXL345_LogReader_t *Reader)
+{
+  if (Reader->Data)
+    munmap((void *)Reader->Data, (size_t)Reader->Size);
+  if (Reader->Fd >= 0)
+    close(Reader->Fd);
+
+  Reader->Data = NULL;
+  Reader->Fd = -1;
+}
+
+/**
+ * @brief  Decode raw samples of a time range into separate axis arrays
+ * @note   Samples lost in gaps are not filled in. Times are in us from the
+ *         first sample of the log.
+ * @param  Reader: Pointer to reader
+ * @param  FromUs: Start of the range
+ * @param  ToUs: End of the range (excluded)
+ * @param  X: X values (NULL if not needed)
+ * @param  Y: Y values (NULL if not needed)
+ * @param  Z: Z values (NULL if not needed)
+ * @param  MaxSamples: Capacity of the arrays
+ * @param  Count: Number of decoded samples
+ * @param  FirstUs: Time of the first decoded sample (NULL if not needed)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_LogReader_Read(ADXL345_LogReader_t *Reader,
+                       uint64_t FromUs, uint64_t ToUs,
+                       int16_t *X, int16_t *Y, int16_t *Z,
+                       uint32_t MaxSamples, uint32_t *Count,
+                       uint64_t *FirstUs)
+{
+  return ADXL345_LogReader_Range(Reader, FromUs, ToUs, X, Y, Z,
+                                 NULL, NULL, NULL, MaxSamples, Count, FirstUs);
+}
+
+/**
+ * @brief  Decode samples of a time range into separate axis arrays in g
+ * @note   Same as ADXL345_LogReader_Read. Values are converted with the range
+ *         and resolution of the log.
+ * @param  Reader: Pointer to reader
+ * @param  FromUs: Start of the range
+ * @param  ToUs: End of the range (excluded)
+ * @param  X: X values (NULL if not needed)
+ * @param  Y: Y values (NULL if not needed)
+ * @param  Z: Z values (NULL if not needed)
+ * @param  MaxSamples: Capacity of the arrays
+ * @param  Count: Number of decoded samples
+ * @param  FirstUs: Time of the first decoded sample (NULL if not needed)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_LogReader_ReadFloat(ADXL345_LogReader_t *Reader,
+                            uint64_t FromUs, uint64_t ToUs,
+                            float *X, float *Y, float *Z,
+                            uint32_t MaxSamples, uint32_t *Count,
+                            uint64_t *FirstUs)
+{
+  if (!X && !Y && !Z)
+    return ADXL345_INVALID_PARAM;
+
+  return ADXL345_LogReader_Range(Reader, FromUs, ToUs, NULL, NULL, NULL,
+                                 X, Y, Z, MaxSamples, Count, FirstUs);
+}
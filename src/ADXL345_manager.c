@@ -0,0 +1,442 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_manager.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 multi-sensor manager and shared-bus scheduler
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include "ADXL345_manager.h"
+#include <string.h>
+
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define ADXL345_MANAGER_NONE    0xFF
+
+
+
+/* Private Macro ----------------------------------------------------------------*/
+// Wrap-around safe time comparison
+#define ADXL345_MANAGER_BEFORE(a, b)  ((int32_t)((a) - (b)) < 0)
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static uint32_t
+ADXL345_Manager_DrainDeadline(ADXL345_ManagerSensor_t *Sensor)
+{
+  ADXL345_Stream_t *Stream = Sensor->Stream;
+  uint32_t PeriodUs = ADXL345_ConvToData_RatePeriodUs(Stream->Config.Rate);
+  uint8_t Free = 1;
+
+  // FIFO holds watermark samples at the interrupt and overruns when full
+  if (Stream->Config.Mode != ADXL345_MODE_BYPASS)
+    Free = ADXL345_FIFO_SIZE - 1 - Stream->FifoConfig.WatermarkSamples;
+
+  return Sensor->ReadyUs + (uint32_t)Free * PeriodUs;
+}
+
+static uint8_t
+ADXL345_Manager_Earlier(uint32_t Deadline, uint8_t Priority,
+                        uint32_t BestDeadline, uint8_t BestPriority)
+{
+  if (ADXL345_MANAGER_BEFORE(Deadline, BestDeadline))
+    return 1;
+
+  return (Deadline == BestDeadline && Priority < BestPriority) ? 1 : 0;
+}
+
+static uint8_t
+ADXL345_Manager_PickDrain(ADXL345_Manager_t *Manager, uint8_t Bus,
+                          uint32_t NowUs, uint32_t *Deadline)
+{
+  struct ADXL345_ManagerBus_s *BusState = &Manager->Bus[Bus];
+  ADXL345_ManagerSensor_t *Sensor = NULL;
+  uint8_t Best = ADXL345_MANAGER_NONE;
+  uint8_t Local = ADXL345_MANAGER_NONE;
+  uint32_t BestDeadline = 0;
+  uint32_t LocalDeadline = 0;
+  uint32_t SensorDeadline = 0;
+  uint32_t Merged = 0;
+  uint8_t i = 0;
+
+  for (i = 0; i < Manager->Sensors; i++)
+  {
+    Sensor = &Manager->Sensor[i];
+    if (Sensor->Bus != Bus)
+      continue;
+
+    // Merged is written by ADXL345_Manager_Notify only, so the interrupt
+    // routine never touches the bus statistics
+    Merged = Sensor->Merged;
+    BusState->Stats.Coalesced += Merged - Sensor->MergedSeen;
+    Sensor->MergedSeen = Merged;
+
+    if (!__atomic_load_n(&Sensor->Pending, __ATOMIC_ACQUIRE))
+      continue;
+
+    SensorDeadline = ADXL345_Manager_DrainDeadline(Sensor);
+    if (Best == ADXL345_MANAGER_NONE ||
+        ADXL345_Manager_Earlier(SensorDeadline, Sensor->Priority,
+                                BestDeadline, Manager->Sensor[Best].Priority))
+    {
+      Best = i;
+      BestDeadline = SensorDeadline;
+    }
+
+    if (ADXL345_Mux_NeedSwitch(Sensor->Stream->Handler))
+      continue;
+
+    if (Local == ADXL345_MANAGER_NONE ||
+        ADXL345_Manager_Earlier(SensorDeadline, Sensor->Priority,
+                                LocalDeadline, Manager->Sensor[Local].Priority))
+    {
+      Local = i;
+      LocalDeadline = SensorDeadline;
+    }
+  }
+
+  // Stay on the selected channel while the most urgent drain can wait for
+  // one more drain and a switch
+  if (Local != ADXL345_MANAGER_NONE && Local != Best &&
+      !ADXL345_MANAGER_BEFORE(BestDeadline,
+                              NowUs + 2 * BusState->DrainUs + BusState->SwitchUs))
+  {
+    BusState->Stats.Batched++;
+    *Deadline = LocalDeadline;
+    return Local;
+  }
+
+  *Deadline = BestDeadline;
+  return Best;
+}
+
+static ADXL345_Result_t
+ADXL345_Manager_Switch(ADXL345_Manager_t *Manager, uint8_t Bus,
+                       ADXL345_Handler_t *Handler)
+{
+  struct ADXL345_ManagerBus_s *BusState = &Manager->Bus[Bus];
+  ADXL345_Result_t Result = ADXL345_OK;
+  uint32_t StartUs = 0;
+  uint32_t ElapsedUs = 0;
+
+  if (!ADXL345_Mux_NeedSwitch(Handler))
+    return ADXL345_OK;
+
+  StartUs = Manager->GetTimeUs();
+  Result = ADXL345_Mux_Select(Handler);
+  ElapsedUs = Manager->GetTimeUs() - StartUs;
+
+  BusState->Stats.Switches++;
+  BusState->Stats.SwitchUs += ElapsedUs;
+  BusState->SwitchUs = BusState->SwitchUs ?
+                       ((3 * BusState->SwitchUs + ElapsedUs) >> 2) : ElapsedUs;
+
+  return Result;
+}
+
+static void
+ADXL345_Manager_Account(ADXL345_Manager_t *Manager, uint8_t Bus,
+                        uint32_t StartUs, uint32_t EndUs)
+{
+  struct ADXL345_ManagerBus_s *BusState = &Manager->Bus[Bus];
+  uint32_t ElapsedUs = 0;
+
+  BusState->Stats.BusyUs += EndUs - StartUs;
+  BusState->WindowBusyUs += EndUs - StartUs;
+
+  ElapsedUs = EndUs - BusState->WindowStartUs;
+  if (ElapsedUs >= ADXL345_MANAGER_UTIL_WINDOW_US)
+  {
+    BusState->Stats.Utilization =
+        (uint16_t)(((uint64_t)BusState->WindowBusyUs * 1000) / ElapsedUs);
+    BusState->WindowBusyUs = 0;
+    BusState->WindowStartUs = EndUs;
+  }
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize manager
+ * @param  Manager: Pointer to manager
+ * @param  Buses: Number of buses (1..ADXL345_MANAGER_MAX_BUSES)
+ * @param  GetTimeUs: Free running time in us
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Manager_Init(ADXL345_Manager_t *Manager, uint8_t Buses,
+                     uint32_t (*GetTimeUs)(void))
+{
+  uint32_t NowUs = 0;
+  uint8_t i = 0;
+
+  if (!Buses || Buses > ADXL345_MANAGER_MAX_BUSES || !GetTimeUs)
+    return ADXL345_INVALID_PARAM;
+
+  memset(Manager, 0, sizeof(ADXL345_Manager_t));
+  Manager->Buses = Buses;
+  Manager->GetTimeUs = GetTimeUs;
+
+  NowUs = GetTimeUs();
+  for (i = 0; i < Buses; i++)
+    Manager->Bus[i].WindowStartUs = NowUs;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Add a sensor to manager
+ * @param  Manager: Pointer to manager
+ * @param  Stream: Pointer to initialized streaming engine of the sensor
+ * @param  Bus: Bus index of the sensor
+ * @param  Priority: Priority of the sensor among equal deadlines
+ * @param  Id: Pointer to store sensor ID
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: No free sensor entry.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Manager_AddSensor(ADXL345_Manager_t *Manager, ADXL345_Stream_t *Stream,
+                          uint8_t Bus, uint8_t Priority, uint8_t *Id)
+{
+  ADXL345_ManagerSensor_t *Sensor = NULL;
+
+  if (!Stream || Bus >= Manager->Buses)
+    return ADXL345_INVALID_PARAM;
+
+  if (Manager->Sensors >= ADXL345_MANAGER_MAX_SENSORS)
+    return ADXL345_FAIL;
+
+  Sensor = &Manager->Sensor[Manager->Sensors];
+  memset(Sensor, 0, sizeof(ADXL345_ManagerSensor_t));
+  Sensor->Stream = Stream;
+  Sensor->Bus = Bus;
+  Sensor->Priority = Priority;
+
+  *Id = Manager->Sensors;
+  Manager->Sensors++;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Request a drain of sensor FIFO
+ * @param  Manager: Pointer to manager
+ * @param  Id: Sensor ID
+ * @retval None
+ */
+void
+ADXL345_Manager_Notify(ADXL345_Manager_t *Manager, uint8_t Id)
+{
+  ADXL345_ManagerSensor_t *Sensor = &Manager->Sensor[Id];
+
+  if (__atomic_load_n(&Sensor->Pending, __ATOMIC_ACQUIRE))
+  {
+    Sensor->Merged++;
+    return;
+  }
+
+  // ReadyUs must be visible before Pending
+  Sensor->ReadyUs = Manager->GetTimeUs();
+  __atomic_store_n(&Sensor->Pending, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief  Queue a configuration job for a sensor
+ * @param  Manager: Pointer to manager
+ * @param  Id: Sensor ID
+ * @param  Key: User defined kind of the job
+ * @param  Priority: Priority among jobs (0 is the highest)
+ * @param  DeadlineUs: Max delay of the job in us from now (0: no deadline)
+ * @param  Run: Job function
+ * @param  Context: User context passed to Run
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Job queue is full.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Manager_Submit(ADXL345_Manager_t *Manager, uint8_t Id, uint8_t Key,
+                       uint8_t Priority, uint32_t DeadlineUs,
+                       ADXL345_ManagerJobFn_t Run, void *Context)
+{
+  ADXL345_ManagerJob_t *Job = NULL;
+  uint8_t i = 0;
+
+  if (Id >= Manager->Sensors || !Run)
+    return ADXL345_INVALID_PARAM;
+
+  for (i = 0; i < ADXL345_MANAGER_MAX_JOBS; i++)
+  {
+    if (Manager->Job[i].Used &&
+        Manager->Job[i].Sensor == Id && Manager->Job[i].Key == Key)
+    {
+      Job = &Manager->Job[i];
+      Manager->Bus[Manager->Sensor[Id].Bus].Stats.Coalesced++;
+      break;
+    }
+    if (!Job && !Manager->Job[i].Used)
+      Job = &Manager->Job[i];
+  }
+
+  if (!Job)
+    return ADXL345_FAIL;
+
+  // A replaced job keeps its place in the queue
+  if (!Job->Used)
+    Job->Order = Manager->JobOrder++;
+
+  Job->Used = 1;
+  Job->Sensor = Id;
+  Job->Key = Key;
+  Job->Priority = Priority;
+  Job->HasDeadline = DeadlineUs ? 1 : 0;
+  Job->DeadlineUs = Manager->GetTimeUs() + DeadlineUs;
+  Job->Run = Run;
+  Job->Context = Context;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Run the most urgent transaction of a bus
+ * @param  Manager: Pointer to manager
+ * @param  Bus: Bus index
+ * @retval 1 if a transaction was run, otherwise 0
+ */
+uint8_t
+ADXL345_Manager_Poll(ADXL345_Manager_t *Manager, uint8_t Bus)
+{
+  ADXL345_ManagerSensor_t *Sensor = NULL;
+  ADXL345_ManagerJob_t *Job = NULL;
+  ADXL345_ManagerJob_t *BestJob = NULL;
+  ADXL345_Handler_t *Handler = NULL;
+  uint8_t BestSensor = ADXL345_MANAGER_NONE;
+  uint32_t BestDeadline = 0;
+  uint32_t StartUs = 0;
+  uint32_t DrainStartUs = 0;
+  uint32_t ReadyUs = 0;
+  uint32_t ElapsedUs = 0;
+  ADXL345_Result_t Result = ADXL345_OK;
+  uint8_t i = 0;
+
+  if (Bus >= Manager->Buses)
+    return 0;
+
+  StartUs = Manager->GetTimeUs();
+
+  // Pending drains, earliest overrun first
+  BestSensor = ADXL345_Manager_PickDrain(Manager, Bus, StartUs, &BestDeadline);
+
+  // Jobs with deadline compete with drains, other jobs run when idle
+  for (i = 0; i < ADXL345_MANAGER_MAX_JOBS; i++)
+  {
+    Job = &Manager->Job[i];
+    if (!Job->Used || Manager->Sensor[Job->Sensor].Bus != Bus)
+      continue;
+
+    if (Job->HasDeadline)
+    {
+      if (BestSensor != ADXL345_MANAGER_NONE &&
+          !ADXL345_MANAGER_BEFORE(Job->DeadlineUs, BestDeadline))
+        continue;
+      if (BestJob && BestJob->HasDeadline &&
+          !ADXL345_MANAGER_BEFORE(Job->DeadlineUs, BestJob->DeadlineUs))
+        continue;
+    }
+    else
+    {
+      if (BestSensor != ADXL345_MANAGER_NONE)
+        continue;
+      if (BestJob && (BestJob->HasDeadline ||
+                      BestJob->Priority < Job->Priority ||
+                      (BestJob->Priority == Job->Priority &&
+                       ADXL345_MANAGER_BEFORE(BestJob->Order, Job->Order))))
+        continue;
+    }
+
+    BestJob = Job;
+  }
+
+  if (BestJob)
+  {
+    BestJob->Used = 0;
+    Handler = Manager->Sensor[BestJob->Sensor].Stream->Handler;
+    Result = ADXL345_Manager_Switch(Manager, Bus, Handler);
+    if (Result == ADXL345_OK)
+      Result = BestJob->Run(Handler, BestJob->Context);
+    Manager->Bus[Bus].Stats.Jobs++;
+  }
+  else if (BestSensor != ADXL345_MANAGER_NONE)
+  {
+    Sensor = &Manager->Sensor[BestSensor];
+    if (ADXL345_MANAGER_BEFORE(BestDeadline, StartUs))
+      Manager->Bus[Bus].Stats.Misses++;
+
+    // Clear before the drain so a new interrupt during it is not lost. A new
+    // request may overwrite ReadyUs right after that.
+    ReadyUs = Sensor->ReadyUs;
+    __atomic_store_n(&Sensor->Pending, 0, __ATOMIC_SEQ_CST);
+    Result = ADXL345_Manager_Switch(Manager, Bus, Sensor->Stream->Handler);
+    if (Result == ADXL345_OK)
+    {
+      DrainStartUs = Manager->GetTimeUs();
+      Result = ADXL345_Stream_IRQAt(Sensor->Stream, ReadyUs);
+      ElapsedUs = Manager->GetTimeUs() - DrainStartUs;
+      Manager->Bus[Bus].DrainUs = Manager->Bus[Bus].DrainUs ?
+          ((3 * Manager->Bus[Bus].DrainUs + ElapsedUs) >> 2) : ElapsedUs;
+    }
+    Manager->Bus[Bus].Stats.Drains++;
+  }
+  else
+  {
+    ADXL345_Manager_Account(Manager, Bus, StartUs, StartUs);
+    return 0;
+  }
+
+  if (Result != ADXL345_OK)
+    Manager->Bus[Bus].Stats.Errors++;
+
+  ADXL345_Manager_Account(Manager, Bus, StartUs, Manager->GetTimeUs());
+
+  return 1;
+}
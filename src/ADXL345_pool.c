@@ -0,0 +1,379 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_pool.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 work-stealing processing pool (POSIX threads)
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include "ADXL345_pool.h"
+#include <string.h>
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static void
+ADXL345_Pool_Enqueue(ADXL345_PoolWorker_t *Worker, ADXL345_PoolSensor_t *Sensor)
+{
+  ADXL345_Pool_t *Pool = Worker->Pool;
+
+  // A sensor is queued at most once, so the queue never overflows
+  pthread_mutex_lock(&Worker->Lock);
+  Worker->Queue[(Worker->Head + Worker->Count) % ADXL345_POOL_MAX_SENSORS] =
+      Sensor;
+  Worker->Count++;
+  pthread_mutex_unlock(&Worker->Lock);
+
+  // Pairs with the barrier after Sleepers++ in the worker loop
+  __sync_fetch_and_add(&Pool->Queued, 1);
+  if (Pool->Sleepers)
+  {
+    pthread_mutex_lock(&Pool->Lock);
+    pthread_cond_signal(&Pool->Wake);
+    pthread_mutex_unlock(&Pool->Lock);
+  }
+}
+
+static ADXL345_PoolSensor_t*
+ADXL345_Pool_Dequeue(ADXL345_PoolWorker_t *Worker, uint8_t Steal)
+{
+  ADXL345_PoolSensor_t *Sensor = NULL;
+
+  pthread_mutex_lock(&Worker->Lock);
+  if (Worker->Count)
+  {
+    Worker->Count--;
+    if (Steal)
+    {
+      Sensor = Worker->Queue[(Worker->Head + Worker->Count) %
+                             ADXL345_POOL_MAX_SENSORS];
+    }
+    else
+    {
+      Sensor = Worker->Queue[Worker->Head];
+      Worker->Head = (Worker->Head + 1) % ADXL345_POOL_MAX_SENSORS;
+    }
+  }
+  pthread_mutex_unlock(&Worker->Lock);
+
+  return Sensor;
+}
+
+static ADXL345_PoolSensor_t*
+ADXL345_Pool_Take(ADXL345_PoolWorker_t *Worker)
+{
+  ADXL345_Pool_t *Pool = Worker->Pool;
+  ADXL345_PoolSensor_t *Sensor = NULL;
+  uint8_t Self = (uint8_t)(Worker - Pool->Worker);
+  uint8_t i = 0;
+
+  Sensor = ADXL345_Pool_Dequeue(Worker, 0);
+  for (i = 1; !Sensor && i < Pool->Workers; i++)
+  {
+    Sensor = ADXL345_Pool_Dequeue(&Pool->Worker[(Self + i) % Pool->Workers], 1);
+    if (Sensor)
+      Worker->Stats.Steals++;
+  }
+
+  if (Sensor)
+  {
+    __sync_fetch_and_sub(&Pool->Queued, 1);
+    // Requeue on the worker that runs it, so it stays warm there
+    Sensor->Home = Self;
+  }
+
+  return Sensor;
+}
+
+static void
+ADXL345_Pool_Run(ADXL345_PoolWorker_t *Worker, ADXL345_PoolSensor_t *Sensor)
+{
+  ADXL345_Pool_t *Pool = Worker->Pool;
+  ADXL345_PoolBurst_t *Burst = NULL;
+  ADXL345_Batch_t Batch;
+  uint8_t i = 0;
+
+  for (i = 0; i < ADXL345_POOL_SENSOR_BATCH; i++)
+  {
+    pthread_mutex_lock(&Sensor->Lock);
+    Burst = Sensor->Head;
+    if (!Burst)
+    {
+      Sensor->Scheduled = 0;
+      pthread_mutex_unlock(&Sensor->Lock);
+      return;
+    }
+    Sensor->Head = Burst->Next;
+    if (!Sensor->Head)
+      Sensor->Tail = NULL;
+    pthread_mutex_unlock(&Sensor->Lock);
+
+    ADXL345_DecodeSamples(&Burst->DataFormat, Burst->Raw,
+                          Worker->Samples, Burst->Count);
+    Batch.Samples = Worker->Samples;
+    Batch.Count = Burst->Count;
+    Batch.Gap = Burst->Gap;
+    Batch.Sequence = Burst->Sequence;
+    Batch.TimestampUs = Burst->TimestampUs;
+    Sensor->Stats.Bursts++;
+    Sensor->Stats.Samples += Batch.Count;
+    Worker->Stats.Bursts++;
+    Sensor->Process(Sensor->Context, &Batch, Burst);
+
+    if (__sync_sub_and_fetch(&Pool->Outstanding, 1) == 0)
+    {
+      pthread_mutex_lock(&Pool->Lock);
+      pthread_cond_broadcast(&Pool->Idle);
+      pthread_mutex_unlock(&Pool->Lock);
+    }
+  }
+
+  // Budget used. Give other sensors a turn if this one still has bursts.
+  pthread_mutex_lock(&Sensor->Lock);
+  if (!Sensor->Head)
+  {
+    Sensor->Scheduled = 0;
+    pthread_mutex_unlock(&Sensor->Lock);
+    return;
+  }
+  pthread_mutex_unlock(&Sensor->Lock);
+
+  ADXL345_Pool_Enqueue(Worker, Sensor);
+}
+
+static void*
+ADXL345_Pool_WorkerMain(void *Argument)
+{
+  ADXL345_PoolWorker_t *Worker = (ADXL345_PoolWorker_t *)Argument;
+  ADXL345_Pool_t *Pool = Worker->Pool;
+  ADXL345_PoolSensor_t *Sensor = NULL;
+
+  for (;;)
+  {
+    Sensor = ADXL345_Pool_Take(Worker);
+    if (Sensor)
+    {
+      ADXL345_Pool_Run(Worker, Sensor);
+      continue;
+    }
+
+    pthread_mutex_lock(&Pool->Lock);
+    Pool->Sleepers++;
+    __sync_synchronize();
+    if (!Pool->Queued)
+    {
+      if (Pool->Stop)
+      {
+        Pool->Sleepers--;
+        pthread_mutex_unlock(&Pool->Lock);
+        break;
+      }
+      Worker->Stats.Sleeps++;
+      pthread_cond_wait(&Pool->Wake, &Pool->Lock);
+    }
+    Pool->Sleepers--;
+    pthread_mutex_unlock(&Pool->Lock);
+  }
+
+  return NULL;
+}
+
+static void
+ADXL345_Pool_StopWorkers(ADXL345_Pool_t *Pool, uint8_t Started)
+{
+  uint8_t i = 0;
+
+  pthread_mutex_lock(&Pool->Lock);
+  Pool->Stop = 1;
+  pthread_cond_broadcast(&Pool->Wake);
+  pthread_mutex_unlock(&Pool->Lock);
+
+  for (i = 0; i < Started; i++)
+    pthread_join(Pool->Worker[i].Thread, NULL);
+
+  for (i = 0; i < Pool->Workers; i++)
+    pthread_mutex_destroy(&Pool->Worker[i].Lock);
+  pthread_cond_destroy(&Pool->Idle);
+  pthread_cond_destroy(&Pool->Wake);
+  pthread_mutex_destroy(&Pool->Lock);
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                            
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize pool and start worker threads
+ * @param  Pool: Pointer to pool
+ * @param  Workers: Number of worker threads (1..ADXL345_POOL_MAX_WORKERS)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to create threads.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Pool_Init(ADXL345_Pool_t *Pool, uint8_t Workers)
+{
+  uint8_t i = 0;
+
+  if (!Pool || !Workers || Workers > ADXL345_POOL_MAX_WORKERS)
+    return ADXL345_INVALID_PARAM;
+
+  memset(Pool, 0, sizeof(ADXL345_Pool_t));
+  Pool->Workers = Workers;
+  pthread_mutex_init(&Pool->Lock, NULL);
+  pthread_cond_init(&Pool->Wake, NULL);
+  pthread_cond_init(&Pool->Idle, NULL);
+  for (i = 0; i < Workers; i++)
+  {
+    Pool->Worker[i].Pool = Pool;
+    pthread_mutex_init(&Pool->Worker[i].Lock, NULL);
+  }
+
+  for (i = 0; i < Workers; i++)
+  {
+    if (pthread_create(&Pool->Worker[i].Thread, NULL,
+                       ADXL345_Pool_WorkerMain, &Pool->Worker[i]) != 0)
+    {
+      ADXL345_Pool_StopWorkers(Pool, i);
+      return ADXL345_FAIL;
+    }
+  }
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Process remaining bursts, stop worker threads and free resources
+ * @param  Pool: Pointer to pool
+ * @retval None
+ */
+void
+ADXL345_Pool_DeInit(ADXL345_Pool_t *Pool)
+{
+  ADXL345_Pool_Drain(Pool);
+  ADXL345_Pool_StopWorkers(Pool, Pool->Workers);
+}
+
+/**
+ * @brief  Add sensor to pool
+ * @note   Sensors are spread over workers in turn. Add all sensors before
+ *         the first submit.
+ * @param  Pool: Pointer to pool
+ * @param  Sensor: Pointer to sensor
+ * @param  Process: Process function of the sensor (decode is done by pool)
+ * @param  Context: Context of process function
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Pool is full.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Pool_AddSensor(ADXL345_Pool_t *Pool, ADXL345_PoolSensor_t *Sensor,
+                       ADXL345_PoolProcessFn_t Process, void *Context)
+{
+  if (!Pool || !Sensor || !Process)
+    return ADXL345_INVALID_PARAM;
+
+  if (Pool->Sensors >= ADXL345_POOL_MAX_SENSORS)
+    return ADXL345_FAIL;
+
+  memset(Sensor, 0, sizeof(ADXL345_PoolSensor_t));
+  Sensor->Process = Process;
+  Sensor->Context = Context;
+  Sensor->Home = (uint8_t)(Pool->Sensors % Pool->Workers);
+  pthread_mutex_init(&Sensor->Lock, NULL);
+  Pool->Sensors++;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Submit a completed raw burst of sensor
+ * @note   Any thread can submit. Bursts of one sensor must be submitted by
+ *         one thread at a time to keep their order.
+ * @param  Pool: Pointer to pool
+ * @param  Sensor: Pointer to sensor
+ * @param  Burst: Pointer to burst
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Pool_Submit(ADXL345_Pool_t *Pool, ADXL345_PoolSensor_t *Sensor,
+                    ADXL345_PoolBurst_t *Burst)
+{
+  uint8_t Schedule = 0;
+
+  if (!Pool || !Sensor || !Burst || !Burst->Raw ||
+      Burst->Count > ADXL345_POOL_MAX_BURST)
+    return ADXL345_INVALID_PARAM;
+
+  Burst->Next = NULL;
+  __sync_fetch_and_add(&Pool->Outstanding, 1);
+
+  pthread_mutex_lock(&Sensor->Lock);
+  if (Sensor->Tail)
+    Sensor->Tail->Next = Burst;
+  else
+    Sensor->Head = Burst;
+  Sensor->Tail = Burst;
+  if (!Sensor->Scheduled)
+  {
+    Sensor->Scheduled = 1;
+    Schedule = 1;
+  }
+  pthread_mutex_unlock(&Sensor->Lock);
+
+  // Only an idle sensor is queued, so one worker at a time runs its bursts
+  if (Schedule)
+    ADXL345_Pool_Enqueue(&Pool->Worker[Sensor->Home], Sensor);
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Wait until all submitted bursts are processed
+ * @param  Pool: Pointer to pool
+ * @retval None
+ */
+void
+ADXL345_Pool_Drain(ADXL345_Pool_t *Pool)
+{
+  pthread_mutex_lock(&Pool->Lock);
+  while (Pool->Outstanding)
+    pthread_cond_wait(&Pool->Idle, &Pool->Lock);
+  pthread_mutex_unlock(&Pool->Lock);
+}
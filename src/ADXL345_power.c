@@ -0,0 +1,274 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_power.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Activity driven Data Rate and power mode manager
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include "ADXL345_power.h"
+#include <string.h>
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static void
+ADXL345_Power_Account(ADXL345_Power_t *Power, uint32_t NowUs)
+{
+  uint32_t Bytes = Power->Stream->Handler->Stats.Bytes;
+
+  Power->Stats.TimeUs[Power->State] += NowUs - Power->LastUs;
+  Power->Stats.BusBytes[Power->State] += Bytes - Power->LastBytes;
+  Power->LastUs = NowUs;
+  Power->LastBytes = Bytes;
+}
+
+
+static ADXL345_Result_t
+ADXL345_Power_Switch(ADXL345_Power_t *Power, ADXL345_PowerState_t State,
+                     uint32_t NowUs)
+{
+  ADXL345_PowerProfile_t *Profile = &Power->Config.Idle;
+
+  if (State == ADXL345_POWER_CAPTURE)
+    Profile = &Power->Config.Capture;
+
+  Power->CheckUs = NowUs + Power->Config.AsleepCheckUs;
+
+  // Idle and asleep share the idle profile
+  if ((Power->State == ADXL345_POWER_CAPTURE) ==
+      (State == ADXL345_POWER_CAPTURE))
+  {
+    Power->State = State;
+    return ADXL345_OK;
+  }
+
+  Power->Stats.Switches++;
+  Power->State = State;
+
+  return ADXL345_Stream_SetRate(Power->Stream, Profile->Rate,
+                                Profile->WatermarkSamples);
+}
+
+
+static ADXL345_Result_t
+ADXL345_Power_OnActivity(ADXL345_Power_t *Power, uint32_t NowUs)
+{
+  if (!Power->Stream->Events.Activity)
+    return ADXL345_OK;
+
+  Power->Stream->Events.Activity = 0;
+  return ADXL345_Power_Switch(Power, ADXL345_POWER_CAPTURE, NowUs);
+}
+
+
+static ADXL345_Result_t
+ADXL345_Power_OnInactivity(ADXL345_Power_t *Power, uint32_t NowUs)
+{
+  if (!Power->Stream->Events.Inactivity)
+    return ADXL345_OK;
+
+  // With auto sleep the device goes to sleep on the inactivity event
+  Power->Stream->Events.Inactivity = 0;
+  return ADXL345_Power_Switch(Power, Power->Config.AutoSleep ?
+                                     ADXL345_POWER_ASLEEP : ADXL345_POWER_IDLE,
+                              NowUs);
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize power manager
+ * @param  Power: Pointer to power manager
+ * @param  Stream: Pointer to streaming engine
+ * @param  Config: Pointer to configuration
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid configuration.
+ */
+ADXL345_Result_t
+ADXL345_Power_Init(ADXL345_Power_t *Power, ADXL345_Stream_t *Stream,
+                   ADXL345_PowerConfig_t *Config)
+{
+  if (Stream->Config.Mode == ADXL345_MODE_BYPASS ||
+      Config->Idle.WatermarkSamples == 0 ||
+      Config->Capture.WatermarkSamples == 0 ||
+      Config->ActivityThreshold == 0 || Config->InactivityTime == 0)
+    return ADXL345_INVALID_PARAM;
+
+  memset(Power, 0, sizeof(ADXL345_Power_t));
+  Power->Stream = Stream;
+  Power->Config = *Config;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Configure activity detection and power control and start
+ *         streaming with the idle profile
+ * @param  Power: Pointer to power manager
+ * @param  NowUs: Current time in us
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Power_Start(ADXL345_Power_t *Power, uint32_t NowUs)
+{
+  ADXL345_Stream_t *Stream = Power->Stream;
+  ADXL345_Handler_t *Handler = Stream->Handler;
+  ADXL345_ActivityInactivity_t ActInact;
+  ADXL345_InterruptConfig_t InterruptConfig;
+  ADXL345_PowerControl_t PowerControl;
+  uint8_t Pin = (Stream->Config.Pin == ADXL345_INTERRUPT_PIN2);
+
+  memset(&ActInact, 0, sizeof(ADXL345_ActivityInactivity_t));
+  ActInact.ActivityThreshold = Power->Config.ActivityThreshold;
+  ActInact.InactivityThreshold = Power->Config.InactivityThreshold;
+  ActInact.InactivityTime = Power->Config.InactivityTime;
+  ActInact.Control.ActivityEnableX = 1;
+  ActInact.Control.ActivityEnableY = 1;
+  ActInact.Control.ActivityEnableZ = 1;
+  ActInact.Control.ActivityCoupled = 1;
+  ActInact.Control.InactivityEnableX = 1;
+  ActInact.Control.InactivityEnableY = 1;
+  ActInact.Control.InactivityEnableZ = 1;
+  ActInact.Control.InactivityCoupled = 1;
+  if (ADXL345_Set_ActivityInactivity(Handler, &ActInact) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  if (ADXL345_Get_InterruptConfig(Handler, &InterruptConfig) != ADXL345_OK)
+    return ADXL345_FAIL;
+  InterruptConfig.Enable.Activity = 1;
+  InterruptConfig.Enable.Inactivity = 1;
+  InterruptConfig.Map.Activity = Pin;
+  InterruptConfig.Map.Inactivity = Pin;
+  if (ADXL345_Set_InterruptConfig(Handler, &InterruptConfig) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  // Link and auto sleep are changed in standby mode. ADXL345_Stream_Start
+  // keeps them when it starts measurement.
+  if (ADXL345_Get_PowerControl(Handler, &PowerControl) != ADXL345_OK)
+    return ADXL345_FAIL;
+  PowerControl.Measure = 0;
+  PowerControl.Sleep = 0;
+  PowerControl.Link = 1;
+  PowerControl.AutoSleep = Power->Config.AutoSleep ? 1 : 0;
+  PowerControl.Wakeup = Power->Config.Wakeup;
+  if (ADXL345_Set_PowerControl(Handler, &PowerControl) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  // In link mode the device looks for activity first
+  Stream->Config.Rate = Power->Config.Idle.Rate;
+  Stream->Config.WatermarkSamples = Power->Config.Idle.WatermarkSamples;
+  Stream->Events.Activity = 0;
+  Stream->Events.Inactivity = 0;
+  Power->State = ADXL345_POWER_IDLE;
+  Power->LastUs = NowUs;
+  Power->LastBytes = Handler->Stats.Bytes;
+
+  return ADXL345_Stream_Start(Stream);
+}
+
+/**
+ * @brief  Service the sensor and switch profiles
+ * @param  Power: Pointer to power manager
+ * @param  NowUs: Current time in us
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Power_Service(ADXL345_Power_t *Power, uint32_t NowUs)
+{
+  ADXL345_ActTapStatus_t Status;
+  ADXL345_Result_t Result = ADXL345_OK;
+
+  ADXL345_Power_Account(Power, NowUs);
+
+  if (Power->State == ADXL345_POWER_ASLEEP)
+  {
+    if ((int32_t)(NowUs - Power->CheckUs) < 0)
+    {
+      Power->Stats.SkippedPolls++;
+      return ADXL345_OK;
+    }
+
+    if (ADXL345_Get_ActTapStatus(Power->Stream->Handler,
+                                 &Status) != ADXL345_OK)
+    {
+      Power->Stats.Errors++;
+      return ADXL345_FAIL;
+    }
+
+    if (Status.Asleep)
+    {
+      Power->CheckUs = NowUs + Power->Config.AsleepCheckUs;
+      return ADXL345_OK;
+    }
+
+    // Woken up by activity. The event is picked up by the stream below.
+    Power->State = ADXL345_POWER_IDLE;
+  }
+
+  if (ADXL345_Stream_IRQ(Power->Stream) != ADXL345_OK)
+  {
+    Power->Stats.Errors++;
+    return ADXL345_FAIL;
+  }
+  ADXL345_Stream_Process(Power->Stream);
+
+  // Link mode alternates the two events, so both in one poll happened in
+  // the order set by the current state
+  if (Power->State == ADXL345_POWER_CAPTURE)
+  {
+    Result = ADXL345_Power_OnInactivity(Power, NowUs);
+    if (Result == ADXL345_OK)
+      Result = ADXL345_Power_OnActivity(Power, NowUs);
+  }
+  else
+  {
+    Result = ADXL345_Power_OnActivity(Power, NowUs);
+    if (Result == ADXL345_OK)
+      Result = ADXL345_Power_OnInactivity(Power, NowUs);
+  }
+
+  if (Result != ADXL345_OK)
+    Power->Stats.Errors++;
+
+  return Result;
+}
@@ -0,0 +1,235 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_pubsub.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 sample stream fan-out to multiple subscribers
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include "ADXL345_pubsub.h"
+#include <string.h>
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize publisher
+ * @param  PubSub: Pointer to publisher
+ * @param  Ring: Shared ring buffer
+ * @param  Size: Number of samples of Ring (power of 2, 2..32768)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_PubSub_Init(ADXL345_PubSub_t *PubSub, ADXL345_Sample_t *Ring,
+                    uint16_t Size)
+{
+  if (!Ring || Size < 2 || (Size & (Size - 1)))
+    return ADXL345_INVALID_PARAM;
+
+  memset(PubSub, 0, sizeof(ADXL345_PubSub_t));
+  PubSub->Ring = Ring;
+  PubSub->Size = Size;
+  PubSub->Mask = Size - 1;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Publish samples
+ * @param  PubSub: Pointer to publisher
+ * @param  Samples: Pointer to samples
+ * @param  Count: Number of samples
+ * @param  Gap: 1 if samples were lost before Samples[0]
+ * @retval None
+ */
+void
+ADXL345_PubSub_Publish(ADXL345_PubSub_t *PubSub,
+                       const ADXL345_Sample_t *Samples, uint16_t Count,
+                       uint8_t Gap)
+{
+  uint32_t Head = PubSub->Head;
+  uint16_t Skip = 0;
+  uint16_t Index = 0;
+  uint16_t Chunk = 0;
+
+  // Only the newest Size samples can be kept
+  if (Count > PubSub->Size)
+    Skip = Count - PubSub->Size;
+
+  Index = (uint16_t)((Head + Skip) & PubSub->Mask);
+  Samples += Skip;
+  Count -= Skip;
+
+  Chunk = PubSub->Size - Index;
+  if (Chunk > Count)
+    Chunk = Count;
+  memcpy(&PubSub->Ring[Index], Samples, Chunk * sizeof(ADXL345_Sample_t));
+  memcpy(PubSub->Ring, &Samples[Chunk], (Count - Chunk) * sizeof(ADXL345_Sample_t));
+
+  if (Gap)
+    PubSub->Gaps++;
+
+  ADXL345_PUBSUB_BARRIER();
+  PubSub->Head = Head + Skip + Count;
+}
+
+/**
+ * @brief  Streaming engine sink that publishes each batch
+ * @param  SinkContext: Pointer to publisher
+ * @param  Batch: Pointer to batch
+ * @retval None
+ */
+void
+ADXL345_PubSub_Sink(void *SinkContext, ADXL345_Batch_t *Batch)
+{
+  ADXL345_PubSub_Publish((ADXL345_PubSub_t *)SinkContext,
+                         Batch->Samples, Batch->Count, Batch->Gap ? 1 : 0);
+}
+
+/**
+ * @brief  Attach subscriber to publisher
+ * @param  Subscriber: Pointer to subscriber
+ * @param  PubSub: Pointer to publisher
+ * @param  Decimation: Deliver every Nth sample (>= 1)
+ * @param  BatchSamples: Min number of samples per view (>= 1)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_PubSub_Subscribe(ADXL345_Subscriber_t *Subscriber,
+                         ADXL345_PubSub_t *PubSub,
+                         uint16_t Decimation, uint16_t BatchSamples)
+{
+  if (!PubSub || !Decimation || !BatchSamples ||
+      ((uint32_t)Decimation * BatchSamples) > PubSub->Size)
+    return ADXL345_INVALID_PARAM;
+
+  memset(Subscriber, 0, sizeof(ADXL345_Subscriber_t));
+  Subscriber->PubSub = PubSub;
+  Subscriber->Decimation = Decimation;
+  Subscriber->BatchSamples = BatchSamples;
+  Subscriber->SeenGaps = PubSub->Gaps;
+  Subscriber->Cursor = PubSub->Head;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Get a view of the next samples of subscriber
+ * @param  Subscriber: Pointer to subscriber
+ * @param  View: Pointer to view
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Not enough samples.
+ */
+ADXL345_Result_t
+ADXL345_PubSub_Peek(ADXL345_Subscriber_t *Subscriber,
+                    ADXL345_SubscriberView_t *View)
+{
+  ADXL345_PubSub_t *PubSub = Subscriber->PubSub;
+  uint32_t Head = PubSub->Head;
+  uint32_t Gaps = 0;
+  uint32_t Lag = 0;
+  uint32_t Available = 0;
+  uint16_t Index = 0;
+  uint16_t Contiguous = 0;
+
+  ADXL345_PUBSUB_BARRIER();
+  Gaps = PubSub->Gaps;
+
+  // Keep one slot away from the producer, it may be writing it right now
+  Lag = Head - Subscriber->Cursor;
+  if (Lag >= PubSub->Size)
+  {
+    Lag = Lag - PubSub->Size + 1;
+    Lag = ((Lag + Subscriber->Decimation - 1) / Subscriber->Decimation) *
+          Subscriber->Decimation;
+    Subscriber->Cursor += Lag;
+    Subscriber->Stats.Dropped += Lag;
+    Subscriber->Lagged = 1;
+  }
+
+  Available = (Head - Subscriber->Cursor) / Subscriber->Decimation;
+  if (Available < Subscriber->BatchSamples)
+    return ADXL345_FAIL;
+
+  Index = (uint16_t)(Subscriber->Cursor & PubSub->Mask);
+  Contiguous = (PubSub->Size - Index + Subscriber->Decimation - 1) /
+               Subscriber->Decimation;
+
+  View->Samples = &PubSub->Ring[Index];
+  View->Count = Subscriber->BatchSamples;
+  if (View->Count > Contiguous)
+    View->Count = Contiguous;
+  View->Stride = Subscriber->Decimation;
+  View->Sequence = Subscriber->Cursor;
+  View->Gap = (Subscriber->Lagged || Gaps != Subscriber->SeenGaps) ? 1 : 0;
+
+  Subscriber->SeenGaps = Gaps;
+  Subscriber->Lagged = 0;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Release a view and advance subscriber cursor
+ * @param  Subscriber: Pointer to subscriber
+ * @param  View: Pointer to view returned by ADXL345_PubSub_Peek
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Samples of the view were overwritten while being
+ *                         read.
+ */
+ADXL345_Result_t
+ADXL345_PubSub_Release(ADXL345_Subscriber_t *Subscriber,
+                       const ADXL345_SubscriberView_t *View)
+{
+  uint32_t Head = 0;
+
+  ADXL345_PUBSUB_BARRIER();
+  Head = Subscriber->PubSub->Head;
+
+  Subscriber->Cursor = View->Sequence + (uint32_t)View->Count * View->Stride;
+
+  if ((Head - View->Sequence) >= Subscriber->PubSub->Size)
+  {
+    Subscriber->Stats.Overruns++;
+    Subscriber->Lagged = 1;
+    return ADXL345_FAIL;
+  }
+
+  Subscriber->Stats.Delivered += View->Count;
+
+  return ADXL345_OK;
+}
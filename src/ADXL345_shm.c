@@ -0,0 +1,423 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_shm.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 shared-memory sample ring for multi-process consumers (Linux)
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Feature Test Macros ----------------------------------------------------------*/
+#define _GNU_SOURCE
+
+/* Includes ---------------------------------------------------------------------*/
+#include "ADXL345_shm.h"
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define ADXL345_SHM_MAGIC     "AXSH"
+#define ADXL345_SHM_VERSION   1
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static ADXL345_Result_t
+ADXL345_Shm_Map(ADXL345_Shm_t *Shm, const char *Name, int Flags, size_t Size)
+{
+  struct stat Stat;
+  void *Map = NULL;
+  int Fd = -1;
+
+  if (strlen(Name) >= sizeof(Shm->Name))
+    return ADXL345_INVALID_PARAM;
+
+  Fd = shm_open(Name, Flags, 0644);
+  if (Fd < 0)
+    return ADXL345_FAIL;
+
+  if (Flags & O_CREAT)
+  {
+    if (ftruncate(Fd, (off_t)Size) != 0)
+    {
+      close(Fd);
+      shm_unlink(Name);
+      return ADXL345_FAIL;
+    }
+  }
+  else
+  {
+    if (fstat(Fd, &Stat) != 0 || (size_t)Stat.st_size < sizeof(ADXL345_ShmRing_t))
+    {
+      close(Fd);
+      return ADXL345_FAIL;
+    }
+    Size = (size_t)Stat.st_size;
+  }
+
+  // Readers write Waiters too, so every process maps it writable
+  Map = mmap(NULL, Size, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+  close(Fd);
+  if (Map == MAP_FAILED)
+  {
+    if (Flags & O_CREAT)
+      shm_unlink(Name);
+    return ADXL345_FAIL;
+  }
+
+  Shm->Ring = (ADXL345_ShmRing_t *)Map;
+  Shm->MapSize = Size;
+  Shm->Owner = (Flags & O_CREAT) ? 1 : 0;
+  strcpy(Shm->Name, Name);
+
+  return ADXL345_OK;
+}
+
+static long
+ADXL345_Shm_Futex(volatile uint32_t *Word, int Op, uint32_t Value,
+                  const struct timespec *Timeout)
+{
+  // Shared futex (no FUTEX_PRIVATE_FLAG), the word is in shared memory
+  return syscall(SYS_futex, Word, Op, Value, Timeout, NULL, 0);
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                            
+ ==================================================================================
+ */
+
+/**
+ * @brief  Create a shared ring (producer)
+ * @param  Shm: Pointer to handle
+ * @param  Name: Shared memory object name (e.g. "/adxl345")
+ * @param  Size: Number of samples (power of 2, >= 2)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to create or map the object.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Shm_Create(ADXL345_Shm_t *Shm, const char *Name, uint32_t Size)
+{
+  ADXL345_ShmRing_t *Ring = NULL;
+  ADXL345_Result_t Result = ADXL345_OK;
+
+  if (!Shm || !Name || Size < 2 || (Size & (Size - 1)))
+    return ADXL345_INVALID_PARAM;
+
+  memset(Shm, 0, sizeof(ADXL345_Shm_t));
+  Result = ADXL345_Shm_Map(Shm, Name, O_CREAT | O_TRUNC | O_RDWR,
+                           sizeof(ADXL345_ShmRing_t) +
+                           (size_t)Size * sizeof(ADXL345_Sample_t));
+  if (Result != ADXL345_OK)
+    return Result;
+
+  Ring = Shm->Ring;
+  Ring->Version = ADXL345_SHM_VERSION;
+  Ring->Size = Size;
+  Ring->SampleSize = sizeof(ADXL345_Sample_t);
+
+  // Readers accept the ring only after the magic is visible
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(Ring->Magic, ADXL345_SHM_MAGIC, 4);
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Attach a reader to an existing shared ring
+ * @note   Delivery starts from the next published sample.
+ * @param  Reader: Pointer to reader
+ * @param  Name: Shared memory object name
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Object does not exist or is not a compatible ring.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Shm_Open(ADXL345_ShmReader_t *Reader, const char *Name)
+{
+  ADXL345_ShmRing_t *Ring = NULL;
+  ADXL345_Result_t Result = ADXL345_OK;
+
+  if (!Reader || !Name)
+    return ADXL345_INVALID_PARAM;
+
+  memset(Reader, 0, sizeof(ADXL345_ShmReader_t));
+  Result = ADXL345_Shm_Map(&Reader->Shm, Name, O_RDWR, 0);
+  if (Result != ADXL345_OK)
+    return Result;
+
+  Ring = Reader->Shm.Ring;
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  if (memcmp(Ring->Magic, ADXL345_SHM_MAGIC, 4) != 0 ||
+      Ring->Version != ADXL345_SHM_VERSION ||
+      Ring->SampleSize != sizeof(ADXL345_Sample_t) ||
+      Reader->Shm.MapSize <
+      sizeof(ADXL345_ShmRing_t) + (size_t)Ring->Size * sizeof(ADXL345_Sample_t))
+  {
+    ADXL345_Shm_Close(&Reader->Shm);
+    return ADXL345_FAIL;
+  }
+
+  Reader->Cursor = __atomic_load_n(&Ring->Head, __ATOMIC_ACQUIRE);
+  Reader->SeenGaps = Ring->Gaps;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Unmap the shared ring. The producer also removes its name.
+ * @param  Shm: Pointer to handle
+ * @retval None
+ */
+void
+ADXL345_Shm_Close(ADXL345_Shm_t *Shm)
+{
+  if (!Shm->Ring)
+    return;
+
+  munmap(Shm->Ring, Shm->MapSize);
+  Shm->Ring = NULL;
+
+  // Mapped readers keep their mapping until they close it
+  if (Shm->Owner)
+    shm_unlink(Shm->Name);
+}
+
+/**
+ * @brief  Publish samples
+ * @note   Lock-free, independent of the number of readers. Sleeping readers
+ *         cost one system call per publish.
+ * @param  Shm: Pointer to handle
+ * @param  Samples: Pointer to samples
+ * @param  Count: Number of samples
+ * @param  Gap: 1 if samples were lost before Samples[0]
+ * @retval None
+ */
+void
+ADXL345_Shm_Publish(ADXL345_Shm_t *Shm, const ADXL345_Sample_t *Samples,
+                    uint32_t Count, uint8_t Gap)
+{
+  ADXL345_ShmRing_t *Ring = Shm->Ring;
+  uint64_t Head = Ring->Head;
+  uint32_t Mask = Ring->Size - 1;
+  uint32_t Skip = 0;
+  uint32_t Index = 0;
+  uint32_t Chunk = 0;
+
+  // Only the newest Size samples can be kept
+  if (Count > Ring->Size)
+    Skip = Count - Ring->Size;
+  Samples += Skip;
+  Count -= Skip;
+  Head += Skip;
+
+  // Readers of the slots about to be written see Reserve before the data
+  __atomic_store_n(&Ring->Reserve, Head + Count, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+  Index = (uint32_t)(Head & Mask);
+  Chunk = Ring->Size - Index;
+  if (Chunk > Count)
+    Chunk = Count;
+  memcpy(&Ring->Ring[Index], Samples, Chunk * sizeof(ADXL345_Sample_t));
+  memcpy(Ring->Ring, &Samples[Chunk], (Count - Chunk) * sizeof(ADXL345_Sample_t));
+
+  if (Gap)
+    Ring->Gaps++;
+
+  __atomic_store_n(&Ring->Head, Head + Count, __ATOMIC_RELEASE);
+  __atomic_add_fetch(&Ring->Notify, 1, __ATOMIC_SEQ_CST);
+
+  if (__atomic_load_n(&Ring->Waiters, __ATOMIC_SEQ_CST))
+    ADXL345_Shm_Futex(&Ring->Notify, FUTEX_WAKE, INT32_MAX, NULL);
+}
+
+/**
+ * @brief  Streaming engine sink that publishes each batch
+ * @note   Set Stream->Sink to this function and Stream->SinkContext to the
+ *         handle.
+ * @param  SinkContext: Pointer to handle
+ * @param  Batch: Pointer to batch
+ * @retval None
+ */
+void
+ADXL345_Shm_Sink(void *SinkContext, ADXL345_Batch_t *Batch)
+{
+  ADXL345_Shm_Publish((ADXL345_Shm_t *)SinkContext, Batch->Samples,
+                      Batch->Count, Batch->Gap ? 1 : 0);
+}
+
+/**
+ * @brief  Get a view of the next samples of reader
+ * @note   The view holds all available samples up to MaxSamples, or fewer
+ *         when they cross the end of the ring.
+ * @param  Reader: Pointer to reader
+ * @param  View: Pointer to view
+ * @param  MinSamples: Min number of available samples (>= 1)
+ * @param  MaxSamples: Max number of samples of the view
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Not enough samples.
+ */
+ADXL345_Result_t
+ADXL345_Shm_Peek(ADXL345_ShmReader_t *Reader, ADXL345_ShmView_t *View,
+                 uint32_t MinSamples, uint32_t MaxSamples)
+{
+  ADXL345_ShmRing_t *Ring = Reader->Shm.Ring;
+  uint64_t Head = __atomic_load_n(&Ring->Head, __ATOMIC_ACQUIRE);
+  uint64_t Reserve = __atomic_load_n(&Ring->Reserve, __ATOMIC_ACQUIRE);
+  uint32_t Gaps = Ring->Gaps;
+  uint64_t Available = 0;
+  uint32_t Index = 0;
+  uint32_t Contiguous = 0;
+
+  // Samples older than Reserve - Size are overwritten or being overwritten
+  if (Reserve - Reader->Cursor > Ring->Size)
+  {
+    Reader->Stats.Dropped += Reserve - Ring->Size - Reader->Cursor;
+    Reader->Cursor = Reserve - Ring->Size;
+    Reader->Lagged = 1;
+  }
+
+  Available = Head - Reader->Cursor;
+  if (Available < MinSamples || !Available)
+    return ADXL345_FAIL;
+
+  Index = (uint32_t)(Reader->Cursor & (Ring->Size - 1));
+  Contiguous = Ring->Size - Index;
+
+  View->Samples = &Ring->Ring[Index];
+  View->Count = (uint32_t)((Available < MaxSamples) ? Available : MaxSamples);
+  if (View->Count > Contiguous)
+    View->Count = Contiguous;
+  View->Sequence = Reader->Cursor;
+  View->Gap = (Reader->Lagged || Gaps != Reader->SeenGaps) ? 1 : 0;
+
+  Reader->SeenGaps = Gaps;
+  Reader->Lagged = 0;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Release a view and advance reader cursor
+ * @param  Reader: Pointer to reader
+ * @param  View: Pointer to view returned by ADXL345_Shm_Peek
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Samples of the view were overwritten while being
+ *                         read. Results computed from the view must be
+ *                         dropped.
+ */
+ADXL345_Result_t
+ADXL345_Shm_Release(ADXL345_ShmReader_t *Reader,
+                    const ADXL345_ShmView_t *View)
+{
+  ADXL345_ShmRing_t *Ring = Reader->Shm.Ring;
+  uint64_t Reserve = 0;
+
+  // Reads of the view must complete before Reserve is checked
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  Reserve = __atomic_load_n(&Ring->Reserve, __ATOMIC_RELAXED);
+
+  Reader->Cursor = View->Sequence + View->Count;
+
+  if (Reserve - View->Sequence > Ring->Size)
+  {
+    Reader->Stats.Overruns++;
+    Reader->Lagged = 1;
+    return ADXL345_FAIL;
+  }
+
+  Reader->Stats.Delivered += View->Count;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Sleep until MinSamples samples are available
+ * @param  Reader: Pointer to reader
+ * @param  MinSamples: Min number of available samples (>= 1)
+ * @param  TimeoutMs: Max waiting time in ms
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Timeout.
+ */
+ADXL345_Result_t
+ADXL345_Shm_Wait(ADXL345_ShmReader_t *Reader, uint32_t MinSamples,
+                 uint32_t TimeoutMs)
+{
+  ADXL345_ShmRing_t *Ring = Reader->Shm.Ring;
+  struct timespec Now;
+  struct timespec Timeout;
+  int64_t LeftNs = (int64_t)TimeoutMs * 1000000;
+  int64_t StartNs = 0;
+  uint32_t Seen = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+  StartNs = (int64_t)Now.tv_sec * 1000000000 + Now.tv_nsec;
+
+  for (;;)
+  {
+    Seen = __atomic_load_n(&Ring->Notify, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&Ring->Head, __ATOMIC_ACQUIRE) - Reader->Cursor >=
+        MinSamples)
+      return ADXL345_OK;
+
+    if (LeftNs <= 0)
+      return ADXL345_FAIL;
+
+    // Pairs with Notify++ then Waiters check in ADXL345_Shm_Publish
+    __atomic_add_fetch(&Ring->Waiters, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&Ring->Notify, __ATOMIC_SEQ_CST) == Seen)
+    {
+      Timeout.tv_sec = LeftNs / 1000000000;
+      Timeout.tv_nsec = LeftNs % 1000000000;
+      ADXL345_Shm_Futex(&Ring->Notify, FUTEX_WAIT, Seen, &Timeout);
+    }
+    __atomic_sub_fetch(&Ring->Waiters, 1, __ATOMIC_SEQ_CST);
+
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+    LeftNs = (int64_t)TimeoutMs * 1000000 -
+             ((int64_t)Now.tv_sec * 1000000000 + Now.tv_nsec - StartNs);
+  }
+}
@@ -0,0 +1,432 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_stats.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 streaming vibration statistics
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include "ADXL345_stats.h"
+#include <string.h>
+#include <math.h>
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static uint32_t
+ADXL345_Stats_Sqrt64(uint64_t Value)
+{
+  uint64_t Result = 0;
+  uint64_t Bit = (uint64_t)1 << 62;
+
+  while (Bit > Value)
+    Bit >>= 2;
+
+  while (Bit)
+  {
+    if (Value >= Result + Bit)
+    {
+      Value -= Result + Bit;
+      Result = (Result >> 1) + Bit;
+    }
+    else
+      Result >>= 1;
+    Bit >>= 2;
+  }
+
+  return (uint32_t)Result;
+}
+
+static uint64_t
+ADXL345_Stats_MulDiv64(uint64_t a, uint64_t b, uint64_t c)
+{
+  uint64_t Hi = 0;
+  uint64_t Lo = 0;
+  uint64_t Mid1 = 0;
+  uint64_t Mid2 = 0;
+  uint64_t Quotient = 0;
+  uint64_t Remainder = 0;
+  uint8_t Carry = 0;
+  int8_t i = 0;
+
+  // 128-bit product from 32-bit halves
+  Lo = (a & 0xFFFFFFFFu) * (b & 0xFFFFFFFFu);
+  Mid1 = (a >> 32) * (b & 0xFFFFFFFFu);
+  Mid2 = (a & 0xFFFFFFFFu) * (b >> 32);
+  Hi = (a >> 32) * (b >> 32);
+  Hi += (Mid1 >> 32) + (Mid2 >> 32);
+  Mid1 <<= 32;
+  Mid2 <<= 32;
+  Lo += Mid1;
+  Hi += (Lo < Mid1);
+  Lo += Mid2;
+  Hi += (Lo < Mid2);
+
+  // Quotient does not fit in 64 bits
+  if (Hi >= c)
+    return UINT64_MAX;
+
+  // Restoring division, one bit of Lo at a time
+  Remainder = Hi;
+  for (i = 63; i >= 0; i--)
+  {
+    Carry = (uint8_t)(Remainder >> 63);
+    Remainder = (Remainder << 1) | ((Lo >> i) & 1);
+    Quotient <<= 1;
+    if (Carry || (Remainder >= c))
+    {
+      Remainder -= c;
+      Quotient |= 1;
+    }
+  }
+
+  return Quotient;
+}
+
+static int64_t
+ADXL345_Stats_ToInt64(uint64_t Value)
+{
+  // Two's complement value of a wrapped sum, without implementation-defined
+  // conversion
+  if (Value > (uint64_t)INT64_MAX)
+    return -(int64_t)(~Value) - 1;
+  return (int64_t)Value;
+}
+
+static int64_t
+ADXL345_Stats_RoundDiv(int64_t Num, int64_t Den)
+{
+  if (Num < 0)
+    return -((-Num + Den / 2) / Den);
+  return (Num + Den / 2) / Den;
+}
+
+static void
+ADXL345_StatsF_UpdateAxis(struct ADXL345_StatsAxisStateF_s *Axis,
+                          uint16_t Count, float Value)
+{
+  float n = (float)(Count + 1);
+  float Delta = Value - Axis->Mean;
+  float DeltaN = Delta / n;
+  float DeltaN2 = DeltaN * DeltaN;
+  float Term1 = Delta * DeltaN * (float)Count;
+
+  Axis->Mean += DeltaN;
+  Axis->M4 += Term1 * DeltaN2 * (n * n - 3.0f * n + 3.0f) +
+              6.0f * DeltaN2 * Axis->M2 - 4.0f * DeltaN * Axis->M3;
+  Axis->M3 += Term1 * DeltaN * (n - 2.0f) - 3.0f * DeltaN * Axis->M2;
+  Axis->M2 += Term1;
+
+  if (Count == 0)
+  {
+    Axis->Min = Value;
+    Axis->Max = Value;
+  }
+  else if (Value < Axis->Min)
+    Axis->Min = Value;
+  else if (Value > Axis->Max)
+    Axis->Max = Value;
+}
+
+static void
+ADXL345_StatsF_FinishAxis(struct ADXL345_StatsAxisStateF_s *Axis,
+                          uint16_t Count, ADXL345_AxisStatsF_t *Result)
+{
+  float n = (float)Count;
+  float Peak = 0.0f;
+
+  memset(Result, 0, sizeof(ADXL345_AxisStatsF_t));
+
+  Result->Mean = Axis->Mean;
+  Result->Rms = sqrtf(Axis->M2 / n);
+  Result->PeakToPeak = Axis->Max - Axis->Min;
+
+  Peak = Axis->Max - Axis->Mean;
+  if ((Axis->Mean - Axis->Min) > Peak)
+    Peak = Axis->Mean - Axis->Min;
+
+  if (Result->Rms > 0.0f)
+    Result->CrestFactor = Peak / Result->Rms;
+
+  if (Axis->M2 > 0.0f)
+    Result->Kurtosis = n * Axis->M4 / (Axis->M2 * Axis->M2);
+}
+
+static void
+ADXL345_StatsQ_UpdateAxis(struct ADXL345_StatsAxisStateQ_s *Axis,
+                          uint16_t Count, int16_t Value)
+{
+  int32_t d = 0;
+  int64_t d2 = 0;
+
+  if (Count == 0)
+  {
+    Axis->Ref = Value;
+    Axis->Min = Value;
+    Axis->Max = Value;
+  }
+  else if (Value < Axis->Min)
+    Axis->Min = Value;
+  else if (Value > Axis->Max)
+    Axis->Max = Value;
+
+  d = (int32_t)Value - Axis->Ref;
+  d2 = (int64_t)d * d;
+
+  Axis->S1 += d;
+  Axis->S2 += d2;
+  Axis->S3 += d2 * d;
+  Axis->S4 += d2 * d2;
+}
+
+static void
+ADXL345_StatsQ_FinishAxis(struct ADXL345_StatsAxisStateQ_s *Axis,
+                          uint16_t Count, ADXL345_AxisStatsQ_t *Result)
+{
+  int64_t n = Count;
+  int64_t q = 0;    // Integer part of the mean around Ref
+  int64_t r = 0;    // Remainder of the mean, 0..n-1
+  uint64_t uq = 0;
+  uint64_t uS1 = 0;
+  uint64_t uS2 = 0;
+  uint64_t uS3 = 0;
+  int64_t S2 = 0;   // Power sums around Ref + q
+  int64_t S3 = 0;
+  int64_t S4 = 0;
+  int64_t C2 = 0;   // n * sum((x - mean)^2)
+  int64_t C4 = 0;   // sum((x - mean)^4), QFrac
+  int64_t Bound = 0;
+  int64_t One = 1;
+  uint8_t Frac = 0;
+  int64_t M2 = 0;   // Q8, variance
+  uint64_t Kurtosis = 0;
+  int32_t Peak = 0;
+
+  memset(Result, 0, sizeof(ADXL345_AxisStatsQ_t));
+
+  q = Axis->S1 / n;
+  r = Axis->S1 - q * n;
+  if (r < 0)
+  {
+    q--;
+    r += n;
+  }
+
+  // Move the sums to Ref + q by binomial expansion. Terms can wrap, but the
+  // results are sums of (x - Ref - q)^k with |x - Ref - q| below the sample
+  // range, so they fit and modulo 2^64 arithmetic gives them exactly.
+  uq = (uint64_t)q;
+  uS1 = (uint64_t)(int64_t)Axis->S1;
+  uS2 = (uint64_t)Axis->S2;
+  uS3 = (uint64_t)Axis->S3;
+  S2 = ADXL345_Stats_ToInt64(uS2 - 2 * uq * uS1 + uq * uq * (uint64_t)n);
+  S3 = ADXL345_Stats_ToInt64(uS3 - 3 * uq * uS2 + 3 * uq * uq * uS1 -
+                             uq * uq * uq * (uint64_t)n);
+  S4 = ADXL345_Stats_ToInt64((uint64_t)Axis->S4 - 4 * uq * uS3 +
+                             6 * uq * uq * uS2 - 4 * uq * uq * uq * uS1 +
+                             uq * uq * uq * uq * (uint64_t)n);
+
+  // Central sums around the mean Ref + q + r/n. Sum of (x - Ref - q) is r.
+  C2 = n * S2 - r * r;
+  if (C2 < 0)
+    C2 = 0;
+
+  // Small signals get fractional bits, so rounding of the correction terms
+  // does not swamp C4
+  Bound = S4 + 4 * r * (S3 < 0 ? -S3 : S3) + 6 * r * r * S2 +
+          3 * r * r * r * r;
+  while ((Frac < 32) && (Bound < ((int64_t)1 << (59 - Frac))) &&
+         (C2 < ((int64_t)1 << (61 - Frac))))
+    Frac++;
+  One <<= Frac;
+
+  C4 = S4 * One - ADXL345_Stats_RoundDiv(4 * r * S3 * One, n) +
+       ADXL345_Stats_RoundDiv(6 * r * r * S2 * One, n * n) -
+       ADXL345_Stats_RoundDiv(3 * r * r * r * r * One, n * n * n);
+  if (C4 < 0)
+    C4 = 0;
+
+  M2 = ADXL345_Stats_RoundDiv(C2 * 256, n * n);
+
+  Result->Mean = (int32_t)(((int64_t)Axis->Ref + q) * 16 +
+                           ADXL345_Stats_RoundDiv(r * 16, n));
+  Result->Rms = (int32_t)ADXL345_Stats_Sqrt64((uint64_t)M2);
+  Result->PeakToPeak = (int32_t)Axis->Max - Axis->Min;
+
+  Peak = (int32_t)Axis->Max * 16 - Result->Mean;
+  if ((Result->Mean - (int32_t)Axis->Min * 16) > Peak)
+    Peak = Result->Mean - (int32_t)Axis->Min * 16;
+
+  if (Result->Rms > 0)
+    Result->CrestFactor = (Peak * 256) / Result->Rms;
+
+  // Kurtosis = n * C4 / (C2 / n)^2 = n^3 * C4 / C2^2, in Q8. The two
+  // floor divisions by C2 equal one division by C2^2.
+  if (C2 > 0)
+  {
+    Kurtosis = ADXL345_Stats_MulDiv64((uint64_t)C4,
+                                      (uint64_t)(n * n * n) << 8,
+                                      (uint64_t)(C2 * One));
+    Kurtosis /= (uint64_t)C2;
+    if (Kurtosis > INT32_MAX)
+      Kurtosis = INT32_MAX;
+    Result->Kurtosis = (int32_t)Kurtosis;
+  }
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize floating-point window statistics
+ * @param  Stats: Pointer to statistics
+ * @param  WindowSamples: Number of samples per window (> 1)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid window length.
+ */
+ADXL345_Result_t
+ADXL345_StatsF_Init(ADXL345_StatsF_t *Stats, uint16_t WindowSamples)
+{
+  if (WindowSamples < 2)
+    return ADXL345_INVALID_PARAM;
+
+  memset(Stats, 0, sizeof(ADXL345_StatsF_t));
+  Stats->WindowSamples = WindowSamples;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Restart the current window
+ * @param  Stats: Pointer to statistics
+ * @retval None
+ */
+void
+ADXL345_StatsF_Reset(ADXL345_StatsF_t *Stats)
+{
+  Stats->Count = 0;
+  memset(Stats->Axis, 0, sizeof(Stats->Axis));
+}
+
+/**
+ * @brief  Add one sample (AccelX, AccelY and AccelZ are used)
+ * @param  Stats: Pointer to statistics
+ * @param  Sample: Pointer to sample
+ * @retval 1 if the window is completed and Stats->Result is updated,
+ *         otherwise 0
+ */
+uint8_t
+ADXL345_StatsF_Push(ADXL345_StatsF_t *Stats, const ADXL345_Sample_t *Sample)
+{
+  ADXL345_StatsF_UpdateAxis(&Stats->Axis[0], Stats->Count, Sample->AccelX);
+  ADXL345_StatsF_UpdateAxis(&Stats->Axis[1], Stats->Count, Sample->AccelY);
+  ADXL345_StatsF_UpdateAxis(&Stats->Axis[2], Stats->Count, Sample->AccelZ);
+  Stats->Count++;
+
+  if (Stats->Count < Stats->WindowSamples)
+    return 0;
+
+  ADXL345_StatsF_FinishAxis(&Stats->Axis[0], Stats->Count, &Stats->Result.X);
+  ADXL345_StatsF_FinishAxis(&Stats->Axis[1], Stats->Count, &Stats->Result.Y);
+  ADXL345_StatsF_FinishAxis(&Stats->Axis[2], Stats->Count, &Stats->Result.Z);
+  Stats->Result.Samples = Stats->Count;
+
+  ADXL345_StatsF_Reset(Stats);
+
+  return 1;
+}
+
+/**
+ * @brief  Initialize fixed-point window statistics
+ * @param  Stats: Pointer to statistics
+ * @param  WindowSamples: Number of samples per window
+ *                        (2..ADXL345_STATSQ_MAX_WINDOW)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid window length.
+ */
+ADXL345_Result_t
+ADXL345_StatsQ_Init(ADXL345_StatsQ_t *Stats, uint16_t WindowSamples)
+{
+  if ((WindowSamples < 2) || (WindowSamples > ADXL345_STATSQ_MAX_WINDOW))
+    return ADXL345_INVALID_PARAM;
+
+  memset(Stats, 0, sizeof(ADXL345_StatsQ_t));
+  Stats->WindowSamples = WindowSamples;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Restart the current window
+ * @param  Stats: Pointer to statistics
+ * @retval None
+ */
+void
+ADXL345_StatsQ_Reset(ADXL345_StatsQ_t *Stats)
+{
+  Stats->Count = 0;
+  memset(Stats->Axis, 0, sizeof(Stats->Axis));
+}
+
+/**
+ * @brief  Add one sample (RawX, RawY and RawZ are used)
+ * @param  Stats: Pointer to statistics
+ * @param  Sample: Pointer to sample
+ * @retval 1 if the window is completed and Stats->Result is updated,
+ *         otherwise 0
+ */
+uint8_t
+ADXL345_StatsQ_Push(ADXL345_StatsQ_t *Stats, const ADXL345_Sample_t *Sample)
+{
+  ADXL345_StatsQ_UpdateAxis(&Stats->Axis[0], Stats->Count, Sample->RawX);
+  ADXL345_StatsQ_UpdateAxis(&Stats->Axis[1], Stats->Count, Sample->RawY);
+  ADXL345_StatsQ_UpdateAxis(&Stats->Axis[2], Stats->Count, Sample->RawZ);
+  Stats->Count++;
+
+  if (Stats->Count < Stats->WindowSamples)
+    return 0;
+
+  ADXL345_StatsQ_FinishAxis(&Stats->Axis[0], Stats->Count, &Stats->Result.X);
+  ADXL345_StatsQ_FinishAxis(&Stats->Axis[1], Stats->Count, &Stats->Result.Y);
+  ADXL345_StatsQ_FinishAxis(&Stats->Axis[2], Stats->Count, &Stats->Result.Z);
+  Stats->Result.Samples = Stats->Count;
+
+  ADXL345_StatsQ_Reset(Stats);
+
+  return 1;
+}
@@ -0,0 +1,989 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_stream.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 streaming helpers
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include "ADXL345_stream.h"
+#include <string.h>
+
+
+
+/* Private Constants ------------------------------------------------------------*/
+/**
+ * @brief  FIFO capacity (not counting the output data registers)
+ */
+#define ADXL345_STREAM_FIFO_ENTRIES   32
+
+/**
+ * @brief  Max value of WatermarkSamples
+ */
+#define ADXL345_STREAM_MAX_WATERMARK  31
+
+/**
+ * @brief  Min number of drained samples per ODR estimate of the polling
+ *         scheduler (one sample of quantization error is 0.4%)
+ */
+#define ADXL345_POLLSCHED_WINDOW      256
+
+
+/* Private Macro ----------------------------------------------------------------*/
+#ifndef MIN
+#define MIN(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+
+#ifndef MAX
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+
+#if (ADXL345_STREAM_SLOTS & (ADXL345_STREAM_SLOTS - 1)) != 0
+#error "ADXL345_STREAM_SLOTS must be a power of 2"
+#endif
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static uint8_t
+ADXL345_WatermarkCtrl_Target(ADXL345_WatermarkCtrl_t *Ctrl)
+{
+  uint32_t ByBudget = 0;
+  uint32_t ByHeadroom = 0;
+  uint32_t HeadroomSamples = 0;
+  uint32_t Target = 0;
+
+  // The oldest sample waits Watermark periods plus the drain itself
+  if (Ctrl->LatencyBudgetUs > Ctrl->DrainLatencyUs)
+    ByBudget = (Ctrl->LatencyBudgetUs - Ctrl->DrainLatencyUs) /
+               Ctrl->SamplePeriodUs;
+
+  // Keep room for twice the drain latency above the watermark
+  HeadroomSamples = (2 * Ctrl->DrainLatencyUs + Ctrl->SamplePeriodUs - 1) /
+                    Ctrl->SamplePeriodUs;
+  if (HeadroomSamples < ADXL345_STREAM_FIFO_ENTRIES)
+    ByHeadroom = ADXL345_STREAM_FIFO_ENTRIES - HeadroomSamples;
+
+  Target = MIN(ByBudget, ByHeadroom);
+  Target = MAX(Target, Ctrl->MinWatermark);
+  Target = MIN(Target, Ctrl->MaxWatermark);
+
+  return (uint8_t)Target;
+}
+
+
+static ADXL345_Result_t
+ADXL345_Stream_SetMeasure(ADXL345_Stream_t *Stream, uint8_t Measure)
+{
+  ADXL345_PowerControl_t PowerControl;
+
+  if (ADXL345_Get_PowerControl(Stream->Handler, &PowerControl) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  PowerControl.Measure = Measure ? 1 : 0;
+  if (Measure)
+    PowerControl.Sleep = 0;
+
+  return ADXL345_Set_PowerControl(Stream->Handler, &PowerControl);
+}
+
+static ADXL345_Result_t
+ADXL345_Stream_SetInterrupts(ADXL345_Stream_t *Stream, uint8_t Enable)
+{
+  ADXL345_InterruptConfig_t InterruptConfig;
+  uint8_t Bypass = (Stream->Config.Mode == ADXL345_MODE_BYPASS);
+  uint8_t Pin = (Stream->Config.Pin == ADXL345_INTERRUPT_PIN2);
+
+  if (ADXL345_Get_InterruptConfig(Stream->Handler,
+                                  &InterruptConfig) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  InterruptConfig.Enable.Overrun = (Enable && !Bypass) ? 1 : 0;
+  InterruptConfig.Enable.Watermark = (Enable && !Bypass) ? 1 : 0;
+  InterruptConfig.Enable.DataReady = (Enable && Bypass) ? 1 : 0;
+
+  InterruptConfig.Map.Overrun = Pin;
+  InterruptConfig.Map.Watermark = Pin;
+  InterruptConfig.Map.DataReady = Pin;
+
+  return ADXL345_Set_InterruptConfig(Stream->Handler, &InterruptConfig);
+}
+
+static ADXL345_Result_t
+ADXL345_Stream_Drain(ADXL345_Stream_t *Stream, uint8_t *Raw,
+                     const uint8_t *Sample, uint8_t Watermark,
+                     uint8_t *Count, uint32_t *TimestampUs)
+{
+  ADXL345_FifoStatus_t FifoStatus;
+  uint8_t Known = 0;
+  uint8_t TopUp = 0;
+
+  *Count = 0;
+
+  // Without FIFO the sample was read along with INT_SOURCE
+  if (Stream->Config.Mode == ADXL345_MODE_BYPASS)
+  {
+    memcpy(Raw, Sample, 6);
+    *Count = 1;
+    return ADXL345_OK;
+  }
+
+  // Watermark entries are known to be present, read them before FIFO_STATUS
+  if (Watermark)
+    Known = MIN(Stream->FifoConfig.WatermarkSamples, ADXL345_FIFO_SIZE);
+
+  if (ADXL345_ReadRawSamples(Stream->Handler, Raw, Known) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  if (ADXL345_Get_FifoStatus(Stream->Handler, &FifoStatus) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  // Newest sample of the burst is the last one counted by FIFO_STATUS; the
+  // time spent reading the top-up must not shift the timeline
+  if (Stream->GetTimeUs)
+    *TimestampUs = Stream->GetTimeUs();
+
+  TopUp = MIN(FifoStatus.Entries, ADXL345_FIFO_SIZE - Known);
+  if (ADXL345_ReadRawSamples(Stream->Handler,
+                             Raw + 6 * Known, TopUp) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  *Count = Known + TopUp;
+
+  return ADXL345_OK;
+}
+
+static void
+ADXL345_Stream_Forward(ADXL345_Stream_t *Stream,
+                       ADXL345_InterruptReg_t *Interrupt)
+{
+  ADXL345_Handler_t *Handler = Stream->Handler;
+
+  if (Handler->InterruptCallback == NULL)
+    return;
+
+  if (Stream->Running == 0)
+  {
+    if (Interrupt->Overrun)
+      Handler->InterruptCallback(ADXL345_INTERRUPT_OVERRUN);
+    if (Interrupt->Watermark)
+      Handler->InterruptCallback(ADXL345_INTERRUPT_WATERMARK);
+  }
+
+  if (Interrupt->FreeFall)
+    Handler->InterruptCallback(ADXL345_INTERRUPT_FREE_FALL);
+  if (Interrupt->Inactivity)
+    Handler->InterruptCallback(ADXL345_INTERRUPT_INACTIVITY);
+  if (Interrupt->Activity)
+    Handler->InterruptCallback(ADXL345_INTERRUPT_ACTIVITY);
+  if (Interrupt->DoubleTap)
+    Handler->InterruptCallback(ADXL345_INTERRUPT_DOUBLE_TAP);
+  if (Interrupt->SingleTap)
+    Handler->InterruptCallback(ADXL345_INTERRUPT_SINGLE_TAP);
+
+  if ((Stream->Running == 0) && Interrupt->DataReady)
+    Handler->InterruptCallback(ADXL345_INTERRUPT_DATA_READY);
+}
+
+/**
+ * Without FIFO a sample can be read only until the next one replaces it, so
+ * polls are kept one sample period apart and an empty poll is not repeated
+ * early. Polls that drift to the edge of the period show up as an empty poll
+ * when they come early or as an overrun when they come late. They are moved
+ * back to the middle of the period and the period is corrected by the drift,
+ * which is half a period over the samples since the last move.
+ */
+static uint32_t
+ADXL345_PollSched_Bypass(ADXL345_PollSched_t *Sched, uint32_t NowUs,
+                         uint8_t Drained, uint8_t Overrun)
+{
+  uint32_t PeriodUs = Sched->PeriodQ8 >> 8;
+  uint32_t DueUs = Sched->DeadlineUs;
+  uint32_t MaxQ8 = (Sched->NominalPeriodUs << 8) + (Sched->NominalPeriodUs << 5);
+  uint32_t MinQ8 = (Sched->NominalPeriodUs << 8) - (Sched->NominalPeriodUs << 5);
+  uint32_t Samples = Sched->Samples - Sched->AnchorSamples;
+  uint32_t ErrorQ8 = 0;
+  uint32_t StepQ8 = 0;
+
+  if (Drained && !Overrun)
+  {
+    StepQ8 = Sched->PeriodQ8 + Sched->DeadlineQ8;
+    Sched->DeadlineUs += StepQ8 >> 8;
+    Sched->DeadlineQ8 = (uint8_t)StepQ8;
+    return Sched->DeadlineUs;
+  }
+
+  if (!Drained)
+    Sched->Stats.EarlyPolls++;
+  if (Overrun)
+    Sched->Stats.Overruns++;
+
+  // Polls that leave the period right after a move only show the host jitter
+  if (Samples >= ADXL345_POLLSCHED_WINDOW / 32)
+  {
+    ErrorQ8 = (Sched->PeriodQ8 / 2) / Samples;
+    if (Overrun)
+      Sched->PeriodQ8 = MAX(Sched->PeriodQ8 - ErrorQ8, MinQ8);
+    else
+      Sched->PeriodQ8 = MIN(Sched->PeriodQ8 + ErrorQ8, MaxQ8);
+  }
+  Sched->AnchorUs = NowUs;
+  Sched->AnchorSamples = Sched->Samples;
+
+  // The sample after an empty poll is read half a period later, the one
+  // after an overrun one and a half periods later
+  Sched->DeadlineUs = DueUs + PeriodUs / 2 + (Overrun ? PeriodUs : 0);
+  Sched->DeadlineQ8 = 0;
+
+  // A host that slept through whole periods does not catch up with polls
+  while ((int32_t)(Sched->DeadlineUs - NowUs) <= 0)
+    Sched->DeadlineUs += PeriodUs;
+
+  return Sched->DeadlineUs;
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize adaptive watermark controller
+ * @param  Ctrl: Pointer to controller
+ * @param  Rate: Data Rate of the device
+ * @param  LatencyBudgetUs: Max age of the oldest sample in us when a drain
+ *                          finishes
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: LatencyBudgetUs is 0.
+ */
+ADXL345_Result_t
+ADXL345_WatermarkCtrl_Init(ADXL345_WatermarkCtrl_t *Ctrl,
+                           ADXL345_Rate_t Rate, uint32_t LatencyBudgetUs)
+{
+  if (LatencyBudgetUs == 0)
+    return ADXL345_INVALID_PARAM;
+
+  memset(Ctrl, 0, sizeof(ADXL345_WatermarkCtrl_t));
+
+  Ctrl->LatencyBudgetUs = LatencyBudgetUs;
+  Ctrl->MinWatermark = 1;
+  Ctrl->MaxWatermark = ADXL345_STREAM_MAX_WATERMARK;
+  Ctrl->HoldDrains = 16;
+  Ctrl->SamplePeriodUs = ADXL345_ConvToData_RatePeriodUs(Rate);
+  Ctrl->Watermark = ADXL345_WatermarkCtrl_Target(Ctrl);
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Update controller after a FIFO drain
+ * @param  Ctrl: Pointer to controller
+ * @param  DrainLatencyUs: Time from interrupt to the end of the drain in us
+ * @param  Overrun: 1 if an overrun was reported since the last drain
+ * @retval New watermark
+ */
+uint8_t
+ADXL345_WatermarkCtrl_Update(ADXL345_WatermarkCtrl_t *Ctrl,
+                             uint32_t DrainLatencyUs, uint8_t Overrun)
+{
+  uint8_t Target = 0;
+
+  if (Ctrl->Stats.Drains == 0)
+    Ctrl->DrainLatencyUs = DrainLatencyUs;
+  else
+    Ctrl->DrainLatencyUs = (3 * Ctrl->DrainLatencyUs + DrainLatencyUs) / 4;
+
+  Ctrl->Stats.Drains++;
+  Ctrl->Stats.MaxDrainLatencyUs = MAX(Ctrl->Stats.MaxDrainLatencyUs,
+                                      DrainLatencyUs);
+
+  Target = ADXL345_WatermarkCtrl_Target(Ctrl);
+
+  if (Overrun)
+  {
+    Ctrl->Stats.Overruns++;
+    Ctrl->Hold = Ctrl->HoldDrains;
+    Target = MIN(Target, Ctrl->Watermark / 2);
+    Target = MAX(Target, Ctrl->MinWatermark);
+  }
+  else if (Ctrl->Hold)
+  {
+    Ctrl->Hold--;
+    Target = MIN(Target, Ctrl->Watermark);
+  }
+  else if (Target > Ctrl->Watermark)
+  {
+    Target = Ctrl->Watermark + 1;
+  }
+
+  if (Target > Ctrl->Watermark)
+    Ctrl->Stats.Increases++;
+  else if (Target < Ctrl->Watermark)
+    Ctrl->Stats.Decreases++;
+
+  Ctrl->Watermark = Target;
+
+  return Ctrl->Watermark;
+}
+
+/**
+ * @brief  Write controller watermark to FIFO_CTL if it has changed
+ * @param  Handler: Pointer to handler
+ * @param  Ctrl: Pointer to controller
+ * @param  Config: Pointer to current FIFO Configurations. WatermarkSamples is
+ *                 updated on success.
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_WatermarkCtrl_Apply(ADXL345_Handler_t *Handler,
+                            ADXL345_WatermarkCtrl_t *Ctrl,
+                            ADXL345_FifoConfig_t *Config)
+{
+  ADXL345_FifoConfig_t NewConfig = *Config;
+
+  if (Config->WatermarkSamples == Ctrl->Watermark)
+    return ADXL345_OK;
+
+  NewConfig.WatermarkSamples = Ctrl->Watermark;
+  if (ADXL345_Set_FifoConfig(Handler, &NewConfig) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  *Config = NewConfig;
+
+  return ADXL345_OK;
+}
+
+
+/**
+ * @brief  Initialize sample stream gap tracker
+ * @param  Tracker: Pointer to tracker
+ * @param  Rate: Data Rate of the device
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ */
+ADXL345_Result_t
+ADXL345_GapTracker_Init(ADXL345_GapTracker_t *Tracker, ADXL345_Rate_t Rate)
+{
+  memset(Tracker, 0, sizeof(ADXL345_GapTracker_t));
+  Tracker->SamplePeriodUs = ADXL345_ConvToData_RatePeriodUs(Rate);
+  Tracker->FifoDepth = ADXL345_FIFO_SIZE;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Fill sequence, timestamp and gap fields of a drained batch
+ * @param  Tracker: Pointer to tracker
+ * @param  Batch: Pointer to batch. Samples and Count must be set.
+ * @param  DrainTimestampUs: Time the FIFO entry count was read in us
+ * @param  Overrun: 1 if an overrun was reported since the previous drain
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ */
+ADXL345_Result_t
+ADXL345_GapTracker_Mark(ADXL345_GapTracker_t *Tracker, ADXL345_Batch_t *Batch,
+                        uint32_t DrainTimestampUs, uint8_t Overrun)
+{
+  uint32_t Period = Tracker->SamplePeriodUs;
+  uint32_t FirstTimestamp = 0;
+  uint32_t Elapsed = 0;
+  uint32_t Gap = 0;
+
+  FirstTimestamp = DrainTimestampUs;
+  if (Batch->Count)
+    FirstTimestamp -= (uint32_t)(Batch->Count - 1) * Period;
+
+  // Samples are read in order, so the count is authoritative. Timing is only
+  // used to size the gap when samples can have been dropped: on overrun, or
+  // when the FIFO was found full.
+  if (Tracker->Started &&
+      (Overrun || Tracker->OverrunPending ||
+       Batch->Count >= Tracker->FifoDepth))
+  {
+    // The newest sample is up to one period before DrainTimestampUs, so only
+    // a distance of two periods or more is taken as lost samples
+    Elapsed = FirstTimestamp - Tracker->LastTimestampUs;
+    if ((int32_t)Elapsed >= (int32_t)(2 * Period))
+      Gap = (Elapsed + Period / 2) / Period - 1;
+  }
+
+  if (Overrun)
+    Tracker->Stats.Overruns++;
+
+  if (Batch->Count == 0)
+  {
+    // Nothing to attach the gap to; keep it for the next batch
+    Tracker->OverrunPending |= Overrun;
+    Batch->Gap = 0;
+    Batch->Sequence = Tracker->NextSequence;
+    Batch->TimestampUs = DrainTimestampUs;
+    return ADXL345_OK;
+  }
+
+  if (Overrun || Tracker->OverrunPending)
+    Gap = MAX(Gap, 1);
+  Tracker->OverrunPending = 0;
+
+  if (Gap)
+  {
+    Tracker->Stats.Gaps++;
+    Tracker->Stats.DroppedSamples += Gap;
+  }
+
+  Batch->Gap = Gap;
+  Batch->Sequence = Tracker->NextSequence + Gap;
+  Batch->TimestampUs = FirstTimestamp;
+
+  Tracker->NextSequence = Batch->Sequence + Batch->Count;
+  Tracker->LastTimestampUs = DrainTimestampUs;
+  Tracker->Started = 1;
+  Tracker->Stats.Samples += Batch->Count;
+
+  return ADXL345_OK;
+}
+
+
+/**
+ * @brief  Initialize streaming engine
+ * @param  Stream: Pointer to streaming engine
+ * @param  Handler: Pointer to initialized handler
+ * @param  Config: Pointer to streaming configuration
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid configuration.
+ */
+ADXL345_Result_t
+ADXL345_Stream_Init(ADXL345_Stream_t *Stream, ADXL345_Handler_t *Handler,
+                    ADXL345_StreamConfig_t *Config)
+{
+  if (Config->WatermarkSamples > ADXL345_STREAM_MAX_WATERMARK)
+    return ADXL345_INVALID_PARAM;
+
+  if ((Config->Mode != ADXL345_MODE_BYPASS) && (Config->WatermarkSamples == 0))
+    return ADXL345_INVALID_PARAM;
+
+  memset(Stream, 0, sizeof(ADXL345_Stream_t));
+  Stream->Handler = Handler;
+  Stream->Config = *Config;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Configure the device and start streaming
+ * @param  Stream: Pointer to streaming engine
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ *         - ADXL345_INVALID_PARAM: Sink is not set.
+ */
+ADXL345_Result_t
+ADXL345_Stream_Start(ADXL345_Stream_t *Stream)
+{
+  ADXL345_Handler_t *Handler = Stream->Handler;
+  ADXL345_FifoConfig_t Bypass = {0};
+
+  if (Stream->Sink == NULL)
+    return ADXL345_INVALID_PARAM;
+
+  Stream->Running = 0;
+
+  if (ADXL345_Stream_SetMeasure(Stream, 0) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  if (ADXL345_Set_Rate(Handler, Stream->Config.Rate) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  memset(&Stream->DataFormat, 0, sizeof(ADXL345_DataFormat_t));
+  Stream->DataFormat.Range = Stream->Config.Range;
+  Stream->DataFormat.FullResolution = Stream->Config.FullResolution ? 1 : 0;
+  if (ADXL345_Set_DataFormat(Handler, &Stream->DataFormat) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  // Going through bypass mode flushes old FIFO entries
+  Bypass.Mode = ADXL345_MODE_BYPASS;
+  if (ADXL345_Set_FifoConfig(Handler, &Bypass) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  memset(&Stream->FifoConfig, 0, sizeof(ADXL345_FifoConfig_t));
+  Stream->FifoConfig.Mode = Stream->Config.Mode;
+  Stream->FifoConfig.Trigger = Stream->Config.Pin;
+  Stream->FifoConfig.WatermarkSamples = Stream->Config.WatermarkSamples;
+  if (Stream->WatermarkCtrl)
+    Stream->FifoConfig.WatermarkSamples = Stream->WatermarkCtrl->Watermark;
+  if (ADXL345_Set_FifoConfig(Handler, &Stream->FifoConfig) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  ADXL345_GapTracker_Init(&Stream->Tracker, Stream->Config.Rate);
+  // Bypass mode has no overrun interrupt; every read empties a full FIFO
+  if (Stream->Config.Mode == ADXL345_MODE_BYPASS)
+    Stream->Tracker.FifoDepth = 1;
+  Stream->Head = 0;
+  Stream->Tail = 0;
+  Stream->OverrunPending = 0;
+
+  if (ADXL345_Stream_SetInterrupts(Stream, 1) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  Stream->Running = 1;
+
+  if (ADXL345_Stream_SetMeasure(Stream, 1) != ADXL345_OK)
+  {
+    Stream->Running = 0;
+    return ADXL345_FAIL;
+  }
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Stop streaming
+ * @param  Stream: Pointer to streaming engine
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Stream_Stop(ADXL345_Stream_t *Stream)
+{
+  Stream->Running = 0;
+
+  if (ADXL345_Stream_SetMeasure(Stream, 0) != ADXL345_OK)
+    return ADXL345_FAIL;
+
+  return ADXL345_Stream_SetInterrupts(Stream, 0);
+}
+
+/**
+ * @brief  Change Data Rate and watermark while streaming
+ * @param  Stream: Pointer to started streaming engine
+ * @param  Rate: New Data Rate
+ * @param  WatermarkSamples: New FIFO watermark (ignored in
+ *                           ADXL345_MODE_BYPASS and when WatermarkCtrl is
+ *                           set)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ *         - ADXL345_INVALID_PARAM: Invalid watermark.
+ */
+ADXL345_Result_t
+ADXL345_Stream_SetRate(ADXL345_Stream_t *Stream, ADXL345_Rate_t Rate,
+                       uint8_t WatermarkSamples)
+{
+  uint32_t PeriodUs = ADXL345_ConvToData_RatePeriodUs(Rate);
+  uint8_t Bypass = (Stream->Config.Mode == ADXL345_MODE_BYPASS);
+
+  if (!Bypass && (WatermarkSamples == 0 ||
+                  WatermarkSamples > ADXL345_STREAM_MAX_WATERMARK))
+    return ADXL345_INVALID_PARAM;
+
+  if (ADXL345_Set_Rate(Stream->Handler, Rate) != ADXL345_OK)
+    return ADXL345_FAIL;
+  Stream->Config.Rate = Rate;
+  Stream->Tracker.SamplePeriodUs = PeriodUs;
+
+  if (Stream->WatermarkCtrl)
+  {
+    Stream->WatermarkCtrl->SamplePeriodUs = PeriodUs;
+    return ADXL345_OK;
+  }
+
+  if (Bypass || Stream->FifoConfig.WatermarkSamples == WatermarkSamples)
+    return ADXL345_OK;
+
+  Stream->Config.WatermarkSamples = WatermarkSamples;
+  Stream->FifoConfig.WatermarkSamples = WatermarkSamples;
+
+  return ADXL345_Set_FifoConfig(Stream->Handler, &Stream->FifoConfig);
+}
+
+/**
+ * @brief  Streaming IRQ Handler
+ * @param  Stream: Pointer to streaming engine
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Stream_IRQ(ADXL345_Stream_t *Stream)
+{
+  uint32_t InterruptUs = 0;
+
+  if (Stream->GetTimeUs)
+    InterruptUs = Stream->GetTimeUs();
+
+  return ADXL345_Stream_IRQAt(Stream, InterruptUs);
+}
+
+/**
+ * @brief  Streaming IRQ Handler with the time of the interrupt
+ * @param  Stream: Pointer to streaming engine
+ * @param  InterruptUs: Time the interrupt was raised in us (same clock as
+ *                      GetTimeUs)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Stream_IRQAt(ADXL345_Stream_t *Stream, uint32_t InterruptUs)
+{
+  ADXL345_InterruptReg_t Interrupt;
+  struct ADXL345_StreamSlot_s *Slot = NULL;
+  uint8_t Scratch[ADXL345_FIFO_SIZE * 6];
+  uint8_t *Raw = Scratch;
+  uint8_t Sample[6] = {0};
+  uint8_t Count = 0;
+  uint8_t Overrun = 0;
+  ADXL345_Result_t Result = ADXL345_OK;
+  uint32_t StartUs = 0;
+  uint32_t EndUs = 0;
+  uint32_t SampleUs = 0;
+
+  if (Stream->GetTimeUs)
+    StartUs = Stream->GetTimeUs();
+
+  // Without FIFO a sample replaced between INT_SOURCE and the data registers
+  // would be lost unseen, so both are read in one burst
+  if (Stream->Running && Stream->Config.Mode == ADXL345_MODE_BYPASS)
+    Result = ADXL345_Get_InterruptSourceSample(Stream->Handler,
+                                               &Interrupt, Sample);
+  else
+    Result = ADXL345_Get_InterruptSource(Stream->Handler, &Interrupt);
+  SampleUs = StartUs;
+
+  if (Result != ADXL345_OK)
+  {
+    Stream->Stats.BusErrors++;
+    return ADXL345_FAIL;
+  }
+
+  if (Stream->Running &&
+      (Interrupt.Watermark || Interrupt.DataReady || Interrupt.Overrun))
+  {
+    if (Interrupt.Overrun)
+    {
+      Stream->Stats.Overruns++;
+      Stream->OverrunPending = 1;
+    }
+
+    // Drain into scratch when ADXL345_Stream_Process is behind, so the
+    // interrupt is cleared anyway. The lost burst is marked as a gap.
+    // Tail is loaded with acquire, so a slot is refilled only after
+    // ADXL345_Stream_Process is done with it.
+    if ((uint8_t)(Stream->Head -
+                  __atomic_load_n(&Stream->Tail, __ATOMIC_ACQUIRE)) <
+        ADXL345_STREAM_SLOTS)
+    {
+      Slot = &Stream->Slots[Stream->Head & (ADXL345_STREAM_SLOTS - 1)];
+      Raw = Slot->Raw;
+    }
+
+    if (ADXL345_Stream_Drain(Stream, Raw, Sample,
+                             Interrupt.Watermark, &Count,
+                             &SampleUs) != ADXL345_OK)
+    {
+      Stream->Stats.BusErrors++;
+      return ADXL345_FAIL;
+    }
+    Stream->Stats.Drains++;
+
+    if (Stream->GetTimeUs)
+      EndUs = Stream->GetTimeUs();
+
+    Overrun = Stream->OverrunPending;
+    if (Slot)
+    {
+      Slot->Count = Count;
+      Slot->Overrun = Overrun;
+      Slot->TimestampUs = SampleUs;
+      Stream->OverrunPending = 0;
+      // The slot must be visible before Head
+      __atomic_store_n(&Stream->Head, (uint8_t)(Stream->Head + 1),
+                       __ATOMIC_RELEASE);
+    }
+    else
+    {
+      Stream->Stats.SlotOverflows++;
+      Stream->OverrunPending = 1;
+    }
+
+    if (Stream->WatermarkCtrl && Stream->GetTimeUs &&
+        (Stream->Config.Mode != ADXL345_MODE_BYPASS))
+    {
+      ADXL345_WatermarkCtrl_Update(Stream->WatermarkCtrl,
+                                   EndUs - InterruptUs, Interrupt.Overrun);
+      if (ADXL345_WatermarkCtrl_Apply(Stream->Handler, Stream->WatermarkCtrl,
+                                      &Stream->FifoConfig) != ADXL345_OK)
+        Stream->Stats.BusErrors++;
+    }
+  }
+
+  Stream->Events.FreeFall |= Interrupt.FreeFall;
+  Stream->Events.Inactivity |= Interrupt.Inactivity;
+  Stream->Events.Activity |= Interrupt.Activity;
+  Stream->Events.DoubleTap |= Interrupt.DoubleTap;
+  Stream->Events.SingleTap |= Interrupt.SingleTap;
+
+  ADXL345_Stream_Forward(Stream, &Interrupt);
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Decode drained bursts and deliver them to Sink
+ * @param  Stream: Pointer to streaming engine
+ * @retval Number of delivered batches
+ */
+uint8_t
+ADXL345_Stream_Process(ADXL345_Stream_t *Stream)
+{
+  struct ADXL345_StreamSlot_s *Slot = NULL;
+  ADXL345_Batch_t Batch;
+  uint32_t TimestampUs = 0;
+  uint8_t Delivered = 0;
+
+  // Head is loaded with acquire, so the slots it publishes are complete
+  while (Stream->Tail != __atomic_load_n(&Stream->Head, __ATOMIC_ACQUIRE))
+  {
+    Slot = &Stream->Slots[Stream->Tail & (ADXL345_STREAM_SLOTS - 1)];
+
+    ADXL345_DecodeSamples(&Stream->DataFormat, Slot->Raw,
+                          Stream->Samples, Slot->Count);
+
+    memset(&Batch, 0, sizeof(ADXL345_Batch_t));
+    Batch.Samples = Stream->Samples;
+    Batch.Count = Slot->Count;
+
+    // Without a time source the timeline is built from sample count only
+    if (Stream->GetTimeUs)
+      TimestampUs = Slot->TimestampUs;
+    else
+      TimestampUs = Stream->Tracker.LastTimestampUs +
+                    Slot->Count * Stream->Tracker.SamplePeriodUs;
+
+    ADXL345_GapTracker_Mark(&Stream->Tracker, &Batch,
+                            TimestampUs, Slot->Overrun);
+
+    // Slot is free as soon as it is decoded; the next burst can be read
+    // while Sink is running
+    __atomic_store_n(&Stream->Tail, (uint8_t)(Stream->Tail + 1),
+                     __ATOMIC_RELEASE);
+
+    if (Batch.Count == 0)
+      continue;
+
+    Stream->Stats.Batches++;
+    Stream->Stats.Samples += Batch.Count;
+    Stream->Sink(Stream->SinkContext, &Batch);
+    Delivered++;
+  }
+
+  return Delivered;
+}
+
+/**
+ * @brief  Initialize ODR-aligned polling scheduler
+ * @param  Sched: Pointer to scheduler
+ * @param  Rate: Data Rate of the device
+ * @param  Watermark: FIFO watermark (1 in ADXL345_MODE_BYPASS)
+ * @param  NowUs: Current time in us
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Watermark is out of range.
+ */
+ADXL345_Result_t
+ADXL345_PollSched_Init(ADXL345_PollSched_t *Sched, ADXL345_Rate_t Rate,
+                       uint8_t Watermark, uint32_t NowUs)
+{
+  if (Watermark == 0 || Watermark > ADXL345_STREAM_FIFO_ENTRIES)
+    return ADXL345_INVALID_PARAM;
+
+  memset(Sched, 0, sizeof(ADXL345_PollSched_t));
+  Sched->NominalPeriodUs = ADXL345_ConvToData_RatePeriodUs(Rate);
+  Sched->PeriodQ8 = Sched->NominalPeriodUs << 8;
+  // Without FIFO polls aim at the middle of each sample period
+  Sched->OffsetUs = (int32_t)(Sched->NominalPeriodUs /
+                              ((Watermark == 1) ? 2 : 4));
+  Sched->Watermark = Watermark;
+  Sched->LastUs = NowUs;
+  Sched->AnchorUs = NowUs;
+  Sched->Anchored = 1;
+  Sched->DeadlineUs = NowUs + Watermark * Sched->NominalPeriodUs +
+                      Sched->OffsetUs;
+
+  return ADXL345_OK;
+}
+
+/**
+ * @brief  Update scheduler after a status poll
+ * @param  Sched: Pointer to scheduler
+ * @param  NowUs: Time at the end of the poll in us
+ * @param  Drained: Number of drained samples
+ * @param  Overrun: 1 if an overrun was reported by the poll
+ * @retval Time of the next poll in us (absolute, same clock as NowUs)
+ */
+uint32_t
+ADXL345_PollSched_Update(ADXL345_PollSched_t *Sched, uint32_t NowUs,
+                         uint8_t Drained, uint8_t Overrun)
+{
+  int32_t PeriodUs = (int32_t)(Sched->PeriodQ8 >> 8);
+  int32_t MinOffsetUs = -(int32_t)Sched->Watermark * PeriodUs;
+  uint32_t MaxQ8 = 0;
+  uint32_t MinQ8 = 0;
+  uint32_t EstimateQ8 = 0;
+  uint32_t Due = 0;
+
+  Sched->Stats.Polls++;
+  Sched->NaiveUs += NowUs - Sched->LastUs;
+  Sched->Stats.NaivePolls += Sched->NaiveUs / Sched->NominalPeriodUs;
+  Sched->NaiveUs %= Sched->NominalPeriodUs;
+  Sched->LastUs = NowUs;
+
+  if (Drained)
+  {
+    Sched->Stats.Drains++;
+    Sched->Samples += Drained;
+  }
+
+  if (Sched->Watermark == 1)
+    return ADXL345_PollSched_Bypass(Sched, NowUs, Drained, Overrun);
+
+  // DATA_READY makes the stream drain whatever is in FIFO, so a poll before
+  // the watermark shows up as a short drain. Wake up a bit earlier after
+  // every full drain and clearly later after every early poll, so the polls
+  // settle around the watermark.
+  if (Drained < Sched->Watermark)
+  {
+    Sched->Stats.EarlyPolls++;
+    Sched->OffsetUs = MIN(Sched->OffsetUs + PeriodUs / 2, PeriodUs);
+  }
+  else
+  {
+    Sched->OffsetUs = MAX(Sched->OffsetUs - PeriodUs / 16, MinOffsetUs);
+  }
+
+  // Samples were lost, so the drained count no longer follows the ODR
+  if (Overrun)
+  {
+    Sched->Stats.Overruns++;
+    Sched->OffsetUs = MAX(Sched->OffsetUs - Sched->Watermark * PeriodUs / 4,
+                          MinOffsetUs);
+    Sched->Anchored = 0;
+  }
+
+  if (Drained && !Sched->Anchored)
+  {
+    Sched->Anchored = 1;
+    Sched->AnchorUs = NowUs;
+    Sched->AnchorSamples = Sched->Samples;
+  }
+  else if (Sched->Samples - Sched->AnchorSamples >= ADXL345_POLLSCHED_WINDOW)
+  {
+    EstimateQ8 = (uint32_t)(((uint64_t)(NowUs - Sched->AnchorUs) << 8) /
+                            (Sched->Samples - Sched->AnchorSamples));
+
+    // Anything beyond 1/8 of the nominal period is a timing glitch of the host
+    MaxQ8 = (Sched->NominalPeriodUs << 8) + (Sched->NominalPeriodUs << 5);
+    MinQ8 = (Sched->NominalPeriodUs << 8) - (Sched->NominalPeriodUs << 5);
+    EstimateQ8 = MIN(MAX(EstimateQ8, MinQ8), MaxQ8);
+
+    Sched->PeriodQ8 = (uint32_t)(((uint64_t)3 * Sched->PeriodQ8 +
+                                  EstimateQ8) / 4);
+    Sched->AnchorUs = NowUs;
+    Sched->AnchorSamples = Sched->Samples;
+  }
+
+  // Deadlines follow the sample grid from the anchor, so the time spent in
+  // each poll does not add up
+  Due = Sched->Samples - Sched->AnchorSamples + Sched->Watermark;
+  Sched->DeadlineUs = Sched->AnchorUs +
+                      (uint32_t)(((uint64_t)Due * Sched->PeriodQ8) >> 8) +
+                      (uint32_t)Sched->OffsetUs;
+
+  if ((int32_t)(Sched->DeadlineUs - NowUs) < PeriodUs / 4)
+    Sched->DeadlineUs = NowUs + (uint32_t)(PeriodUs / 4);
+
+  return Sched->DeadlineUs;
+}
+
+/**
+ * @brief  Poll and drain a stream and schedule the next poll
+ * @param  Sched: Pointer to scheduler
+ * @param  Stream: Pointer to started streaming engine
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ *         - ADXL345_INVALID_PARAM: GetTimeUs is not set.
+ */
+ADXL345_Result_t
+ADXL345_PollSched_Service(ADXL345_PollSched_t *Sched,
+                          ADXL345_Stream_t *Stream)
+{
+  uint8_t Head = Stream->Head;
+  uint32_t Overruns = Stream->Stats.Overruns;
+  uint32_t StartUs = 0;
+  uint32_t EndUs = 0;
+  uint8_t Drained = 0;
+
+  if (Stream->GetTimeUs == NULL)
+    return ADXL345_INVALID_PARAM;
+
+  StartUs = Stream->GetTimeUs();
+  if (ADXL345_Stream_IRQ(Stream) != ADXL345_OK)
+  {
+    Sched->DeadlineUs = Stream->GetTimeUs() + Sched->NominalPeriodUs;
+    return ADXL345_FAIL;
+  }
+  EndUs = Stream->GetTimeUs();
+
+  if (Stream->Head != Head)
+  {
+    Drained = Stream->Slots[(uint8_t)(Stream->Head - 1) &
+                            (ADXL345_STREAM_SLOTS - 1)].Count;
+    Sched->LastDrainUs = EndUs - StartUs;
+  }
+
+  if (Stream->Config.Mode != ADXL345_MODE_BYPASS)
+    Sched->Watermark = Stream->FifoConfig.WatermarkSamples;
+
+  ADXL345_PollSched_Update(Sched, EndUs, Drained,
+                           Stream->Stats.Overruns != Overruns);
+  ADXL345_Stream_Process(Stream);
+
+  return ADXL345_OK;
+}
@@ -48,6 +48,19 @@ extern "C"
 
 
 
+/* Exported Constants -----------------------------------------------------------*/
+/**
+ * @brief  FIFO capacity including the output data registers
+ */
+#define ADXL345_FIFO_SIZE   33
+
+/**
+ * @brief  Mux channel value when the selected channel is unknown
+ */
+#define ADXL345_MUX_CHANNEL_NONE  0xFF
+
+
+
 /* Exported Data Types ----------------------------------------------------------*/
 
 /**
@@ -281,6 +294,45 @@ typedef struct ADXL345_Sample_s
   float AccelZ;
 } ADXL345_Sample_t;
 
+/**
+ * @brief  Register map snapshot data type
+ */
+typedef struct ADXL345_Snapshot_s
+{
+  ADXL345_TapConfig_t TapConfig;
+  int8_t OffsetX;
+  int8_t OffsetY;
+  int8_t OffsetZ;
+  ADXL345_ActivityInactivity_t ActivityInactivity;
+  uint8_t FreeFallThreshold;
+  uint8_t FreeFallTime;
+  ADXL345_ActTapStatus_t ActTapStatus;
+  ADXL345_Rate_t Rate;
+  ADXL345_PowerControl_t PowerControl;
+  ADXL345_InterruptConfig_t InterruptConfig;
+  ADXL345_DataFormat_t DataFormat;
+  ADXL345_FifoConfig_t FifoConfig;
+  ADXL345_FifoStatus_t FifoStatus;
+} ADXL345_Snapshot_t;
+
+/**
+ * @brief  I2C multiplexer (TCA9548A style) data type
+ * @note   One instance is shared by all handlers behind the same mux. It keeps
+ *         the selected channel so the mux is written only on a channel change.
+ */
+typedef struct ADXL345_Mux_s
+{
+  uint8_t AddressI2C;
+  uint8_t Channel;
+
+  struct ADXL345_MuxStats_s
+  {
+    uint32_t Switches;  // channel select writes
+    uint32_t Skipped;   // accesses on the already selected channel
+    uint32_t Errors;
+  } Stats;
+} ADXL345_Mux_t;
+
 /**
  * @brief  Handler data type
  * @note   User must initialize this this functions before using library:
@@ -290,6 +342,20 @@ typedef struct ADXL345_Sample_s
  *         - PlatformI2CReceive
  *         - InterruptCallback
  * @note   If success the functions must return 0 
+ * @note   PlatformLock and PlatformUnlock are optional (NULL if not used).
+ *         Handlers on the same bus (or behind the same mux) must share them.
+ *         The lock is held only during these atomic operations:
+ *         - Each register access (mux select, register pointer and data)
+ *         - Read-modify-write setters (Set_Rate, Set_DataFormat,
+ *           Set_InterruptConfig) and DeInit
+ *         - Multi-register Get/Set functions (Get/Set_TapConfig,
+ *           Get_Snapshot)
+ *         - Each FIFO read (ReadRawSamples, ReadSamples and
+ *           ReadSamplesWatermark), so samples are decoded with the
+ *           DATA_FORMAT they were read with
+ *         The lock is never taken twice by the same call, so a non-recursive
+ *         mutex is enough. If driver functions are called from an ISR, the
+ *         lock must be usable there (e.g. disabling interrupts).
  */
 typedef struct ADXL345_Handler_s
 {
@@ -303,9 +369,28 @@ typedef struct ADXL345_Handler_s
   int8_t (*PlatformI2CSend)(uint8_t Address, uint8_t *Data, uint8_t Len);
   // Receive Data from the slave with the address of Address. (0 <= Address <= 127)
   int8_t (*PlatformI2CReceive)(uint8_t Address, uint8_t *Data, uint8_t Len);
+  // Lock and unlock the bus (optional)
+  void (*PlatformLock)(void);
+  void (*PlatformUnlock)(void);
 
   // Callback For Interrupts. This function will call from ADXL345_IRQ_Handler
   int8_t (*InterruptCallback)(ADXL345_Interrupt_t Interrupt);
+
+  // I2C multiplexer of the device (NULL when it is directly on the bus).
+  // Use ADXL345_SetMux to set these members.
+  ADXL345_Mux_t *Mux;
+  uint8_t MuxChannel;
+
+  // Bus traffic of the device registers (mux selects are counted by the mux).
+  // Bytes are register pointer and data bytes, without the address byte.
+  // Only completed transfers are counted; failed ones count in Errors.
+  // Reset by ADXL345_Init.
+  struct ADXL345_HandlerStats_s
+  {
+    uint32_t Transfers;
+    uint32_t Bytes;
+    uint32_t Errors;
+  } Stats;
 } ADXL345_Handler_t;
 
 
@@ -619,6 +704,22 @@ ADXL345_Set_Rate(ADXL345_Handler_t *Handler, ADXL345_Rate_t Rate);
 ADXL345_Result_t
 ADXL345_Get_Rate(ADXL345_Handler_t *Handler, ADXL345_Rate_t *Rate);
 
+/**
+ * @brief  Convert Data Rate to sample period in us
+ * @param  rate: Data Rate (ADXL345_Rate_t)
+ * @retval Sample period in us
+ */
+#define ADXL345_ConvToData_RatePeriodUs(rate) \
+  ((625UL << (15 - ((rate) & 0x0F))) >> 1)
+
+/**
+ * @brief  Convert Data Rate to output data rate in mHz
+ * @param  rate: Data Rate (ADXL345_Rate_t)
+ * @retval Output data rate in mHz
+ */
+#define ADXL345_ConvToData_RateMilliHz(rate) \
+  (3200000UL >> (15 - ((rate) & 0x0F)))
+
 
 /**
  * @brief  Set Interrupt Configuration
@@ -656,6 +757,23 @@ ADXL345_Result_t
 ADXL345_Get_InterruptSource(ADXL345_Handler_t *Handler,
                             ADXL345_InterruptReg_t *Source);
 
+/**
+ * @brief  Get Interrupt Source and read the data registers in one burst
+ * @note   Meant for ADXL345_MODE_BYPASS. Between two separate reads a new
+ *         sample can replace the unread one without a trace, since reading
+ *         the data clears the Overrun bit.
+ * @param  Handler: Pointer to handler
+ * @param  Source: Pointer to Interrupt Source structure
+ * @param  Buffer: Pointer to 6-byte buffer (DATAX0 to DATAZ1)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Get_InterruptSourceSample(ADXL345_Handler_t *Handler,
+                                  ADXL345_InterruptReg_t *Source,
+                                  uint8_t *Buffer);
+
 
 /**
  * @brief  Set Data Format settings
@@ -746,7 +864,49 @@ ADXL345_Get_PowerControl(ADXL345_Handler_t *Handler,
 
 
 /**
- * @brief  
+ * @brief  Read all configuration and status registers with a few burst reads
+ *         and decode them into configuration structures
+ * @note   INT_SOURCE and DATAX0..DATAZ1 are skipped. Reading them would clear
+ *         latched interrupts and pop a FIFO entry.
+ * @param  Handler: Pointer to handler
+ * @param  Snapshot: Pointer to snapshot structure
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Get_Snapshot(ADXL345_Handler_t *Handler,
+                     ADXL345_Snapshot_t *Snapshot);
+
+
+/**
+ * @brief  Read raw samples from FIFO
+ * @note   Each FIFO entry takes 6 bytes in Buffer (DATAX0 to DATAZ1)
+ * @param  Handler: Pointer to handler
+ * @param  Buffer: Pointer to buffer with at least 6 * Entries bytes
+ * @param  Entries: Number of FIFO entries to read
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_ReadRawSamples(ADXL345_Handler_t *Handler,
+                       uint8_t *Buffer, uint8_t Entries);
+
+/**
+ * @brief  Decode raw samples read by ADXL345_ReadRawSamples
+ * @param  DataFormat: Pointer to Data Format settings used for the samples
+ * @param  Buffer: Pointer to raw samples
+ * @param  Samples: Pointer to Samples array
+ * @param  Count: Number of samples to decode
+ * @retval None
+ */
+void
+ADXL345_DecodeSamples(ADXL345_DataFormat_t *DataFormat, uint8_t *Buffer,
+                      ADXL345_Sample_t *Samples, uint8_t Count);
+
+/**
+ * @brief  Read samples from FIFO
  * @param  Handler: Pointer to handler
  * @param  Samples: Pointer to Samples array
  * @param  SamplesBufferLen: Sample buffer capacity in terms of number of samples
@@ -760,6 +920,25 @@ ADXL345_ReadSamples(ADXL345_Handler_t *Handler,
                     ADXL345_Sample_t *Samples,
                     uint8_t SamplesBufferLen, uint8_t *ReadSamples);
 
+/**
+ * @brief  Read samples from FIFO after a watermark interrupt
+ * @note   WatermarkSamples entries are read immediately. FIFO_STATUS is read
+ *         afterwards only to top up the samples that arrived in the meantime.
+ * @param  Handler: Pointer to handler
+ * @param  Samples: Pointer to Samples array
+ * @param  SamplesBufferLen: Sample buffer capacity in terms of number of samples
+ * @param  WatermarkSamples: Number of samples known to be in FIFO
+ * @param  ReadSamples: Number of samples read
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_ReadSamplesWatermark(ADXL345_Handler_t *Handler,
+                             ADXL345_Sample_t *Samples,
+                             uint8_t SamplesBufferLen,
+                             uint8_t WatermarkSamples, uint8_t *ReadSamples);
+
 
 /**
  * @brief  IRQ Handler
@@ -808,6 +987,53 @@ ADXL345_DeInit(ADXL345_Handler_t *Handler);
 ADXL345_Result_t
 ADXL345_SetAddressI2C(ADXL345_Handler_t *Handler, uint8_t Address);
 
+/**
+ * @brief  Initialize I2C multiplexer
+ * @param  Mux: Pointer to mux
+ * @param  AddressI2C: Address of the mux (0x70 to 0x77 for TCA9548A)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid address.
+ */
+ADXL345_Result_t
+ADXL345_Mux_Init(ADXL345_Mux_t *Mux, uint8_t AddressI2C);
+
+/**
+ * @brief  Put the device behind a channel of an I2C multiplexer
+ * @note   ADXL345_Init detaches the mux. Call this function after it.
+ *         A device is identified by (bus, mux channel, address). So two
+ *         devices per channel can be used.
+ * @param  Handler: Pointer to handler
+ * @param  Mux: Pointer to mux. NULL to access the device directly.
+ * @param  Channel: Mux channel of the device (0 to 7)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid channel.
+ */
+ADXL345_Result_t
+ADXL345_SetMux(ADXL345_Handler_t *Handler, ADXL345_Mux_t *Mux, uint8_t Channel);
+
+/**
+ * @brief  Select the mux channel of the device if it is not selected
+ * @note   Register accesses call it automatically. Schedulers can call it
+ *         to measure the switch overhead separately. It takes the platform
+ *         lock of the handler like a register access.
+ * @param  Handler: Pointer to handler
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send data.
+ */
+ADXL345_Result_t
+ADXL345_Mux_Select(ADXL345_Handler_t *Handler);
+
+/**
+ * @brief  Check if accessing the device needs a mux channel switch
+ * @param  Handler: Pointer to handler
+ * @retval 1 if a switch is needed, otherwise 0
+ */
+uint8_t
+ADXL345_Mux_NeedSwitch(ADXL345_Handler_t *Handler);
+
 
 /**
  * @brief  
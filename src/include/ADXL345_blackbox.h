@@ -0,0 +1,196 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_blackbox.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 crash-safe black-box recorder on a memory-mapped circular file (POSIX)
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _ADXL345_BLACKBOX_H_
+#define _ADXL345_BLACKBOX_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "ADXL345.h"
+
+
+
+/* Exported Constants -----------------------------------------------------------*/
+/**
+ * @brief  File layout
+ * @note   A header page is followed by fixed-size slots. Record N is stored
+ *         in slot N % Slots. A slot never straddles a page, so a crash can
+ *         only damage the records being written, and their CRC shows it.
+ *         Slot (little endian):
+ *           0  Magic (0xB5 0x7E)
+ *           2  Number of FIFO entries
+ *           3  Data format (bit 0-1 range, bit 2 justify left,
+ *              bit 3 full resolution)
+ *           4  Sequence number of the record (uint32)
+ *           8  Timestamp in us (uint32)
+ *           12 Samples lost right before the record (uint32)
+ *           16 Raw FIFO entries, 6 bytes each
+ *           254 CRC-16 of the header and the entries (ADXL345_Log_Crc16)
+ */
+#define ADXL345_BLACKBOX_HEADER_LEN     4096
+#define ADXL345_BLACKBOX_SLOT_LEN       256
+#define ADXL345_BLACKBOX_MAX_ENTRIES    39
+
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Black-box record data type
+ * @note   Raw points into the mapped file and is valid until the slot is
+ *         written again.
+ */
+typedef struct ADXL345_BlackboxRecord_s
+{
+  uint32_t Sequence;
+  uint32_t TimestampUs;
+  uint32_t Gap;
+  ADXL345_DataFormat_t DataFormat;
+  uint8_t Entries;
+  const uint8_t *Raw;
+} ADXL345_BlackboxRecord_t;
+
+/**
+ * @brief  Black-box recorder data type
+ * @note   After ADXL345_Blackbox_Open, records Tail..Head are the recovered
+ *         ones (none if Empty is 1). Head moves on each append.
+ */
+typedef struct ADXL345_Blackbox_s
+{
+  int Fd;
+  uint8_t *Map;
+  uint64_t Size;
+  uint32_t Slots;
+  uint32_t Next;            // sequence number of the next record
+  uint32_t Head;
+  uint32_t Tail;
+  uint8_t Empty;
+
+  struct ADXL345_BlackboxStats_s
+  {
+    uint32_t Appended;
+    uint32_t Recovered;     // valid records found by the recovery scan
+    uint32_t Invalid;       // damaged records between Tail and Head
+  } Stats;
+} ADXL345_Blackbox_t;
+
+
+
+/**
+ ==================================================================================
+                               ##### Functions #####                               
+ ==================================================================================
+ */
+
+/**
+ * @brief  Open or create a black-box file and recover its records
+ * @note   A file of another slot count is cleared.
+ * @param  Box: Pointer to recorder
+ * @param  Path: Path of the file
+ * @param  Slots: Number of records kept (>= 2)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to create or map the file.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Blackbox_Open(ADXL345_Blackbox_t *Box, const char *Path,
+                      uint32_t Slots);
+
+/**
+ * @brief  Unmap and close the file
+ * @note   Data is written back by the kernel. No sync is forced.
+ * @param  Box: Pointer to recorder
+ * @retval None
+ */
+void
+ADXL345_Blackbox_Close(ADXL345_Blackbox_t *Box);
+
+/**
+ * @brief  Append a raw FIFO burst
+ * @note   Only memory is written, there is no system call on this path.
+ *         The oldest record is overwritten when the file is full.
+ * @param  Box: Pointer to recorder
+ * @param  DataFormat: Data format the burst was read with
+ * @param  Raw: Raw FIFO entries (6 bytes each, as by ADXL345_ReadRawSamples)
+ * @param  Entries: Number of entries (1..ADXL345_BLACKBOX_MAX_ENTRIES)
+ * @param  Gap: Samples lost right before the burst
+ * @param  TimestampUs: Timestamp of the first entry
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Blackbox_Append(ADXL345_Blackbox_t *Box,
+                        const ADXL345_DataFormat_t *DataFormat,
+                        const uint8_t *Raw, uint8_t Entries,
+                        uint32_t Gap, uint32_t TimestampUs);
+
+/**
+ * @brief  Read a record
+ * @param  Box: Pointer to recorder
+ * @param  Sequence: Sequence number of the record (Tail..Head)
+ * @param  Record: Pointer to record
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Record is overwritten or damaged.
+ */
+ADXL345_Result_t
+ADXL345_Blackbox_Read(ADXL345_Blackbox_t *Box, uint32_t Sequence,
+                      ADXL345_BlackboxRecord_t *Record);
+
+/**
+ * @brief  Ask the kernel to write back the file
+ * @note   Call it from a slow path (e.g. once a second) to bound the data
+ *         lost on power failure.
+ * @param  Box: Pointer to recorder
+ * @param  Wait: 1 to wait until data is on the disk
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to sync.
+ */
+ADXL345_Result_t
+ADXL345_Blackbox_Sync(ADXL345_Blackbox_t *Box, uint8_t Wait);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _ADXL345_BLACKBOX_H_
@@ -0,0 +1,235 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_capture.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 trigger mode event capture
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _ADXL345_CAPTURE_H_
+#define _ADXL345_CAPTURE_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "ADXL345.h"
+
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+
+/**
+ * @brief  Capture engine configuration data type
+ * @note   Thresholds of the trigger events (activity, tap, free-fall) must be
+ *         configured with the driver functions before ADXL345_Capture_Start.
+ */
+typedef struct ADXL345_CaptureConfig_s
+{
+  ADXL345_Rate_t Rate;
+  ADXL345_Range_t Range;
+  uint8_t FullResolution;
+  ADXL345_TriggerPin_t Pin; // Interrupt pin connected to the host
+  // Trigger events. Only FreeFall, Activity, DoubleTap and SingleTap are used.
+  ADXL345_InterruptReg_t Events;
+  // FIFO samples bits in trigger mode (1..31). The device keeps this many
+  // entries from before the trigger, and the same bits set the watermark.
+  // If PreSamples > FifoSamples, FIFO is drained into the history at the
+  // watermark while armed, and FifoSamples must be 16 or less. Otherwise
+  // FIFO runs as a ring until the trigger and the pre-trigger part comes
+  // from the retained entries only.
+  uint8_t FifoSamples;
+  uint16_t PreSamples;  // Samples before the trigger event, with the one that
+                        // fired it
+  uint16_t PostSamples; // Samples after the trigger event (> 0)
+} ADXL345_CaptureConfig_t;
+
+/**
+ * @brief  Captured event window data type
+ */
+typedef struct ADXL345_CaptureWindow_s
+{
+  ADXL345_Sample_t *Samples; // PreCount samples followed by PostCount samples
+  uint16_t PreCount;         // Short after a history gap or an early trigger
+  uint16_t PostCount;
+  ADXL345_InterruptReg_t Source; // Events that fired the trigger
+  uint32_t Sequence;             // Sequence number of Samples[0]
+  uint32_t TimestampUs;          // Estimated timestamp of Samples[0]
+  uint32_t TriggerTimestampUs;   // Timestamp of the trigger interrupt
+                                 // (last pre-trigger sample)
+} ADXL345_CaptureWindow_t;
+
+/**
+ * @brief  Capture engine statistics data type
+ */
+typedef struct ADXL345_CaptureStats_s
+{
+  uint32_t Captures;
+  uint32_t MissedTriggers; // Triggers while the previous window was not delivered
+  uint32_t Overruns;
+  uint32_t BusErrors;
+} ADXL345_CaptureStats_t;
+
+/**
+ * @brief  Capture engine data type
+ * @note   User must initialize these members before ADXL345_Capture_Start:
+ *         - Callback: Called from ADXL345_Capture_Process for every window
+ *         - Context (optional): Passed to Callback
+ *         - GetTimeUs (optional): Free running time in us
+ */
+typedef struct ADXL345_Capture_s
+{
+  ADXL345_Handler_t *Handler;
+  ADXL345_CaptureConfig_t Config;
+
+  void (*Callback)(void *Context, ADXL345_CaptureWindow_t *Window);
+  void *Context;
+  uint32_t (*GetTimeUs)(void);
+
+  // Host-side history ring with PreSamples capacity
+  ADXL345_Sample_t *History;
+  uint16_t HistoryHead;
+  uint16_t HistoryCount;
+
+  // Window buffer with PreSamples + PostSamples capacity
+  ADXL345_Sample_t *Buffer;
+  ADXL345_CaptureWindow_t Window;
+
+  ADXL345_DataFormat_t DataFormat;
+  uint32_t Sequence; // Sequence number of the next sample
+  uint32_t EmptyUs;  // Time FIFO was last emptied while armed
+  uint8_t State;
+  volatile uint8_t Ready;
+
+  ADXL345_CaptureStats_t Stats;
+} ADXL345_Capture_t;
+
+
+
+/**
+ ==================================================================================
+                               ##### Functions #####                               
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize capture engine
+ * @param  Capture: Pointer to capture engine
+ * @param  Handler: Pointer to initialized handler
+ * @param  Config: Pointer to capture configuration
+ * @param  History: Pointer to history array with Config->PreSamples capacity.
+ *                  It can be NULL if PreSamples is 0.
+ * @param  Buffer: Pointer to window array with
+ *                 Config->PreSamples + Config->PostSamples capacity
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid configuration.
+ */
+ADXL345_Result_t
+ADXL345_Capture_Init(ADXL345_Capture_t *Capture, ADXL345_Handler_t *Handler,
+                     ADXL345_CaptureConfig_t *Config,
+                     ADXL345_Sample_t *History, ADXL345_Sample_t *Buffer);
+
+/**
+ * @brief  Configure the device and arm trigger mode
+ * @param  Capture: Pointer to capture engine
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ *         - ADXL345_INVALID_PARAM: Callback is not set.
+ */
+ADXL345_Result_t
+ADXL345_Capture_Start(ADXL345_Capture_t *Capture);
+
+/**
+ * @brief  Stop capturing
+ * @param  Capture: Pointer to capture engine
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Capture_Stop(ADXL345_Capture_t *Capture);
+
+/**
+ * @brief  Capture IRQ Handler
+ * @note   Put this function in ISR instead of ADXL345_IRQ_Handler. While armed
+ *         FIFO is drained into history (if PreSamples > FifoSamples). Once
+ *         FIFO_TRIG is set, the entries FIFO kept from before the trigger
+ *         end the pre-trigger part and the rest start the post-trigger part.
+ *         Then trigger mode is re-armed. Interrupts not used by the engine
+ *         are passed to Handler->InterruptCallback (if set).
+ * @note   The interrupt time is taken when this function is called. Use
+ *         ADXL345_Capture_IRQAt if the ISR is dispatched late.
+ * @param  Capture: Pointer to capture engine
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Capture_IRQ(ADXL345_Capture_t *Capture);
+
+/**
+ * @brief  Capture IRQ Handler with the time of the interrupt
+ * @note   Samples that came after the trigger interrupt are counted from
+ *         InterruptUs. This is needed to split the FIFO when it holds fewer
+ *         than FifoSamples pre-trigger entries (history drained or trigger
+ *         right after arming), and to detect entries the device dropped
+ *         between the last history drain and the trigger. Without GetTimeUs
+ *         all entries up to FifoSamples are taken as pre-trigger.
+ * @param  Capture: Pointer to capture engine
+ * @param  InterruptUs: Time the interrupt was raised in us (same clock as
+ *                      GetTimeUs)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Capture_IRQAt(ADXL345_Capture_t *Capture, uint32_t InterruptUs);
+
+/**
+ * @brief  Deliver the completed window to Callback
+ * @note   Call this function from the main loop or a task. Triggers that
+ *         happen before the window is delivered are counted as missed.
+ * @param  Capture: Pointer to capture engine
+ * @retval 1 if a window was delivered, otherwise 0
+ */
+uint8_t
+ADXL345_Capture_Process(ADXL345_Capture_t *Capture);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _ADXL345_CAPTURE_H_
@@ -0,0 +1,164 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_cost.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 bus and energy cost model
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _ADXL345_COST_H_
+#define _ADXL345_COST_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "ADXL345.h"
+
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Transport of the modeled bus
+ */
+typedef enum ADXL345_CostBus_e
+{
+  ADXL345_COST_I2C = 0x00,  // Pointer write and data read per register access
+  ADXL345_COST_SPI = 0x01,  // One multi-byte transaction per register access
+} ADXL345_CostBus_t;
+
+/**
+ * @brief  Cost model configuration data type
+ * @note   Range and resolution do not change the transaction pattern; every
+ *         FIFO entry is a 6-byte burst.
+ */
+typedef struct ADXL345_CostConfig_s
+{
+  ADXL345_Rate_t Rate;
+  ADXL345_Mode_t Mode;            // BYPASS, FIFO or STREAM
+  uint8_t WatermarkSamples;       // 1..31, ignored in ADXL345_MODE_BYPASS
+  ADXL345_CostBus_t Bus;
+  uint32_t ClockHz;               // SCL or SCLK frequency
+  uint8_t Sensors;                // Sensors with the same setting on the bus
+  uint8_t Muxed;                  // I2C sensors are on channels of a mux
+  // Time from INT (or the poll deadline) to the first bus access in us
+  uint32_t ServiceLatencyUs;
+  // Host time per transfer beyond the wire time in us (e.g. system call)
+  uint32_t TransferOverheadUs;
+} ADXL345_CostConfig_t;
+
+/**
+ * @brief  Cost model result data type
+ * @note   Average values assume the sensors are not phase aligned, so each
+ *         drain starts ServiceLatencyUs after its watermark. Worst case values
+ *         assume all sensors reach the watermark at once and are drained one
+ *         after another. Transfers and bytes are counted like
+ *         Handler->Stats; mux channel switches are only in BusUtilisation.
+ */
+typedef struct ADXL345_Cost_s
+{
+  float SamplesPerDrain;          // Average, watermark plus top-up
+  float InterruptsPerSec;         // Drains per second of all sensors
+  float TransfersPerSec;
+  float BytesPerSec;
+  float BusUtilisation;           // Busy fraction of the bus (0..1)
+  uint32_t DrainUs;               // Average drain time of one sensor
+  uint32_t WorstLatencyUs;        // Watermark to the end of the last drain
+  uint32_t OldestAgeUs;           // Worst age of a sample when it is read
+  int16_t MarginSamples;          // Free FIFO entries at peak, < 0 => overrun
+  int32_t MarginUs;               // MarginSamples in time
+  uint16_t SupplyUa;              // Typical supply current of one sensor
+  uint8_t Feasible;               // No overrun and the bus keeps up
+} ADXL345_Cost_t;
+
+/**
+ * @brief  Limits of ADXL345_Cost_Recommend
+ */
+typedef struct ADXL345_CostLimits_s
+{
+  float MaxUtilisation;           // e.g. 0.5 to leave room for other traffic
+  uint8_t MinMarginSamples;       // FIFO entries to keep free at peak
+  uint32_t LatencyBudgetUs;       // Max OldestAgeUs, 0 for no limit
+} ADXL345_CostLimits_t;
+
+
+
+/**
+ ==================================================================================
+                               ##### Functions #####                               
+ ==================================================================================
+ */
+
+/**
+ * @brief  Estimate the bus cost of streaming with a setting
+ * @note   The model follows the transactions of ADXL345_Stream_IRQ:
+ *         INT_SOURCE, WatermarkSamples FIFO entries, FIFO_STATUS and the
+ *         entries that arrived meanwhile (in bypass mode one burst from
+ *         INT_SOURCE to DATAZ1), plus a mux channel switch per drain
+ *         when several muxed sensors share the bus. I2C transfers take
+ *         start, address, data bytes with ACK and stop on the wire.
+ * @param  Config: Pointer to configuration
+ * @param  Cost: Pointer to result
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid configuration.
+ */
+ADXL345_Result_t
+ADXL345_Cost_Estimate(const ADXL345_CostConfig_t *Config, ADXL345_Cost_t *Cost);
+
+/**
+ * @brief  Find the FIFO mode and watermark with the fewest interrupts that
+ *         meets the limits at Config->Rate
+ * @note   Config->Mode and Config->WatermarkSamples are replaced with the
+ *         recommended setting. FIFO mode is kept if it is set, otherwise
+ *         stream mode is used; bypass is only recommended when no watermark
+ *         meets LatencyBudgetUs.
+ * @param  Config: Pointer to configuration
+ * @param  Limits: Pointer to limits
+ * @param  Cost: Pointer to result of the recommended setting
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: No setting meets the limits at this rate.
+ *         - ADXL345_INVALID_PARAM: Invalid configuration.
+ */
+ADXL345_Result_t
+ADXL345_Cost_Recommend(ADXL345_CostConfig_t *Config,
+                       const ADXL345_CostLimits_t *Limits,
+                       ADXL345_Cost_t *Cost);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _ADXL345_COST_H_
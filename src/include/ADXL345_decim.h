@@ -0,0 +1,175 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_decim.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 multi-rate decimation stage
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _ADXL345_DECIM_H_
+#define _ADXL345_DECIM_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "ADXL345.h"
+
+
+
+/* Functionality Options --------------------------------------------------------*/
+/**
+ * @brief  Max number of decimate-by-2 stages
+ * @note   8 stages: 3200 Hz => 12.5 Hz
+ */
+#ifndef ADXL345_DECIM_MAX_STAGES
+#define ADXL345_DECIM_MAX_STAGES    8
+#endif
+
+
+
+/* Exported Constants -----------------------------------------------------------*/
+/**
+ * @brief  Number of taps of the half-band filter of each stage
+ */
+#define ADXL345_DECIM_TAPS          19
+
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Decimated sample (unit is LSB of raw samples)
+ */
+typedef struct ADXL345_DecimSample_s
+{
+  int16_t X;
+  int16_t Y;
+  int16_t Z;
+} ADXL345_DecimSample_t;
+
+/**
+ * @brief  Decimator data type
+ * @note   A cascade of half-band FIR decimate-by-2 stages in Q15. The output
+ *         of any stage can be delivered, so several output rates are produced
+ *         at once from the same input. Each stage has a passband up to 1/4 of
+ *         its output rate and more than 65 dB of alias rejection in it.
+ */
+typedef struct ADXL345_Decimator_s
+{
+  uint8_t Stages;
+  uint8_t OutputMask;
+
+  // Called for each output sample of each stage enabled in OutputMask
+  void (*Sink)(void *Context, uint8_t Stage, const ADXL345_DecimSample_t *Sample);
+  void *SinkContext;
+
+  struct ADXL345_DecimStage_s
+  {
+    // Each sample is stored twice so the taps are always contiguous
+    int16_t Delay[3][2 * ADXL345_DECIM_TAPS];
+    uint8_t Index;
+    uint8_t Phase;
+  } Stage[ADXL345_DECIM_MAX_STAGES];
+
+  struct ADXL345_DecimStats_s
+  {
+    uint32_t Input;
+    uint32_t Output[ADXL345_DECIM_MAX_STAGES];
+  } Stats;
+} ADXL345_Decimator_t;
+
+
+
+/**
+ ==================================================================================
+                               ##### Functions #####                               
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize decimator
+ * @param  Decimator: Pointer to decimator
+ * @param  OutputMask: Bit N enables output of stage N (input rate / 2^(N+1)).
+ *                     Stages after the highest enabled one are not run.
+ * @param  Sink: Output function
+ * @param  SinkContext: User context passed to Sink
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Decim_Init(ADXL345_Decimator_t *Decimator, uint8_t OutputMask,
+                   void (*Sink)(void *Context, uint8_t Stage,
+                                const ADXL345_DecimSample_t *Sample),
+                   void *SinkContext);
+
+/**
+ * @brief  Clear filter states
+ * @note   Call this function on a gap in the sample stream.
+ * @param  Decimator: Pointer to decimator
+ * @retval None
+ */
+void
+ADXL345_Decim_Reset(ADXL345_Decimator_t *Decimator);
+
+/**
+ * @brief  Feed samples (RawX, RawY and RawZ are used)
+ * @param  Decimator: Pointer to decimator
+ * @param  Samples: Pointer to samples
+ * @param  Count: Number of samples
+ * @retval None
+ */
+void
+ADXL345_Decim_Push(ADXL345_Decimator_t *Decimator,
+                   const ADXL345_Sample_t *Samples, uint16_t Count);
+
+/**
+ * @brief  Output data rate of a stage
+ * @param  Rate: Input data rate
+ * @param  Stage: Stage index (0 => Rate / 2)
+ * @param  StageRate: Pointer to output data rate of the stage
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Stage is out of range, or its rate is
+ *                                  below the lowest Data Rate of the device.
+ */
+ADXL345_Result_t
+ADXL345_Decim_StageRate(ADXL345_Rate_t Rate, uint8_t Stage,
+                        ADXL345_Rate_t *StageRate);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _ADXL345_DECIM_H_
@@ -0,0 +1,194 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_event.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Pollable file descriptor integration for event loops (Linux)
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _ADXL345_EVENT_H_
+#define _ADXL345_EVENT_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "ADXL345.h"
+#include "ADXL345_stream.h"
+
+
+
+/* Functionality Options --------------------------------------------------------*/
+/**
+ * @brief  Max number of services per ADXL345_Event_Service call while the INT
+ *         line stays active
+ * @note   The line is edge triggered. If a new watermark is reached while the
+ *         FIFO is being drained, the line never goes inactive and no new edge
+ *         comes, so the line level is checked after each service.
+ */
+#ifndef ADXL345_EVENT_MAX_ROUNDS
+#define ADXL345_EVENT_MAX_ROUNDS    4
+#endif
+
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Event source
+ */
+typedef enum ADXL345_EventSource_e
+{
+  ADXL345_EVENT_GPIO  = 0x00,   // INT pin through a GPIO character device
+  ADXL345_EVENT_TIMER = 0x01,   // periodic timer (boards without INT line)
+} ADXL345_EventSource_t;
+
+/**
+ * @brief  Event data type
+ * @note   Fd becomes readable when the sensor needs service. Add it to
+ *         epoll/poll (edge or level triggered) and call
+ *         ADXL345_Event_Service when it is readable.
+ *         If Stream is set, service means ADXL345_Stream_IRQ followed by
+ *         ADXL345_Stream_Process. Otherwise ADXL345_IRQ_Handler is called.
+ */
+typedef struct ADXL345_Event_s
+{
+  int Fd;
+  ADXL345_EventSource_t Source;
+  uint8_t ActiveLow;            // INT_INVERT is set in DATA_FORMAT
+  uint8_t Again;                // service again without waiting for Fd
+  ADXL345_Handler_t *Handler;
+  ADXL345_Stream_t *Stream;
+
+  struct ADXL345_EventStats_s
+  {
+    uint32_t Wakeups;           // readable notifications consumed
+    uint32_t Spurious;          // service calls with nothing pending
+    uint32_t Services;          // driver services
+    uint32_t Rounds;            // extra services because INT stayed active
+    uint32_t Errors;
+  } Stats;
+} ADXL345_Event_t;
+
+
+
+/**
+ ==================================================================================
+                               ##### Functions #####                               
+ ==================================================================================
+ */
+
+/**
+ * @brief  Create an event backed by the INT line of the sensor
+ * @note   The line is requested as input with an edge event from a GPIO
+ *         character device (e.g. "/dev/gpiochip0").
+ * @param  Event: Pointer to event
+ * @param  Handler: Pointer to initialized handler
+ * @param  Stream: Pointer to streaming engine (NULL to use
+ *                 ADXL345_IRQ_Handler)
+ * @param  Chip: Path of the GPIO character device
+ * @param  Line: Line offset on the chip
+ * @param  ActiveLow: 1 if INT_INVERT is set in DATA_FORMAT
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to open the chip or request the line.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Event_OpenGpio(ADXL345_Event_t *Event, ADXL345_Handler_t *Handler,
+                       ADXL345_Stream_t *Stream, const char *Chip,
+                       uint32_t Line, uint8_t ActiveLow);
+
+/**
+ * @brief  Create an event backed by a periodic timer
+ * @note   The timer starts disarmed if PeriodUs is 0 and can be armed later
+ *         with ADXL345_Event_ArmTimer.
+ * @param  Event: Pointer to event
+ * @param  Handler: Pointer to initialized handler
+ * @param  Stream: Pointer to streaming engine (NULL to use
+ *                 ADXL345_IRQ_Handler)
+ * @param  PeriodUs: Timer period in us
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to create the timer.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Event_OpenTimer(ADXL345_Event_t *Event, ADXL345_Handler_t *Handler,
+                        ADXL345_Stream_t *Stream, uint32_t PeriodUs);
+
+/**
+ * @brief  Arm the timer of a timer event
+ * @param  Event: Pointer to event
+ * @param  FirstUs: Time to the first expiry in us (0 disarms the timer)
+ * @param  PeriodUs: Period after the first expiry in us (0 for one shot)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to set the timer.
+ *         - ADXL345_INVALID_PARAM: Event is not a timer event.
+ */
+ADXL345_Result_t
+ADXL345_Event_ArmTimer(ADXL345_Event_t *Event,
+                       uint32_t FirstUs, uint32_t PeriodUs);
+
+/**
+ * @brief  Close the file descriptor of the event
+ * @note   Remove Fd from the event loop before this function.
+ * @param  Event: Pointer to event
+ * @retval None
+ */
+void
+ADXL345_Event_Close(ADXL345_Event_t *Event);
+
+/**
+ * @brief  Service the sensor if its event is pending
+ * @note   Never blocks. Call it when Fd is readable. Notifications are
+ *         consumed first, so a notification that arrives during the service
+ *         makes Fd readable again.
+ *         If the INT line is still active after ADXL345_EVENT_MAX_ROUNDS
+ *         services, no new edge will come and Event->Again is set. Call
+ *         this function again (e.g. after a zero timeout poll of the other
+ *         descriptors) while it is set.
+ * @param  Event: Pointer to event
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful (or nothing was pending).
+ *         - ADXL345_FAIL: Failed to read Fd or to service the sensor.
+ */
+ADXL345_Result_t
+ADXL345_Event_Service(ADXL345_Event_t *Event);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _ADXL345_EVENT_H_
@@ -0,0 +1,311 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_fft.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 real FFT spectrum stage
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _ADXL345_FFT_H_
+#define _ADXL345_FFT_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "ADXL345.h"
+
+
+
+/* Functionality Options --------------------------------------------------------*/
+/**
+ * @brief  Min and max number of points (window length) of the FFT
+ * @note   Both must be powers of 2.
+ */
+#ifndef ADXL345_FFT_MIN_POINTS
+#define ADXL345_FFT_MIN_POINTS    16
+#endif
+#ifndef ADXL345_FFT_MAX_POINTS
+#define ADXL345_FFT_MAX_POINTS    4096
+#endif
+
+
+
+/* Exported Macro ---------------------------------------------------------------*/
+/**
+ * @brief  Length of buffers needed for a window of 'points' samples
+ * @note   Twiddle and WindowCoef buffers are used by tables and can be shared
+ *         between all FFT instances with the same length and window.
+ *         Work buffer is private to each FFT instance.
+ */
+#define ADXL345_FFT_TWIDDLE_LEN(points)     (points)
+#define ADXL345_FFT_WINDOW_LEN(points)      (points)
+#define ADXL345_FFT_WORK_LEN(points)        (points)
+#define ADXL345_FFT_AMPLITUDE_LEN(points)   (((points) >> 1) + 1)
+
+/**
+ * @brief  Center frequency of a bin in mHz
+ * @param  rate: Output data rate (ADXL345_Rate_t)
+ * @param  points: Number of FFT points
+ * @param  bin: Bin index (0..points/2)
+ */
+#define ADXL345_Fft_BinMilliHz(rate, points, bin) \
+  ((ADXL345_ConvToData_RateMilliHz(rate) * (uint32_t)(bin)) / (uint32_t)(points))
+
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Window function
+ * @note   FLATTOP has the best amplitude accuracy between bins and the
+ *         widest main lobe.
+ */
+typedef enum ADXL345_FftWindow_e
+{
+  ADXL345_FFT_WINDOW_RECTANGULAR = 0,
+  ADXL345_FFT_WINDOW_HANN        = 1,
+  ADXL345_FFT_WINDOW_HAMMING     = 2,
+  ADXL345_FFT_WINDOW_BLACKMAN    = 3,
+  ADXL345_FFT_WINDOW_FLATTOP     = 4,
+} ADXL345_FftWindow_t;
+
+/**
+ * @brief  Axis of the samples
+ */
+typedef enum ADXL345_FftAxis_e
+{
+  ADXL345_FFT_AXIS_X = 0,
+  ADXL345_FFT_AXIS_Y = 1,
+  ADXL345_FFT_AXIS_Z = 2,
+} ADXL345_FftAxis_t;
+
+/**
+ * @brief  Q15 twiddle and window tables
+ */
+typedef struct ADXL345_FftTableQ15_s
+{
+  uint16_t Points;
+  uint8_t Log2Points;
+  ADXL345_FftWindow_t Window;
+  int16_t *Twiddle;         // Points/2 pairs of (cos, -sin), Q15
+  int16_t *WindowCoef;      // Q15
+  uint32_t AmplitudeGain;   // Q8, scales |X| to amplitude in Q4 LSB
+} ADXL345_FftTableQ15_t;
+
+/**
+ * @brief  Q15 FFT instance (one axis of one sensor)
+ */
+typedef struct ADXL345_FftQ15_s
+{
+  const ADXL345_FftTableQ15_t *Table;
+  ADXL345_FftAxis_t Axis;
+  uint8_t RemoveMean;
+  uint16_t Fill;
+  int16_t *Work;
+} ADXL345_FftQ15_t;
+
+/**
+ * @brief  Floating-point twiddle and window tables
+ */
+typedef struct ADXL345_FftTableF_s
+{
+  uint16_t Points;
+  uint8_t Log2Points;
+  ADXL345_FftWindow_t Window;
+  float *Twiddle;           // Points/2 pairs of (cos, -sin)
+  float *WindowCoef;
+  float AmplitudeGain;      // scales |X| to amplitude in g
+} ADXL345_FftTableF_t;
+
+/**
+ * @brief  Floating-point FFT instance (one axis of one sensor)
+ */
+typedef struct ADXL345_FftF_s
+{
+  const ADXL345_FftTableF_t *Table;
+  ADXL345_FftAxis_t Axis;
+  uint8_t RemoveMean;
+  uint16_t Fill;
+  float *Work;
+} ADXL345_FftF_t;
+
+
+
+/**
+ ==================================================================================
+                               ##### Functions #####                               
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize Q15 twiddle and window tables
+ * @note   Uses floating-point math once. Call it at startup.
+ * @param  Table: Pointer to table
+ * @param  Points: Number of points (power of 2, ADXL345_FFT_MIN_POINTS to
+ *                 ADXL345_FFT_MAX_POINTS)
+ * @param  Window: Window function
+ * @param  Twiddle: Buffer of ADXL345_FFT_TWIDDLE_LEN(Points) elements
+ * @param  WindowCoef: Buffer of ADXL345_FFT_WINDOW_LEN(Points) elements
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_FftQ15_InitTable(ADXL345_FftTableQ15_t *Table, uint16_t Points,
+                         ADXL345_FftWindow_t Window,
+                         int16_t *Twiddle, int16_t *WindowCoef);
+
+/**
+ * @brief  Initialize Q15 FFT instance
+ * @param  Fft: Pointer to FFT instance
+ * @param  Table: Pointer to initialized table
+ * @param  Axis: Axis of the samples
+ * @param  RemoveMean: 1 to remove the mean (gravity) of the window before
+ *                     windowing
+ * @param  Work: Buffer of ADXL345_FFT_WORK_LEN(Points) elements
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_FftQ15_Init(ADXL345_FftQ15_t *Fft, const ADXL345_FftTableQ15_t *Table,
+                    ADXL345_FftAxis_t Axis, uint8_t RemoveMean, int16_t *Work);
+
+/**
+ * @brief  Restart the current window
+ * @note   Call this function on a gap in the sample stream.
+ * @param  Fft: Pointer to FFT instance
+ * @retval None
+ */
+void
+ADXL345_FftQ15_Reset(ADXL345_FftQ15_t *Fft);
+
+/**
+ * @brief  Add one sample (RawX, RawY or RawZ is used)
+ * @param  Fft: Pointer to FFT instance
+ * @param  Sample: Pointer to sample
+ * @retval 1 if the window is full and ADXL345_FftQ15_Compute must be called,
+ *         otherwise 0
+ */
+uint8_t
+ADXL345_FftQ15_Push(ADXL345_FftQ15_t *Fft, const ADXL345_Sample_t *Sample);
+
+/**
+ * @brief  Compute amplitude spectrum of the full window
+ * @note   The Work buffer is transformed in place and the window is restarted.
+ * @note   Input is scaled by 4 and each stage is scaled by 1/2. So there is no
+ *         overflow for 13-bit samples, and the amplitude step is about
+ *         0.5 LSB / (coherent gain of the window) for any window length.
+ * @param  Fft: Pointer to FFT instance
+ * @param  Amplitude: Buffer of ADXL345_FFT_AMPLITUDE_LEN(Points) elements.
+ *                    Single-sided peak amplitude of each bin in Q4 LSB of raw
+ *                    samples, corrected for the coherent gain of the window.
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Window is not full.
+ */
+ADXL345_Result_t
+ADXL345_FftQ15_Compute(ADXL345_FftQ15_t *Fft, uint32_t *Amplitude);
+
+/**
+ * @brief  Initialize floating-point twiddle and window tables
+ * @param  Table: Pointer to table
+ * @param  Points: Number of points (power of 2, ADXL345_FFT_MIN_POINTS to
+ *                 ADXL345_FFT_MAX_POINTS)
+ * @param  Window: Window function
+ * @param  Twiddle: Buffer of ADXL345_FFT_TWIDDLE_LEN(Points) elements
+ * @param  WindowCoef: Buffer of ADXL345_FFT_WINDOW_LEN(Points) elements
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_FftF_InitTable(ADXL345_FftTableF_t *Table, uint16_t Points,
+                       ADXL345_FftWindow_t Window,
+                       float *Twiddle, float *WindowCoef);
+
+/**
+ * @brief  Initialize floating-point FFT instance
+ * @param  Fft: Pointer to FFT instance
+ * @param  Table: Pointer to initialized table
+ * @param  Axis: Axis of the samples
+ * @param  RemoveMean: 1 to remove the mean (gravity) of the window before
+ *                     windowing
+ * @param  Work: Buffer of ADXL345_FFT_WORK_LEN(Points) elements
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_FftF_Init(ADXL345_FftF_t *Fft, const ADXL345_FftTableF_t *Table,
+                  ADXL345_FftAxis_t Axis, uint8_t RemoveMean, float *Work);
+
+/**
+ * @brief  Restart the current window
+ * @note   Call this function on a gap in the sample stream.
+ * @param  Fft: Pointer to FFT instance
+ * @retval None
+ */
+void
+ADXL345_FftF_Reset(ADXL345_FftF_t *Fft);
+
+/**
+ * @brief  Add one sample (AccelX, AccelY or AccelZ is used)
+ * @param  Fft: Pointer to FFT instance
+ * @param  Sample: Pointer to sample
+ * @retval 1 if the window is full and ADXL345_FftF_Compute must be called,
+ *         otherwise 0
+ */
+uint8_t
+ADXL345_FftF_Push(ADXL345_FftF_t *Fft, const ADXL345_Sample_t *Sample);
+
+/**
+ * @brief  Compute amplitude spectrum of the full window
+ * @note   The Work buffer is transformed in place and the window is restarted.
+ * @param  Fft: Pointer to FFT instance
+ * @param  Amplitude: Buffer of ADXL345_FFT_AMPLITUDE_LEN(Points) elements.
+ *                    Single-sided peak amplitude of each bin in g, corrected
+ *                    for the coherent gain of the window.
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Window is not full.
+ */
+ADXL345_Result_t
+ADXL345_FftF_Compute(ADXL345_FftF_t *Fft, float *Amplitude);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _ADXL345_FFT_H_
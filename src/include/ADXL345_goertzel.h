@@ -0,0 +1,146 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_goertzel.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 Goertzel frequency bin tracking
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _ADXL345_GOERTZEL_H_
+#define _ADXL345_GOERTZEL_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "ADXL345.h"
+
+
+
+/* Functionality Options --------------------------------------------------------*/
+/**
+ * @brief  Max number of tracked frequencies per axis
+ */
+#ifndef ADXL345_GOERTZEL_MAX_BINS
+#define ADXL345_GOERTZEL_MAX_BINS   8
+#endif
+
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Goertzel bank data type
+ * @note   Each window of WindowSamples samples gives the amplitude of every
+ *         tracked frequency on each axis. With the same window length and
+ *         window coefficients, results match the ADXL345_FftF_Compute
+ *         amplitudes of the corresponding bins.
+ * @note   The first sample of each window is subtracted from the samples of
+ *         that window. So gravity does not leak into the tracked bins.
+ */
+typedef struct ADXL345_GoertzelF_s
+{
+  uint16_t WindowSamples;
+  uint16_t Count;
+  uint8_t Bins;
+  const float *WindowCoef;
+  float AmplitudeGain;
+
+  float Coef[ADXL345_GOERTZEL_MAX_BINS];
+  float Ref[3];
+  float S1[3][ADXL345_GOERTZEL_MAX_BINS];
+  float S2[3][ADXL345_GOERTZEL_MAX_BINS];
+
+  struct ADXL345_GoertzelResultF_s
+  {
+    float Amplitude[3][ADXL345_GOERTZEL_MAX_BINS]; // [axis][bin], g
+    uint16_t Samples;
+  } Result;
+} ADXL345_GoertzelF_t;
+
+
+
+/**
+ ==================================================================================
+                               ##### Functions #####                               
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize Goertzel bank
+ * @param  Goertzel: Pointer to Goertzel bank
+ * @param  Rate: Output data rate of the samples
+ * @param  WindowSamples: Number of samples per window (> 1)
+ * @param  FreqMilliHz: Array of tracked frequencies in mHz. Each one must be
+ *                      above 0 and below half of the data rate. The
+ *                      frequencies do not need to be on FFT bin centers.
+ * @param  Bins: Number of tracked frequencies (1..ADXL345_GOERTZEL_MAX_BINS)
+ * @param  WindowCoef: Window coefficients of WindowSamples elements (for
+ *                     example WindowCoef of ADXL345_FftTableF_t) or NULL for
+ *                     rectangular window. It is used in place and must remain
+ *                     valid.
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_GoertzelF_Init(ADXL345_GoertzelF_t *Goertzel, ADXL345_Rate_t Rate,
+                       uint16_t WindowSamples, const uint32_t *FreqMilliHz,
+                       uint8_t Bins, const float *WindowCoef);
+
+/**
+ * @brief  Restart the current window
+ * @note   Call this function on a gap in the sample stream.
+ * @param  Goertzel: Pointer to Goertzel bank
+ * @retval None
+ */
+void
+ADXL345_GoertzelF_Reset(ADXL345_GoertzelF_t *Goertzel);
+
+/**
+ * @brief  Add one sample (AccelX, AccelY and AccelZ are used)
+ * @note   Cost is one multiply and two adds per bin and axis.
+ * @param  Goertzel: Pointer to Goertzel bank
+ * @param  Sample: Pointer to sample
+ * @retval 1 if the window is completed and Goertzel->Result is updated,
+ *         otherwise 0
+ */
+uint8_t
+ADXL345_GoertzelF_Push(ADXL345_GoertzelF_t *Goertzel,
+                       const ADXL345_Sample_t *Sample);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _ADXL345_GOERTZEL_H_
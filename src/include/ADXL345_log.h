@@ -0,0 +1,285 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_log.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 compact binary sample log (delta + zigzag varint)
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _ADXL345_LOG_H_
+#define _ADXL345_LOG_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "ADXL345.h"
+#include "ADXL345_stream.h"
+
+
+
+/* Exported Constants -----------------------------------------------------------*/
+/**
+ * @brief  Log format
+ * @note   All fields are little endian.
+ *         File header (16 bytes):
+ *           0  Magic "AXLG"
+ *           4  Version
+ *           5  Device ID
+ *           6  Range (ADXL345_Range_t)
+ *           7  Full resolution (0 or 1)
+ *           8  Rate (ADXL345_Rate_t)
+ *           9  Reserved (0)
+ *           10 ODR in mHz (uint32)
+ *           14 CRC-16 of bytes 0..13
+ *         Block (header, payload, CRC-16 of header and payload):
+ *           0  Sync (0xA5)
+ *           1  Flags (ADXL345_LOG_FLAG_x)
+ *           2  Number of samples (uint16)
+ *           4  Payload length (uint16)
+ *           6  Timestamp of the first sample in us (uint32)
+ *           10 Sequence of the first sample (uint32)
+ *           14 Samples lost right before the first sample (uint32)
+ *           18 Payload: for each sample X, Y and Z, each as the difference
+ *              from the same axis of the previous sample of the block
+ *              (0 for the first one), zigzag encoded and written as a
+ *              base-128 varint (1 to 3 bytes)
+ *         Each block decodes on its own, so a damaged block loses only its
+ *         own samples.
+ */
+#define ADXL345_LOG_MAGIC               "AXLG"
+#define ADXL345_LOG_VERSION             1
+#define ADXL345_LOG_FILE_HEADER_LEN     16
+#define ADXL345_LOG_BLOCK_SYNC          0xA5
+#define ADXL345_LOG_BLOCK_HEADER_LEN    18
+#define ADXL345_LOG_BLOCK_CRC_LEN       2
+// Max encoded size of one sample
+#define ADXL345_LOG_SAMPLE_MAX_LEN      9
+
+/**
+ * @brief  Block flags
+ */
+#define ADXL345_LOG_FLAG_GAP            0x01  // samples lost before the block
+
+/**
+ * @brief  Min block buffer size for a given number of samples per block
+ */
+#define ADXL345_LOG_BLOCK_LEN(samples) \
+  (ADXL345_LOG_BLOCK_HEADER_LEN + ADXL345_LOG_SAMPLE_MAX_LEN * (samples) + \
+   ADXL345_LOG_BLOCK_CRC_LEN)
+
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Log file information data type
+ */
+typedef struct ADXL345_LogInfo_s
+{
+  uint8_t DeviceId;
+  ADXL345_Range_t Range;
+  uint8_t FullResolution;
+  ADXL345_Rate_t Rate;
+} ADXL345_LogInfo_t;
+
+/**
+ * @brief  Parsed log block data type
+ */
+typedef struct ADXL345_LogBlock_s
+{
+  uint8_t Flags;
+  uint16_t Count;
+  uint16_t PayloadLen;
+  uint32_t TimestampUs;
+  uint32_t Sequence;
+  uint32_t Gap;
+  const uint8_t *Payload;
+} ADXL345_LogBlock_t;
+
+/**
+ * @brief  Log write function data type
+ * @note   If success the function must return 0
+ */
+typedef int8_t (*ADXL345_LogWriteFn_t)(void *Context, const uint8_t *Data,
+                                       uint16_t Len);
+
+/**
+ * @brief  Streaming log writer data type
+ * @note   Samples are encoded straight into Block. A block is written when it
+ *         is full, on a gap and on ADXL345_Log_Flush.
+ */
+typedef struct ADXL345_LogWriter_s
+{
+  ADXL345_LogWriteFn_t Write;
+  void *Context;
+  uint8_t *Block;
+  uint16_t BlockSize;
+  uint16_t Length;          // bytes of the open block, 0 if none is open
+  uint16_t Count;           // samples of the open block
+  int16_t Last[3];
+  uint32_t PeriodUs;
+  uint32_t NextSequence;   // sequence expected from the next batch
+  uint8_t Started;
+
+  struct ADXL345_LogWriterStats_s
+  {
+    uint32_t Blocks;
+    uint32_t Samples;
+    uint32_t Bytes;
+    uint32_t Gaps;
+    uint32_t Errors;        // blocks dropped because Write failed
+  } Stats;
+} ADXL345_LogWriter_t;
+
+
+
+/**
+ ==================================================================================
+                               ##### Functions #####                               
+ ==================================================================================
+ */
+
+/**
+ * @brief  Compute CRC-16/CCITT-FALSE used by log headers and blocks
+ * @param  Data: Pointer to data
+ * @param  Len: Number of bytes
+ * @retval CRC
+ */
+uint16_t
+ADXL345_Log_Crc16(const uint8_t *Data, uint32_t Len);
+
+/**
+ * @brief  Initialize log writer and write the file header
+ * @param  Writer: Pointer to writer
+ * @param  Info: Pointer to log file information
+ * @param  Block: Block buffer (at least ADXL345_LOG_BLOCK_LEN(1) bytes)
+ * @param  BlockSize: Size of Block in bytes
+ * @param  Write: Write function of the output
+ * @param  Context: Context of write function
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to write the header.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Log_WriterInit(ADXL345_LogWriter_t *Writer,
+                       const ADXL345_LogInfo_t *Info,
+                       uint8_t *Block, uint16_t BlockSize,
+                       ADXL345_LogWriteFn_t Write, void *Context);
+
+/**
+ * @brief  Append a batch of samples to the log
+ * @note   Only raw values of the samples are stored. A new block with the
+ *         gap flag is started when Batch->Gap is not zero or its sequence
+ *         does not follow the previous batch.
+ * @param  Writer: Pointer to writer
+ * @param  Batch: Pointer to batch
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to write a block. Its samples are dropped.
+ */
+ADXL345_Result_t
+ADXL345_Log_Write(ADXL345_LogWriter_t *Writer, const ADXL345_Batch_t *Batch);
+
+/**
+ * @brief  Streaming engine sink that appends each batch to the log
+ * @note   Set Stream->Sink to this function and Stream->SinkContext to the
+ *         writer.
+ * @param  SinkContext: Pointer to writer
+ * @param  Batch: Pointer to batch
+ * @retval None
+ */
+void
+ADXL345_Log_Sink(void *SinkContext, ADXL345_Batch_t *Batch);
+
+/**
+ * @brief  Write the open block
+ * @param  Writer: Pointer to writer
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to write the block. Its samples are dropped.
+ */
+ADXL345_Result_t
+ADXL345_Log_Flush(ADXL345_LogWriter_t *Writer);
+
+/**
+ * @brief  Read log file information from the file header
+ * @param  Data: Pointer to the start of the log
+ * @param  Len: Number of available bytes
+ * @param  Info: Pointer to log file information
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Not a valid log header.
+ */
+ADXL345_Result_t
+ADXL345_Log_ReadInfo(const uint8_t *Data, uint32_t Len,
+                     ADXL345_LogInfo_t *Info);
+
+/**
+ * @brief  Parse the block at Data
+ * @note   Total size of the block is ADXL345_LOG_BLOCK_HEADER_LEN +
+ *         Block->PayloadLen + ADXL345_LOG_BLOCK_CRC_LEN.
+ * @param  Data: Pointer to the block
+ * @param  Len: Number of available bytes
+ * @param  CheckCrc: 1 to verify the CRC of the block
+ * @param  Block: Pointer to parsed block
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Not a valid block.
+ */
+ADXL345_Result_t
+ADXL345_Log_ParseBlock(const uint8_t *Data, uint32_t Len, uint8_t CheckCrc,
+                       ADXL345_LogBlock_t *Block);
+
+/**
+ * @brief  Decode samples of a parsed block into separate axis arrays
+ * @note   Samples before First are decoded but not stored.
+ * @param  Block: Pointer to parsed block
+ * @param  First: Index of the first sample to store
+ * @param  Count: Max number of samples to store
+ * @param  X: X values (NULL if not needed)
+ * @param  Y: Y values (NULL if not needed)
+ * @param  Z: Z values (NULL if not needed)
+ * @retval Number of stored samples
+ */
+uint16_t
+ADXL345_Log_DecodeBlock(const ADXL345_LogBlock_t *Block,
+                        uint16_t First, uint16_t Count,
+                        int16_t *X, int16_t *Y, int16_t *Z);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _ADXL345_LOG_H_
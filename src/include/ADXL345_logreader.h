@@ -0,0 +1,191 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_logreader.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 memory-mapped log reader with sparse time index (POSIX)
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _ADXL345_LOGREADER_H_
+#define _ADXL345_LOGREADER_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "ADXL345.h"
+#include "ADXL345_log.h"
+
+
+
+/* Functionality Options --------------------------------------------------------*/
+/**
+ * @brief  Number of samples decoded at once by ADXL345_LogReader_ReadFloat
+ */
+#ifndef ADXL345_LOGREADER_CHUNK
+#define ADXL345_LOGREADER_CHUNK   256
+#endif
+
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Sparse index entry data type
+ * @note   TimeUs is the time from the first sample of the log. Timestamps of
+ *         the log wrap every 71 minutes and are unwrapped here.
+ */
+typedef struct ADXL345_LogIndexEntry_s
+{
+  uint64_t Offset;
+  uint64_t TimeUs;
+} ADXL345_LogIndexEntry_t;
+
+/**
+ * @brief  Log reader data type
+ * @note   The index keeps every Stride-th block. Stride doubles each time
+ *         the index array is full, so any log fits in a fixed array.
+ */
+typedef struct ADXL345_LogReader_s
+{
+  int Fd;
+  const uint8_t *Data;
+  uint64_t Size;
+  ADXL345_LogInfo_t Info;
+  uint64_t PeriodNs;
+  uint8_t CheckCrc;         // verify block CRCs while reading (default 1)
+
+  ADXL345_LogIndexEntry_t *Index;
+  uint32_t IndexLen;
+  uint32_t IndexCount;
+  uint32_t Stride;
+  uint64_t DurationUs;      // end time of the last block
+
+  struct ADXL345_LogReaderStats_s
+  {
+    uint32_t Blocks;
+    uint32_t Samples;
+    uint32_t Gaps;
+    uint32_t BadBytes;      // bytes skipped to find the next valid block
+  } Stats;
+} ADXL345_LogReader_t;
+
+
+
+/**
+ ==================================================================================
+                               ##### Functions #####                               
+ ==================================================================================
+ */
+
+/**
+ * @brief  Map a log file and build or load its index
+ * @note   If IndexPath is not NULL, the index is loaded from it when it
+ *         matches the log, otherwise it is built by a scan of block headers
+ *         and saved there.
+ * @param  Reader: Pointer to reader
+ * @param  Path: Path of the log file
+ * @param  IndexPath: Path of the index file (NULL if not used)
+ * @param  Index: Index array
+ * @param  IndexLen: Number of entries of Index (>= 2)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to open or map the file or not a log.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_LogReader_Open(ADXL345_LogReader_t *Reader, const char *Path,
+                       const char *IndexPath,
+                       ADXL345_LogIndexEntry_t *Index, uint32_t IndexLen);
+
+/**
+ * @brief  Unmap the log file
+ * @param  Reader: Pointer to reader
+ * @retval None
+ */
+void
+ADXL345_LogReader_Close(ADXL345_LogReader_t *Reader);
+
+/**
+ * @brief  Decode raw samples of a time range into separate axis arrays
+ * @note   Samples lost in gaps are not filled in. Times are in us from the
+ *         first sample of the log.
+ * @param  Reader: Pointer to reader
+ * @param  FromUs: Start of the range
+ * @param  ToUs: End of the range (excluded)
+ * @param  X: X values (NULL if not needed)
+ * @param  Y: Y values (NULL if not needed)
+ * @param  Z: Z values (NULL if not needed)
+ * @param  MaxSamples: Capacity of the arrays
+ * @param  Count: Number of decoded samples
+ * @param  FirstUs: Time of the first decoded sample (NULL if not needed)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_LogReader_Read(ADXL345_LogReader_t *Reader,
+                       uint64_t FromUs, uint64_t ToUs,
+                       int16_t *X, int16_t *Y, int16_t *Z,
+                       uint32_t MaxSamples, uint32_t *Count,
+                       uint64_t *FirstUs);
+
+/**
+ * @brief  Decode samples of a time range into separate axis arrays in g
+ * @note   Same as ADXL345_LogReader_Read. Values are converted with the range
+ *         and resolution of the log.
+ * @param  Reader: Pointer to reader
+ * @param  FromUs: Start of the range
+ * @param  ToUs: End of the range (excluded)
+ * @param  X: X values (NULL if not needed)
+ * @param  Y: Y values (NULL if not needed)
+ * @param  Z: Z values (NULL if not needed)
+ * @param  MaxSamples: Capacity of the arrays
+ * @param  Count: Number of decoded samples
+ * @param  FirstUs: Time of the first decoded sample (NULL if not needed)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_LogReader_ReadFloat(ADXL345_LogReader_t *Reader,
+                            uint64_t FromUs, uint64_t ToUs,
+                            float *X, float *Y, float *Z,
+                            uint32_t MaxSamples, uint32_t *Count,
+                            uint64_t *FirstUs);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _ADXL345_LOGREADER_H_
@@ -0,0 +1,255 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_manager.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 multi-sensor manager and shared-bus scheduler
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _ADXL345_MANAGER_H_
+#define _ADXL345_MANAGER_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "ADXL345.h"
+#include "ADXL345_stream.h"
+
+
+
+/* Functionality Options --------------------------------------------------------*/
+/**
+ * @brief  Max number of sensors, buses and queued configuration jobs
+ */
+#ifndef ADXL345_MANAGER_MAX_SENSORS
+#define ADXL345_MANAGER_MAX_SENSORS   64
+#endif
+#ifndef ADXL345_MANAGER_MAX_BUSES
+#define ADXL345_MANAGER_MAX_BUSES     8
+#endif
+#ifndef ADXL345_MANAGER_MAX_JOBS
+#define ADXL345_MANAGER_MAX_JOBS      16
+#endif
+
+/**
+ * @brief  Window of bus utilisation measurement in us
+ */
+#ifndef ADXL345_MANAGER_UTIL_WINDOW_US
+#define ADXL345_MANAGER_UTIL_WINDOW_US  1000000UL
+#endif
+
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Configuration job function
+ * @note   It runs on the bus of the sensor when the job is scheduled.
+ */
+typedef ADXL345_Result_t (*ADXL345_ManagerJobFn_t)(ADXL345_Handler_t *Handler,
+                                                   void *Context);
+
+/**
+ * @brief  Managed sensor data type
+ */
+typedef struct ADXL345_ManagerSensor_s
+{
+  ADXL345_Stream_t *Stream;
+  uint8_t Bus;
+  uint8_t Priority;           // 0 is the highest
+  volatile uint8_t Pending;   // drain requested by ADXL345_Manager_Notify
+  volatile uint32_t ReadyUs;  // time of the first pending request
+  volatile uint32_t Merged;   // requests merged by ADXL345_Manager_Notify
+  uint32_t MergedSeen;        // part of Merged counted in bus statistics
+} ADXL345_ManagerSensor_t;
+
+/**
+ * @brief  Queued configuration job data type
+ */
+typedef struct ADXL345_ManagerJob_s
+{
+  uint8_t Used;
+  uint8_t Sensor;
+  uint8_t Key;
+  uint8_t Priority;
+  uint8_t HasDeadline;
+  uint32_t DeadlineUs;
+  uint32_t Order;
+  ADXL345_ManagerJobFn_t Run;
+  void *Context;
+} ADXL345_ManagerJob_t;
+
+/**
+ * @brief  Per-bus statistics data type
+ */
+typedef struct ADXL345_ManagerBusStats_s
+{
+  uint32_t Drains;
+  uint32_t Jobs;
+  uint32_t Coalesced;     // requests merged into pending work
+  uint32_t Misses;        // drains started after their deadline
+  uint32_t Errors;
+  uint32_t BusyUs;        // total time of transactions
+  uint16_t Utilization;   // permille over the last window
+  uint32_t Switches;      // mux channel switches
+  uint32_t SwitchUs;      // total time of mux channel switches
+  uint32_t Batched;       // drains kept on the selected mux channel
+} ADXL345_ManagerBusStats_t;
+
+/**
+ * @brief  Multi-sensor manager data type
+ * @note   Each sensor is drained through its streaming engine. The interrupt
+ *         routine of each sensor only calls ADXL345_Manager_Notify and the
+ *         drains are done by ADXL345_Manager_Poll of the sensor bus. So
+ *         sensors on the same bus never compete for it and the drain with the
+ *         nearest FIFO overrun goes first.
+ * @note   Sensors behind I2C multiplexers (see ADXL345_SetMux) are drained in
+ *         batches per mux channel: a drain on the selected channel goes first
+ *         while the most urgent drain can still wait for it.
+ */
+typedef struct ADXL345_Manager_s
+{
+  uint32_t (*GetTimeUs)(void);
+  uint8_t Buses;
+  uint8_t Sensors;
+  uint32_t JobOrder;
+
+  ADXL345_ManagerSensor_t Sensor[ADXL345_MANAGER_MAX_SENSORS];
+  ADXL345_ManagerJob_t Job[ADXL345_MANAGER_MAX_JOBS];
+
+  struct ADXL345_ManagerBus_s
+  {
+    uint32_t WindowStartUs;
+    uint32_t WindowBusyUs;
+    uint32_t DrainUs;     // average drain time
+    uint32_t SwitchUs;    // average mux channel switch time
+    ADXL345_ManagerBusStats_t Stats;
+  } Bus[ADXL345_MANAGER_MAX_BUSES];
+} ADXL345_Manager_t;
+
+
+
+/**
+ ==================================================================================
+                               ##### Functions #####                               
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize manager
+ * @param  Manager: Pointer to manager
+ * @param  Buses: Number of buses (1..ADXL345_MANAGER_MAX_BUSES)
+ * @param  GetTimeUs: Free running time in us
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Manager_Init(ADXL345_Manager_t *Manager, uint8_t Buses,
+                     uint32_t (*GetTimeUs)(void));
+
+/**
+ * @brief  Add a sensor to manager
+ * @param  Manager: Pointer to manager
+ * @param  Stream: Pointer to initialized streaming engine of the sensor
+ * @param  Bus: Bus index of the sensor
+ * @param  Priority: Priority of the sensor among equal deadlines (0 is the
+ *                   highest)
+ * @param  Id: Pointer to store sensor ID
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: No free sensor entry.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Manager_AddSensor(ADXL345_Manager_t *Manager, ADXL345_Stream_t *Stream,
+                          uint8_t Bus, uint8_t Priority, uint8_t *Id);
+
+/**
+ * @brief  Request a drain of sensor FIFO
+ * @note   Call this function from the interrupt routine of the sensor
+ *         instead of ADXL345_Stream_IRQ. Requests before the pending drain is
+ *         started are merged. The time of the first request is passed to
+ *         ADXL345_Stream_IRQAt, so GetTimeUs of the stream must run on the
+ *         clock of the manager.
+ * @note   It needs no lock against ADXL345_Manager_Poll: Pending is handed
+ *         over with atomic load/store, and the fields it writes have no
+ *         other writer. One sensor must not be notified from two contexts
+ *         at once.
+ * @param  Manager: Pointer to manager
+ * @param  Id: Sensor ID
+ * @retval None
+ */
+void
+ADXL345_Manager_Notify(ADXL345_Manager_t *Manager, uint8_t Id);
+
+/**
+ * @brief  Queue a configuration job for a sensor
+ * @note   A queued job with the same sensor and Key is replaced by the new one.
+ *         So repeated writes of the same setting cost one transaction.
+ * @param  Manager: Pointer to manager
+ * @param  Id: Sensor ID
+ * @param  Key: User defined kind of the job
+ * @param  Priority: Priority among jobs (0 is the highest)
+ * @param  DeadlineUs: Max delay of the job in us from now. 0 means no
+ *                     deadline: the job runs when no drain is pending.
+ * @param  Run: Job function
+ * @param  Context: User context passed to Run
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Job queue is full.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Manager_Submit(ADXL345_Manager_t *Manager, uint8_t Id, uint8_t Key,
+                       uint8_t Priority, uint32_t DeadlineUs,
+                       ADXL345_ManagerJobFn_t Run, void *Context);
+
+/**
+ * @brief  Run the most urgent transaction of a bus
+ * @note   Call this function from the task that owns the bus. Earliest
+ *         deadline goes first. The deadline of a drain is the time its FIFO
+ *         overruns. Jobs without deadline run when nothing else is pending.
+ * @param  Manager: Pointer to manager
+ * @param  Bus: Bus index
+ * @retval 1 if a transaction was run, otherwise 0
+ */
+uint8_t
+ADXL345_Manager_Poll(ADXL345_Manager_t *Manager, uint8_t Bus);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _ADXL345_MANAGER_H_
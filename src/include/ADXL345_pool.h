@@ -0,0 +1,243 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_pool.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 work-stealing processing pool (POSIX threads)
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _ADXL345_POOL_H_
+#define _ADXL345_POOL_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include <pthread.h>
+#include "ADXL345.h"
+#include "ADXL345_stream.h"
+
+
+
+/* Functionality Options --------------------------------------------------------*/
+/**
+ * @brief  Max number of worker threads and sensors of a pool
+ */
+#ifndef ADXL345_POOL_MAX_WORKERS
+#define ADXL345_POOL_MAX_WORKERS    16
+#endif
+#ifndef ADXL345_POOL_MAX_SENSORS
+#define ADXL345_POOL_MAX_SENSORS    256
+#endif
+
+/**
+ * @brief  Max number of samples of a burst
+ */
+#ifndef ADXL345_POOL_MAX_BURST
+#define ADXL345_POOL_MAX_BURST      64
+#endif
+
+/**
+ * @brief  Max number of bursts of one sensor processed before the worker
+ *         moves on to another sensor
+ */
+#ifndef ADXL345_POOL_SENSOR_BATCH
+#define ADXL345_POOL_SENSOR_BATCH   4
+#endif
+
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Raw burst data type
+ * @note   Raw holds 6 bytes per sample as read by ADXL345_ReadRawSamples.
+ *         DataFormat must be the one the samples were read with.
+ *         The burst is owned by the pool from ADXL345_Pool_Submit until it
+ *         is passed to the process function of its sensor.
+ */
+typedef struct ADXL345_PoolBurst_s
+{
+  struct ADXL345_PoolBurst_s *Next;
+  uint8_t *Raw;
+  uint8_t Count;
+  ADXL345_DataFormat_t DataFormat;
+  // Same meaning as ADXL345_Batch_t members
+  uint32_t Gap;
+  uint32_t Sequence;
+  uint32_t TimestampUs;
+} ADXL345_PoolBurst_t;
+
+/**
+ * @brief  Process function data type
+ * @note   Batch holds the decoded samples of Burst. The pool does not use
+ *         Burst after this call, so it can be reused right away.
+ *         Calls of one sensor never overlap and follow the submit order.
+ */
+typedef void (*ADXL345_PoolProcessFn_t)(void *Context, ADXL345_Batch_t *Batch,
+                                        ADXL345_PoolBurst_t *Burst);
+
+/**
+ * @brief  Pool sensor data type
+ */
+typedef struct ADXL345_PoolSensor_s
+{
+  ADXL345_PoolProcessFn_t Process;
+  void *Context;
+  pthread_mutex_t Lock;
+  ADXL345_PoolBurst_t *Head;
+  ADXL345_PoolBurst_t *Tail;
+  uint8_t Scheduled;        // queued on a worker or being processed
+  uint8_t Home;             // worker that the sensor is queued on
+
+  struct ADXL345_PoolSensorStats_s
+  {
+    uint32_t Bursts;
+    uint32_t Samples;
+  } Stats;
+} ADXL345_PoolSensor_t;
+
+/**
+ * @brief  Pool worker data type
+ * @note   A worker runs sensors of its own queue in FIFO order and steals
+ *         the most recently queued sensor of another worker when its queue
+ *         is empty.
+ */
+typedef struct ADXL345_PoolWorker_s
+{
+  struct ADXL345_Pool_s *Pool;
+  pthread_t Thread;
+  pthread_mutex_t Lock;
+  ADXL345_PoolSensor_t *Queue[ADXL345_POOL_MAX_SENSORS];
+  uint16_t Head;
+  uint16_t Count;
+  ADXL345_Sample_t Samples[ADXL345_POOL_MAX_BURST];
+
+  struct ADXL345_PoolWorkerStats_s
+  {
+    uint32_t Bursts;
+    uint32_t Steals;
+    uint32_t Sleeps;
+  } Stats;
+} ADXL345_PoolWorker_t;
+
+/**
+ * @brief  Pool data type
+ */
+typedef struct ADXL345_Pool_s
+{
+  ADXL345_PoolWorker_t Worker[ADXL345_POOL_MAX_WORKERS];
+  uint8_t Workers;
+  uint16_t Sensors;
+  pthread_mutex_t Lock;
+  pthread_cond_t Wake;
+  pthread_cond_t Idle;
+  volatile uint32_t Queued;       // sensors queued on workers
+  volatile uint32_t Outstanding;  // submitted bursts not processed yet
+  volatile uint32_t Sleepers;
+  volatile uint8_t Stop;
+} ADXL345_Pool_t;
+
+
+
+/**
+ ==================================================================================
+                               ##### Functions #####                               
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize pool and start worker threads
+ * @param  Pool: Pointer to pool
+ * @param  Workers: Number of worker threads (1..ADXL345_POOL_MAX_WORKERS)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to create threads.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Pool_Init(ADXL345_Pool_t *Pool, uint8_t Workers);
+
+/**
+ * @brief  Process remaining bursts, stop worker threads and free resources
+ * @param  Pool: Pointer to pool
+ * @retval None
+ */
+void
+ADXL345_Pool_DeInit(ADXL345_Pool_t *Pool);
+
+/**
+ * @brief  Add sensor to pool
+ * @note   Sensors are spread over workers in turn. Add all sensors before
+ *         the first submit.
+ * @param  Pool: Pointer to pool
+ * @param  Sensor: Pointer to sensor
+ * @param  Process: Process function of the sensor (decode is done by pool)
+ * @param  Context: Context of process function
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Pool is full.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Pool_AddSensor(ADXL345_Pool_t *Pool, ADXL345_PoolSensor_t *Sensor,
+                       ADXL345_PoolProcessFn_t Process, void *Context);
+
+/**
+ * @brief  Submit a completed raw burst of sensor
+ * @note   Any thread can submit. Bursts of one sensor must be submitted by
+ *         one thread at a time to keep their order.
+ * @param  Pool: Pointer to pool
+ * @param  Sensor: Pointer to sensor
+ * @param  Burst: Pointer to burst
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Pool_Submit(ADXL345_Pool_t *Pool, ADXL345_PoolSensor_t *Sensor,
+                    ADXL345_PoolBurst_t *Burst);
+
+/**
+ * @brief  Wait until all submitted bursts are processed
+ * @param  Pool: Pointer to pool
+ * @retval None
+ */
+void
+ADXL345_Pool_Drain(ADXL345_Pool_t *Pool);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _ADXL345_POOL_H_
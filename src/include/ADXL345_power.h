@@ -0,0 +1,177 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_power.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Activity driven Data Rate and power mode manager
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _ADXL345_POWER_H_
+#define _ADXL345_POWER_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "ADXL345.h"
+#include "ADXL345_stream.h"
+
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Power manager state
+ */
+typedef enum ADXL345_PowerState_e
+{
+  ADXL345_POWER_IDLE    = 0x00, // Idle profile, device awake
+  ADXL345_POWER_CAPTURE = 0x01, // Capture profile
+  ADXL345_POWER_ASLEEP  = 0x02, // Idle profile, device in sleep mode
+} ADXL345_PowerState_t;
+
+#define ADXL345_POWER_STATES  3
+
+/**
+ * @brief  Streaming profile data type
+ */
+typedef struct ADXL345_PowerProfile_s
+{
+  ADXL345_Rate_t Rate;
+  uint8_t WatermarkSamples;
+} ADXL345_PowerProfile_t;
+
+/**
+ * @brief  Power manager configuration data type
+ * @note   Thresholds and time use the register units (see
+ *         ADXL345_ConvToReg_ActivityThreshold,
+ *         ADXL345_ConvToReg_InactivityThreshold and
+ *         ADXL345_ConvToReg_InactivityTime).
+ */
+typedef struct ADXL345_PowerConfig_s
+{
+  ADXL345_PowerProfile_t Idle;      // e.g. ADXL345_LOW_POWER_RATE_12P5
+  ADXL345_PowerProfile_t Capture;   // e.g. ADXL345_RATE_1600
+  uint8_t ActivityThreshold;
+  uint8_t InactivityThreshold;
+  uint8_t InactivityTime;
+  // Let the device sleep after inactivity. It samples at Wakeup frequency
+  // while asleep and wakes up by itself on activity.
+  uint8_t AutoSleep;
+  ADXL345_SleepFrequency_t Wakeup;
+  // Time between ACT_TAP_STATUS reads while the device is asleep in us
+  uint32_t AsleepCheckUs;
+} ADXL345_PowerConfig_t;
+
+/**
+ * @brief  Power manager data type
+ * @note   The manager uses the device in link mode: inactivity is detected
+ *         only after activity and activity only after inactivity. So each
+ *         interrupt switches the profile once.
+ */
+typedef struct ADXL345_Power_s
+{
+  ADXL345_Stream_t *Stream;
+  ADXL345_PowerConfig_t Config;
+  ADXL345_PowerState_t State;
+  uint32_t LastUs;          // Time of the last accounting
+  uint32_t LastBytes;       // Handler->Stats.Bytes at the last accounting
+  uint32_t CheckUs;         // Time of the next ACT_TAP_STATUS read (asleep)
+
+  struct ADXL345_PowerStats_s
+  {
+    uint64_t TimeUs[ADXL345_POWER_STATES];
+    uint32_t BusBytes[ADXL345_POWER_STATES];
+    uint32_t Switches;      // Profile switches
+    uint32_t SkippedPolls;  // Service calls without bus access while asleep
+    uint32_t Errors;
+  } Stats;
+} ADXL345_Power_t;
+
+
+
+/**
+ ==================================================================================
+                               ##### Functions #####                               
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize power manager
+ * @note   Stream must be initialized (ADXL345_Stream_Init) with a FIFO mode
+ *         and all its members set, but not started.
+ * @param  Power: Pointer to power manager
+ * @param  Stream: Pointer to streaming engine
+ * @param  Config: Pointer to configuration
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid configuration.
+ */
+ADXL345_Result_t
+ADXL345_Power_Init(ADXL345_Power_t *Power, ADXL345_Stream_t *Stream,
+                   ADXL345_PowerConfig_t *Config);
+
+/**
+ * @brief  Configure activity detection and power control and start
+ *         streaming with the idle profile
+ * @param  Power: Pointer to power manager
+ * @param  NowUs: Current time in us
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Power_Start(ADXL345_Power_t *Power, uint32_t NowUs);
+
+/**
+ * @brief  Service the sensor and switch profiles
+ * @note   Call this function instead of ADXL345_Stream_IRQ and
+ *         ADXL345_Stream_Process, on INT or at the polling interval. While
+ *         the device is asleep it returns without bus access until
+ *         Config.AsleepCheckUs has passed, so the host can sleep too.
+ *         Time and bus bytes (Handler->Stats) are charged to the state they
+ *         were spent in.
+ * @param  Power: Pointer to power manager
+ * @param  NowUs: Current time in us
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Power_Service(ADXL345_Power_t *Power, uint32_t NowUs);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _ADXL345_POWER_H_
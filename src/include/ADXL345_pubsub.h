@@ -0,0 +1,219 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_pubsub.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 sample stream fan-out to multiple subscribers
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _ADXL345_PUBSUB_H_
+#define _ADXL345_PUBSUB_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "ADXL345.h"
+#include "ADXL345_stream.h"
+
+
+
+/* Functionality Options --------------------------------------------------------*/
+/**
+ * @brief  Memory barrier between ring writes and the Head update
+ * @note   Needed when publisher and subscribers run on different cores.
+ *         Define it as empty on single-core targets to save a few cycles.
+ */
+#ifndef ADXL345_PUBSUB_BARRIER
+#if defined(__GNUC__)
+#define ADXL345_PUBSUB_BARRIER()  __sync_synchronize()
+#else
+#define ADXL345_PUBSUB_BARRIER()
+#endif
+#endif
+
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Publisher data type
+ * @note   One producer writes samples to a shared ring and never waits for
+ *         subscribers. Subscribers keep their own cursors and read samples in
+ *         place. A subscriber that falls more than the ring size behind skips
+ *         to the newest data.
+ */
+typedef struct ADXL345_PubSub_s
+{
+  ADXL345_Sample_t *Ring;
+  uint16_t Size;            // power of 2
+  uint16_t Mask;
+  volatile uint32_t Head;   // number of published samples
+  volatile uint32_t Gaps;   // number of published discontinuities
+} ADXL345_PubSub_t;
+
+/**
+ * @brief  Subscriber data type
+ */
+typedef struct ADXL345_Subscriber_s
+{
+  ADXL345_PubSub_t *PubSub;
+  uint16_t Decimation;      // every Nth published sample is delivered
+  uint16_t BatchSamples;    // min delivered samples per view
+  uint32_t Cursor;          // next published sample to deliver
+  uint32_t SeenGaps;
+  uint8_t Lagged;
+
+  struct ADXL345_SubscriberStats_s
+  {
+    uint32_t Delivered;
+    uint32_t Dropped;       // published samples skipped due to lag
+    uint32_t Overruns;      // views overwritten while they were read
+  } Stats;
+} ADXL345_Subscriber_t;
+
+/**
+ * @brief  Zero-copy view of delivered samples
+ * @note   Samples of the view are Samples[0], Samples[Stride],
+ *         Samples[2 * Stride], ... (Count samples).
+ */
+typedef struct ADXL345_SubscriberView_s
+{
+  const ADXL345_Sample_t *Samples;
+  uint16_t Count;
+  uint16_t Stride;
+  // 1 if samples were lost before Samples[0]
+  uint8_t Gap;
+  // Published sample number of Samples[0]
+  uint32_t Sequence;
+} ADXL345_SubscriberView_t;
+
+
+
+/**
+ ==================================================================================
+                               ##### Functions #####                               
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize publisher
+ * @param  PubSub: Pointer to publisher
+ * @param  Ring: Shared ring buffer
+ * @param  Size: Number of samples of Ring (power of 2, 2..32768)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_PubSub_Init(ADXL345_PubSub_t *PubSub, ADXL345_Sample_t *Ring,
+                    uint16_t Size);
+
+/**
+ * @brief  Publish samples
+ * @note   Lock-free and independent of the number of subscribers. Only one
+ *         producer is allowed.
+ * @param  PubSub: Pointer to publisher
+ * @param  Samples: Pointer to samples
+ * @param  Count: Number of samples
+ * @param  Gap: 1 if samples were lost before Samples[0]
+ * @retval None
+ */
+void
+ADXL345_PubSub_Publish(ADXL345_PubSub_t *PubSub,
+                       const ADXL345_Sample_t *Samples, uint16_t Count,
+                       uint8_t Gap);
+
+/**
+ * @brief  Streaming engine sink that publishes each batch
+ * @note   Set Stream->Sink to this function and Stream->SinkContext to the
+ *         publisher.
+ * @param  SinkContext: Pointer to publisher
+ * @param  Batch: Pointer to batch
+ * @retval None
+ */
+void
+ADXL345_PubSub_Sink(void *SinkContext, ADXL345_Batch_t *Batch);
+
+/**
+ * @brief  Attach subscriber to publisher
+ * @note   Delivery starts from the next published sample.
+ * @param  Subscriber: Pointer to subscriber
+ * @param  PubSub: Pointer to publisher
+ * @param  Decimation: Deliver every Nth sample (>= 1). No anti-alias filter is
+ *                     applied. Use ADXL345_decim for filtered rates.
+ * @param  BatchSamples: Min number of samples per view (>= 1).
+ *                       Decimation * BatchSamples must not exceed ring size.
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_PubSub_Subscribe(ADXL345_Subscriber_t *Subscriber,
+                         ADXL345_PubSub_t *PubSub,
+                         uint16_t Decimation, uint16_t BatchSamples);
+
+/**
+ * @brief  Get a view of the next samples of subscriber
+ * @note   A view is returned only when BatchSamples samples are available.
+ *         It has BatchSamples samples, or fewer when the batch crosses the end
+ *         of the ring. Then the rest is returned by the next call.
+ * @param  Subscriber: Pointer to subscriber
+ * @param  View: Pointer to view
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Not enough samples.
+ */
+ADXL345_Result_t
+ADXL345_PubSub_Peek(ADXL345_Subscriber_t *Subscriber,
+                    ADXL345_SubscriberView_t *View);
+
+/**
+ * @brief  Release a view and advance subscriber cursor
+ * @param  Subscriber: Pointer to subscriber
+ * @param  View: Pointer to view returned by ADXL345_PubSub_Peek
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Samples of the view were overwritten while being
+ *                         read. Results computed from the view must be
+ *                         dropped.
+ */
+ADXL345_Result_t
+ADXL345_PubSub_Release(ADXL345_Subscriber_t *Subscriber,
+                       const ADXL345_SubscriberView_t *View);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _ADXL345_PUBSUB_H_
@@ -0,0 +1,233 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_shm.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 shared-memory sample ring for multi-process consumers (Linux)
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _ADXL345_SHM_H_
+#define _ADXL345_SHM_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+#include "ADXL345.h"
+#include "ADXL345_stream.h"
+
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+/**
+ * @brief  Shared ring data type
+ * @note   It lives in POSIX shared memory and is mapped by every process.
+ *         One producer writes samples in place and never waits for readers.
+ *         Reserve is moved before samples are written and Head after, so a
+ *         reader can tell whether the samples it has read were overwritten
+ *         meanwhile (seqlock style).
+ */
+typedef struct ADXL345_ShmRing_s
+{
+  char Magic[4];
+  uint32_t Version;
+  uint32_t Size;                // number of samples (power of 2)
+  uint32_t SampleSize;          // sizeof(ADXL345_Sample_t) of the producer
+  volatile uint64_t Reserve;    // samples being or already written
+  volatile uint64_t Head;       // samples published
+  volatile uint32_t Gaps;       // published discontinuities
+  volatile uint32_t Notify;     // futex word, changes on every publish
+  volatile uint32_t Waiters;    // readers sleeping on Notify
+  uint32_t Reserved;
+  ADXL345_Sample_t Ring[];
+} ADXL345_ShmRing_t;
+
+/**
+ * @brief  Shared ring handle data type (per process)
+ */
+typedef struct ADXL345_Shm_s
+{
+  ADXL345_ShmRing_t *Ring;
+  size_t MapSize;
+  uint8_t Owner;                // created by this process, unlinked on close
+  char Name[64];
+} ADXL345_Shm_t;
+
+/**
+ * @brief  Shared ring reader data type
+ */
+typedef struct ADXL345_ShmReader_s
+{
+  ADXL345_Shm_t Shm;
+  uint64_t Cursor;              // next sample to deliver
+  uint32_t SeenGaps;
+  uint8_t Lagged;
+
+  struct ADXL345_ShmReaderStats_s
+  {
+    uint64_t Delivered;
+    uint64_t Dropped;           // samples skipped due to lag
+    uint32_t Overruns;          // views overwritten while they were read
+  } Stats;
+} ADXL345_ShmReader_t;
+
+/**
+ * @brief  Zero-copy view of shared samples
+ */
+typedef struct ADXL345_ShmView_s
+{
+  const ADXL345_Sample_t *Samples;
+  uint32_t Count;
+  // 1 if samples were lost before Samples[0]
+  uint8_t Gap;
+  // Published sample number of Samples[0]
+  uint64_t Sequence;
+} ADXL345_ShmView_t;
+
+
+
+/**
+ ==================================================================================
+                               ##### Functions #####                               
+ ==================================================================================
+ */
+
+/**
+ * @brief  Create a shared ring (producer)
+ * @param  Shm: Pointer to handle
+ * @param  Name: Shared memory object name (e.g. "/adxl345")
+ * @param  Size: Number of samples (power of 2, >= 2)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to create or map the object.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Shm_Create(ADXL345_Shm_t *Shm, const char *Name, uint32_t Size);
+
+/**
+ * @brief  Attach a reader to an existing shared ring
+ * @note   Delivery starts from the next published sample.
+ * @param  Reader: Pointer to reader
+ * @param  Name: Shared memory object name
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Object does not exist or is not a compatible ring.
+ *         - ADXL345_INVALID_PARAM: Invalid parameter.
+ */
+ADXL345_Result_t
+ADXL345_Shm_Open(ADXL345_ShmReader_t *Reader, const char *Name);
+
+/**
+ * @brief  Unmap the shared ring. The producer also removes its name.
+ * @param  Shm: Pointer to handle
+ * @retval None
+ */
+void
+ADXL345_Shm_Close(ADXL345_Shm_t *Shm);
+
+/**
+ * @brief  Publish samples
+ * @note   Lock-free, independent of the number of readers. Sleeping readers
+ *         cost one system call per publish.
+ * @param  Shm: Pointer to handle
+ * @param  Samples: Pointer to samples
+ * @param  Count: Number of samples
+ * @param  Gap: 1 if samples were lost before Samples[0]
+ * @retval None
+ */
+void
+ADXL345_Shm_Publish(ADXL345_Shm_t *Shm, const ADXL345_Sample_t *Samples,
+                    uint32_t Count, uint8_t Gap);
+
+/**
+ * @brief  Streaming engine sink that publishes each batch
+ * @note   Set Stream->Sink to this function and Stream->SinkContext to the
+ *         handle.
+ * @param  SinkContext: Pointer to handle
+ * @param  Batch: Pointer to batch
+ * @retval None
+ */
+void
+ADXL345_Shm_Sink(void *SinkContext, ADXL345_Batch_t *Batch);
+
+/**
+ * @brief  Get a view of the next samples of reader
+ * @note   The view holds all available samples up to MaxSamples, or fewer
+ *         when they cross the end of the ring.
+ * @param  Reader: Pointer to reader
+ * @param  View: Pointer to view
+ * @param  MinSamples: Min number of available samples (>= 1)
+ * @param  MaxSamples: Max number of samples of the view
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Not enough samples.
+ */
+ADXL345_Result_t
+ADXL345_Shm_Peek(ADXL345_ShmReader_t *Reader, ADXL345_ShmView_t *View,
+                 uint32_t MinSamples, uint32_t MaxSamples);
+
+/**
+ * @brief  Release a view and advance reader cursor
+ * @param  Reader: Pointer to reader
+ * @param  View: Pointer to view returned by ADXL345_Shm_Peek
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Samples of the view were overwritten while being
+ *                         read. Results computed from the view must be
+ *                         dropped.
+ */
+ADXL345_Result_t
+ADXL345_Shm_Release(ADXL345_ShmReader_t *Reader,
+                    const ADXL345_ShmView_t *View);
+
+/**
+ * @brief  Sleep until MinSamples samples are available
+ * @param  Reader: Pointer to reader
+ * @param  MinSamples: Min number of available samples (>= 1)
+ * @param  TimeoutMs: Max waiting time in ms
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Timeout.
+ */
+ADXL345_Result_t
+ADXL345_Shm_Wait(ADXL345_ShmReader_t *Reader, uint32_t MinSamples,
+                 uint32_t TimeoutMs);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _ADXL345_SHM_H_
@@ -0,0 +1,222 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_stats.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 streaming vibration statistics
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _ADXL345_STATS_H_
+#define _ADXL345_STATS_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "ADXL345.h"
+
+
+
+/* Exported Constants -----------------------------------------------------------*/
+/**
+ * @brief  Max window length of the fixed-point statistics
+ * @note   It keeps the 4th power sums of 14-bit samples inside int64_t.
+ */
+#define ADXL345_STATSQ_MAX_WINDOW   1024
+
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+
+/**
+ * @brief  Floating-point statistics of one axis (unit is g)
+ * @note   Rms and CrestFactor are computed around the mean. So gravity does
+ *         not affect them. Kurtosis is not excess kurtosis (sine => 1.5,
+ *         Gaussian => 3).
+ */
+typedef struct ADXL345_AxisStatsF_s
+{
+  float Mean;
+  float Rms;
+  float PeakToPeak;
+  float CrestFactor;
+  float Kurtosis;
+} ADXL345_AxisStatsF_t;
+
+/**
+ * @brief  Fixed-point statistics of one axis (unit is LSB of raw samples)
+ */
+typedef struct ADXL345_AxisStatsQ_s
+{
+  int32_t Mean;         // Q4
+  int32_t Rms;          // Q4
+  int32_t PeakToPeak;   // Q0
+  int32_t CrestFactor;  // Q8
+  int32_t Kurtosis;     // Q8
+} ADXL345_AxisStatsQ_t;
+
+/**
+ * @brief  Floating-point window statistics data type
+ * @note   Welford/Terriberry online update is used for mean and central
+ *         moments. So each sample is O(1) and there is no cancellation.
+ */
+typedef struct ADXL345_StatsF_s
+{
+  uint16_t WindowSamples;
+  uint16_t Count;
+
+  struct ADXL345_StatsAxisStateF_s
+  {
+    float Mean;
+    float M2;
+    float M3;
+    float M4;
+    float Min;
+    float Max;
+  } Axis[3];
+
+  struct ADXL345_StatsResultF_s
+  {
+    ADXL345_AxisStatsF_t X;
+    ADXL345_AxisStatsF_t Y;
+    ADXL345_AxisStatsF_t Z;
+    uint16_t Samples;
+  } Result;
+} ADXL345_StatsF_t;
+
+/**
+ * @brief  Fixed-point window statistics data type
+ * @note   Power sums are accumulated around the first sample of the window.
+ *         Central moments are computed once per window with integer math.
+ *         No floating-point operation is used.
+ */
+typedef struct ADXL345_StatsQ_s
+{
+  uint16_t WindowSamples;
+  uint16_t Count;
+
+  struct ADXL345_StatsAxisStateQ_s
+  {
+    int16_t Ref;
+    int16_t Min;
+    int16_t Max;
+    int32_t S1;
+    int64_t S2;
+    int64_t S3;
+    int64_t S4;
+  } Axis[3];
+
+  struct ADXL345_StatsResultQ_s
+  {
+    ADXL345_AxisStatsQ_t X;
+    ADXL345_AxisStatsQ_t Y;
+    ADXL345_AxisStatsQ_t Z;
+    uint16_t Samples;
+  } Result;
+} ADXL345_StatsQ_t;
+
+
+
+/**
+ ==================================================================================
+                               ##### Functions #####                               
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize floating-point window statistics
+ * @param  Stats: Pointer to statistics
+ * @param  WindowSamples: Number of samples per window (> 1)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid window length.
+ */
+ADXL345_Result_t
+ADXL345_StatsF_Init(ADXL345_StatsF_t *Stats, uint16_t WindowSamples);
+
+/**
+ * @brief  Restart the current window
+ * @note   Call this function on a gap in the sample stream.
+ * @param  Stats: Pointer to statistics
+ * @retval None
+ */
+void
+ADXL345_StatsF_Reset(ADXL345_StatsF_t *Stats);
+
+/**
+ * @brief  Add one sample (AccelX, AccelY and AccelZ are used)
+ * @param  Stats: Pointer to statistics
+ * @param  Sample: Pointer to sample
+ * @retval 1 if the window is completed and Stats->Result is updated,
+ *         otherwise 0
+ */
+uint8_t
+ADXL345_StatsF_Push(ADXL345_StatsF_t *Stats, const ADXL345_Sample_t *Sample);
+
+/**
+ * @brief  Initialize fixed-point window statistics
+ * @param  Stats: Pointer to statistics
+ * @param  WindowSamples: Number of samples per window
+ *                        (2..ADXL345_STATSQ_MAX_WINDOW)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid window length.
+ */
+ADXL345_Result_t
+ADXL345_StatsQ_Init(ADXL345_StatsQ_t *Stats, uint16_t WindowSamples);
+
+/**
+ * @brief  Restart the current window
+ * @note   Call this function on a gap in the sample stream.
+ * @param  Stats: Pointer to statistics
+ * @retval None
+ */
+void
+ADXL345_StatsQ_Reset(ADXL345_StatsQ_t *Stats);
+
+/**
+ * @brief  Add one sample (RawX, RawY and RawZ are used)
+ * @param  Stats: Pointer to statistics
+ * @param  Sample: Pointer to sample
+ * @retval 1 if the window is completed and Stats->Result is updated,
+ *         otherwise 0
+ */
+uint8_t
+ADXL345_StatsQ_Push(ADXL345_StatsQ_t *Stats, const ADXL345_Sample_t *Sample);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _ADXL345_STATS_H_
@@ -0,0 +1,492 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_stream.h
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  ADXL345 streaming helpers
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Define to prevent recursive inclusion ----------------------------------------*/
+#ifndef _ADXL345_STREAM_H_
+#define _ADXL345_STREAM_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdint.h>
+#include "ADXL345.h"
+
+
+
+/* Functionality Options --------------------------------------------------------*/
+/**
+ * @brief  Number of drained FIFO bursts that can wait for ADXL345_Stream_Process
+ * @note   2 gives double buffering: one burst is decoded while the next one is
+ *         being read.
+ */
+#ifndef ADXL345_STREAM_SLOTS
+#define ADXL345_STREAM_SLOTS  2
+#endif
+
+
+
+/* Exported Data Types ----------------------------------------------------------*/
+
+/**
+ * @brief  Adaptive FIFO watermark controller data type
+ * @note   Configuration members are set by ADXL345_WatermarkCtrl_Init and can
+ *         be changed afterwards. State and Stats are managed by the controller.
+ */
+typedef struct ADXL345_WatermarkCtrl_s
+{
+  // Max age of the oldest sample in us when a drain finishes
+  uint32_t LatencyBudgetUs;
+  // Watermark limits (1 <= MinWatermark <= MaxWatermark <= 31)
+  uint8_t MinWatermark;
+  uint8_t MaxWatermark;
+  // Number of drains to hold the watermark down after an overrun
+  uint8_t HoldDrains;
+
+  uint32_t SamplePeriodUs;
+  uint32_t DrainLatencyUs; // Filtered interrupt to end of drain time in us
+  uint8_t Watermark;
+  uint8_t Hold;
+
+  struct ADXL345_WatermarkCtrlStats_s
+  {
+    uint32_t Drains;
+    uint32_t Overruns;
+    uint32_t Increases;
+    uint32_t Decreases;
+    uint32_t MaxDrainLatencyUs;
+  } Stats;
+} ADXL345_WatermarkCtrl_t;
+
+/**
+ * @brief  Sample batch data type
+ * @note   FIFO overrun loses the samples right before the oldest entry in FIFO.
+ *         So a gap can only appear at the beginning of a batch and it is
+ *         marked by a non-zero Gap.
+ */
+typedef struct ADXL345_Batch_s
+{
+  ADXL345_Sample_t *Samples;
+  uint8_t Count;
+  // Number of samples lost right before Samples[0] (0 => contiguous)
+  uint32_t Gap;
+  // Sequence number of Samples[0], counting the lost samples too
+  uint32_t Sequence;
+  // Estimated timestamp of Samples[0] in us
+  uint32_t TimestampUs;
+} ADXL345_Batch_t;
+
+/**
+ * @brief  Streaming engine configuration data type
+ * @note   In ADXL345_MODE_BYPASS the engine drains one sample per DATA_READY
+ *         interrupt. In the other modes it drains on WATERMARK interrupt.
+ */
+typedef struct ADXL345_StreamConfig_s
+{
+  ADXL345_Rate_t Rate;
+  ADXL345_Range_t Range;
+  uint8_t FullResolution;
+  ADXL345_Mode_t Mode;
+  uint8_t WatermarkSamples;
+  ADXL345_TriggerPin_t Pin; // Interrupt pin connected to the host
+} ADXL345_StreamConfig_t;
+
+/**
+ * @brief  Streaming engine statistics data type
+ */
+typedef struct ADXL345_StreamStats_s
+{
+  uint32_t Drains;
+  uint32_t Batches;
+  uint32_t Samples;
+  uint32_t Overruns;      // FIFO overruns reported by the device
+  uint32_t SlotOverflows; // Bursts dropped because all slots were full
+  uint32_t BusErrors;
+} ADXL345_StreamStats_t;
+
+/**
+ * @brief  Sample stream gap tracker data type
+ */
+typedef struct ADXL345_GapTracker_s
+{
+  uint32_t SamplePeriodUs;
+  uint32_t NextSequence;
+  uint32_t LastTimestampUs; // Estimated timestamp of the last sample
+  uint8_t FifoDepth;        // A batch this long may have lost samples
+  uint8_t Started;
+  uint8_t OverrunPending;
+
+  struct ADXL345_GapTrackerStats_s
+  {
+    uint32_t Samples;
+    uint32_t Overruns;
+    uint32_t Gaps;
+    uint32_t DroppedSamples;
+  } Stats;
+} ADXL345_GapTracker_t;
+
+/**
+ * @brief  ODR-aligned polling scheduler data type
+ * @note   For boards without INT line. The time the FIFO reaches the
+ *         watermark is predicted from the end of the previous drain and the
+ *         real sample period. The period starts at the nominal value of the
+ *         Data Rate and is corrected from the number of drained samples over
+ *         time, since the ODR of a device can be a few percent off.
+ */
+typedef struct ADXL345_PollSched_s
+{
+  uint32_t NominalPeriodUs;
+  uint32_t PeriodQ8;        // Estimated sample period in 1/256 us
+  int32_t OffsetUs;         // Wake-up time from the predicted watermark
+  uint8_t Watermark;
+  uint8_t Anchored;
+  uint32_t LastUs;          // Time of the last poll
+  uint32_t AnchorUs;
+  uint32_t AnchorSamples;
+  uint32_t Samples;         // Drained samples
+  uint32_t NaiveUs;         // Time not yet counted in Stats.NaivePolls
+  uint32_t DeadlineUs;      // Time of the next poll
+  uint8_t DeadlineQ8;       // Fraction of DeadlineUs in 1/256 us
+  uint32_t LastDrainUs;     // Duration of the last poll that drained FIFO
+
+  struct ADXL345_PollSchedStats_s
+  {
+    uint32_t Polls;         // Status polls (one INT_SOURCE read each)
+    uint32_t EarlyPolls;    // Polls that drained less than the watermark
+    uint32_t Drains;
+    uint32_t Overruns;
+    uint32_t NaivePolls;    // Polls of a loop that polls every sample period
+  } Stats;
+} ADXL345_PollSched_t;
+
+
+
+/**
+ * @brief  Streaming engine data type
+ * @note   User must initialize these members before ADXL345_Stream_Start:
+ *         - Sink: Called from ADXL345_Stream_Process for every drained batch
+ *         - SinkContext (optional): Passed to Sink
+ *         - GetTimeUs (optional): Free running time in us. Used for
+ *           timestamps, gap estimation and watermark control.
+ *         - WatermarkCtrl (optional): Adaptive watermark controller. Needs
+ *           GetTimeUs. ADXL345_WatermarkCtrl_Init must be called before.
+ */
+typedef struct ADXL345_Stream_s
+{
+  ADXL345_Handler_t *Handler;
+  ADXL345_StreamConfig_t Config;
+
+  void (*Sink)(void *SinkContext, ADXL345_Batch_t *Batch);
+  void *SinkContext;
+  uint32_t (*GetTimeUs)(void);
+  ADXL345_WatermarkCtrl_t *WatermarkCtrl;
+
+  ADXL345_DataFormat_t DataFormat;
+  ADXL345_FifoConfig_t FifoConfig;
+  ADXL345_GapTracker_t Tracker;
+  uint8_t Running;
+  uint8_t OverrunPending;
+
+  // Raw bursts written by ADXL345_Stream_IRQ and read by ADXL345_Stream_Process
+  // Head is stored with release after its slot is written, Tail after its
+  // slot is decoded. Each side loads the other one with acquire.
+  struct ADXL345_StreamSlot_s
+  {
+    uint8_t Raw[ADXL345_FIFO_SIZE * 6];
+    uint8_t Count;
+    uint8_t Overrun;
+    uint32_t TimestampUs;
+  } Slots[ADXL345_STREAM_SLOTS];
+  volatile uint8_t Head;
+  volatile uint8_t Tail;
+
+  ADXL345_Sample_t Samples[ADXL345_FIFO_SIZE];
+  ADXL345_StreamStats_t Stats;
+
+  // Interrupts not used by the engine (free fall, activity, inactivity and
+  // taps) seen by ADXL345_Stream_IRQ. Bits stay set until the user clears
+  // them.
+  ADXL345_InterruptReg_t Events;
+} ADXL345_Stream_t;
+
+
+
+/**
+ ==================================================================================
+                               ##### Functions #####                               
+ ==================================================================================
+ */
+
+/**
+ * @brief  Initialize adaptive watermark controller
+ * @param  Ctrl: Pointer to controller
+ * @param  Rate: Data Rate of the device
+ * @param  LatencyBudgetUs: Max age of the oldest sample in us when a drain
+ *                          finishes
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: LatencyBudgetUs is 0.
+ */
+ADXL345_Result_t
+ADXL345_WatermarkCtrl_Init(ADXL345_WatermarkCtrl_t *Ctrl,
+                           ADXL345_Rate_t Rate, uint32_t LatencyBudgetUs);
+
+/**
+ * @brief  Update controller after a FIFO drain
+ * @note   The watermark follows an additive-increase/multiplicative-decrease
+ *         rule. It grows by one sample per drain towards the largest value
+ *         that fits both the latency budget and the FIFO headroom needed to
+ *         cover the measured drain latency. It is halved on overrun and held
+ *         down for HoldDrains drains.
+ * @param  Ctrl: Pointer to controller
+ * @param  DrainLatencyUs: Time from interrupt to the end of the drain in us
+ * @param  Overrun: 1 if an overrun was reported since the last drain
+ * @retval New watermark
+ */
+uint8_t
+ADXL345_WatermarkCtrl_Update(ADXL345_WatermarkCtrl_t *Ctrl,
+                             uint32_t DrainLatencyUs, uint8_t Overrun);
+
+/**
+ * @brief  Write controller watermark to FIFO_CTL if it has changed
+ * @param  Handler: Pointer to handler
+ * @param  Ctrl: Pointer to controller
+ * @param  Config: Pointer to current FIFO Configurations. WatermarkSamples is
+ *                 updated on success.
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_WatermarkCtrl_Apply(ADXL345_Handler_t *Handler,
+                            ADXL345_WatermarkCtrl_t *Ctrl,
+                            ADXL345_FifoConfig_t *Config);
+
+
+/**
+ * @brief  Initialize sample stream gap tracker
+ * @param  Tracker: Pointer to tracker
+ * @param  Rate: Data Rate of the device
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ */
+ADXL345_Result_t
+ADXL345_GapTracker_Init(ADXL345_GapTracker_t *Tracker, ADXL345_Rate_t Rate);
+
+/**
+ * @brief  Fill sequence, timestamp and gap fields of a drained batch
+ * @note   Batches are taken as contiguous unless Overrun is set or Count
+ *         reaches FifoDepth. Only then the number of lost samples is
+ *         estimated from the time between the last sample of the previous
+ *         batch and the first sample of this batch, taking the newest sample
+ *         at DrainTimestampUs. When Overrun is set, at least one sample is
+ *         counted as lost.
+ * @param  Tracker: Pointer to tracker
+ * @param  Batch: Pointer to batch. Samples and Count must be set.
+ * @param  DrainTimestampUs: Time the FIFO entry count was read in us
+ * @param  Overrun: 1 if an overrun was reported since the previous drain
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ */
+ADXL345_Result_t
+ADXL345_GapTracker_Mark(ADXL345_GapTracker_t *Tracker, ADXL345_Batch_t *Batch,
+                        uint32_t DrainTimestampUs, uint8_t Overrun);
+
+
+/**
+ * @brief  Initialize streaming engine
+ * @note   Sink and optional members must be set after this function.
+ * @param  Stream: Pointer to streaming engine
+ * @param  Handler: Pointer to initialized handler
+ * @param  Config: Pointer to streaming configuration
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Invalid configuration.
+ */
+ADXL345_Result_t
+ADXL345_Stream_Init(ADXL345_Stream_t *Stream, ADXL345_Handler_t *Handler,
+                    ADXL345_StreamConfig_t *Config);
+
+/**
+ * @brief  Configure the device and start streaming
+ * @note   Rate, data format, FIFO and interrupt registers are written, FIFO is
+ *         flushed and measurement is started.
+ * @param  Stream: Pointer to streaming engine
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ *         - ADXL345_INVALID_PARAM: Sink is not set.
+ */
+ADXL345_Result_t
+ADXL345_Stream_Start(ADXL345_Stream_t *Stream);
+
+/**
+ * @brief  Stop streaming
+ * @note   Measurement and streaming interrupts are disabled. Bursts already
+ *         drained can still be delivered by ADXL345_Stream_Process.
+ * @param  Stream: Pointer to streaming engine
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Stream_Stop(ADXL345_Stream_t *Stream);
+
+/**
+ * @brief  Change Data Rate and watermark while streaming
+ * @note   The device stays in measurement mode, so activity, inactivity and
+ *         auto sleep keep their state. Samples already in FIFO are delivered
+ *         with the next batch and timestamped at the new rate.
+ * @param  Stream: Pointer to started streaming engine
+ * @param  Rate: New Data Rate
+ * @param  WatermarkSamples: New FIFO watermark (ignored in
+ *                           ADXL345_MODE_BYPASS and when WatermarkCtrl is
+ *                           set)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ *         - ADXL345_INVALID_PARAM: Invalid watermark.
+ */
+ADXL345_Result_t
+ADXL345_Stream_SetRate(ADXL345_Stream_t *Stream, ADXL345_Rate_t Rate,
+                       uint8_t WatermarkSamples);
+
+/**
+ * @brief  Streaming IRQ Handler
+ * @note   Put this function in ISR instead of ADXL345_IRQ_Handler. It drains
+ *         FIFO into a free slot without decoding. Interrupts not used by the
+ *         engine are passed to Handler->InterruptCallback (if set).
+ * @param  Stream: Pointer to streaming engine
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Stream_IRQ(ADXL345_Stream_t *Stream);
+
+/**
+ * @brief  Streaming IRQ Handler with the time of the interrupt
+ * @note   Same as ADXL345_Stream_IRQ, which takes the time of its own call as
+ *         the time of the interrupt. The watermark controller sizes the FIFO
+ *         headroom from the time between InterruptUs and the end of the
+ *         drain, so it only sees the interrupt dispatch latency (ISR entry,
+ *         deferred work, thread wake-up) when InterruptUs is taken at the
+ *         interrupt itself (e.g. first thing in the ISR or the edge time of
+ *         the GPIO).
+ * @param  Stream: Pointer to streaming engine
+ * @param  InterruptUs: Time the interrupt was raised in us (same clock as
+ *                      GetTimeUs)
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ */
+ADXL345_Result_t
+ADXL345_Stream_IRQAt(ADXL345_Stream_t *Stream, uint32_t InterruptUs);
+
+/**
+ * @brief  Decode drained bursts and deliver them to Sink
+ * @note   Call this function from the main loop or a task. It runs
+ *         concurrently with ADXL345_Stream_IRQ filling the next slot.
+ * @param  Stream: Pointer to streaming engine
+ * @retval Number of delivered batches
+ */
+uint8_t
+ADXL345_Stream_Process(ADXL345_Stream_t *Stream);
+
+
+/**
+ * @brief  Initialize ODR-aligned polling scheduler
+ * @note   Call this function right after measurement is started (e.g. after
+ *         ADXL345_Stream_Start).
+ * @param  Sched: Pointer to scheduler
+ * @param  Rate: Data Rate of the device
+ * @param  Watermark: FIFO watermark (1 in ADXL345_MODE_BYPASS)
+ * @param  NowUs: Current time in us
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_INVALID_PARAM: Watermark is out of range.
+ */
+ADXL345_Result_t
+ADXL345_PollSched_Init(ADXL345_PollSched_t *Sched, ADXL345_Rate_t Rate,
+                       uint8_t Watermark, uint32_t NowUs);
+
+/**
+ * @brief  Update scheduler after a status poll
+ * @note   Polls are aligned to the sample grid predicted from the last
+ *         anchor drain. A poll that drains less than the watermark came too
+ *         early and moves the next wake-ups later by half a period. Each
+ *         full drain moves them earlier by 1/16 of a period and an overrun
+ *         by a quarter of the watermark, so the polls settle around the
+ *         watermark.
+ *         With a watermark of 1 (ADXL345_MODE_BYPASS) polls are one sample
+ *         period apart and an empty poll is not repeated early. An empty
+ *         poll or an overrun moves them back to the middle of the period
+ *         and corrects the period by the drift since the last move.
+ *         Stats.NaivePolls - Stats.Polls is the number of status polls saved
+ *         compared with polling once per sample period.
+ * @param  Sched: Pointer to scheduler
+ * @param  NowUs: Time at the end of the poll in us
+ * @param  Drained: Number of drained samples
+ * @param  Overrun: 1 if an overrun was reported by the poll
+ * @retval Time of the next poll in us (absolute, same clock as NowUs)
+ */
+uint32_t
+ADXL345_PollSched_Update(ADXL345_PollSched_t *Sched, uint32_t NowUs,
+                         uint8_t Drained, uint8_t Overrun);
+
+/**
+ * @brief  Poll and drain a stream and schedule the next poll
+ * @note   Call this function when the time reaches Sched->DeadlineUs.
+ *         Stream->GetTimeUs must be set. It runs ADXL345_Stream_IRQ and
+ *         ADXL345_Stream_Process and follows watermark changes of the
+ *         stream.
+ * @param  Sched: Pointer to scheduler
+ * @param  Stream: Pointer to started streaming engine
+ * @retval ADXL345_Result_t
+ *         - ADXL345_OK: Operation was successful.
+ *         - ADXL345_FAIL: Failed to send or receive data.
+ *         - ADXL345_INVALID_PARAM: GetTimeUs is not set.
+ */
+ADXL345_Result_t
+ADXL345_PollSched_Service(ADXL345_PollSched_t *Sched,
+                          ADXL345_Stream_t *Stream);
+
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif //! _ADXL345_STREAM_H_
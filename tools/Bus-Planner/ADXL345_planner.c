@@ -0,0 +1,607 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_planner.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Host utility for choosing Data Rate, FIFO mode and watermark
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "ADXL345.h"
+#include "ADXL345_cost.h"
+#ifdef ADXL345_PLANNER_SIM
+#include "ADXL345_stream.h"
+#include "ADXL345_platform.h"
+#endif
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define PLANNER_I2C_CLOCK     400000
+#define PLANNER_SPI_CLOCK     5000000
+
+#ifdef ADXL345_PLANNER_SIM
+#define PLANNER_SIM_SENSORS   8
+#define PLANNER_SIM_MUX       0x70
+// Simulated time before the counters are sampled
+#define PLANNER_SIM_WARMUP_US 100000
+#endif
+
+
+/* Private Data Types -----------------------------------------------------------*/
+typedef struct Planner_Options_s
+{
+  ADXL345_CostConfig_t Config;
+  ADXL345_CostLimits_t Limits;
+  uint32_t ValidateMs;
+} Planner_Options_t;
+
+#ifdef ADXL345_PLANNER_SIM
+typedef struct Planner_Counters_s
+{
+  uint32_t NowUs;
+  uint32_t Drains;
+  uint32_t Samples;
+  uint32_t Overruns;
+  uint32_t Transfers;
+  uint32_t Bytes;
+  uint32_t Transactions;
+  uint64_t BusyNs;
+} Planner_Counters_t;
+#endif
+
+
+/* Private Variables ------------------------------------------------------------*/
+#ifdef ADXL345_PLANNER_SIM
+static int8_t (*Planner_Send)(uint8_t Address, uint8_t *Data, uint8_t Len);
+static int8_t (*Planner_Receive)(uint8_t Address, uint8_t *Data, uint8_t Len);
+static uint32_t Planner_OverheadUs = 0;
+static ADXL345_Handler_t Planner_Handler[PLANNER_SIM_SENSORS];
+static ADXL345_Stream_t Planner_Stream[PLANNER_SIM_SENSORS];
+static ADXL345_Mux_t Planner_Mux;
+#endif
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static int
+Planner_ParseRate(const char *Arg, ADXL345_Rate_t *Rate)
+{
+  uint8_t LowPower = 0;
+  uint32_t MilliHz = 0;
+  uint32_t Nominal = 0;
+  uint8_t Code = 0;
+
+  if (strncmp(Arg, "lp", 2) == 0)
+  {
+    LowPower = 1;
+    Arg += 2;
+  }
+
+  MilliHz = (uint32_t)(atof(Arg) * 1000 + 0.5);
+
+  for (Code = 0; Code < 16; Code++)
+  {
+    Nominal = ADXL345_ConvToData_RateMilliHz(Code);
+    if (MilliHz * 50 < Nominal * 49 || MilliHz * 50 > Nominal * 51)
+      continue;
+    if (LowPower && (Code < ADXL345_RATE_12P5 || Code > ADXL345_RATE_400))
+      return -1;
+    *Rate = (ADXL345_Rate_t)(LowPower ? (Code | 0x10) : Code);
+    return 0;
+  }
+
+  return -1;
+}
+
+
+static int
+Planner_ParseMode(const char *Arg, ADXL345_Mode_t *Mode)
+{
+  if (strcmp(Arg, "bypass") == 0)
+    *Mode = ADXL345_MODE_BYPASS;
+  else if (strcmp(Arg, "fifo") == 0)
+    *Mode = ADXL345_MODE_FIFO;
+  else if (strcmp(Arg, "stream") == 0)
+    *Mode = ADXL345_MODE_STREAM;
+  else
+    return -1;
+
+  return 0;
+}
+
+
+static const char*
+Planner_ModeName(ADXL345_Mode_t Mode)
+{
+  switch (Mode)
+  {
+  case ADXL345_MODE_BYPASS: return "bypass";
+  case ADXL345_MODE_FIFO:   return "fifo";
+  default:                  return "stream";
+  }
+}
+
+
+static void
+Planner_RateName(ADXL345_Rate_t Rate, char *Name, size_t Size)
+{
+  snprintf(Name, Size, "%s%g", (Rate & 0x10) ? "lp" : "",
+           ADXL345_ConvToData_RateMilliHz(Rate) / 1000.0);
+}
+
+
+static void
+Planner_Usage(const char *Name)
+{
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  -r HZ       output data rate, \"lp\" prefix for low power "
+          "(default 800)\n"
+          "  -m MODE     FIFO mode bypass, fifo or stream (default stream)\n"
+          "  -w N        FIFO watermark 1..31 (default 16)\n"
+          "  -t BUS      i2c or spi (default i2c)\n"
+          "  -c HZ       bus clock (default %d for i2c, %d for spi)\n"
+          "  -n N        sensors on the bus (default 1)\n"
+          "  -x          sensors are behind an I2C mux\n"
+          "  -l US       INT to first bus access (default 50)\n"
+          "  -o US       host overhead per transfer (default 0)\n"
+          "  -u PCT      max bus utilisation of recommendations (default 50)\n"
+          "  -M N        FIFO entries to keep free (default 2)\n"
+          "  -L US       max age of a sample when read, 0 for none "
+          "(default 0)\n"
+#ifdef ADXL345_PLANNER_SIM
+          "  -V SEC      run the setting on the simulator and compare\n"
+#endif
+          , Name, PLANNER_I2C_CLOCK, PLANNER_SPI_CLOCK);
+}
+
+
+static int
+Planner_ParseOptions(int argc, char **argv, Planner_Options_t *Options)
+{
+  ADXL345_CostConfig_t *Config = &Options->Config;
+  int Opt = 0;
+
+  memset(Options, 0, sizeof(Planner_Options_t));
+  Config->Rate = ADXL345_RATE_800;
+  Config->Mode = ADXL345_MODE_STREAM;
+  Config->WatermarkSamples = 16;
+  Config->Bus = ADXL345_COST_I2C;
+  Config->Sensors = 1;
+  Config->ServiceLatencyUs = 50;
+  Options->Limits.MaxUtilisation = 0.5f;
+  Options->Limits.MinMarginSamples = 2;
+
+  while ((Opt = getopt(argc, argv, "r:m:w:t:c:n:xl:o:u:M:L:V:h")) != -1)
+  {
+    switch (Opt)
+    {
+    case 'r':
+      if (Planner_ParseRate(optarg, &Config->Rate) != 0)
+        return -1;
+      break;
+    case 'm':
+      if (Planner_ParseMode(optarg, &Config->Mode) != 0)
+        return -1;
+      break;
+    case 'w':
+      Config->WatermarkSamples = (uint8_t)atoi(optarg);
+      break;
+    case 't':
+      if (strcmp(optarg, "i2c") == 0)
+        Config->Bus = ADXL345_COST_I2C;
+      else if (strcmp(optarg, "spi") == 0)
+        Config->Bus = ADXL345_COST_SPI;
+      else
+        return -1;
+      break;
+    case 'c':
+      Config->ClockHz = (uint32_t)atof(optarg);
+      break;
+    case 'n':
+      Config->Sensors = (uint8_t)atoi(optarg);
+      break;
+    case 'x':
+      Config->Muxed = 1;
+      break;
+    case 'l':
+      Config->ServiceLatencyUs = (uint32_t)atoi(optarg);
+      break;
+    case 'o':
+      Config->TransferOverheadUs = (uint32_t)atoi(optarg);
+      break;
+    case 'u':
+      Options->Limits.MaxUtilisation = (float)(atof(optarg) / 100);
+      break;
+    case 'M':
+      Options->Limits.MinMarginSamples = (uint8_t)atoi(optarg);
+      break;
+    case 'L':
+      Options->Limits.LatencyBudgetUs = (uint32_t)atoi(optarg);
+      break;
+#ifdef ADXL345_PLANNER_SIM
+    case 'V':
+      Options->ValidateMs = (uint32_t)(atof(optarg) * 1000);
+      if (Options->ValidateMs == 0)
+        return -1;
+      break;
+#endif
+    default:
+      return -1;
+    }
+  }
+
+  if (Config->ClockHz == 0)
+    Config->ClockHz = (Config->Bus == ADXL345_COST_SPI) ? PLANNER_SPI_CLOCK :
+                                                         PLANNER_I2C_CLOCK;
+
+  if (Config->Sensors == 0)
+    return -1;
+
+  return 0;
+}
+
+
+static void
+Planner_PrintCost(const ADXL345_CostConfig_t *Config,
+                  const ADXL345_Cost_t *Cost)
+{
+  char Rate[16];
+
+  Planner_RateName(Config->Rate, Rate, sizeof(Rate));
+  printf("%-8s %-6s %3u  %9.1f  %6.1f%%  %9.0f  %7lu  %8lu  %10lu  %4d  %5u"
+         "  %s\n", Rate, Planner_ModeName(Config->Mode),
+         (Config->Mode == ADXL345_MODE_BYPASS) ? 0 : Config->WatermarkSamples,
+         Cost->InterruptsPerSec, Cost->BusUtilisation * 100,
+         Cost->BytesPerSec, (unsigned long)Cost->DrainUs,
+         (unsigned long)Cost->WorstLatencyUs, (unsigned long)Cost->OldestAgeUs,
+         Cost->MarginSamples, Cost->SupplyUa * Config->Sensors,
+         Cost->Feasible ? "" : "overrun");
+}
+
+
+static void
+Planner_PrintHeader(void)
+{
+  printf("%-8s %-6s %3s  %9s  %7s  %9s  %7s  %8s  %10s  %4s  %5s\n",
+         "rate", "mode", "wm", "int/s", "bus", "bytes/s", "drain",
+         "worst us", "age us", "free", "uA");
+}
+
+
+static void
+Planner_Recommend(const Planner_Options_t *Options)
+{
+  ADXL345_CostConfig_t Config;
+  ADXL345_Cost_t Cost;
+  ADXL345_Rate_t Rate = ADXL345_RATE_0P1;
+  ADXL345_Rate_t Highest = ADXL345_RATE_0P1;
+  uint8_t Found = 0;
+  char Name[16];
+
+  printf("\nrecommended settings (bus <= %.0f%%, >= %u entries free",
+         Options->Limits.MaxUtilisation * 100,
+         Options->Limits.MinMarginSamples);
+  if (Options->Limits.LatencyBudgetUs)
+    printf(", age <= %lu us", (unsigned long)Options->Limits.LatencyBudgetUs);
+  printf("):\n");
+  Planner_PrintHeader();
+
+  for (Rate = ADXL345_RATE_0P1; Rate <= ADXL345_LOW_POWER_RATE_400; Rate++)
+  {
+    if (Rate > ADXL345_RATE_3200 && Rate < ADXL345_LOW_POWER_RATE_12P5)
+      continue;
+
+    Config = Options->Config;
+    Config.Rate = Rate;
+    if (ADXL345_Cost_Recommend(&Config, &Options->Limits, &Cost) != ADXL345_OK)
+    {
+      Planner_RateName(Rate, Name, sizeof(Name));
+      printf("%-8s no setting meets the limits\n", Name);
+      continue;
+    }
+
+    Planner_PrintCost(&Config, &Cost);
+    if (!(Rate & 0x10))
+    {
+      Highest = Rate;
+      Found = 1;
+    }
+  }
+
+  if (Found)
+  {
+    Planner_RateName(Highest, Name, sizeof(Name));
+    printf("highest feasible rate: %s Hz\n", Name);
+  }
+}
+
+
+#ifdef ADXL345_PLANNER_SIM
+static int8_t
+Planner_HostSend(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  ADXL345_Sim_AdvanceUs(Planner_OverheadUs);
+  return Planner_Send(Address, Data, Len);
+}
+
+static int8_t
+Planner_HostReceive(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  ADXL345_Sim_AdvanceUs(Planner_OverheadUs);
+  return Planner_Receive(Address, Data, Len);
+}
+
+
+static void
+Planner_NullSink(void *SinkContext, ADXL345_Batch_t *Batch)
+{
+  (void)SinkContext;
+  (void)Batch;
+}
+
+
+static void
+Planner_Sample(uint8_t Sensors, Planner_Counters_t *Counters)
+{
+  ADXL345_SimBusStats_t Bus;
+  uint8_t i = 0;
+
+  memset(Counters, 0, sizeof(Planner_Counters_t));
+  Counters->NowUs = ADXL345_Sim_GetTimeUs();
+  for (i = 0; i < Sensors; i++)
+  {
+    Counters->Drains += Planner_Stream[i].Stats.Drains;
+    Counters->Samples += Planner_Stream[i].Stats.Samples;
+    Counters->Overruns += Planner_Stream[i].Stats.Overruns;
+    Counters->Transfers += Planner_Handler[i].Stats.Transfers;
+    Counters->Bytes += Planner_Handler[i].Stats.Bytes;
+  }
+
+  ADXL345_Sim_GetBusStats(&Bus);
+  Counters->Transactions = Bus.Transactions;
+  Counters->BusyNs = Bus.BusyNs;
+}
+
+
+/**
+ * The host reacts on INT like an interrupt handler: ServiceLatencyUs after a
+ * pin goes active, every sensor with an active pin is drained in turn.
+ */
+static uint32_t
+Planner_Run(uint8_t Sensors, uint32_t LatencyUs, uint32_t UntilUs)
+{
+  uint32_t MaxLatencyUs = 0;
+  uint32_t EventUs = 0;
+  uint8_t Active = 0;
+  uint8_t i = 0;
+
+  while ((int32_t)(ADXL345_Sim_GetTimeUs() - UntilUs) < 0)
+  {
+    Active = 0;
+    for (i = 0; i < Sensors; i++)
+      Active |= ADXL345_Sim_IntPin(i, 1);
+
+    if (!Active)
+    {
+      ADXL345_Sim_AdvanceUs(1);
+      continue;
+    }
+
+    EventUs = ADXL345_Sim_GetTimeUs();
+    ADXL345_Sim_AdvanceUs(LatencyUs);
+    for (i = 0; i < Sensors; i++)
+    {
+      if (!ADXL345_Sim_IntPin(i, 1))
+        continue;
+      ADXL345_Stream_IRQ(&Planner_Stream[i]);
+      ADXL345_Stream_Process(&Planner_Stream[i]);
+    }
+
+    if (ADXL345_Sim_GetTimeUs() - EventUs > MaxLatencyUs)
+      MaxLatencyUs = ADXL345_Sim_GetTimeUs() - EventUs;
+  }
+
+  return MaxLatencyUs;
+}
+
+
+static void
+Planner_Compare(const char *Name, double Model, double Measured)
+{
+  printf("  %-16s %12.2f %12.2f %8.1f%%\n", Name, Model, Measured,
+         Model ? (Measured - Model) * 100 / Model : 0.0);
+}
+
+
+static int
+Planner_Validate(const ADXL345_CostConfig_t *Config, uint32_t DurationMs)
+{
+  ADXL345_StreamConfig_t StreamConfig;
+  ADXL345_Cost_t Cost;
+  Planner_Counters_t Start;
+  Planner_Counters_t End;
+  ADXL345_SimStats_t SimStats;
+  uint32_t Lost = 0;
+  uint32_t MaxLatencyUs = 0;
+  double Seconds = 0;
+  uint8_t Muxed = Config->Muxed || Config->Sensors > 2;
+  uint8_t i = 0;
+
+  if (Config->Bus != ADXL345_COST_I2C ||
+      Config->ClockHz != ADXL345_SIM_I2C_RATE)
+  {
+    fprintf(stderr, "the simulator models an I2C bus at %d Hz\n",
+            ADXL345_SIM_I2C_RATE);
+    return -1;
+  }
+
+  if (Config->Sensors > PLANNER_SIM_SENSORS ||
+      (Config->Sensors > 1 && Muxed != Config->Muxed))
+  {
+    fprintf(stderr, "the simulator runs up to 2 sensors on the bus or up to "
+            "%d behind a mux (-x)\n", PLANNER_SIM_SENSORS);
+    return -1;
+  }
+
+  if (ADXL345_Cost_Estimate(Config, &Cost) != ADXL345_OK)
+    return -1;
+
+  memset(&StreamConfig, 0, sizeof(ADXL345_StreamConfig_t));
+  StreamConfig.Rate = Config->Rate;
+  StreamConfig.Range = ADXL345_RANGE_16G;
+  StreamConfig.Mode = Config->Mode;
+  StreamConfig.WatermarkSamples = Config->WatermarkSamples;
+  StreamConfig.Pin = ADXL345_INTERRUPT_PIN1;
+
+  Planner_OverheadUs = Config->TransferOverheadUs;
+  ADXL345_Mux_Init(&Planner_Mux, PLANNER_SIM_MUX);
+
+  for (i = 0; i < Config->Sensors; i++)
+  {
+    ADXL345_Sim_AddDevice((Muxed || i == 0) ? 0x53 : 0x1D,
+                          Muxed ? PLANNER_SIM_MUX : 0, i, 50000 + 1000 * i);
+
+    ADXL345_Platform_Init(&Planner_Handler[i]);
+    Planner_Send = Planner_Handler[i].PlatformI2CSend;
+    Planner_Receive = Planner_Handler[i].PlatformI2CReceive;
+    Planner_Handler[i].PlatformI2CSend = Planner_HostSend;
+    Planner_Handler[i].PlatformI2CReceive = Planner_HostReceive;
+
+    if (ADXL345_Init(&Planner_Handler[i]) != ADXL345_OK)
+      return -1;
+    ADXL345_SetAddressI2C(&Planner_Handler[i], (Muxed || i == 0) ? 0 : 1);
+    if (Muxed)
+      ADXL345_SetMux(&Planner_Handler[i], &Planner_Mux, i);
+
+    if (ADXL345_Stream_Init(&Planner_Stream[i], &Planner_Handler[i],
+                            &StreamConfig) != ADXL345_OK)
+      return -1;
+    Planner_Stream[i].Sink = Planner_NullSink;
+    Planner_Stream[i].GetTimeUs = ADXL345_Sim_GetTimeUs;
+
+    if (ADXL345_Stream_Start(&Planner_Stream[i]) != ADXL345_OK)
+    {
+      fprintf(stderr, "failed to start simulated sensor %u\n", i);
+      return -1;
+    }
+  }
+
+  Planner_Run(Config->Sensors, Config->ServiceLatencyUs,
+              ADXL345_Sim_GetTimeUs() + PLANNER_SIM_WARMUP_US);
+  Planner_Sample(Config->Sensors, &Start);
+  MaxLatencyUs = Planner_Run(Config->Sensors, Config->ServiceLatencyUs,
+                             Start.NowUs + DurationMs * 1000);
+  Planner_Sample(Config->Sensors, &End);
+
+  for (i = 0; i < Config->Sensors; i++)
+  {
+    ADXL345_Sim_GetStats(i, &SimStats);
+    Lost += SimStats.Lost;
+  }
+
+  Seconds = (End.NowUs - Start.NowUs) / 1e6;
+  printf("\nsimulator, %.1f s:     %12s %12s %9s\n", Seconds,
+         "model", "measured", "error");
+  Planner_Compare("samples/drain", Cost.SamplesPerDrain,
+                  End.Drains - Start.Drains ?
+                  (double)(End.Samples - Start.Samples) /
+                  (End.Drains - Start.Drains) : 0);
+  Planner_Compare("interrupts/s", Cost.InterruptsPerSec,
+                  (End.Drains - Start.Drains) / Seconds);
+  Planner_Compare("transfers/s", Cost.TransfersPerSec,
+                  (End.Transfers - Start.Transfers) / Seconds);
+  Planner_Compare("bytes/s", Cost.BytesPerSec,
+                  (End.Bytes - Start.Bytes) / Seconds);
+  Planner_Compare("bus %", Cost.BusUtilisation * 100,
+                  ((End.BusyNs - Start.BusyNs) / 1e3 +
+                   (double)(End.Transactions - Start.Transactions) *
+                   Config->TransferOverheadUs) / 1e4 / Seconds);
+  printf("  %-16s %12lu %12lu (max seen)\n", "worst latency us",
+         (unsigned long)Cost.WorstLatencyUs, (unsigned long)MaxLatencyUs);
+  printf("  %-16s %12s %12lu (overruns), %lu samples lost\n", "overrun",
+         Cost.Feasible ? "none" : "expected",
+         (unsigned long)(End.Overruns - Start.Overruns), (unsigned long)Lost);
+
+  return 0;
+}
+#endif
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+int
+main(int argc, char **argv)
+{
+  Planner_Options_t Options;
+  ADXL345_Cost_t Cost;
+
+  if (Planner_ParseOptions(argc, argv, &Options) != 0)
+  {
+    Planner_Usage(argv[0]);
+    return 2;
+  }
+
+  if (ADXL345_Cost_Estimate(&Options.Config, &Cost) != ADXL345_OK)
+  {
+    fprintf(stderr, "invalid setting\n");
+    return 2;
+  }
+
+  printf("%u sensor(s) on %s at %lu Hz%s, %lu us service latency, "
+         "%lu us per transfer\n",
+         Options.Config.Sensors,
+         (Options.Config.Bus == ADXL345_COST_SPI) ? "SPI" : "I2C",
+         (unsigned long)Options.Config.ClockHz,
+         Options.Config.Muxed ? " behind a mux" : "",
+         (unsigned long)Options.Config.ServiceLatencyUs,
+         (unsigned long)Options.Config.TransferOverheadUs);
+  Planner_PrintHeader();
+  Planner_PrintCost(&Options.Config, &Cost);
+
+  Planner_Recommend(&Options);
+
+#ifdef ADXL345_PLANNER_SIM
+  if (Options.ValidateMs &&
+      Planner_Validate(&Options.Config, Options.ValidateMs) != 0)
+    return 1;
+#endif
+
+  return 0;
+}
@@ -0,0 +1,516 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_fleetbench.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Sensor fleet throughput benchmark on the simulator
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Feature Test Macros ----------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "ADXL345.h"
+#include "ADXL345_stream.h"
+#include "ADXL345_manager.h"
+#include "ADXL345_pool.h"
+#include "ADXL345_platform.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+// One mux, both ADXL345 addresses on each of its 8 channels
+#define BENCH_MAX_SENSORS   16
+#define BENCH_MUX           0x70
+// Bursts per sensor that can wait in the pool
+#define BENCH_BURSTS        8
+// Latency histogram of 1 us bins, the last bin collects the rest
+#define BENCH_HIST_BINS     65536
+
+
+/* Private Data Types -----------------------------------------------------------*/
+typedef struct Bench_Options_s
+{
+  ADXL345_Rate_t Rate;
+  uint8_t Watermark;
+  uint8_t MaxSensors;
+  uint8_t Workers;
+  uint32_t LatencyUs;
+  uint32_t DurationUs;
+} Bench_Options_t;
+
+typedef struct Bench_Sensor_s
+{
+  ADXL345_Handler_t Handler;
+  ADXL345_Stream_t Stream;
+  ADXL345_PoolSensor_t PoolSensor;
+  ADXL345_PoolBurst_t Burst[BENCH_BURSTS];
+  uint8_t Raw[BENCH_BURSTS][ADXL345_FIFO_SIZE * 6];
+  volatile uint8_t Busy[BENCH_BURSTS];
+  uint32_t Sequence;
+  uint32_t Samples;
+  int16_t Device;
+  uint8_t Id;
+} Bench_Sensor_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static Bench_Sensor_t Bench_Sensor[BENCH_MAX_SENSORS];
+static ADXL345_Manager_t Bench_Manager;
+static ADXL345_Pool_t Bench_Pool;
+static ADXL345_Mux_t Bench_Mux;
+static uint32_t Bench_Hist[BENCH_HIST_BINS];
+static uint32_t Bench_HistCount = 0;
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static uint64_t
+Bench_CpuNs(clockid_t Clock)
+{
+  struct timespec Now;
+
+  clock_gettime(Clock, &Now);
+  return (uint64_t)Now.tv_sec * 1000000000ULL + (uint64_t)Now.tv_nsec;
+}
+
+
+static uint32_t
+Bench_Percentile(uint32_t Permille)
+{
+  uint64_t Rank = ((uint64_t)Bench_HistCount * Permille + 999) / 1000;
+  uint64_t Seen = 0;
+  uint32_t i = 0;
+
+  for (i = 0; i < BENCH_HIST_BINS; i++)
+  {
+    Seen += Bench_Hist[i];
+    if (Seen >= Rank && Seen)
+      return i;
+  }
+
+  return BENCH_HIST_BINS - 1;
+}
+
+
+static void
+Bench_Sink(void *SinkContext, ADXL345_Batch_t *Batch)
+{
+  Bench_Sensor_t *Sensor = (Bench_Sensor_t *)SinkContext;
+
+  Sensor->Samples += Batch->Count;
+}
+
+
+static void
+Bench_PoolProcess(void *Context, ADXL345_Batch_t *Batch,
+                  ADXL345_PoolBurst_t *Burst)
+{
+  Bench_Sensor_t *Sensor = (Bench_Sensor_t *)Context;
+
+  Sensor->Samples += Batch->Count;
+  __atomic_store_n(&Sensor->Busy[Burst - Sensor->Burst], 0, __ATOMIC_RELEASE);
+}
+
+
+/**
+ * With workers, drained raw bursts go to the pool instead of
+ * ADXL345_Stream_Process. The bus loop waits for a free burst buffer, so a
+ * pool that cannot keep up shows as drain latency and overruns.
+ */
+static void
+Bench_Forward(Bench_Sensor_t *Sensor, uint8_t Workers)
+{
+  ADXL345_Stream_t *Stream = &Sensor->Stream;
+  struct ADXL345_StreamSlot_s *Slot = NULL;
+  ADXL345_PoolBurst_t *Burst = NULL;
+  uint8_t i = 0;
+
+  if (!Workers)
+  {
+    ADXL345_Stream_Process(Stream);
+    return;
+  }
+
+  while (Stream->Tail != Stream->Head)
+  {
+    Slot = &Stream->Slots[Stream->Tail & (ADXL345_STREAM_SLOTS - 1)];
+
+    for (;;)
+    {
+      for (i = 0; i < BENCH_BURSTS; i++)
+        if (!__atomic_load_n(&Sensor->Busy[i], __ATOMIC_ACQUIRE))
+          break;
+      if (i < BENCH_BURSTS)
+        break;
+      sched_yield();
+    }
+
+    Burst = &Sensor->Burst[i];
+    Sensor->Busy[i] = 1;
+    memcpy(Sensor->Raw[i], Slot->Raw, 6 * Slot->Count);
+    Burst->Raw = Sensor->Raw[i];
+    Burst->Count = Slot->Count;
+    Burst->DataFormat = Stream->DataFormat;
+    Burst->Gap = Slot->Overrun;
+    Burst->Sequence = Sensor->Sequence;
+    Burst->TimestampUs = Slot->TimestampUs;
+    Sensor->Sequence += Slot->Count;
+    Stream->Tail++;
+
+    ADXL345_Pool_Submit(&Bench_Pool, &Sensor->PoolSensor, Burst);
+  }
+}
+
+
+static int
+Bench_Setup(const Bench_Options_t *Options, uint8_t Sensors)
+{
+  ADXL345_StreamConfig_t Config;
+  Bench_Sensor_t *Sensor = NULL;
+  uint8_t i = 0;
+
+  ADXL345_Sim_Reset();
+  memset(Bench_Sensor, 0, sizeof(Bench_Sensor));
+  memset(Bench_Hist, 0, sizeof(Bench_Hist));
+  Bench_HistCount = 0;
+  ADXL345_Mux_Init(&Bench_Mux, BENCH_MUX);
+  if (ADXL345_Manager_Init(&Bench_Manager, 1,
+                           ADXL345_Sim_GetTimeUs) != ADXL345_OK)
+    return -1;
+
+  memset(&Config, 0, sizeof(ADXL345_StreamConfig_t));
+  Config.Rate = Options->Rate;
+  Config.Range = ADXL345_RANGE_16G;
+  Config.Mode = ADXL345_MODE_STREAM;
+  Config.WatermarkSamples = Options->Watermark;
+  Config.Pin = ADXL345_INTERRUPT_PIN1;
+
+  if (Options->Workers &&
+      ADXL345_Pool_Init(&Bench_Pool, Options->Workers) != ADXL345_OK)
+    return -1;
+
+  for (i = 0; i < Sensors; i++)
+  {
+    Sensor = &Bench_Sensor[i];
+    Sensor->Device = ADXL345_Sim_AddDevice((i & 1) ? 0x1D : 0x53, BENCH_MUX,
+                                           i / 2, 40000 + 1000 * i);
+
+    ADXL345_Platform_Init(&Sensor->Handler);
+    if (ADXL345_Init(&Sensor->Handler) != ADXL345_OK)
+      return -1;
+    ADXL345_SetAddressI2C(&Sensor->Handler, i & 1);
+    ADXL345_SetMux(&Sensor->Handler, &Bench_Mux, i / 2);
+
+    if (ADXL345_Stream_Init(&Sensor->Stream, &Sensor->Handler,
+                            &Config) != ADXL345_OK)
+      return -1;
+    Sensor->Stream.Sink = Bench_Sink;
+    Sensor->Stream.SinkContext = Sensor;
+    Sensor->Stream.GetTimeUs = ADXL345_Sim_GetTimeUs;
+
+    if (ADXL345_Manager_AddSensor(&Bench_Manager, &Sensor->Stream, 0, 0,
+                                  &Sensor->Id) != ADXL345_OK)
+      return -1;
+    if (Options->Workers &&
+        ADXL345_Pool_AddSensor(&Bench_Pool, &Sensor->PoolSensor,
+                               Bench_PoolProcess, Sensor) != ADXL345_OK)
+      return -1;
+  }
+
+  // Start after all devices are configured, so they run from the same time
+  for (i = 0; i < Sensors; i++)
+    if (ADXL345_Stream_Start(&Bench_Sensor[i].Stream) != ADXL345_OK)
+      return -1;
+
+  return 0;
+}
+
+
+/**
+ * The INT pins are sampled every simulated microsecond. Notify stands for
+ * the interrupt routine; the bus task polls the manager until it is idle.
+ */
+static uint64_t
+Bench_Run(const Bench_Options_t *Options, uint8_t Sensors)
+{
+  uint32_t ReadyUs[BENCH_MAX_SENSORS];
+  uint32_t Drains[BENCH_MAX_SENSORS];
+  uint32_t EndUs = ADXL345_Sim_GetTimeUs() + Options->DurationUs;
+  uint32_t LatencyUs = 0;
+  uint64_t CpuNs = 0;
+  uint64_t StartNs = 0;
+  uint8_t Notified = 0;
+  uint8_t i = 0;
+
+  for (i = 0; i < Sensors; i++)
+    Drains[i] = 0;
+
+  while ((int32_t)(ADXL345_Sim_GetTimeUs() - EndUs) < 0)
+  {
+    Notified = 0;
+    for (i = 0; i < Sensors; i++)
+    {
+      if (Bench_Manager.Sensor[i].Pending ||
+          !ADXL345_Sim_IntPin(Bench_Sensor[i].Device, 1))
+        continue;
+      ADXL345_Manager_Notify(&Bench_Manager, Bench_Sensor[i].Id);
+      Notified = 1;
+    }
+
+    if (!Notified)
+    {
+      ADXL345_Sim_AdvanceUs(1);
+      continue;
+    }
+
+    ADXL345_Sim_AdvanceUs(Options->LatencyUs);
+
+    StartNs = Bench_CpuNs(CLOCK_THREAD_CPUTIME_ID);
+    for (;;)
+    {
+      for (i = 0; i < Sensors; i++)
+        ReadyUs[i] = Bench_Manager.Sensor[i].ReadyUs;
+
+      if (!ADXL345_Manager_Poll(&Bench_Manager, 0))
+        break;
+
+      for (i = 0; i < Sensors; i++)
+      {
+        if (Bench_Sensor[i].Stream.Stats.Drains == Drains[i])
+          continue;
+        Drains[i] = Bench_Sensor[i].Stream.Stats.Drains;
+        Bench_Forward(&Bench_Sensor[i], Options->Workers);
+
+        LatencyUs = ADXL345_Sim_GetTimeUs() - ReadyUs[i];
+        Bench_Hist[(LatencyUs < BENCH_HIST_BINS) ?
+                   LatencyUs : (BENCH_HIST_BINS - 1)]++;
+        Bench_HistCount++;
+      }
+    }
+    CpuNs += Bench_CpuNs(CLOCK_THREAD_CPUTIME_ID) - StartNs;
+  }
+
+  return CpuNs;
+}
+
+
+static void
+Bench_Report(const Bench_Options_t *Options, uint8_t Sensors,
+             uint64_t CpuNs, uint32_t StartUs, uint64_t BusyNs)
+{
+  ADXL345_SimStats_t SimStats;
+  clockid_t Clock;
+  double Seconds = (ADXL345_Sim_GetTimeUs() - StartUs) / 1e6;
+  double Nominal = ADXL345_ConvToData_RateMilliHz(Options->Rate) / 1000.0;
+  uint32_t Samples = 0;
+  uint32_t Overruns = 0;
+  uint32_t Generated = 0;
+  uint32_t Lost = 0;
+  uint8_t i = 0;
+
+  for (i = 0; i < Options->Workers; i++)
+  {
+    if (pthread_getcpuclockid(Bench_Pool.Worker[i].Thread, &Clock) == 0)
+      CpuNs += Bench_CpuNs(Clock);
+  }
+
+  for (i = 0; i < Sensors; i++)
+  {
+    Samples += Bench_Sensor[i].Samples;
+    Overruns += Bench_Sensor[i].Stream.Stats.Overruns;
+    ADXL345_Sim_GetStats(Bench_Sensor[i].Device, &SimStats);
+    Generated += SimStats.Generated;
+    Lost += SimStats.Lost;
+  }
+
+  printf("%3u  %10.0f  %6.1f%%  %8.2f  %6.2f%%  %6lu  %6lu  %6lu  %6lu  "
+         "%5.1f%%  %7.0f\n",
+         Sensors, Samples / Seconds,
+         Samples * 100 / (Seconds * Nominal * Sensors),
+         Overruns / Seconds, Generated ? Lost * 100.0 / Generated : 0.0,
+         (unsigned long)Bench_Percentile(500),
+         (unsigned long)Bench_Percentile(900),
+         (unsigned long)Bench_Percentile(990),
+         (unsigned long)Bench_Percentile(1000),
+         BusyNs / 1e7 / Seconds,
+         Samples ? (double)CpuNs / Samples : 0.0);
+}
+
+
+static int
+Bench_ParseRate(const char *Arg, ADXL345_Rate_t *Rate)
+{
+  uint32_t MilliHz = (uint32_t)(atof(Arg) * 1000 + 0.5);
+  uint32_t Nominal = 0;
+  uint8_t Code = 0;
+
+  for (Code = 0; Code < 16; Code++)
+  {
+    Nominal = ADXL345_ConvToData_RateMilliHz(Code);
+    if (MilliHz * 50 < Nominal * 49 || MilliHz * 50 > Nominal * 51)
+      continue;
+    *Rate = (ADXL345_Rate_t)Code;
+    return 0;
+  }
+
+  return -1;
+}
+
+
+static void
+Bench_Usage(const char *Name)
+{
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  -r HZ       output data rate (default 400)\n"
+          "  -w N        FIFO watermark 1..31 (default 16)\n"
+          "  -n N        max sensors on the mux, 1..%d (default %d)\n"
+          "  -j N        pool workers, 0 to decode on the bus task "
+          "(default 0)\n"
+          "  -l US       INT to bus task latency (default 20)\n"
+          "  -d SEC      simulated time per run (default 2)\n",
+          Name, BENCH_MAX_SENSORS, BENCH_MAX_SENSORS);
+}
+
+
+static int
+Bench_ParseOptions(int argc, char **argv, Bench_Options_t *Options)
+{
+  int Opt = 0;
+
+  memset(Options, 0, sizeof(Bench_Options_t));
+  Options->Rate = ADXL345_RATE_400;
+  Options->Watermark = 16;
+  Options->MaxSensors = BENCH_MAX_SENSORS;
+  Options->LatencyUs = 20;
+  Options->DurationUs = 2000000;
+
+  while ((Opt = getopt(argc, argv, "r:w:n:j:l:d:h")) != -1)
+  {
+    switch (Opt)
+    {
+    case 'r':
+      if (Bench_ParseRate(optarg, &Options->Rate) != 0)
+        return -1;
+      break;
+    case 'w':
+      Options->Watermark = (uint8_t)atoi(optarg);
+      break;
+    case 'n':
+      Options->MaxSensors = (uint8_t)atoi(optarg);
+      break;
+    case 'j':
+      Options->Workers = (uint8_t)atoi(optarg);
+      break;
+    case 'l':
+      Options->LatencyUs = (uint32_t)atoi(optarg);
+      break;
+    case 'd':
+      Options->DurationUs = (uint32_t)(atof(optarg) * 1e6);
+      break;
+    default:
+      return -1;
+    }
+  }
+
+  if (Options->Watermark < 1 || Options->Watermark > 31 ||
+      Options->MaxSensors < 1 || Options->MaxSensors > BENCH_MAX_SENSORS ||
+      Options->Workers > ADXL345_POOL_MAX_WORKERS ||
+      Options->DurationUs == 0)
+    return -1;
+
+  return 0;
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+int
+main(int argc, char **argv)
+{
+  Bench_Options_t Options;
+  ADXL345_SimBusStats_t Bus;
+  uint64_t BusyNs = 0;
+  uint64_t CpuNs = 0;
+  uint32_t StartUs = 0;
+  uint8_t Sensors = 1;
+
+  if (Bench_ParseOptions(argc, argv, &Options) != 0)
+  {
+    Bench_Usage(argv[0]);
+    return 2;
+  }
+
+  printf("%.1f Hz, watermark %u, 400 kHz I2C with one mux, %u pool "
+         "worker(s), %.1f s per run\n",
+         ADXL345_ConvToData_RateMilliHz(Options.Rate) / 1000.0,
+         Options.Watermark, Options.Workers, Options.DurationUs / 1e6);
+  printf("%3s  %10s  %7s  %8s  %7s  %6s  %6s  %6s  %6s  %6s  %7s\n",
+         "n", "samples/s", "of odr", "ovr/s", "lost", "p50us", "p90us",
+         "p99us", "maxus", "bus", "cpu ns");
+
+  for (;;)
+  {
+    if (Bench_Setup(&Options, Sensors) != 0)
+    {
+      fprintf(stderr, "failed to set up %u sensors\n", Sensors);
+      return 1;
+    }
+
+    StartUs = ADXL345_Sim_GetTimeUs();
+    ADXL345_Sim_GetBusStats(&Bus);
+    BusyNs = Bus.BusyNs;
+    CpuNs = Bench_Run(&Options, Sensors);
+    if (Options.Workers)
+      ADXL345_Pool_Drain(&Bench_Pool);
+    ADXL345_Sim_GetBusStats(&Bus);
+    Bench_Report(&Options, Sensors, CpuNs, StartUs, Bus.BusyNs - BusyNs);
+    if (Options.Workers)
+      ADXL345_Pool_DeInit(&Bench_Pool);
+
+    if (Sensors == Options.MaxSensors)
+      break;
+    Sensors = (2 * Sensors > Options.MaxSensors) ? Options.MaxSensors :
+                                                   2 * Sensors;
+  }
+
+  return 0;
+}
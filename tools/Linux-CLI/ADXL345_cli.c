@@ -0,0 +1,597 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_cli.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Command line capture tool with live statistics (Linux)
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Feature Test Macros ----------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <getopt.h>
+#include "ADXL345.h"
+#include "ADXL345_stream.h"
+#include "ADXL345_log.h"
+#include "ADXL345_platform.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define CLI_FORMAT_CSV    0
+#define CLI_FORMAT_BIN    1
+
+// Samples per block of the binary log
+#define CLI_LOG_SAMPLES   128
+
+#ifdef ADXL345_CLI_SIM
+#define CLI_DEFAULT_BUS   "simulator"
+#else
+#define CLI_DEFAULT_BUS   ADXL345_I2C_DEV
+#endif
+
+
+/* Private Data Types -----------------------------------------------------------*/
+typedef struct Cli_Options_s
+{
+  const char *Bus;
+  uint8_t Address;
+  ADXL345_StreamConfig_t Stream;
+  const char *Output;
+  uint8_t Format;
+  uint32_t DurationMs;
+  uint32_t IntervalMs;
+} Cli_Options_t;
+
+typedef struct Cli_Interval_s
+{
+  uint32_t StartUs;
+  uint32_t Samples;
+  uint32_t Drains;
+  uint32_t Overruns;
+  uint32_t Dropped;
+  uint64_t BusUs;
+  uint64_t DrainUs;
+  uint32_t MaxDrainUs;
+  uint32_t Polls;
+  uint32_t NaivePolls;
+} Cli_Interval_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static int8_t (*Cli_Send)(uint8_t Address, uint8_t *Data, uint8_t Len);
+static int8_t (*Cli_Receive)(uint8_t Address, uint8_t *Data, uint8_t Len);
+static uint64_t Cli_BusUs = 0;
+static volatile sig_atomic_t Cli_Stop = 0;
+static FILE *Cli_Out = NULL;
+static ADXL345_LogWriter_t Cli_Log;
+static uint8_t Cli_LogBlock[ADXL345_LOG_BLOCK_LEN(CLI_LOG_SAMPLES)];
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+#ifdef ADXL345_CLI_SIM
+static uint32_t
+Cli_NowUs(void)
+{
+  return ADXL345_Sim_GetTimeUs();
+}
+
+static void
+Cli_SleepUntilUs(uint32_t DeadlineUs)
+{
+  int32_t Us = (int32_t)(DeadlineUs - ADXL345_Sim_GetTimeUs());
+
+  if (Us > 0)
+    ADXL345_Sim_AdvanceUs((uint32_t)Us);
+}
+#else
+static uint32_t
+Cli_NowUs(void)
+{
+  struct timespec Now;
+
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+  return (uint32_t)((uint64_t)Now.tv_sec * 1000000 + Now.tv_nsec / 1000);
+}
+
+/**
+ * The deadline is turned into an absolute time of the monotonic clock, so
+ * being preempted before the sleep does not push the wake-up later.
+ */
+static void
+Cli_SleepUntilUs(uint32_t DeadlineUs)
+{
+  struct timespec Now;
+  uint64_t NowUs = 0;
+  uint64_t WakeUs = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+  NowUs = (uint64_t)Now.tv_sec * 1000000 + Now.tv_nsec / 1000;
+  WakeUs = NowUs + (int32_t)(DeadlineUs - (uint32_t)NowUs);
+  if (WakeUs <= NowUs)
+    return;
+
+  Now.tv_sec = WakeUs / 1000000;
+  Now.tv_nsec = (long)(WakeUs % 1000000) * 1000;
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &Now, NULL) != 0 &&
+         !Cli_Stop);
+}
+#endif
+
+
+/**
+ * Bus utilisation is the time spent inside the platform functions. On i2c-dev
+ * it includes the system call overhead, which is what limits the host.
+ */
+static int8_t
+Cli_TimedSend(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  uint32_t StartUs = Cli_NowUs();
+  int8_t Result = Cli_Send(Address, Data, Len);
+
+  Cli_BusUs += (uint32_t)(Cli_NowUs() - StartUs);
+  return Result;
+}
+
+static int8_t
+Cli_TimedReceive(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  uint32_t StartUs = Cli_NowUs();
+  int8_t Result = Cli_Receive(Address, Data, Len);
+
+  Cli_BusUs += (uint32_t)(Cli_NowUs() - StartUs);
+  return Result;
+}
+
+
+static void
+Cli_Signal(int Signal)
+{
+  (void)Signal;
+  Cli_Stop = 1;
+}
+
+
+static int8_t
+Cli_LogWrite(void *Context, const uint8_t *Data, uint16_t Len)
+{
+  return (fwrite(Data, 1, Len, (FILE *)Context) == Len) ? 0 : -1;
+}
+
+
+static void
+Cli_CsvSink(void *SinkContext, ADXL345_Batch_t *Batch)
+{
+  ADXL345_Stream_t *Stream = (ADXL345_Stream_t *)SinkContext;
+  ADXL345_Sample_t *Sample = NULL;
+  uint32_t PeriodUs = Stream->Tracker.SamplePeriodUs;
+  uint8_t i = 0;
+
+  for (i = 0; i < Batch->Count; i++)
+  {
+    Sample = &Batch->Samples[i];
+    fprintf(Cli_Out, "%lu,%lu,%lu,%.4f,%.4f,%.4f\n",
+            (unsigned long)(Batch->Sequence + i),
+            (unsigned long)(Batch->TimestampUs + i * PeriodUs),
+            (unsigned long)(i ? 0 : Batch->Gap),
+            Sample->AccelX, Sample->AccelY, Sample->AccelZ);
+  }
+}
+
+
+static int
+Cli_ParseRate(const char *Arg, ADXL345_Rate_t *Rate)
+{
+  uint8_t LowPower = 0;
+  uint32_t MilliHz = 0;
+  uint32_t Nominal = 0;
+  uint8_t Code = 0;
+
+  if (strncmp(Arg, "lp", 2) == 0)
+  {
+    LowPower = 1;
+    Arg += 2;
+  }
+
+  MilliHz = (uint32_t)(atof(Arg) * 1000 + 0.5);
+
+  for (Code = 0; Code < 16; Code++)
+  {
+    Nominal = ADXL345_ConvToData_RateMilliHz(Code);
+    if (MilliHz * 50 < Nominal * 49 || MilliHz * 50 > Nominal * 51)
+      continue;
+    if (LowPower && (Code < ADXL345_RATE_12P5 || Code > ADXL345_RATE_400))
+      return -1;
+    *Rate = (ADXL345_Rate_t)(LowPower ? (Code | 0x10) : Code);
+    return 0;
+  }
+
+  return -1;
+}
+
+
+static int
+Cli_ParseRange(const char *Arg, ADXL345_Range_t *Range)
+{
+  switch (atoi(Arg))
+  {
+  case 2:  *Range = ADXL345_RANGE_2G;  return 0;
+  case 4:  *Range = ADXL345_RANGE_4G;  return 0;
+  case 8:  *Range = ADXL345_RANGE_8G;  return 0;
+  case 16: *Range = ADXL345_RANGE_16G; return 0;
+  default: return -1;
+  }
+}
+
+
+static int
+Cli_ParseMode(const char *Arg, ADXL345_Mode_t *Mode)
+{
+  if (strcmp(Arg, "bypass") == 0)
+    *Mode = ADXL345_MODE_BYPASS;
+  else if (strcmp(Arg, "fifo") == 0)
+    *Mode = ADXL345_MODE_FIFO;
+  else if (strcmp(Arg, "stream") == 0)
+    *Mode = ADXL345_MODE_STREAM;
+  else
+    return -1;
+
+  return 0;
+}
+
+
+static void
+Cli_Usage(const char *Name)
+{
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  -b PATH     I2C adapter (default " CLI_DEFAULT_BUS ")\n"
+          "  -a 0|1      ALT ADDRESS pin level (0 => 0x53, 1 => 0x1D)\n"
+          "  -r HZ       output data rate, \"lp\" prefix for low power "
+          "(default 800)\n"
+          "  -g G        range 2, 4, 8 or 16 (default 16)\n"
+          "  -F          full resolution\n"
+          "  -m MODE     FIFO mode bypass, fifo or stream (default stream)\n"
+          "  -w N        FIFO watermark 1..31 (default 16)\n"
+          "  -o FILE     output file (default stdout, \"-\" for stdout)\n"
+          "  -f FORMAT   csv or bin (ADXL345_log format) (default csv)\n"
+          "  -d SEC      capture duration, 0 until SIGINT (default 0)\n"
+          "  -i SEC      statistics interval (default 1)\n",
+          Name);
+}
+
+
+static int
+Cli_ParseOptions(int argc, char **argv, Cli_Options_t *Options)
+{
+  int Opt = 0;
+
+  memset(Options, 0, sizeof(Cli_Options_t));
+  Options->Bus = CLI_DEFAULT_BUS;
+  Options->Stream.Rate = ADXL345_RATE_800;
+  Options->Stream.Range = ADXL345_RANGE_16G;
+  Options->Stream.Mode = ADXL345_MODE_STREAM;
+  Options->Stream.WatermarkSamples = 16;
+  Options->Stream.Pin = ADXL345_INTERRUPT_PIN1;
+  Options->Format = CLI_FORMAT_CSV;
+  Options->IntervalMs = 1000;
+
+  while ((Opt = getopt(argc, argv, "b:a:r:g:Fm:w:o:f:d:i:h")) != -1)
+  {
+    switch (Opt)
+    {
+    case 'b':
+      Options->Bus = optarg;
+      break;
+    case 'a':
+      Options->Address = atoi(optarg) ? 1 : 0;
+      break;
+    case 'r':
+      if (Cli_ParseRate(optarg, &Options->Stream.Rate) != 0)
+        return -1;
+      break;
+    case 'g':
+      if (Cli_ParseRange(optarg, &Options->Stream.Range) != 0)
+        return -1;
+      break;
+    case 'F':
+      Options->Stream.FullResolution = 1;
+      break;
+    case 'm':
+      if (Cli_ParseMode(optarg, &Options->Stream.Mode) != 0)
+        return -1;
+      break;
+    case 'w':
+      Options->Stream.WatermarkSamples = (uint8_t)atoi(optarg);
+      break;
+    case 'o':
+      if (strcmp(optarg, "-") != 0)
+        Options->Output = optarg;
+      break;
+    case 'f':
+      if (strcmp(optarg, "csv") == 0)
+        Options->Format = CLI_FORMAT_CSV;
+      else if (strcmp(optarg, "bin") == 0)
+        Options->Format = CLI_FORMAT_BIN;
+      else
+        return -1;
+      break;
+    case 'd':
+      Options->DurationMs = (uint32_t)(atof(optarg) * 1000);
+      break;
+    case 'i':
+      Options->IntervalMs = (uint32_t)(atof(optarg) * 1000);
+      if (Options->IntervalMs == 0)
+        return -1;
+      break;
+    default:
+      return -1;
+    }
+  }
+
+  if (Options->Stream.WatermarkSamples < 1 ||
+      Options->Stream.WatermarkSamples > 31)
+    return -1;
+
+  return 0;
+}
+
+
+static void
+Cli_Report(ADXL345_Stream_t *Stream, ADXL345_PollSched_t *Sched,
+           Cli_Interval_t *Interval, uint32_t StartUs, uint32_t NowUs)
+{
+  uint32_t ElapsedUs = NowUs - Interval->StartUs;
+  uint32_t Samples = Stream->Stats.Samples - Interval->Samples;
+  uint32_t Drains = Stream->Stats.Drains - Interval->Drains;
+  uint32_t Overruns = Stream->Stats.Overruns - Interval->Overruns;
+  uint32_t Dropped = Stream->Tracker.Stats.DroppedSamples - Interval->Dropped;
+  uint32_t Polls = Sched->Stats.Polls - Interval->Polls;
+  uint32_t NaivePolls = Sched->Stats.NaivePolls - Interval->NaivePolls;
+  double Nominal = ADXL345_ConvToData_RateMilliHz(Stream->Config.Rate) / 1000.0;
+
+  if (ElapsedUs == 0)
+    return;
+
+  fprintf(stderr,
+          "[%8.2f s] odr %8.1f Hz (%6.1f%% of %.1f)  bus %5.1f%%  "
+          "drain avg %5lu us max %5lu us  polls %lu (%ld saved)  "
+          "overruns %lu  gap est. %lu\n",
+          (NowUs - StartUs) / 1e6,
+          Samples * 1e6 / ElapsedUs,
+          Samples * 1e8 / ElapsedUs / Nominal, Nominal,
+          (Cli_BusUs - Interval->BusUs) * 100.0 / ElapsedUs,
+          (unsigned long)(Drains ? Interval->DrainUs / Drains : 0),
+          (unsigned long)Interval->MaxDrainUs,
+          (unsigned long)Polls, (long)NaivePolls - (long)Polls,
+          (unsigned long)Overruns, (unsigned long)Dropped);
+
+  Interval->StartUs = NowUs;
+  Interval->Samples = Stream->Stats.Samples;
+  Interval->Drains = Stream->Stats.Drains;
+  Interval->Overruns = Stream->Stats.Overruns;
+  Interval->Dropped = Stream->Tracker.Stats.DroppedSamples;
+  Interval->BusUs = Cli_BusUs;
+  Interval->DrainUs = 0;
+  Interval->MaxDrainUs = 0;
+  Interval->Polls = Sched->Stats.Polls;
+  Interval->NaivePolls = Sched->Stats.NaivePolls;
+}
+
+
+static int
+Cli_Capture(ADXL345_Stream_t *Stream, const Cli_Options_t *Options)
+{
+  ADXL345_PollSched_t Sched;
+  Cli_Interval_t Interval;
+  uint8_t Watermark = Stream->Config.WatermarkSamples;
+  uint32_t StartUs = 0;
+  uint32_t NowUs = 0;
+  uint32_t Drains = 0;
+
+  if (ADXL345_Stream_Start(Stream) != ADXL345_OK)
+  {
+    fprintf(stderr, "failed to start streaming\n");
+    return -1;
+  }
+
+  StartUs = Cli_NowUs();
+  memset(&Interval, 0, sizeof(Cli_Interval_t));
+  Interval.StartUs = StartUs;
+
+  if (Stream->Config.Mode == ADXL345_MODE_BYPASS)
+    Watermark = 1;
+  ADXL345_PollSched_Init(&Sched, Stream->Config.Rate, Watermark, StartUs);
+
+  while (!Cli_Stop)
+  {
+    Cli_SleepUntilUs(Sched.DeadlineUs);
+
+    // INT pins are not wired to the host, so the interrupt source is polled
+    // when the FIFO is expected to reach the watermark
+    Drains = Sched.Stats.Drains;
+    if (ADXL345_PollSched_Service(&Sched, Stream) != ADXL345_OK)
+      continue;
+
+    if (Sched.Stats.Drains != Drains)
+    {
+      Interval.DrainUs += Sched.LastDrainUs;
+      if (Sched.LastDrainUs > Interval.MaxDrainUs)
+        Interval.MaxDrainUs = Sched.LastDrainUs;
+    }
+
+    NowUs = Cli_NowUs();
+    if ((uint32_t)(NowUs - Interval.StartUs) >= Options->IntervalMs * 1000)
+      Cli_Report(Stream, &Sched, &Interval, StartUs, NowUs);
+
+    if (Options->DurationMs &&
+        (uint32_t)(NowUs - StartUs) >= Options->DurationMs * 1000)
+      break;
+  }
+
+  ADXL345_Stream_Stop(Stream);
+  ADXL345_Stream_Process(Stream);
+  NowUs = Cli_NowUs();
+  if ((uint32_t)(NowUs - Interval.StartUs) >= Options->IntervalMs * 100)
+    Cli_Report(Stream, &Sched, &Interval, StartUs, NowUs);
+
+  fprintf(stderr, "total: %lu samples, %lu drains, %lu overruns, "
+          "%lu slot overflows, %lu bus errors, %lu samples estimated lost\n",
+          (unsigned long)Stream->Stats.Samples,
+          (unsigned long)Stream->Stats.Drains,
+          (unsigned long)Stream->Stats.Overruns,
+          (unsigned long)Stream->Stats.SlotOverflows,
+          (unsigned long)Stream->Stats.BusErrors,
+          (unsigned long)Stream->Tracker.Stats.DroppedSamples);
+  fprintf(stderr, "status polls: %lu (%lu early), %lu with naive polling "
+          "at the nominal ODR\n",
+          (unsigned long)Sched.Stats.Polls,
+          (unsigned long)Sched.Stats.EarlyPolls,
+          (unsigned long)Sched.Stats.NaivePolls);
+
+  return 0;
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+int
+main(int argc, char **argv)
+{
+  static ADXL345_Handler_t Handler;
+  static ADXL345_Stream_t Stream;
+  Cli_Options_t Options;
+  ADXL345_LogInfo_t Info;
+  int Result = 0;
+
+  if (Cli_ParseOptions(argc, argv, &Options) != 0)
+  {
+    Cli_Usage(argv[0]);
+    return 2;
+  }
+
+#ifdef ADXL345_CLI_SIM
+  ADXL345_Sim_AddDevice(Options.Address ? 0x1D : 0x53, 0, 0, 50000);
+#else
+  ADXL345_Platform_SetBus(Options.Bus);
+#endif
+
+  ADXL345_Platform_Init(&Handler);
+  Cli_Send = Handler.PlatformI2CSend;
+  Cli_Receive = Handler.PlatformI2CReceive;
+  Handler.PlatformI2CSend = Cli_TimedSend;
+  Handler.PlatformI2CReceive = Cli_TimedReceive;
+
+  if (ADXL345_Init(&Handler) != ADXL345_OK)
+  {
+    fprintf(stderr, "failed to open %s\n", Options.Bus);
+    return 1;
+  }
+  ADXL345_SetAddressI2C(&Handler, Options.Address);
+
+  if (ADXL345_CheckDeviceID(&Handler) != ADXL345_OK)
+  {
+    fprintf(stderr, "no ADXL345 at 0x%02X\n", Options.Address ? 0x1D : 0x53);
+    ADXL345_DeInit(&Handler);
+    return 1;
+  }
+
+  Cli_Out = stdout;
+  if (Options.Output)
+    Cli_Out = fopen(Options.Output, (Options.Format == CLI_FORMAT_BIN) ?
+                                    "wb" : "w");
+  if (Cli_Out == NULL)
+  {
+    perror(Options.Output);
+    ADXL345_DeInit(&Handler);
+    return 1;
+  }
+
+  if (ADXL345_Stream_Init(&Stream, &Handler, &Options.Stream) != ADXL345_OK)
+  {
+    fprintf(stderr, "invalid stream configuration\n");
+    Result = 1;
+    goto exit;
+  }
+  Stream.GetTimeUs = Cli_NowUs;
+
+  if (Options.Format == CLI_FORMAT_BIN)
+  {
+    Info.DeviceId = 0xE5;
+    Info.Range = Options.Stream.Range;
+    Info.FullResolution = Options.Stream.FullResolution;
+    Info.Rate = Options.Stream.Rate;
+    if (ADXL345_Log_WriterInit(&Cli_Log, &Info, Cli_LogBlock,
+                               sizeof(Cli_LogBlock), Cli_LogWrite,
+                               Cli_Out) != ADXL345_OK)
+    {
+      fprintf(stderr, "failed to write log header\n");
+      Result = 1;
+      goto exit;
+    }
+    Stream.Sink = ADXL345_Log_Sink;
+    Stream.SinkContext = &Cli_Log;
+  }
+  else
+  {
+    fprintf(Cli_Out, "sequence,time_us,gap,x_g,y_g,z_g\n");
+    Stream.Sink = Cli_CsvSink;
+    Stream.SinkContext = &Stream;
+  }
+
+  signal(SIGINT, Cli_Signal);
+  signal(SIGTERM, Cli_Signal);
+
+  if (Cli_Capture(&Stream, &Options) != 0)
+    Result = 1;
+
+  if (Options.Format == CLI_FORMAT_BIN)
+    ADXL345_Log_Flush(&Cli_Log);
+
+exit:
+  if (Cli_Out != stdout)
+    fclose(Cli_Out);
+  else
+    fflush(Cli_Out);
+  ADXL345_DeInit(&Handler);
+
+  return Result;
+}
@@ -0,0 +1,310 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_bench_decim.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Cost per sample of the decimation stage on simulator samples
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Feature Test Macros ----------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include "ADXL345.h"
+#include "ADXL345_stream.h"
+#include "ADXL345_decim.h"
+#include "ADXL345_platform.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define BENCH_SAMPLES   4096
+// Samples per ADXL345_Decim_Push, as delivered by a drain
+#define BENCH_BLOCK     32
+
+
+/* Private Data Types -----------------------------------------------------------*/
+typedef struct Bench_Capture_s
+{
+  ADXL345_Sample_t *Samples;
+  uint32_t Count;
+} Bench_Capture_t;
+
+typedef struct Bench_Case_s
+{
+  const char *Name;
+  uint8_t OutputMask;
+} Bench_Case_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static const Bench_Case_t Bench_Cases[] =
+{
+  {"stage 0",        0x01},
+  {"stage 4",        0x10},
+  {"stages 0 + 4",   0x11},
+  {"all 8 stages",   0xFF},
+};
+
+static ADXL345_Sample_t Bench_Samples[BENCH_SAMPLES];
+static volatile int16_t Bench_Last;
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static uint64_t
+Bench_CpuNs(void)
+{
+  struct timespec Now;
+
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &Now);
+  return (uint64_t)Now.tv_sec * 1000000000ULL + (uint64_t)Now.tv_nsec;
+}
+
+
+static void
+Bench_Sink(void *SinkContext, ADXL345_Batch_t *Batch)
+{
+  Bench_Capture_t *Capture = (Bench_Capture_t *)SinkContext;
+  uint8_t i = 0;
+
+  for (i = 0; i < Batch->Count; i++)
+  {
+    if (Capture->Count < BENCH_SAMPLES)
+      Capture->Samples[Capture->Count++] = Batch->Samples[i];
+  }
+}
+
+
+static void
+Bench_DecimSink(void *Context, uint8_t Stage,
+                const ADXL345_DecimSample_t *Sample)
+{
+  (void)Context;
+  (void)Stage;
+
+  // Keep the compiler from dropping the filter work
+  Bench_Last = Sample->X;
+}
+
+
+static int
+Bench_Capture(ADXL345_Rate_t Rate, uint32_t SignalMilliHz)
+{
+  static ADXL345_Handler_t Handler;
+  static ADXL345_Stream_t Stream;
+  ADXL345_StreamConfig_t Config;
+  Bench_Capture_t Capture;
+  int16_t Device = 0;
+
+  ADXL345_Sim_Reset();
+  Device = ADXL345_Sim_AddDevice(0x53, 0, 0, SignalMilliHz);
+  ADXL345_Platform_Init(&Handler);
+  if (ADXL345_Init(&Handler) != ADXL345_OK)
+    return -1;
+  ADXL345_SetAddressI2C(&Handler, 0);
+
+  memset(&Config, 0, sizeof(ADXL345_StreamConfig_t));
+  Config.Rate = Rate;
+  Config.Range = ADXL345_RANGE_16G;
+  Config.FullResolution = 1;
+  Config.Mode = ADXL345_MODE_STREAM;
+  Config.WatermarkSamples = 16;
+  Config.Pin = ADXL345_INTERRUPT_PIN1;
+  if (ADXL345_Stream_Init(&Stream, &Handler, &Config) != ADXL345_OK)
+    return -1;
+
+  Capture.Samples = Bench_Samples;
+  Capture.Count = 0;
+  Stream.Sink = Bench_Sink;
+  Stream.SinkContext = &Capture;
+  Stream.GetTimeUs = ADXL345_Sim_GetTimeUs;
+  if (ADXL345_Stream_Start(&Stream) != ADXL345_OK)
+    return -1;
+
+  while (Capture.Count < BENCH_SAMPLES)
+  {
+    if (!ADXL345_Sim_IntPin(Device, 1))
+    {
+      ADXL345_Sim_AdvanceUs(10);
+      continue;
+    }
+    if (ADXL345_Stream_IRQ(&Stream) != ADXL345_OK)
+      return -1;
+    ADXL345_Stream_Process(&Stream);
+  }
+
+  ADXL345_Stream_Stop(&Stream);
+  ADXL345_DeInit(&Handler);
+
+  return 0;
+}
+
+
+/**
+ * Cost of one 3-axis input sample, averaged over enough passes of the
+ * captured samples to take about MinNs of CPU time
+ */
+static double
+Bench_Run(uint8_t OutputMask, uint64_t MinNs, ADXL345_Decimator_t *Decimator)
+{
+  uint64_t StartNs = 0;
+  uint64_t ElapsedNs = 0;
+  uint64_t Samples = 0;
+  uint32_t i = 0;
+
+  if (ADXL345_Decim_Init(Decimator, OutputMask,
+                         Bench_DecimSink, NULL) != ADXL345_OK)
+    return -1;
+
+  StartNs = Bench_CpuNs();
+  do
+  {
+    for (i = 0; i < BENCH_SAMPLES; i += BENCH_BLOCK)
+      ADXL345_Decim_Push(Decimator, &Bench_Samples[i], BENCH_BLOCK);
+    Samples += BENCH_SAMPLES;
+    ElapsedNs = Bench_CpuNs() - StartNs;
+  } while (ElapsedNs < MinNs);
+
+  return (double)ElapsedNs / Samples;
+}
+
+
+static void
+Bench_Usage(const char *Name)
+{
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  -r CODE     Data Rate code 0..15 (default 15 => 3200 Hz)\n"
+          "  -g GHZ      clock of the host to print cycles per sample\n"
+          "  -s N        sensors for the load figure (default 16)\n"
+          "  -t MS       CPU time per measurement (default 200)\n",
+          Name);
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+int
+main(int argc, char **argv)
+{
+  static ADXL345_Decimator_t Decimator;
+  ADXL345_Rate_t Rate = ADXL345_RATE_3200;
+  ADXL345_Rate_t StageRate = ADXL345_RATE_3200;
+  uint32_t Sensors = 16;
+  uint64_t MinNs = 200000000;
+  double Ghz = 0;
+  double Ns = 0;
+  char Rates[64];
+  size_t Used = 0;
+  uint8_t Stage = 0;
+  uint8_t i = 0;
+  int Opt = 0;
+
+  while ((Opt = getopt(argc, argv, "r:g:s:t:h")) != -1)
+  {
+    switch (Opt)
+    {
+    case 'r':
+      Rate = (ADXL345_Rate_t)(atoi(optarg) & 0x0F);
+      break;
+    case 'g':
+      Ghz = atof(optarg);
+      break;
+    case 's':
+      Sensors = (uint32_t)atoi(optarg);
+      break;
+    case 't':
+      MinNs = (uint64_t)atoi(optarg) * 1000000ULL;
+      break;
+    default:
+      Bench_Usage(argv[0]);
+      return 2;
+    }
+  }
+
+  if (Bench_Capture(Rate, 50000) != 0)
+  {
+    fprintf(stderr, "capture failed\n");
+    return 1;
+  }
+
+  printf("%.1f Hz input, %d-tap half-band stages, %d samples per push, "
+         "load of %lu sensors\n",
+         ADXL345_ConvToData_RateMilliHz(Rate) / 1000.0, ADXL345_DECIM_TAPS,
+         BENCH_BLOCK, (unsigned long)Sensors);
+  printf("%-13s %-34s %10s %10s %12s\n", "outputs", "rates (Hz)",
+         "ns/sample", "cycles", "% of a core");
+
+  for (i = 0; i < sizeof(Bench_Cases) / sizeof(Bench_Cases[0]); i++)
+  {
+    Used = 0;
+    Rates[0] = '\0';
+    for (Stage = 0; Stage < ADXL345_DECIM_MAX_STAGES; Stage++)
+    {
+      if (!(Bench_Cases[i].OutputMask & (1u << Stage)))
+        continue;
+      // Stages below the lowest Data Rate are skipped
+      if (ADXL345_Decim_StageRate(Rate, Stage, &StageRate) != ADXL345_OK)
+        continue;
+      if (Used < sizeof(Rates))
+        Used += (size_t)snprintf(Rates + Used, sizeof(Rates) - Used, "%s%g",
+                                 Used ? " " : "",
+                                 ADXL345_ConvToData_RateMilliHz(StageRate) /
+                                 1000.0);
+    }
+
+    Ns = Bench_Run(Bench_Cases[i].OutputMask, MinNs, &Decimator);
+    if (Ns < 0)
+    {
+      fprintf(stderr, "init failed\n");
+      return 1;
+    }
+
+    printf("%-13s %-34s %10.1f ", Bench_Cases[i].Name, Rates, Ns);
+    if (Ghz > 0)
+      printf("%10.0f ", Ns * Ghz);
+    else
+      printf("%10s ", "-");
+    printf("%11.2f%%\n", Ns * Sensors *
+           (ADXL345_ConvToData_RateMilliHz(Rate) / 1000.0) / 1e7);
+  }
+
+  return 0;
+}
@@ -0,0 +1,259 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_bench_drain.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Interrupt-to-data latency of the FIFO drains on the simulator
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "ADXL345.h"
+#include "ADXL345_stream.h"
+#include "ADXL345_platform.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define BENCH_DRAIN_FULL       0
+#define BENCH_DRAIN_WATERMARK  1
+
+
+/* Private Data Types -----------------------------------------------------------*/
+typedef struct Bench_Result_s
+{
+  uint32_t Drains;
+  uint32_t Samples;
+  uint64_t FirstDataUs;
+  uint32_t MaxFirstDataUs;
+  uint64_t DrainUs;
+  uint32_t MaxDrainUs;
+} Bench_Result_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static int8_t (*Bench_Receive)(uint8_t Address, uint8_t *Data, uint8_t Len);
+static uint32_t Bench_FirstDataUs = 0;
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * The first 6-byte read of a drain is the first FIFO entry reaching the host.
+ */
+static int8_t
+Bench_TimedReceive(uint8_t Address, uint8_t *Data, uint8_t Len)
+{
+  int8_t Result = Bench_Receive(Address, Data, Len);
+
+  if (Len == 6 && Bench_FirstDataUs == 0)
+    Bench_FirstDataUs = ADXL345_Sim_GetTimeUs();
+
+  return Result;
+}
+
+
+static void
+Bench_NullSink(void *SinkContext, ADXL345_Batch_t *Batch)
+{
+  (void)SinkContext;
+  (void)Batch;
+}
+
+
+static int
+Bench_Run(ADXL345_Rate_t Rate, uint8_t Watermark, uint8_t Drain,
+          uint32_t LatencyUs, uint32_t DurationUs, Bench_Result_t *Result)
+{
+  static ADXL345_Handler_t Handler;
+  static ADXL345_Stream_t Stream;
+  ADXL345_StreamConfig_t Config;
+  ADXL345_InterruptReg_t Interrupt;
+  ADXL345_Sample_t Samples[ADXL345_FIFO_SIZE];
+  int16_t Device = 0;
+  uint32_t EndUs = 0;
+  uint32_t EventUs = 0;
+  uint32_t Us = 0;
+  uint8_t Count = 0;
+
+  memset(Result, 0, sizeof(Bench_Result_t));
+
+  ADXL345_Sim_Reset();
+  Device = ADXL345_Sim_AddDevice(0x53, 0, 0, 50000);
+  ADXL345_Platform_Init(&Handler);
+  Bench_Receive = Handler.PlatformI2CReceive;
+  Handler.PlatformI2CReceive = Bench_TimedReceive;
+  if (ADXL345_Init(&Handler) != ADXL345_OK)
+    return -1;
+  ADXL345_SetAddressI2C(&Handler, 0);
+
+  // The streaming engine only configures the device; drains are done here
+  memset(&Config, 0, sizeof(ADXL345_StreamConfig_t));
+  Config.Rate = Rate;
+  Config.Range = ADXL345_RANGE_16G;
+  Config.Mode = ADXL345_MODE_STREAM;
+  Config.WatermarkSamples = Watermark;
+  Config.Pin = ADXL345_INTERRUPT_PIN1;
+  if (ADXL345_Stream_Init(&Stream, &Handler, &Config) != ADXL345_OK)
+    return -1;
+  Stream.Sink = Bench_NullSink;
+  if (ADXL345_Stream_Start(&Stream) != ADXL345_OK)
+    return -1;
+
+  EndUs = ADXL345_Sim_GetTimeUs() + DurationUs;
+  while ((int32_t)(ADXL345_Sim_GetTimeUs() - EndUs) < 0)
+  {
+    if (!ADXL345_Sim_IntPin(Device, 1))
+    {
+      ADXL345_Sim_AdvanceUs(1);
+      continue;
+    }
+
+    EventUs = ADXL345_Sim_GetTimeUs();
+    ADXL345_Sim_AdvanceUs(LatencyUs);
+    Bench_FirstDataUs = 0;
+
+    if (ADXL345_Get_InterruptSource(&Handler, &Interrupt) != ADXL345_OK)
+      return -1;
+
+    if (Drain == BENCH_DRAIN_WATERMARK)
+    {
+      if (ADXL345_ReadSamplesWatermark(&Handler, Samples, ADXL345_FIFO_SIZE,
+                                       Watermark, &Count) != ADXL345_OK)
+        return -1;
+    }
+    else if (ADXL345_ReadSamples(&Handler, Samples, ADXL345_FIFO_SIZE,
+                                 &Count) != ADXL345_OK)
+    {
+      return -1;
+    }
+
+    Result->Drains++;
+    Result->Samples += Count;
+    Us = Bench_FirstDataUs - EventUs;
+    Result->FirstDataUs += Us;
+    if (Us > Result->MaxFirstDataUs)
+      Result->MaxFirstDataUs = Us;
+    Us = ADXL345_Sim_GetTimeUs() - EventUs;
+    Result->DrainUs += Us;
+    if (Us > Result->MaxDrainUs)
+      Result->MaxDrainUs = Us;
+  }
+
+  ADXL345_Stream_Stop(&Stream);
+  ADXL345_DeInit(&Handler);
+
+  return Result->Drains ? 0 : -1;
+}
+
+
+static void
+Bench_Usage(const char *Name)
+{
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  -r CODE     Data Rate code 0..15 (default 13 => 800 Hz)\n"
+          "  -l US       INT to first bus access (default 0)\n"
+          "  -d SEC      simulated time per run (default 1)\n",
+          Name);
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+int
+main(int argc, char **argv)
+{
+  static const uint8_t Watermarks[] = {1, 4, 8, 16, 24, 31};
+  static const char *const Names[] = {"ReadSamples", "ReadSamplesWatermark"};
+  ADXL345_Rate_t Rate = ADXL345_RATE_800;
+  Bench_Result_t Result;
+  uint32_t LatencyUs = 0;
+  uint32_t DurationUs = 1000000;
+  uint8_t Drain = 0;
+  uint8_t i = 0;
+  int Opt = 0;
+
+  while ((Opt = getopt(argc, argv, "r:l:d:h")) != -1)
+  {
+    switch (Opt)
+    {
+    case 'r':
+      Rate = (ADXL345_Rate_t)(atoi(optarg) & 0x0F);
+      break;
+    case 'l':
+      LatencyUs = (uint32_t)atoi(optarg);
+      break;
+    case 'd':
+      DurationUs = (uint32_t)(atof(optarg) * 1e6);
+      break;
+    default:
+      Bench_Usage(argv[0]);
+      return 2;
+    }
+  }
+
+  printf("%.1f Hz, 400 kHz I2C, %lu us service latency\n",
+         ADXL345_ConvToData_RateMilliHz(Rate) / 1000.0,
+         (unsigned long)LatencyUs);
+  printf("%-22s %3s  %8s  %14s  %14s\n", "drain", "wm", "samples",
+         "first data us", "drain us");
+  printf("%-22s %3s  %8s  %6s  %6s  %6s  %6s\n", "", "", "/drain",
+         "avg", "max", "avg", "max");
+
+  for (i = 0; i < sizeof(Watermarks); i++)
+  {
+    for (Drain = BENCH_DRAIN_FULL; Drain <= BENCH_DRAIN_WATERMARK; Drain++)
+    {
+      if (Bench_Run(Rate, Watermarks[i], Drain, LatencyUs, DurationUs,
+                    &Result) != 0)
+      {
+        fprintf(stderr, "run failed\n");
+        return 1;
+      }
+
+      printf("%-22s %3u  %8.1f  %6.1f  %6lu  %6.1f  %6lu\n", Names[Drain],
+             Watermarks[i], (double)Result.Samples / Result.Drains,
+             (double)Result.FirstDataUs / Result.Drains,
+             (unsigned long)Result.MaxFirstDataUs,
+             (double)Result.DrainUs / Result.Drains,
+             (unsigned long)Result.MaxDrainUs);
+    }
+  }
+
+  return 0;
+}
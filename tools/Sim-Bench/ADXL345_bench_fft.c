@@ -0,0 +1,352 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_bench_fft.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Per-window cost of the FFT stage on simulator samples
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Feature Test Macros ----------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include "ADXL345.h"
+#include "ADXL345_stream.h"
+#include "ADXL345_fft.h"
+#include "ADXL345_platform.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define BENCH_POINTS  ADXL345_FFT_MAX_POINTS
+
+
+/* Private Data Types -----------------------------------------------------------*/
+typedef struct Bench_Capture_s
+{
+  ADXL345_Sample_t *Samples;
+  uint32_t Count;
+} Bench_Capture_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static ADXL345_Sample_t Bench_Samples[BENCH_POINTS];
+static int16_t Bench_TwiddleQ15[ADXL345_FFT_TWIDDLE_LEN(BENCH_POINTS)];
+static int16_t Bench_WindowQ15[ADXL345_FFT_WINDOW_LEN(BENCH_POINTS)];
+static int16_t Bench_WorkQ15[ADXL345_FFT_WORK_LEN(BENCH_POINTS)];
+static uint32_t Bench_AmplitudeQ15[ADXL345_FFT_AMPLITUDE_LEN(BENCH_POINTS)];
+static float Bench_TwiddleF[ADXL345_FFT_TWIDDLE_LEN(BENCH_POINTS)];
+static float Bench_WindowF[ADXL345_FFT_WINDOW_LEN(BENCH_POINTS)];
+static float Bench_WorkF[ADXL345_FFT_WORK_LEN(BENCH_POINTS)];
+static float Bench_AmplitudeF[ADXL345_FFT_AMPLITUDE_LEN(BENCH_POINTS)];
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static uint64_t
+Bench_CpuNs(void)
+{
+  struct timespec Now;
+
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &Now);
+  return (uint64_t)Now.tv_sec * 1000000000ULL + (uint64_t)Now.tv_nsec;
+}
+
+
+static void
+Bench_Sink(void *SinkContext, ADXL345_Batch_t *Batch)
+{
+  Bench_Capture_t *Capture = (Bench_Capture_t *)SinkContext;
+  uint8_t i = 0;
+
+  for (i = 0; i < Batch->Count; i++)
+  {
+    if (Capture->Count < BENCH_POINTS)
+      Capture->Samples[Capture->Count++] = Batch->Samples[i];
+  }
+}
+
+
+static int
+Bench_Capture(ADXL345_Rate_t Rate, uint32_t SignalMilliHz)
+{
+  static ADXL345_Handler_t Handler;
+  static ADXL345_Stream_t Stream;
+  ADXL345_StreamConfig_t Config;
+  Bench_Capture_t Capture;
+  int16_t Device = 0;
+
+  ADXL345_Sim_Reset();
+  Device = ADXL345_Sim_AddDevice(0x53, 0, 0, SignalMilliHz);
+  ADXL345_Platform_Init(&Handler);
+  if (ADXL345_Init(&Handler) != ADXL345_OK)
+    return -1;
+  ADXL345_SetAddressI2C(&Handler, 0);
+
+  memset(&Config, 0, sizeof(ADXL345_StreamConfig_t));
+  Config.Rate = Rate;
+  Config.Range = ADXL345_RANGE_16G;
+  Config.FullResolution = 1;
+  Config.Mode = ADXL345_MODE_STREAM;
+  Config.WatermarkSamples = 16;
+  Config.Pin = ADXL345_INTERRUPT_PIN1;
+  if (ADXL345_Stream_Init(&Stream, &Handler, &Config) != ADXL345_OK)
+    return -1;
+
+  Capture.Samples = Bench_Samples;
+  Capture.Count = 0;
+  Stream.Sink = Bench_Sink;
+  Stream.SinkContext = &Capture;
+  Stream.GetTimeUs = ADXL345_Sim_GetTimeUs;
+  if (ADXL345_Stream_Start(&Stream) != ADXL345_OK)
+    return -1;
+
+  while (Capture.Count < BENCH_POINTS)
+  {
+    if (!ADXL345_Sim_IntPin(Device, 1))
+    {
+      ADXL345_Sim_AdvanceUs(10);
+      continue;
+    }
+    if (ADXL345_Stream_IRQ(&Stream) != ADXL345_OK)
+      return -1;
+    ADXL345_Stream_Process(&Stream);
+  }
+
+  ADXL345_Stream_Stop(&Stream);
+  ADXL345_DeInit(&Handler);
+
+  return 0;
+}
+
+
+static uint32_t
+Bench_PeakQ15(uint16_t Points)
+{
+  uint32_t Peak = 1;
+  uint32_t i = 0;
+
+  for (i = 1; i <= Points / 2u; i++)
+  {
+    if (Bench_AmplitudeQ15[i] > Bench_AmplitudeQ15[Peak])
+      Peak = i;
+  }
+
+  return Peak;
+}
+
+
+static uint32_t
+Bench_PeakF(uint16_t Points)
+{
+  uint32_t Peak = 1;
+  uint32_t i = 0;
+
+  for (i = 1; i <= Points / 2u; i++)
+  {
+    if (Bench_AmplitudeF[i] > Bench_AmplitudeF[Peak])
+      Peak = i;
+  }
+
+  return Peak;
+}
+
+
+/**
+ * Cost of one window (Push of every sample and Compute), averaged over
+ * enough windows to take about MinNs of CPU time
+ */
+static double
+Bench_RunQ15(uint16_t Points, uint64_t MinNs, uint32_t *Peak)
+{
+  ADXL345_FftTableQ15_t Table;
+  ADXL345_FftQ15_t Fft;
+  uint64_t StartNs = 0;
+  uint64_t ElapsedNs = 0;
+  uint32_t Windows = 0;
+  uint16_t i = 0;
+
+  if (ADXL345_FftQ15_InitTable(&Table, Points, ADXL345_FFT_WINDOW_HANN,
+                               Bench_TwiddleQ15, Bench_WindowQ15) != ADXL345_OK)
+    return -1;
+  if (ADXL345_FftQ15_Init(&Fft, &Table, ADXL345_FFT_AXIS_X,
+                          1, Bench_WorkQ15) != ADXL345_OK)
+    return -1;
+
+  StartNs = Bench_CpuNs();
+  do
+  {
+    for (i = 0; i < Points; i++)
+      ADXL345_FftQ15_Push(&Fft, &Bench_Samples[i]);
+    ADXL345_FftQ15_Compute(&Fft, Bench_AmplitudeQ15);
+    Windows++;
+    ElapsedNs = Bench_CpuNs() - StartNs;
+  } while (ElapsedNs < MinNs);
+
+  *Peak = Bench_PeakQ15(Points);
+
+  return (double)ElapsedNs / Windows;
+}
+
+
+static double
+Bench_RunF(uint16_t Points, uint64_t MinNs, uint32_t *Peak)
+{
+  ADXL345_FftTableF_t Table;
+  ADXL345_FftF_t Fft;
+  uint64_t StartNs = 0;
+  uint64_t ElapsedNs = 0;
+  uint32_t Windows = 0;
+  uint16_t i = 0;
+
+  if (ADXL345_FftF_InitTable(&Table, Points, ADXL345_FFT_WINDOW_HANN,
+                             Bench_TwiddleF, Bench_WindowF) != ADXL345_OK)
+    return -1;
+  if (ADXL345_FftF_Init(&Fft, &Table, ADXL345_FFT_AXIS_X,
+                        1, Bench_WorkF) != ADXL345_OK)
+    return -1;
+
+  StartNs = Bench_CpuNs();
+  do
+  {
+    for (i = 0; i < Points; i++)
+      ADXL345_FftF_Push(&Fft, &Bench_Samples[i]);
+    ADXL345_FftF_Compute(&Fft, Bench_AmplitudeF);
+    Windows++;
+    ElapsedNs = Bench_CpuNs() - StartNs;
+  } while (ElapsedNs < MinNs);
+
+  *Peak = Bench_PeakF(Points);
+
+  return (double)ElapsedNs / Windows;
+}
+
+
+static void
+Bench_Usage(const char *Name)
+{
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  -r CODE     Data Rate code 0..15 (default 15 => 3200 Hz)\n"
+          "  -f MHZ      vibration of the simulated device in mHz "
+          "(default 120000)\n"
+          "  -s N        sensors for the load figure (default 16)\n"
+          "  -t MS       CPU time per measurement (default 200)\n",
+          Name);
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+int
+main(int argc, char **argv)
+{
+  ADXL345_Rate_t Rate = ADXL345_RATE_3200;
+  uint32_t SignalMilliHz = 120000;
+  uint32_t Sensors = 16;
+  uint64_t MinNs = 200000000;
+  uint32_t RateMilliHz = 0;
+  uint32_t Points = 0;
+  uint32_t Peak = 0;
+  double Ns = 0;
+  double Load = 0;
+  uint8_t Variant = 0;
+  int Opt = 0;
+
+  while ((Opt = getopt(argc, argv, "r:f:s:t:h")) != -1)
+  {
+    switch (Opt)
+    {
+    case 'r':
+      Rate = (ADXL345_Rate_t)(atoi(optarg) & 0x0F);
+      break;
+    case 'f':
+      SignalMilliHz = (uint32_t)atol(optarg);
+      break;
+    case 's':
+      Sensors = (uint32_t)atoi(optarg);
+      break;
+    case 't':
+      MinNs = (uint64_t)atoi(optarg) * 1000000ULL;
+      break;
+    default:
+      Bench_Usage(argv[0]);
+      return 2;
+    }
+  }
+
+  if (Bench_Capture(Rate, SignalMilliHz) != 0)
+  {
+    fprintf(stderr, "capture failed\n");
+    return 1;
+  }
+
+  RateMilliHz = ADXL345_ConvToData_RateMilliHz(Rate);
+  printf("%.1f Hz, Hann window, %.1f Hz vibration, load of %lu sensors x 3 "
+         "axes with back-to-back windows\n",
+         RateMilliHz / 1000.0, SignalMilliHz / 1000.0, (unsigned long)Sensors);
+  printf("%-5s %6s %12s %10s %10s %12s\n", "type", "points", "us/window",
+         "ns/sample", "peak Hz", "% of a core");
+
+  for (Variant = 0; Variant < 2; Variant++)
+  {
+    for (Points = ADXL345_FFT_MIN_POINTS * 16;
+         Points <= BENCH_POINTS; Points <<= 1)
+    {
+      if (Variant == 0)
+        Ns = Bench_RunQ15((uint16_t)Points, MinNs, &Peak);
+      else
+        Ns = Bench_RunF((uint16_t)Points, MinNs, &Peak);
+      if (Ns < 0)
+      {
+        fprintf(stderr, "init failed\n");
+        return 1;
+      }
+
+      // Every axis of every sensor fills a window each Points/ODR seconds
+      Load = Ns * 3 * Sensors * (RateMilliHz / 1000.0) / Points / 1e7;
+      printf("%-5s %6lu %12.1f %10.1f %10.2f %11.2f%%\n",
+             Variant ? "float" : "Q15", (unsigned long)Points, Ns / 1000.0,
+             Ns / Points, ADXL345_Fft_BinMilliHz(Rate, Points, Peak) / 1000.0,
+             Load);
+    }
+  }
+
+  return 0;
+}
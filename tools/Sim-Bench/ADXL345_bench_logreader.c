@@ -0,0 +1,659 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_bench_logreader.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Log reader decode throughput and time-to-first-sample benchmark
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Feature Test Macros ----------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <getopt.h>
+#include "ADXL345.h"
+#include "ADXL345_stream.h"
+#include "ADXL345_log.h"
+#include "ADXL345_logreader.h"
+#include "ADXL345_platform.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+// Samples captured from the simulator and replayed until the log is full
+#define BENCH_CAPTURE       32768
+#define BENCH_BATCH         32
+#define BENCH_INDEX         4096
+// Sequential reads decode 10 s of samples per call
+#define BENCH_CHUNK_US      10000000ULL
+#define BENCH_CHUNK         40000
+// Samples read to get the first sample of a random time
+#define BENCH_FIRST         32
+
+
+/* Private Data Types -----------------------------------------------------------*/
+typedef struct Bench_Capture_s
+{
+  ADXL345_Sample_t *Samples;
+  uint32_t Count;
+} Bench_Capture_t;
+
+typedef struct Bench_File_s
+{
+  FILE *File;
+  uint64_t Bytes;
+} Bench_File_t;
+
+typedef struct Bench_Time_s
+{
+  double Sum;
+  double Max;
+  uint32_t Count;
+} Bench_Time_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static ADXL345_Sample_t Bench_Samples[BENCH_CAPTURE];
+static ADXL345_LogIndexEntry_t Bench_Index[BENCH_INDEX];
+static int16_t Bench_Raw[3][BENCH_CHUNK];
+static float Bench_Float[3][BENCH_CHUNK];
+static ADXL345_LogInfo_t Bench_Info;
+static uint32_t Bench_Random = 2463534242u;
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static double
+Bench_Seconds(void)
+{
+  struct timespec Now;
+
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+  return Now.tv_sec + Now.tv_nsec / 1e9;
+}
+
+
+static uint64_t
+Bench_RandomUs(uint64_t MaxUs)
+{
+  uint64_t Value = 0;
+
+  Bench_Random ^= Bench_Random << 13;
+  Bench_Random ^= Bench_Random >> 17;
+  Bench_Random ^= Bench_Random << 5;
+  Value = Bench_Random;
+  Bench_Random ^= Bench_Random << 13;
+  Bench_Random ^= Bench_Random >> 17;
+  Bench_Random ^= Bench_Random << 5;
+  Value = (Value << 32) | Bench_Random;
+
+  return MaxUs ? Value % MaxUs : 0;
+}
+
+
+static void
+Bench_AddTime(Bench_Time_t *Time, double Seconds)
+{
+  Time->Sum += Seconds;
+  if (Seconds > Time->Max)
+    Time->Max = Seconds;
+  Time->Count++;
+}
+
+
+static void
+Bench_Sink(void *SinkContext, ADXL345_Batch_t *Batch)
+{
+  Bench_Capture_t *Capture = (Bench_Capture_t *)SinkContext;
+  uint8_t i = 0;
+
+  for (i = 0; i < Batch->Count; i++)
+  {
+    if (Capture->Count < BENCH_CAPTURE)
+      Capture->Samples[Capture->Count++] = Batch->Samples[i];
+  }
+}
+
+
+static int
+Bench_Capture(ADXL345_Rate_t Rate, uint32_t SignalMilliHz)
+{
+  static ADXL345_Handler_t Handler;
+  static ADXL345_Stream_t Stream;
+  ADXL345_StreamConfig_t Config;
+  Bench_Capture_t Capture;
+  int16_t Device = 0;
+
+  ADXL345_Sim_Reset();
+  Device = ADXL345_Sim_AddDevice(0x53, 0, 0, SignalMilliHz);
+  ADXL345_Platform_Init(&Handler);
+  if (ADXL345_Init(&Handler) != ADXL345_OK)
+    return -1;
+  ADXL345_SetAddressI2C(&Handler, 0);
+
+  memset(&Config, 0, sizeof(ADXL345_StreamConfig_t));
+  Config.Rate = Rate;
+  Config.Range = ADXL345_RANGE_16G;
+  Config.FullResolution = 1;
+  Config.Mode = ADXL345_MODE_STREAM;
+  Config.WatermarkSamples = 16;
+  Config.Pin = ADXL345_INTERRUPT_PIN1;
+  if (ADXL345_Stream_Init(&Stream, &Handler, &Config) != ADXL345_OK)
+    return -1;
+
+  Capture.Samples = Bench_Samples;
+  Capture.Count = 0;
+  Stream.Sink = Bench_Sink;
+  Stream.SinkContext = &Capture;
+  Stream.GetTimeUs = ADXL345_Sim_GetTimeUs;
+  if (ADXL345_Stream_Start(&Stream) != ADXL345_OK)
+    return -1;
+
+  while (Capture.Count < BENCH_CAPTURE)
+  {
+    if (!ADXL345_Sim_IntPin(Device, 1))
+    {
+      ADXL345_Sim_AdvanceUs(10);
+      continue;
+    }
+    if (ADXL345_Stream_IRQ(&Stream) != ADXL345_OK)
+      return -1;
+    ADXL345_Stream_Process(&Stream);
+  }
+
+  Bench_Info.DeviceId = 0xE5;
+  Bench_Info.Range = Config.Range;
+  Bench_Info.FullResolution = Config.FullResolution;
+  Bench_Info.Rate = Rate;
+
+  ADXL345_Stream_Stop(&Stream);
+  ADXL345_DeInit(&Handler);
+
+  return 0;
+}
+
+
+static int8_t
+Bench_Write(void *Context, const uint8_t *Data, uint16_t Len)
+{
+  Bench_File_t *File = (Bench_File_t *)Context;
+
+  if (fwrite(Data, 1, Len, File->File) != Len)
+    return -1;
+  File->Bytes += Len;
+
+  return 0;
+}
+
+
+/**
+ * The captured samples are appended over and over with contiguous sequence
+ * numbers and timestamps until the log reaches Bytes
+ */
+static int
+Bench_WriteLog(const char *Path, uint64_t Bytes, uint16_t BlockSize,
+               uint64_t *Samples)
+{
+  static uint8_t Block[0xFFFF];
+  ADXL345_LogWriter_t Writer;
+  ADXL345_Batch_t Batch;
+  Bench_File_t File;
+  uint32_t RateMilliHz = ADXL345_ConvToData_RateMilliHz(Bench_Info.Rate);
+  uint64_t Sequence = 0;
+  int Result = 0;
+
+  File.File = fopen(Path, "wb");
+  File.Bytes = 0;
+  if (!File.File)
+    return -1;
+
+  if (ADXL345_Log_WriterInit(&Writer, &Bench_Info, Block, BlockSize,
+                             Bench_Write, &File) != ADXL345_OK)
+    Result = -1;
+
+  while (!Result && File.Bytes < Bytes)
+  {
+    Batch.Samples = &Bench_Samples[Sequence % BENCH_CAPTURE];
+    Batch.Count = BENCH_BATCH;
+    Batch.Gap = 0;
+    Batch.Sequence = (uint32_t)Sequence;
+    Batch.TimestampUs = (uint32_t)(Sequence * 1000000000ULL / RateMilliHz);
+    if (ADXL345_Log_Write(&Writer, &Batch) != ADXL345_OK)
+      Result = -1;
+    Sequence += BENCH_BATCH;
+  }
+
+  if (ADXL345_Log_Flush(&Writer) != ADXL345_OK)
+    Result = -1;
+  // Written back, so the page cache can be dropped before cold runs
+  if (fflush(File.File) != 0 || fsync(fileno(File.File)) != 0)
+    Result = -1;
+  if (fclose(File.File) != 0)
+    Result = -1;
+
+  *Samples = Sequence;
+
+  return Result;
+}
+
+
+/**
+ * Drop the log from the page cache for a cold run, or read it all into the
+ * page cache for a warm run
+ */
+static void
+Bench_Cache(const char *Path, uint8_t Cold)
+{
+  static uint8_t Buffer[1 << 20];
+  int Fd = open(Path, O_RDONLY);
+
+  if (Fd < 0)
+    return;
+  if (Cold)
+    posix_fadvise(Fd, 0, 0, POSIX_FADV_DONTNEED);
+  else
+    while (read(Fd, Buffer, sizeof(Buffer)) > 0);
+  close(Fd);
+}
+
+
+static int
+Bench_Open(ADXL345_LogReader_t *Reader, const char *Path,
+           const char *IndexPath, uint8_t Cold, Bench_Time_t *Time)
+{
+  double Start = 0;
+
+  Bench_Cache(Path, Cold);
+
+  Start = Bench_Seconds();
+  if (ADXL345_LogReader_Open(Reader, Path, IndexPath,
+                             Bench_Index, BENCH_INDEX) != ADXL345_OK)
+    return -1;
+  Bench_AddTime(Time, Bench_Seconds() - Start);
+
+  return 0;
+}
+
+
+/**
+ * Open with the saved index and read the samples at a random time. The
+ * decoded values must match the replayed capture.
+ */
+static int
+Bench_First(const char *Path, const char *IndexPath, uint8_t Cold,
+            uint32_t Trials, Bench_Time_t *Time, uint32_t *Errors)
+{
+  ADXL345_LogReader_t Reader;
+  uint64_t FromUs = 0;
+  uint64_t FirstUs = 0;
+  uint64_t Sample = 0;
+  uint32_t Count = 0;
+  double Start = 0;
+  uint32_t t = 0;
+  uint32_t i = 0;
+
+  Bench_Cache(Path, Cold);
+
+  for (t = 0; t < Trials; t++)
+  {
+    if (Cold && t)
+      Bench_Cache(Path, Cold);
+
+    Start = Bench_Seconds();
+    if (ADXL345_LogReader_Open(&Reader, Path, IndexPath,
+                               Bench_Index, BENCH_INDEX) != ADXL345_OK)
+      return -1;
+    FromUs = Bench_RandomUs(Reader.DurationUs);
+    ADXL345_LogReader_Read(&Reader, FromUs, Reader.DurationUs,
+                           Bench_Raw[0], Bench_Raw[1], Bench_Raw[2],
+                           BENCH_FIRST, &Count, &FirstUs);
+    Bench_AddTime(Time, Bench_Seconds() - Start);
+
+    Sample = (FirstUs * 1000 + Reader.PeriodNs / 2) / Reader.PeriodNs;
+    if (!Count || FirstUs < FromUs)
+      (*Errors)++;
+    for (i = 0; i < Count; i++)
+    {
+      if (Bench_Raw[0][i] != Bench_Samples[(Sample + i) % BENCH_CAPTURE].RawX ||
+          Bench_Raw[1][i] != Bench_Samples[(Sample + i) % BENCH_CAPTURE].RawY ||
+          Bench_Raw[2][i] != Bench_Samples[(Sample + i) % BENCH_CAPTURE].RawZ)
+      {
+        (*Errors)++;
+        break;
+      }
+    }
+
+    ADXL345_LogReader_Close(&Reader);
+  }
+
+  return 0;
+}
+
+
+/**
+ * Read from the start with no end time. It must return the first samples
+ * of the log.
+ */
+static int
+Bench_FullRange(const char *Path, const char *IndexPath, uint64_t Samples,
+                uint32_t *Errors)
+{
+  ADXL345_LogReader_t Reader;
+  uint64_t FirstUs = 0;
+  uint32_t Count = 0;
+  uint32_t i = 0;
+
+  if (ADXL345_LogReader_Open(&Reader, Path, IndexPath,
+                             Bench_Index, BENCH_INDEX) != ADXL345_OK)
+    return -1;
+
+  ADXL345_LogReader_Read(&Reader, 0, ~0ULL,
+                         Bench_Raw[0], Bench_Raw[1], Bench_Raw[2],
+                         BENCH_CHUNK, &Count, &FirstUs);
+
+  if (Count != ((Samples < BENCH_CHUNK) ? Samples : BENCH_CHUNK) || FirstUs)
+    (*Errors)++;
+  for (i = 0; i < Count; i++)
+  {
+    if (Bench_Raw[0][i] != Bench_Samples[i % BENCH_CAPTURE].RawX ||
+        Bench_Raw[1][i] != Bench_Samples[i % BENCH_CAPTURE].RawY ||
+        Bench_Raw[2][i] != Bench_Samples[i % BENCH_CAPTURE].RawZ)
+    {
+      (*Errors)++;
+      break;
+    }
+  }
+
+  ADXL345_LogReader_Close(&Reader);
+
+  return 0;
+}
+
+
+/**
+ * Decode the whole log into the SoA arrays, 10 s of samples per call
+ */
+static double
+Bench_Decode(const char *Path, uint8_t Cold, uint8_t Float, uint8_t CheckCrc,
+             uint64_t *Samples)
+{
+  ADXL345_LogReader_t Reader;
+  Bench_Time_t Open;
+  uint64_t FromUs = 0;
+  uint32_t Count = 0;
+  double Start = 0;
+
+  memset(&Open, 0, sizeof(Open));
+  *Samples = 0;
+
+  if (Bench_Open(&Reader, Path, NULL, Cold, &Open) != 0)
+    return -1;
+  Reader.CheckCrc = CheckCrc;
+
+  Start = Bench_Seconds();
+  for (FromUs = 0; FromUs < Reader.DurationUs; FromUs += BENCH_CHUNK_US)
+  {
+    if (Float)
+      ADXL345_LogReader_ReadFloat(&Reader, FromUs, FromUs + BENCH_CHUNK_US,
+                                  Bench_Float[0], Bench_Float[1],
+                                  Bench_Float[2], BENCH_CHUNK, &Count, NULL);
+    else
+      ADXL345_LogReader_Read(&Reader, FromUs, FromUs + BENCH_CHUNK_US,
+                             Bench_Raw[0], Bench_Raw[1], Bench_Raw[2],
+                             BENCH_CHUNK, &Count, NULL);
+    *Samples += Count;
+  }
+
+  ADXL345_LogReader_Close(&Reader);
+
+  return Bench_Seconds() - Start;
+}
+
+
+static void
+Bench_Usage(const char *Name)
+{
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  -m MB       log size (default 2048)\n"
+          "  -b BYTES    block size (default 1024)\n"
+          "  -r RATE     ADXL345_Rate_t value (default 15 = 3200 Hz)\n"
+          "  -f MHZ      vibration frequency in mHz (default 50000)\n"
+          "  -n N        time-to-first-sample trials (default 20)\n"
+          "  -c          skip block CRC checks while decoding\n"
+          "  -o PATH     log file (default /tmp/adxl345_bench.log)\n"
+          "  -k          keep the log and its index\n",
+          Name);
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+int
+main(int argc, char **argv)
+{
+  ADXL345_LogReader_t Reader;
+  Bench_Time_t Build[2];    // [0]: warm, [1]: cold
+  Bench_Time_t Load[2];
+  Bench_Time_t First[2];
+  double Decode[2][2];      // [Float][Cold]
+  char IndexPath[512];
+  const char *Path = "/tmp/adxl345_bench.log";
+  ADXL345_Rate_t Rate = ADXL345_RATE_3200;
+  uint32_t SignalMilliHz = 50000;
+  uint64_t Bytes = 2048ULL << 20;
+  uint64_t Samples = 0;
+  uint64_t Decoded = 0;
+  uint32_t BlockSize = 1024;
+  uint32_t Trials = 20;
+  uint32_t Errors = 0;
+  double Seconds = 0;
+  uint8_t Float = 0;
+  uint8_t CheckCrc = 1;
+  uint8_t Keep = 0;
+  uint8_t Cold = 0;
+  uint8_t i = 0;
+  int Failed = 0;
+  int Opt = 0;
+
+  while ((Opt = getopt(argc, argv, "m:b:r:f:n:co:kh")) != -1)
+  {
+    switch (Opt)
+    {
+    case 'm':
+      Bytes = (uint64_t)atol(optarg) << 20;
+      break;
+    case 'b':
+      BlockSize = (uint32_t)atol(optarg);
+      break;
+    case 'r':
+      Rate = (ADXL345_Rate_t)(atoi(optarg) & 0x0F);
+      break;
+    case 'f':
+      SignalMilliHz = (uint32_t)atol(optarg);
+      break;
+    case 'n':
+      Trials = (uint32_t)atol(optarg);
+      break;
+    case 'c':
+      CheckCrc = 0;
+      break;
+    case 'o':
+      Path = optarg;
+      break;
+    case 'k':
+      Keep = 1;
+      break;
+    default:
+      Bench_Usage(argv[0]);
+      return 2;
+    }
+  }
+
+  if (!Bytes || !Trials ||
+      BlockSize < ADXL345_LOG_BLOCK_LEN(1) || BlockSize > 0xFFFF)
+  {
+    Bench_Usage(argv[0]);
+    return 2;
+  }
+  snprintf(IndexPath, sizeof(IndexPath), "%s.idx", Path);
+
+  if (Bench_Capture(Rate, SignalMilliHz) != 0)
+  {
+    fprintf(stderr, "capture failed\n");
+    return 1;
+  }
+
+  Seconds = Bench_Seconds();
+  if (Bench_WriteLog(Path, Bytes, (uint16_t)BlockSize, &Samples) != 0)
+  {
+    fprintf(stderr, "failed to write %s\n", Path);
+    remove(Path);
+    return 1;
+  }
+  Seconds = Bench_Seconds() - Seconds;
+  remove(IndexPath);
+
+  printf("%.0f MB log, %lu-byte blocks, %lu samples (%.1f h at %.1f Hz), "
+         "%.2f bytes/sample, written in %.1f s\n",
+         Bytes / 1048576.0, (unsigned long)BlockSize, (unsigned long)Samples,
+         Samples * 1000.0 / ADXL345_ConvToData_RateMilliHz(Rate) / 3600,
+         ADXL345_ConvToData_RateMilliHz(Rate) / 1000.0,
+         (double)Bytes / Samples, Seconds);
+  printf("cold runs drop the page cache of the log with POSIX_FADV_DONTNEED, "
+         "warm runs read it all first; block CRCs %s while decoding\n\n",
+         CheckCrc ? "checked" : "not checked");
+
+  memset(Build, 0, sizeof(Build));
+  memset(Load, 0, sizeof(Load));
+  memset(First, 0, sizeof(First));
+
+  // Each cold run is followed by a warm run of the same kind
+  for (i = 0; i < 2 && !Failed; i++)
+  {
+    Cold = !i;
+    if (Bench_Open(&Reader, Path, NULL, Cold, &Build[Cold]) != 0)
+    {
+      Failed = 1;
+      break;
+    }
+    if (Reader.Stats.Samples != Samples || Reader.Stats.Gaps ||
+        Reader.Stats.BadBytes)
+      Errors++;
+    ADXL345_LogReader_Close(&Reader);
+  }
+
+  // The first open with IndexPath builds and saves the index
+  if (!Failed &&
+      ADXL345_LogReader_Open(&Reader, Path, IndexPath,
+                             Bench_Index, BENCH_INDEX) == ADXL345_OK)
+    ADXL345_LogReader_Close(&Reader);
+
+  for (i = 0; i < 2 && !Failed; i++)
+  {
+    Cold = !i;
+    if (Bench_Open(&Reader, Path, IndexPath, Cold, &Load[Cold]) != 0)
+    {
+      Failed = 1;
+      break;
+    }
+    ADXL345_LogReader_Close(&Reader);
+  }
+
+  for (i = 0; i < 2 && !Failed; i++)
+  {
+    Cold = !i;
+    if (Bench_First(Path, IndexPath, Cold, Trials,
+                    &First[Cold], &Errors) != 0)
+      Failed = 1;
+  }
+
+  if (!Failed && Bench_FullRange(Path, IndexPath, Samples, &Errors) != 0)
+    Failed = 1;
+
+  for (Float = 0; Float < 2 && !Failed; Float++)
+  {
+    for (i = 0; i < 2; i++)
+    {
+      Cold = !i;
+      Decode[Float][Cold] = Bench_Decode(Path, Cold, Float, CheckCrc,
+                                         &Decoded);
+      if (Decode[Float][Cold] <= 0 || Decoded != Samples)
+        Errors++;
+    }
+  }
+
+  if (Failed)
+  {
+    fprintf(stderr, "failed to open %s\n", Path);
+  }
+  else
+  {
+    printf("%-36s %14s %14s\n", "", "cold", "warm");
+    printf("%-36s %11.2f ms %11.2f ms\n", "open, index built from headers",
+           Build[1].Sum * 1e3, Build[0].Sum * 1e3);
+    printf("%-36s %11.3f ms %11.3f ms\n", "open, saved index loaded",
+           Load[1].Sum * 1e3, Load[0].Sum * 1e3);
+    printf("%-36s %11.3f ms %11.3f ms\n", "time to first sample, average",
+           First[1].Sum * 1e3 / Trials, First[0].Sum * 1e3 / Trials);
+    printf("%-36s %11.3f ms %11.3f ms\n", "time to first sample, max",
+           First[1].Max * 1e3, First[0].Max * 1e3);
+    for (Float = 0; Float < 2; Float++)
+    {
+      printf("%-36s %9.2f GB/s %9.2f GB/s\n",
+             Float ? "decode to float SoA" : "decode to int16 SoA",
+             Bytes / Decode[Float][1] / 1e9, Bytes / Decode[Float][0] / 1e9);
+      printf("%-36s %7.1f Msa/s %7.1f Msa/s\n", "",
+             Samples / Decode[Float][1] / 1e6,
+             Samples / Decode[Float][0] / 1e6);
+    }
+  }
+
+  if (!Keep)
+  {
+    remove(Path);
+    remove(IndexPath);
+  }
+
+  if (Errors)
+    printf("\n%lu errors\n", (unsigned long)Errors);
+
+  return Failed || Errors;
+}
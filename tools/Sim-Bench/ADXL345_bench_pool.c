@@ -0,0 +1,349 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_bench_pool.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Scaling of the processing pool over worker threads
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Feature Test Macros ----------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include "ADXL345.h"
+#include "ADXL345_stream.h"
+#include "ADXL345_stats.h"
+#include "ADXL345_pool.h"
+#include "ADXL345_platform.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define BENCH_MAX_SENSORS   ADXL345_POOL_MAX_SENSORS
+// Bursts per sensor submitted before each ADXL345_Pool_Drain
+#define BENCH_BURSTS        64
+// Raw bursts captured from the simulator and replayed by every sensor
+#define BENCH_CAPTURES      64
+#define BENCH_BURST_LEN     32
+
+
+/* Private Data Types -----------------------------------------------------------*/
+typedef struct Bench_Sensor_s
+{
+  ADXL345_PoolSensor_t PoolSensor;
+  ADXL345_PoolBurst_t Burst[BENCH_BURSTS];
+  ADXL345_StatsQ_t Stats;
+  uint32_t NextSequence;
+  uint32_t Disorder;
+  uint16_t Passes;
+} Bench_Sensor_t;
+
+typedef struct Bench_Result_s
+{
+  double Seconds;
+  uint64_t Bursts;
+  uint32_t Steals;
+  uint32_t Disorder;
+} Bench_Result_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static uint8_t Bench_Raw[BENCH_CAPTURES][6 * BENCH_BURST_LEN];
+static ADXL345_DataFormat_t Bench_DataFormat;
+static Bench_Sensor_t Bench_Sensor[BENCH_MAX_SENSORS];
+static ADXL345_Pool_t Bench_Pool;
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static double
+Bench_Seconds(void)
+{
+  struct timespec Now;
+
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+  return Now.tv_sec + Now.tv_nsec / 1e9;
+}
+
+
+static void
+Bench_NullSink(void *SinkContext, ADXL345_Batch_t *Batch)
+{
+  (void)SinkContext;
+  (void)Batch;
+}
+
+
+/**
+ * Bursts of 32 samples are read from a simulated 3200 Hz device, the way
+ * a watermark drain would read them
+ */
+static int
+Bench_Capture(void)
+{
+  static ADXL345_Handler_t Handler;
+  static ADXL345_Stream_t Stream;
+  ADXL345_StreamConfig_t Config;
+  uint8_t i = 0;
+
+  ADXL345_Sim_Reset();
+  ADXL345_Sim_AddDevice(0x53, 0, 0, 50000);
+  ADXL345_Platform_Init(&Handler);
+  if (ADXL345_Init(&Handler) != ADXL345_OK)
+    return -1;
+  ADXL345_SetAddressI2C(&Handler, 0);
+
+  memset(&Config, 0, sizeof(ADXL345_StreamConfig_t));
+  Config.Rate = ADXL345_RATE_3200;
+  Config.Range = ADXL345_RANGE_16G;
+  Config.FullResolution = 1;
+  Config.Mode = ADXL345_MODE_STREAM;
+  Config.WatermarkSamples = BENCH_BURST_LEN - 1;
+  Config.Pin = ADXL345_INTERRUPT_PIN1;
+  if (ADXL345_Stream_Init(&Stream, &Handler, &Config) != ADXL345_OK)
+    return -1;
+  Stream.Sink = Bench_NullSink;
+  if (ADXL345_Stream_Start(&Stream) != ADXL345_OK)
+    return -1;
+
+  for (i = 0; i < BENCH_CAPTURES; i++)
+  {
+    ADXL345_Sim_AdvanceUs(BENCH_BURST_LEN *
+                          ADXL345_ConvToData_RatePeriodUs(Config.Rate));
+    if (ADXL345_ReadRawSamples(&Handler, Bench_Raw[i],
+                               BENCH_BURST_LEN) != ADXL345_OK)
+      return -1;
+  }
+
+  Bench_DataFormat = Stream.DataFormat;
+  ADXL345_Stream_Stop(&Stream);
+  ADXL345_DeInit(&Handler);
+
+  return 0;
+}
+
+
+static void
+Bench_Process(void *Context, ADXL345_Batch_t *Batch,
+              ADXL345_PoolBurst_t *Burst)
+{
+  Bench_Sensor_t *Sensor = (Bench_Sensor_t *)Context;
+  uint16_t Pass = 0;
+  uint8_t i = 0;
+
+  (void)Burst;
+
+  if (Batch->Sequence != Sensor->NextSequence)
+    Sensor->Disorder++;
+  Sensor->NextSequence = Batch->Sequence + Batch->Count;
+
+  // Window statistics stand for the analysis of a gateway
+  for (Pass = 0; Pass < Sensor->Passes; Pass++)
+    for (i = 0; i < Batch->Count; i++)
+      ADXL345_StatsQ_Push(&Sensor->Stats, &Batch->Samples[i]);
+}
+
+
+static int
+Bench_Run(uint8_t Workers, uint16_t Sensors, uint16_t Passes,
+          double MinSeconds, Bench_Result_t *Result)
+{
+  Bench_Sensor_t *Sensor = NULL;
+  ADXL345_PoolBurst_t *Burst = NULL;
+  uint32_t Sequence = 0;
+  double Start = 0;
+  uint16_t s = 0;
+  uint16_t b = 0;
+  uint8_t i = 0;
+
+  memset(Result, 0, sizeof(Bench_Result_t));
+  memset(Bench_Sensor, 0, Sensors * sizeof(Bench_Sensor_t));
+
+  if (ADXL345_Pool_Init(&Bench_Pool, Workers) != ADXL345_OK)
+    return -1;
+
+  for (s = 0; s < Sensors; s++)
+  {
+    Sensor = &Bench_Sensor[s];
+    Sensor->Passes = Passes;
+    ADXL345_StatsQ_Init(&Sensor->Stats, 256);
+    if (ADXL345_Pool_AddSensor(&Bench_Pool, &Sensor->PoolSensor,
+                               Bench_Process, Sensor) != ADXL345_OK)
+      return -1;
+  }
+
+  Start = Bench_Seconds();
+  do
+  {
+    // Bursts of all sensors interleave, as drains of a fleet would
+    for (b = 0; b < BENCH_BURSTS; b++)
+    {
+      for (s = 0; s < Sensors; s++)
+      {
+        Burst = &Bench_Sensor[s].Burst[b];
+        Burst->Raw = Bench_Raw[(s + Sequence / BENCH_BURST_LEN + b) %
+                               BENCH_CAPTURES];
+        Burst->Count = BENCH_BURST_LEN;
+        Burst->DataFormat = Bench_DataFormat;
+        Burst->Gap = 0;
+        Burst->Sequence = Sequence + b * BENCH_BURST_LEN;
+        Burst->TimestampUs = 0;
+        ADXL345_Pool_Submit(&Bench_Pool, &Bench_Sensor[s].PoolSensor, Burst);
+      }
+    }
+    ADXL345_Pool_Drain(&Bench_Pool);
+
+    Sequence += BENCH_BURSTS * BENCH_BURST_LEN;
+    Result->Bursts += (uint64_t)BENCH_BURSTS * Sensors;
+    Result->Seconds = Bench_Seconds() - Start;
+  } while (Result->Seconds < MinSeconds);
+
+  for (i = 0; i < Workers; i++)
+    Result->Steals += Bench_Pool.Worker[i].Stats.Steals;
+  for (s = 0; s < Sensors; s++)
+    Result->Disorder += Bench_Sensor[s].Disorder;
+
+  ADXL345_Pool_DeInit(&Bench_Pool);
+
+  return 0;
+}
+
+
+static void
+Bench_Usage(const char *Name)
+{
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  -j N        max workers (default: online CPUs, up to %d)\n"
+          "  -s N        sensors (default 64, up to %d)\n"
+          "  -p N        statistics passes per burst (default 4)\n"
+          "  -d SEC      wall time per run (default 1)\n",
+          Name, ADXL345_POOL_MAX_WORKERS, BENCH_MAX_SENSORS);
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+int
+main(int argc, char **argv)
+{
+  Bench_Result_t Result;
+  long Online = sysconf(_SC_NPROCESSORS_ONLN);
+  uint8_t MaxWorkers = 0;
+  uint16_t Sensors = 64;
+  uint16_t Passes = 4;
+  double MinSeconds = 1.0;
+  double Rate = 0;
+  double Base = 0;
+  uint8_t Workers = 0;
+  int Failed = 0;
+  int Opt = 0;
+
+  MaxWorkers = (uint8_t)((Online < 1) ? 1 :
+                         (Online > ADXL345_POOL_MAX_WORKERS) ?
+                         ADXL345_POOL_MAX_WORKERS : Online);
+
+  while ((Opt = getopt(argc, argv, "j:s:p:d:h")) != -1)
+  {
+    switch (Opt)
+    {
+    case 'j':
+      MaxWorkers = (uint8_t)atoi(optarg);
+      break;
+    case 's':
+      Sensors = (uint16_t)atoi(optarg);
+      break;
+    case 'p':
+      Passes = (uint16_t)atoi(optarg);
+      break;
+    case 'd':
+      MinSeconds = atof(optarg);
+      break;
+    default:
+      Bench_Usage(argv[0]);
+      return 2;
+    }
+  }
+
+  if (MaxWorkers < 1 || MaxWorkers > ADXL345_POOL_MAX_WORKERS ||
+      Sensors < 1 || Sensors > BENCH_MAX_SENSORS)
+  {
+    Bench_Usage(argv[0]);
+    return 2;
+  }
+
+  if (Bench_Capture() != 0)
+  {
+    fprintf(stderr, "capture failed\n");
+    return 1;
+  }
+
+  printf("%u sensors, %d-sample bursts, %u statistics passes per burst, "
+         "%ld online CPUs\n", Sensors, BENCH_BURST_LEN, Passes, Online);
+  printf("%7s %12s %14s %8s %10s %8s %9s\n", "workers", "bursts/s",
+         "samples/s", "speedup", "efficiency", "steals", "disorder");
+
+  for (Workers = 1; Workers <= MaxWorkers; Workers <<= 1)
+  {
+    if (Bench_Run(Workers, Sensors, Passes, MinSeconds, &Result) != 0)
+    {
+      fprintf(stderr, "pool failed\n");
+      return 1;
+    }
+
+    Rate = Result.Bursts / Result.Seconds;
+    if (Workers == 1)
+      Base = Rate;
+    if (Result.Disorder)
+      Failed = 1;
+
+    printf("%7u %12.0f %14.0f %7.2fx %9.0f%% %8lu %9lu\n", Workers, Rate,
+           Rate * BENCH_BURST_LEN, Rate / Base,
+           100.0 * Rate / Base / Workers, (unsigned long)Result.Steals,
+           (unsigned long)Result.Disorder);
+
+    // Also run the exact CPU count when it is not a power of 2
+    if (Workers < MaxWorkers && (Workers << 1) > MaxWorkers)
+      Workers = MaxWorkers >> 1;
+  }
+
+  return Failed;
+}
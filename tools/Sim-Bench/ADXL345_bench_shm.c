@@ -0,0 +1,676 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_bench_shm.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Shared-memory ring against Unix socket fan-out benchmark
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Feature Test Macros ----------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "ADXL345.h"
+#include "ADXL345_stream.h"
+#include "ADXL345_shm.h"
+#include "ADXL345_platform.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define BENCH_RING_NAME     "/adxl345_bench"
+#define BENCH_CTL_NAME      "/adxl345_bench_ctl"
+#define BENCH_MAX_READERS   16
+// Samples captured from the simulator and published over and over
+#define BENCH_CAPTURE       4096
+// Samples per read() of a socket reader
+#define BENCH_READ          4096
+// Latency histogram in 1 us buckets, the last one holds all above
+#define BENCH_HIST          100000
+
+
+/* Private Data Types -----------------------------------------------------------*/
+typedef struct Bench_Capture_s
+{
+  ADXL345_Sample_t *Samples;
+  uint32_t Count;
+} Bench_Capture_t;
+
+typedef struct Bench_Reader_s
+{
+  uint64_t Delivered;
+  uint64_t Dropped;
+  uint64_t Errors;          // samples that differ from the published ones
+  uint64_t CpuNs;
+  uint64_t Switches;
+  uint64_t Latencies;
+  uint64_t LatencySumNs;
+  uint64_t LatencyMaxNs;
+  uint32_t Histogram[BENCH_HIST];
+} Bench_Reader_t;
+
+/**
+ * Shared by the producer and the reader processes. PublishNs holds the
+ * time each batch was handed to the transport.
+ */
+typedef struct Bench_Shared_s
+{
+  volatile uint32_t Ready;
+  volatile uint32_t Done;
+  Bench_Reader_t Reader[BENCH_MAX_READERS];
+  volatile uint64_t PublishNs[];
+} Bench_Shared_t;
+
+typedef struct Bench_Config_s
+{
+  uint32_t Readers;
+  uint32_t Batch;
+  uint32_t RingSize;
+  uint64_t Batches;
+  uint64_t BatchNs;
+} Bench_Config_t;
+
+typedef struct Bench_Result_s
+{
+  uint64_t ProducerCpuNs;
+  uint64_t Delivered;
+  uint64_t Dropped;
+  uint64_t Errors;
+  uint64_t CpuNs;
+  uint64_t Switches;
+  uint64_t Latencies;
+  uint64_t LatencySumNs;
+  uint64_t LatencyMaxNs;
+  uint64_t LatencyP99Ns;
+  double Seconds;
+} Bench_Result_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static ADXL345_Sample_t Bench_Samples[BENCH_CAPTURE];
+static ADXL345_Sample_t Bench_Buffer[BENCH_READ];
+static Bench_Shared_t *Bench_Ctl;
+static size_t Bench_CtlSize;
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static uint64_t
+Bench_Ns(void)
+{
+  struct timespec Now;
+
+  clock_gettime(CLOCK_MONOTONIC, &Now);
+  return (uint64_t)Now.tv_sec * 1000000000ULL + (uint64_t)Now.tv_nsec;
+}
+
+
+static void
+Bench_CpuUsage(struct rusage *Usage, uint64_t *CpuNs, uint64_t *Switches)
+{
+  getrusage(RUSAGE_SELF, Usage);
+  *CpuNs = (uint64_t)(Usage->ru_utime.tv_sec + Usage->ru_stime.tv_sec) *
+           1000000000ULL +
+           (uint64_t)(Usage->ru_utime.tv_usec + Usage->ru_stime.tv_usec) * 1000;
+  *Switches = (uint64_t)(Usage->ru_nvcsw + Usage->ru_nivcsw);
+}
+
+
+static void
+Bench_Sink(void *SinkContext, ADXL345_Batch_t *Batch)
+{
+  Bench_Capture_t *Capture = (Bench_Capture_t *)SinkContext;
+  uint8_t i = 0;
+
+  for (i = 0; i < Batch->Count; i++)
+  {
+    if (Capture->Count < BENCH_CAPTURE)
+      Capture->Samples[Capture->Count++] = Batch->Samples[i];
+  }
+}
+
+
+static int
+Bench_Capture(void)
+{
+  static ADXL345_Handler_t Handler;
+  static ADXL345_Stream_t Stream;
+  ADXL345_StreamConfig_t Config;
+  Bench_Capture_t Capture;
+  int16_t Device = 0;
+
+  ADXL345_Sim_Reset();
+  Device = ADXL345_Sim_AddDevice(0x53, 0, 0, 50000);
+  ADXL345_Platform_Init(&Handler);
+  if (ADXL345_Init(&Handler) != ADXL345_OK)
+    return -1;
+  ADXL345_SetAddressI2C(&Handler, 0);
+
+  memset(&Config, 0, sizeof(ADXL345_StreamConfig_t));
+  Config.Rate = ADXL345_RATE_3200;
+  Config.Range = ADXL345_RANGE_16G;
+  Config.FullResolution = 1;
+  Config.Mode = ADXL345_MODE_STREAM;
+  Config.WatermarkSamples = 16;
+  Config.Pin = ADXL345_INTERRUPT_PIN1;
+  if (ADXL345_Stream_Init(&Stream, &Handler, &Config) != ADXL345_OK)
+    return -1;
+
+  Capture.Samples = Bench_Samples;
+  Capture.Count = 0;
+  Stream.Sink = Bench_Sink;
+  Stream.SinkContext = &Capture;
+  Stream.GetTimeUs = ADXL345_Sim_GetTimeUs;
+  if (ADXL345_Stream_Start(&Stream) != ADXL345_OK)
+    return -1;
+
+  while (Capture.Count < BENCH_CAPTURE)
+  {
+    if (!ADXL345_Sim_IntPin(Device, 1))
+    {
+      ADXL345_Sim_AdvanceUs(10);
+      continue;
+    }
+    if (ADXL345_Stream_IRQ(&Stream) != ADXL345_OK)
+      return -1;
+    ADXL345_Stream_Process(&Stream);
+  }
+
+  ADXL345_Stream_Stop(&Stream);
+  ADXL345_DeInit(&Handler);
+
+  return 0;
+}
+
+
+static int
+Bench_CtlCreate(uint64_t Batches)
+{
+  int Fd = shm_open(BENCH_CTL_NAME, O_CREAT | O_TRUNC | O_RDWR, 0600);
+  void *Map = NULL;
+
+  if (Fd < 0)
+    return -1;
+
+  Bench_CtlSize = sizeof(Bench_Shared_t) + Batches * sizeof(uint64_t);
+  if (ftruncate(Fd, (off_t)Bench_CtlSize) != 0)
+  {
+    close(Fd);
+    shm_unlink(BENCH_CTL_NAME);
+    return -1;
+  }
+
+  Map = mmap(NULL, Bench_CtlSize, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+  close(Fd);
+  shm_unlink(BENCH_CTL_NAME);
+  if (Map == MAP_FAILED)
+    return -1;
+
+  Bench_Ctl = (Bench_Shared_t *)Map;
+
+  return 0;
+}
+
+
+/**
+ * Number of samples that differ from the published ones, which repeat the
+ * capture from sequence 0
+ */
+static uint32_t
+Bench_Check(const ADXL345_Sample_t *Samples, uint32_t Count,
+            uint64_t Sequence)
+{
+  const ADXL345_Sample_t *Expected = NULL;
+  uint32_t Errors = 0;
+  uint32_t i = 0;
+
+  for (i = 0; i < Count; i++)
+  {
+    Expected = &Bench_Samples[(Sequence + i) % BENCH_CAPTURE];
+    if (Samples[i].RawX != Expected->RawX ||
+        Samples[i].RawY != Expected->RawY ||
+        Samples[i].RawZ != Expected->RawZ)
+      Errors++;
+  }
+
+  return Errors;
+}
+
+
+/**
+ * Record the latency of every batch completed by the samples received up
+ * to End
+ */
+static void
+Bench_Latency(Bench_Reader_t *Result, const Bench_Config_t *Config,
+              uint64_t End, uint64_t *NextBatch)
+{
+  uint64_t Now = Bench_Ns();
+  uint64_t Ns = 0;
+
+  for (; (*NextBatch + 1) * Config->Batch <= End; (*NextBatch)++)
+  {
+    Ns = Now - Bench_Ctl->PublishNs[*NextBatch];
+    Result->Histogram[(Ns / 1000 < BENCH_HIST) ? Ns / 1000 : BENCH_HIST - 1]++;
+    Result->Latencies++;
+    Result->LatencySumNs += Ns;
+    if (Ns > Result->LatencyMaxNs)
+      Result->LatencyMaxNs = Ns;
+  }
+}
+
+
+static void
+Bench_ShmReader(Bench_Reader_t *Result, const Bench_Config_t *Config)
+{
+  ADXL345_ShmReader_t Reader;
+  ADXL345_ShmView_t View;
+  struct rusage Usage;
+  uint64_t NextBatch = 0;
+  uint32_t Errors = 0;
+
+  if (ADXL345_Shm_Open(&Reader, BENCH_RING_NAME) != ADXL345_OK)
+    _exit(1);
+  __atomic_add_fetch(&Bench_Ctl->Ready, 1, __ATOMIC_SEQ_CST);
+
+  while (!Bench_Ctl->Done || Reader.Cursor != Reader.Shm.Ring->Head)
+  {
+    if (ADXL345_Shm_Wait(&Reader, 1, 100) != ADXL345_OK)
+      continue;
+
+    while (ADXL345_Shm_Peek(&Reader, &View, 1, Config->RingSize) == ADXL345_OK)
+    {
+      // Batches with lost samples have no latency
+      if (View.Sequence > NextBatch * Config->Batch)
+        NextBatch = (View.Sequence + Config->Batch - 1) / Config->Batch;
+
+      // Samples are used in place
+      Errors = Bench_Check(View.Samples, View.Count, View.Sequence);
+      if (ADXL345_Shm_Release(&Reader, &View) == ADXL345_OK)
+      {
+        Result->Errors += Errors;
+        Bench_Latency(Result, Config, View.Sequence + View.Count, &NextBatch);
+      }
+    }
+  }
+
+  Result->Delivered = Reader.Stats.Delivered;
+  // Lagged and overwritten samples
+  Result->Dropped = Reader.Cursor - Reader.Stats.Delivered;
+  Bench_CpuUsage(&Usage, &Result->CpuNs, &Result->Switches);
+  ADXL345_Shm_Close(&Reader.Shm);
+}
+
+
+static void
+Bench_SocketReader(Bench_Reader_t *Result, const Bench_Config_t *Config,
+                   int Fd)
+{
+  uint8_t *Buffer = (uint8_t *)Bench_Buffer;
+  struct rusage Usage;
+  uint64_t Sequence = 0;
+  uint64_t NextBatch = 0;
+  size_t Fill = 0;
+  ssize_t Len = 0;
+  uint32_t Count = 0;
+
+  __atomic_add_fetch(&Bench_Ctl->Ready, 1, __ATOMIC_SEQ_CST);
+
+  while ((Len = read(Fd, Buffer + Fill, sizeof(Bench_Buffer) - Fill)) > 0)
+  {
+    Fill += (size_t)Len;
+    Count = (uint32_t)(Fill / sizeof(ADXL345_Sample_t));
+
+    Result->Errors += Bench_Check(Bench_Buffer, Count, Sequence);
+    Sequence += Count;
+    Bench_Latency(Result, Config, Sequence, &NextBatch);
+
+    // A sample split between two reads is kept for the next one
+    Fill -= Count * sizeof(ADXL345_Sample_t);
+    memmove(Buffer, Buffer + Count * sizeof(ADXL345_Sample_t), Fill);
+  }
+
+  Result->Delivered = Sequence;
+  Bench_CpuUsage(&Usage, &Result->CpuNs, &Result->Switches);
+}
+
+
+static int
+Bench_Write(int Fd, const void *Data, size_t Len)
+{
+  const uint8_t *Ptr = (const uint8_t *)Data;
+  ssize_t Written = 0;
+
+  while (Len)
+  {
+    Written = write(Fd, Ptr, Len);
+    if (Written <= 0)
+      return -1;
+    Ptr += Written;
+    Len -= (size_t)Written;
+  }
+
+  return 0;
+}
+
+
+/**
+ * Publish the batches to every reader process through the shared ring
+ * (Socket = 0) or through one Unix socket per reader, one batch each
+ * BatchNs
+ */
+static int
+Bench_Run(const Bench_Config_t *Config, uint8_t Socket, Bench_Result_t *Result)
+{
+  static uint32_t Histogram[BENCH_HIST];
+  ADXL345_Shm_t Shm;
+  Bench_Reader_t *Reader = NULL;
+  struct rusage Usage;
+  struct timespec Due;
+  pid_t Pid[BENCH_MAX_READERS];
+  int Fd[BENCH_MAX_READERS][2];
+  const ADXL345_Sample_t *Samples = NULL;
+  uint64_t StartNs = 0;
+  uint64_t DueNs = 0;
+  uint64_t StartCpuNs = 0;
+  uint64_t Switches = 0;
+  uint64_t Sequence = 0;
+  uint64_t Seen = 0;
+  uint64_t b = 0;
+  uint32_t r = 0;
+  uint32_t i = 0;
+  int Status = 0;
+  int Failed = 0;
+
+  memset(Result, 0, sizeof(Bench_Result_t));
+  memset(Bench_Ctl, 0, Bench_CtlSize);
+
+  if (!Socket &&
+      ADXL345_Shm_Create(&Shm, BENCH_RING_NAME, Config->RingSize) != ADXL345_OK)
+    return -1;
+
+  for (r = 0; r < Config->Readers; r++)
+  {
+    if (Socket && socketpair(AF_UNIX, SOCK_STREAM, 0, Fd[r]) != 0)
+      return -1;
+
+    Pid[r] = fork();
+    if (Pid[r] < 0)
+      return -1;
+    if (Pid[r] == 0)
+    {
+      if (Socket)
+      {
+        // Only the producer may hold write ends, or readers never see EOF
+        for (i = 0; i <= r; i++)
+          close(Fd[i][0]);
+        Bench_SocketReader(&Bench_Ctl->Reader[r], Config, Fd[r][1]);
+      }
+      else
+      {
+        Bench_ShmReader(&Bench_Ctl->Reader[r], Config);
+      }
+      _exit(0);
+    }
+    if (Socket)
+      close(Fd[r][1]);
+  }
+
+  while (__atomic_load_n(&Bench_Ctl->Ready, __ATOMIC_SEQ_CST) < Config->Readers)
+  {
+    Due.tv_sec = 0;
+    Due.tv_nsec = 1000000;
+    nanosleep(&Due, NULL);
+  }
+
+  Bench_CpuUsage(&Usage, &StartCpuNs, &Switches);
+  StartNs = Bench_Ns();
+  for (b = 0; b < Config->Batches && !Failed; b++)
+  {
+    DueNs = StartNs + b * Config->BatchNs;
+    if (Bench_Ns() < DueNs)
+    {
+      Due.tv_sec = (time_t)(DueNs / 1000000000ULL);
+      Due.tv_nsec = (long)(DueNs % 1000000000ULL);
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &Due, NULL);
+    }
+
+    Samples = &Bench_Samples[Sequence % BENCH_CAPTURE];
+    Bench_Ctl->PublishNs[b] = Bench_Ns();
+    if (Socket)
+    {
+      // Every reader gets its own copy through the kernel
+      for (r = 0; r < Config->Readers; r++)
+      {
+        if (Bench_Write(Fd[r][0], Samples,
+                        Config->Batch * sizeof(ADXL345_Sample_t)) != 0)
+          Failed = 1;
+      }
+    }
+    else
+    {
+      ADXL345_Shm_Publish(&Shm, Samples, Config->Batch, 0);
+    }
+    Sequence += Config->Batch;
+  }
+  Result->Seconds = (Bench_Ns() - StartNs) / 1e9;
+  Bench_CpuUsage(&Usage, &Result->ProducerCpuNs, &Switches);
+  Result->ProducerCpuNs -= StartCpuNs;
+
+  __atomic_store_n(&Bench_Ctl->Done, 1, __ATOMIC_SEQ_CST);
+  for (r = 0; Socket && r < Config->Readers; r++)
+    close(Fd[r][0]);
+
+  for (r = 0; r < Config->Readers; r++)
+  {
+    if (waitpid(Pid[r], &Status, 0) != Pid[r] ||
+        !WIFEXITED(Status) || WEXITSTATUS(Status) != 0)
+      Failed = 1;
+  }
+  if (!Socket)
+    ADXL345_Shm_Close(&Shm);
+
+  memset(Histogram, 0, sizeof(Histogram));
+  for (r = 0; r < Config->Readers; r++)
+  {
+    Reader = &Bench_Ctl->Reader[r];
+    Result->Delivered += Reader->Delivered;
+    Result->Dropped += Reader->Dropped;
+    Result->Errors += Reader->Errors;
+    Result->CpuNs += Reader->CpuNs;
+    Result->Switches += Reader->Switches;
+    Result->Latencies += Reader->Latencies;
+    Result->LatencySumNs += Reader->LatencySumNs;
+    if (Reader->LatencyMaxNs > Result->LatencyMaxNs)
+      Result->LatencyMaxNs = Reader->LatencyMaxNs;
+    for (i = 0; i < BENCH_HIST; i++)
+      Histogram[i] += Reader->Histogram[i];
+  }
+
+  for (i = 0; i < BENCH_HIST; i++)
+  {
+    Seen += Histogram[i];
+    if (Seen * 100 >= Result->Latencies * 99)
+      break;
+  }
+  Result->LatencyP99Ns = (uint64_t)(i + 1) * 1000;
+
+  return Failed ? -1 : 0;
+}
+
+
+static void
+Bench_Usage(const char *Name)
+{
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  -n N        reader processes (default 4, up to %d)\n"
+          "  -s N        sensors (default 16)\n"
+          "  -r HZ       samples/s of each sensor (default 3200)\n"
+          "  -b N        samples per published batch (default 32)\n"
+          "  -z N        ring size in samples (power of 2, default 65536)\n"
+          "  -d SEC      duration of each run (default 5)\n",
+          Name, BENCH_MAX_READERS);
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+int
+main(int argc, char **argv)
+{
+  static const char *Names[2] = {"shm ring", "unix socket"};
+  Bench_Config_t Config;
+  Bench_Result_t Result;
+  uint32_t Sensors = 16;
+  uint32_t RateHz = 3200;
+  double Seconds = 5;
+  double Rate = 0;
+  double Published = 0;
+  uint8_t Socket = 0;
+  int Failed = 0;
+  int Opt = 0;
+
+  memset(&Config, 0, sizeof(Config));
+  Config.Readers = 4;
+  Config.Batch = 32;
+  Config.RingSize = 65536;
+
+  while ((Opt = getopt(argc, argv, "n:s:r:b:z:d:h")) != -1)
+  {
+    switch (Opt)
+    {
+    case 'n':
+      Config.Readers = (uint32_t)atoi(optarg);
+      break;
+    case 's':
+      Sensors = (uint32_t)atoi(optarg);
+      break;
+    case 'r':
+      RateHz = (uint32_t)atoi(optarg);
+      break;
+    case 'b':
+      Config.Batch = (uint32_t)atoi(optarg);
+      break;
+    case 'z':
+      Config.RingSize = (uint32_t)atoi(optarg);
+      break;
+    case 'd':
+      Seconds = atof(optarg);
+      break;
+    default:
+      Bench_Usage(argv[0]);
+      return 2;
+    }
+  }
+
+  Rate = (double)Sensors * RateHz;
+  if (Config.Readers < 1 || Config.Readers > BENCH_MAX_READERS ||
+      Config.Batch < 1 || BENCH_CAPTURE % Config.Batch != 0 ||
+      Config.Batch > BENCH_READ || Config.RingSize < Config.Batch ||
+      (Config.RingSize & (Config.RingSize - 1)) || Rate <= 0 || Seconds <= 0)
+  {
+    Bench_Usage(argv[0]);
+    return 2;
+  }
+  Config.Batches = (uint64_t)(Rate * Seconds / Config.Batch);
+  Config.BatchNs = (uint64_t)(1e9 * Config.Batch / Rate);
+
+  if (Bench_Capture() != 0)
+  {
+    fprintf(stderr, "capture failed\n");
+    return 1;
+  }
+  if (Bench_CtlCreate(Config.Batches) != 0)
+  {
+    fprintf(stderr, "failed to create shared memory\n");
+    return 1;
+  }
+
+  // A reader that exits early must not kill the producer
+  signal(SIGPIPE, SIG_IGN);
+
+  printf("%lu readers, %.0f samples/s (%lu sensors x %lu Hz) in batches of "
+         "%lu, %lu-byte samples, %.1f s, %ld online CPUs\n",
+         (unsigned long)Config.Readers, Rate, (unsigned long)Sensors,
+         (unsigned long)RateHz, (unsigned long)Config.Batch,
+         (unsigned long)sizeof(ADXL345_Sample_t), Seconds,
+         sysconf(_SC_NPROCESSORS_ONLN));
+  printf("%-11s %9s %9s %7s %11s %9s %9s %9s %9s %7s\n", "", "producer",
+         "reader", "CPU", "switches/s", "latency", "p99", "max",
+         "delivered", "errors");
+  printf("%-11s %9s %9s %7s %11s %9s %9s %9s %9s %7s\n", "transport",
+         "ns/sample", "ns/sample", "", "per reader", "avg us", "us", "us",
+         "", "");
+
+  for (Socket = 0; Socket < 2; Socket++)
+  {
+    if (Bench_Run(&Config, Socket, &Result) != 0)
+    {
+      fprintf(stderr, "%s run failed\n", Names[Socket]);
+      Failed = 1;
+      continue;
+    }
+
+    Published = (double)Config.Batches * Config.Batch;
+    if (Result.Errors || Result.Delivered + Result.Dropped !=
+        (uint64_t)Published * Config.Readers)
+      Failed = 1;
+
+    printf("%-11s %9.1f %9.1f %6.1f%% %11.0f %9.1f %9.0f %9.0f %8.2f%% "
+           "%7lu\n", Names[Socket], Result.ProducerCpuNs / Published,
+           Result.Delivered ? (double)Result.CpuNs / Result.Delivered : 0.0,
+           100.0 * (Result.ProducerCpuNs + Result.CpuNs) / 1e9 / Result.Seconds,
+           Result.Switches / Result.Seconds / Config.Readers,
+           Result.Latencies ? Result.LatencySumNs / 1e3 / Result.Latencies : 0.0,
+           Result.LatencyP99Ns / 1e3, Result.LatencyMaxNs / 1e3,
+           100.0 * Result.Delivered / Published / Config.Readers,
+           (unsigned long)Result.Errors);
+  }
+
+  return Failed;
+}
@@ -0,0 +1,287 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_bench_stream.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Streaming engine throughput on the simulator
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Feature Test Macros ----------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200809L
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include "ADXL345.h"
+#include "ADXL345_stream.h"
+#include "ADXL345_platform.h"
+
+
+/* Private Data Types -----------------------------------------------------------*/
+/**
+ * The sink runs in a task that interrupts can preempt. It is busy for
+ * SinkUs per sample after each ADXL345_Stream_Process, and during that time
+ * drains can only land in the free slots.
+ */
+typedef struct Bench_Sink_s
+{
+  uint32_t SinkUs;
+  uint32_t Samples;
+  uint32_t Gaps;
+  uint32_t Dropped;
+  uint32_t CostUs;
+} Bench_Sink_t;
+
+typedef struct Bench_Result_s
+{
+  uint32_t Samples;
+  uint32_t Drains;
+  uint32_t Overruns;
+  uint32_t SlotOverflows;
+  uint32_t Lost;
+  uint32_t Gaps;
+  uint64_t BusyNs;
+  uint64_t CpuNs;
+} Bench_Result_t;
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static uint64_t
+Bench_CpuNs(void)
+{
+  struct timespec Now;
+
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &Now);
+  return (uint64_t)Now.tv_sec * 1000000000ULL + (uint64_t)Now.tv_nsec;
+}
+
+
+static void
+Bench_Sink(void *SinkContext, ADXL345_Batch_t *Batch)
+{
+  Bench_Sink_t *Sink = (Bench_Sink_t *)SinkContext;
+
+  Sink->Samples += Batch->Count;
+  Sink->CostUs += Sink->SinkUs * Batch->Count;
+  if (Batch->Gap)
+  {
+    Sink->Gaps++;
+    Sink->Dropped += Batch->Gap;
+  }
+}
+
+
+static int
+Bench_Run(ADXL345_Rate_t Rate, uint8_t Watermark, uint32_t LatencyUs,
+          uint32_t SinkUs, uint32_t DurationUs, Bench_Result_t *Result)
+{
+  static ADXL345_Handler_t Handler;
+  static ADXL345_Stream_t Stream;
+  ADXL345_StreamConfig_t Config;
+  ADXL345_SimStats_t SimStats;
+  ADXL345_SimBusStats_t Bus;
+  Bench_Sink_t Sink;
+  uint64_t CpuNs = 0;
+  uint64_t BusyNs = 0;
+  uint32_t EndUs = 0;
+  uint32_t TaskUs = 0;
+  int16_t Device = 0;
+
+  memset(Result, 0, sizeof(Bench_Result_t));
+
+  ADXL345_Sim_Reset();
+  Device = ADXL345_Sim_AddDevice(0x53, 0, 0, 50000);
+  ADXL345_Platform_Init(&Handler);
+  if (ADXL345_Init(&Handler) != ADXL345_OK)
+    return -1;
+  ADXL345_SetAddressI2C(&Handler, 0);
+
+  memset(&Config, 0, sizeof(ADXL345_StreamConfig_t));
+  Config.Rate = Rate;
+  Config.Range = ADXL345_RANGE_16G;
+  Config.FullResolution = 1;
+  Config.Mode = Watermark ? ADXL345_MODE_STREAM : ADXL345_MODE_BYPASS;
+  Config.WatermarkSamples = Watermark;
+  Config.Pin = ADXL345_INTERRUPT_PIN1;
+  if (ADXL345_Stream_Init(&Stream, &Handler, &Config) != ADXL345_OK)
+    return -1;
+
+  memset(&Sink, 0, sizeof(Bench_Sink_t));
+  Sink.SinkUs = SinkUs;
+  Stream.Sink = Bench_Sink;
+  Stream.SinkContext = &Sink;
+  Stream.GetTimeUs = ADXL345_Sim_GetTimeUs;
+  if (ADXL345_Stream_Start(&Stream) != ADXL345_OK)
+    return -1;
+
+  ADXL345_Sim_GetBusStats(&Bus);
+  BusyNs = Bus.BusyNs;
+  CpuNs = Bench_CpuNs();
+  EndUs = ADXL345_Sim_GetTimeUs() + DurationUs;
+  TaskUs = ADXL345_Sim_GetTimeUs();
+
+  while ((int32_t)(ADXL345_Sim_GetTimeUs() - EndUs) < 0)
+  {
+    if (ADXL345_Sim_IntPin(Device, 1))
+    {
+      ADXL345_Sim_AdvanceUs(LatencyUs);
+      if (ADXL345_Stream_IRQ(&Stream) != ADXL345_OK)
+        return -1;
+      continue;
+    }
+
+    // The sink task picks up decoded bursts once it is done with the last
+    if ((int32_t)(ADXL345_Sim_GetTimeUs() - TaskUs) >= 0 &&
+        Stream.Tail != Stream.Head)
+    {
+      Sink.CostUs = 0;
+      ADXL345_Stream_Process(&Stream);
+      TaskUs = ADXL345_Sim_GetTimeUs() + Sink.CostUs;
+      continue;
+    }
+
+    ADXL345_Sim_AdvanceUs(1);
+  }
+
+  ADXL345_Stream_Stop(&Stream);
+  ADXL345_Stream_Process(&Stream);
+
+  Result->CpuNs = Bench_CpuNs() - CpuNs;
+  ADXL345_Sim_GetBusStats(&Bus);
+  Result->BusyNs = Bus.BusyNs - BusyNs;
+  ADXL345_Sim_GetStats(Device, &SimStats);
+
+  Result->Samples = Sink.Samples;
+  Result->Gaps = Sink.Gaps;
+  Result->Drains = Stream.Stats.Drains;
+  Result->Overruns = Stream.Stats.Overruns;
+  Result->SlotOverflows = Stream.Stats.SlotOverflows;
+  Result->Lost = SimStats.Lost;
+
+  ADXL345_DeInit(&Handler);
+
+  return 0;
+}
+
+
+static void
+Bench_Usage(const char *Name)
+{
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  -r CODE     Data Rate code 0..15 (default 15 => 3200 Hz)\n"
+          "  -l US       host interrupt latency (default 20)\n"
+          "  -s US       sink cost per sample (default 20)\n"
+          "  -d SEC      simulated time per run (default 5)\n",
+          Name);
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+int
+main(int argc, char **argv)
+{
+  // Watermark 0 runs bypass mode with a drain per DATA_READY
+  static const uint8_t Watermarks[] = {0, 4, 8, 16, 24, 31};
+  ADXL345_Rate_t Rate = ADXL345_RATE_3200;
+  Bench_Result_t Result;
+  uint32_t LatencyUs = 20;
+  uint32_t SinkUs = 20;
+  uint32_t DurationUs = 5000000;
+  double Odr = 0;
+  double Seconds = 0;
+  uint8_t i = 0;
+  int Opt = 0;
+
+  while ((Opt = getopt(argc, argv, "r:l:s:d:h")) != -1)
+  {
+    switch (Opt)
+    {
+    case 'r':
+      Rate = (ADXL345_Rate_t)(atoi(optarg) & 0x0F);
+      break;
+    case 'l':
+      LatencyUs = (uint32_t)atoi(optarg);
+      break;
+    case 's':
+      SinkUs = (uint32_t)atoi(optarg);
+      break;
+    case 'd':
+      DurationUs = (uint32_t)(atof(optarg) * 1e6);
+      break;
+    default:
+      Bench_Usage(argv[0]);
+      return 2;
+    }
+  }
+
+  Odr = ADXL345_ConvToData_RateMilliHz(Rate) / 1000.0;
+  Seconds = DurationUs / 1e6;
+  printf("%.1f Hz, 400 kHz I2C, %d slots, %lu us latency, "
+         "%lu us sink per sample, %.1f s per run\n",
+         Odr, ADXL345_STREAM_SLOTS, (unsigned long)LatencyUs,
+         (unsigned long)SinkUs, Seconds);
+  printf("%-9s %10s %6s %8s %9s %8s %8s %6s %6s %10s\n", "watermark",
+         "samples/s", "% ODR", "drains/s", "overruns", "slot ovf", "lost",
+         "gaps", "bus %", "ns/sample");
+
+  for (i = 0; i < sizeof(Watermarks); i++)
+  {
+    if (Bench_Run(Rate, Watermarks[i], LatencyUs, SinkUs,
+                  DurationUs, &Result) != 0)
+    {
+      fprintf(stderr, "run failed\n");
+      return 1;
+    }
+
+    if (Watermarks[i])
+      printf("%-9u", Watermarks[i]);
+    else
+      printf("%-9s", "bypass");
+    printf(" %10.1f %5.1f%% %8.1f %9lu %8lu %8lu %6lu %5.1f%% %10.0f\n",
+           Result.Samples / Seconds, Result.Samples * 100.0 / Seconds / Odr,
+           Result.Drains / Seconds, (unsigned long)Result.Overruns,
+           (unsigned long)Result.SlotOverflows, (unsigned long)Result.Lost,
+           (unsigned long)Result.Gaps, Result.BusyNs / 1e7 / Seconds,
+           Result.Samples ? (double)Result.CpuNs / Result.Samples : 0.0);
+  }
+
+  return 0;
+}
@@ -0,0 +1,290 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_bench_wmctrl.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Adaptive watermark controller under host load on the simulator
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "ADXL345.h"
+#include "ADXL345_stream.h"
+#include "ADXL345_platform.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+// Watermark 0 runs the adaptive controller
+#define BENCH_ADAPTIVE      0
+#define BENCH_PHASES        4
+
+
+/* Private Data Types -----------------------------------------------------------*/
+/**
+ * The host answers an interrupt after BaseUs, and with StallPermille chance
+ * after an extra stall of up to StallUs (another task holding the CPU).
+ */
+typedef struct Bench_Load_s
+{
+  const char *Name;
+  uint32_t BaseUs;
+  uint16_t StallPermille;
+  uint32_t StallUs;
+} Bench_Load_t;
+
+typedef struct Bench_Result_s
+{
+  uint32_t Drains;
+  uint32_t Overruns;
+  uint32_t Lost;
+  uint32_t BudgetMisses;
+  uint64_t WatermarkSum;
+} Bench_Result_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static const Bench_Load_t Bench_Load[BENCH_PHASES] =
+{
+  {"idle",   20,   0,    0},
+  {"busy",   50, 100, 2000},
+  {"heavy", 100, 300, 6000},
+  {"idle",   20,   0,    0},
+};
+
+static uint32_t Bench_Random = 1;
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static uint32_t
+Bench_Rand(void)
+{
+  // xorshift32, so every run sees the same load
+  Bench_Random ^= Bench_Random << 13;
+  Bench_Random ^= Bench_Random >> 17;
+  Bench_Random ^= Bench_Random << 5;
+  return Bench_Random;
+}
+
+
+static void
+Bench_NullSink(void *SinkContext, ADXL345_Batch_t *Batch)
+{
+  (void)SinkContext;
+  (void)Batch;
+}
+
+
+static int
+Bench_Run(ADXL345_Rate_t Rate, uint8_t Watermark, uint32_t BudgetUs,
+          uint32_t PhaseUs, Bench_Result_t *Result)
+{
+  static ADXL345_Handler_t Handler;
+  static ADXL345_Stream_t Stream;
+  static ADXL345_WatermarkCtrl_t Ctrl;
+  ADXL345_StreamConfig_t Config;
+  ADXL345_SimStats_t SimStats;
+  const Bench_Load_t *Load = NULL;
+  uint32_t PeriodUs = ADXL345_ConvToData_RatePeriodUs(Rate);
+  uint32_t EndUs = 0;
+  uint32_t EventUs = 0;
+  uint32_t Lost = 0;
+  uint32_t Overruns = 0;
+  uint8_t Current = 0;
+  int16_t Device = 0;
+  uint8_t Phase = 0;
+
+  memset(Result, 0, BENCH_PHASES * sizeof(Bench_Result_t));
+  Bench_Random = 1;
+
+  ADXL345_Sim_Reset();
+  Device = ADXL345_Sim_AddDevice(0x53, 0, 0, 50000);
+  ADXL345_Platform_Init(&Handler);
+  if (ADXL345_Init(&Handler) != ADXL345_OK)
+    return -1;
+  ADXL345_SetAddressI2C(&Handler, 0);
+
+  memset(&Config, 0, sizeof(ADXL345_StreamConfig_t));
+  Config.Rate = Rate;
+  Config.Range = ADXL345_RANGE_16G;
+  Config.Mode = ADXL345_MODE_STREAM;
+  Config.WatermarkSamples = Watermark ? Watermark : 16;
+  Config.Pin = ADXL345_INTERRUPT_PIN1;
+  if (ADXL345_Stream_Init(&Stream, &Handler, &Config) != ADXL345_OK)
+    return -1;
+  Stream.Sink = Bench_NullSink;
+  Stream.GetTimeUs = ADXL345_Sim_GetTimeUs;
+
+  if (Watermark == BENCH_ADAPTIVE)
+  {
+    if (ADXL345_WatermarkCtrl_Init(&Ctrl, Rate, BudgetUs) != ADXL345_OK)
+      return -1;
+    Stream.WatermarkCtrl = &Ctrl;
+  }
+
+  if (ADXL345_Stream_Start(&Stream) != ADXL345_OK)
+    return -1;
+
+  for (Phase = 0; Phase < BENCH_PHASES; Phase++)
+  {
+    Load = &Bench_Load[Phase];
+    EndUs = ADXL345_Sim_GetTimeUs() + PhaseUs;
+
+    while ((int32_t)(ADXL345_Sim_GetTimeUs() - EndUs) < 0)
+    {
+      if (!ADXL345_Sim_IntPin(Device, 1))
+      {
+        ADXL345_Sim_AdvanceUs(1);
+        continue;
+      }
+
+      EventUs = ADXL345_Sim_GetTimeUs();
+      ADXL345_Sim_AdvanceUs(Load->BaseUs);
+      if (Load->StallPermille && Bench_Rand() % 1000 < Load->StallPermille)
+        ADXL345_Sim_AdvanceUs(Bench_Rand() % Load->StallUs);
+
+      Current = Stream.FifoConfig.WatermarkSamples;
+      // The controller sees the host latency from the interrupt on
+      if (ADXL345_Stream_IRQAt(&Stream, EventUs) != ADXL345_OK)
+        return -1;
+      ADXL345_Stream_Process(&Stream);
+
+      // The oldest entry was stored Watermark periods before the interrupt
+      Result[Phase].Drains++;
+      Result[Phase].WatermarkSum += Current;
+      if (ADXL345_Sim_GetTimeUs() - EventUs + Current * PeriodUs > BudgetUs)
+        Result[Phase].BudgetMisses++;
+    }
+
+    ADXL345_Sim_GetStats(Device, &SimStats);
+    Result[Phase].Lost = SimStats.Lost - Lost;
+    Result[Phase].Overruns = Stream.Stats.Overruns - Overruns;
+    Lost = SimStats.Lost;
+    Overruns = Stream.Stats.Overruns;
+  }
+
+  ADXL345_Stream_Stop(&Stream);
+  ADXL345_DeInit(&Handler);
+
+  return 0;
+}
+
+
+static void
+Bench_Usage(const char *Name)
+{
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  -r CODE     Data Rate code 0..15 (default 14 => 1600 Hz)\n"
+          "  -b US       latency budget of the controller (default 20000)\n"
+          "  -d SEC      simulated time per load phase (default 2)\n",
+          Name);
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+int
+main(int argc, char **argv)
+{
+  static const uint8_t Watermarks[] = {BENCH_ADAPTIVE, 4, 16, 28};
+  ADXL345_Rate_t Rate = ADXL345_RATE_1600;
+  Bench_Result_t Result[BENCH_PHASES];
+  uint32_t BudgetUs = 20000;
+  uint32_t PhaseUs = 2000000;
+  char Name[16];
+  uint8_t Phase = 0;
+  uint8_t i = 0;
+  int Opt = 0;
+
+  while ((Opt = getopt(argc, argv, "r:b:d:h")) != -1)
+  {
+    switch (Opt)
+    {
+    case 'r':
+      Rate = (ADXL345_Rate_t)(atoi(optarg) & 0x0F);
+      break;
+    case 'b':
+      BudgetUs = (uint32_t)atoi(optarg);
+      break;
+    case 'd':
+      PhaseUs = (uint32_t)(atof(optarg) * 1e6);
+      break;
+    default:
+      Bench_Usage(argv[0]);
+      return 2;
+    }
+  }
+
+  printf("%.1f Hz, 400 kHz I2C, %lu us latency budget, load phases:",
+         ADXL345_ConvToData_RateMilliHz(Rate) / 1000.0,
+         (unsigned long)BudgetUs);
+  for (Phase = 0; Phase < BENCH_PHASES; Phase++)
+    printf(" %s", Bench_Load[Phase].Name);
+  printf("\n%-9s %-6s %8s %7s %9s %8s %8s\n", "watermark", "load",
+         "int/s", "avg wm", "overruns", "lost", "over budget");
+
+  for (i = 0; i < sizeof(Watermarks); i++)
+  {
+    if (Bench_Run(Rate, Watermarks[i], BudgetUs, PhaseUs, Result) != 0)
+    {
+      fprintf(stderr, "run failed\n");
+      return 1;
+    }
+
+    if (Watermarks[i] == BENCH_ADAPTIVE)
+      snprintf(Name, sizeof(Name), "adaptive");
+    else
+      snprintf(Name, sizeof(Name), "fixed %u", Watermarks[i]);
+
+    for (Phase = 0; Phase < BENCH_PHASES; Phase++)
+    {
+      printf("%-9s %-6s %8.1f %7.1f %9lu %8lu %8.1f%%\n",
+             Phase ? "" : Name, Bench_Load[Phase].Name,
+             Result[Phase].Drains * 1e6 / PhaseUs,
+             Result[Phase].Drains ?
+             (double)Result[Phase].WatermarkSum / Result[Phase].Drains : 0.0,
+             (unsigned long)Result[Phase].Overruns,
+             (unsigned long)Result[Phase].Lost,
+             Result[Phase].Drains ?
+             Result[Phase].BudgetMisses * 100.0 / Result[Phase].Drains : 0.0);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,323 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_check_capture.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Trigger boundary of the capture engine on the simulator
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "ADXL345.h"
+#include "ADXL345_capture.h"
+#include "ADXL345_platform.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define CHECK_PI            3.14159265358979323846
+// The signal runs at ODR / CHECK_CYCLE, so sample s has phase 2*pi*s/50
+#define CHECK_CYCLE         50
+// Phase tolerance; a sample off by one is 0.126 rad off
+#define CHECK_TOLERANCE     0.06
+#define CHECK_RUN_US        2000000
+// Triggers come 0..CHECK_SPREAD samples after the earliest allowed time
+#define CHECK_SPREAD        40
+#define CHECK_MAX_SAMPLES   256
+
+
+/* Private Data Types -----------------------------------------------------------*/
+typedef struct Check_Case_s
+{
+  ADXL345_Rate_t Rate;
+  uint8_t FifoSamples;
+  uint16_t PreSamples;
+  uint16_t PostSamples;
+  // The ISR runs this long after the interrupt pin goes active
+  uint32_t LatencyUs;
+  // Pass the time of the pin edge to ADXL345_Capture_IRQAt
+  uint8_t UseIRQAt;
+  // Samples after arming before a trigger is raised
+  uint16_t ArmedSamples;
+  // Windows are delivered every ProcessEveryUs (0 => right away)
+  uint32_t ProcessEveryUs;
+} Check_Case_t;
+
+typedef struct Check_Result_s
+{
+  const Check_Case_t *Case;
+  uint32_t TriggerAt;     // simulator index of the sample of the trigger
+  uint32_t Windows;
+  uint32_t ShortPre;
+  uint32_t ShortPost;
+  uint32_t Misaligned;
+} Check_Result_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static uint32_t Check_Random = 2463534242u;
+
+static const Check_Case_t Check_Cases[] =
+{
+  // FIFO runs as a ring while armed
+  {ADXL345_RATE_800,   20,  20,   64,   200,   0,  21,  0},
+  {ADXL345_RATE_1600,  31,  10,  100,   500,   0,  32,  0},
+  {ADXL345_RATE_3200,  12,  12,   40,  1000,   1,   0,  0},
+  // FIFO is drained into the history while armed
+  {ADXL345_RATE_800,   16,  64,   64,  3000,   1,  64,  0},
+  {ADXL345_RATE_1600,   8,  40,   40,   700,   1,  40,  0},
+  {ADXL345_RATE_1600,  16,  40,   40,   800,   1,   0,  0},
+  {ADXL345_RATE_800,   16,  48,   32,   100,   1,  48,  100000},
+};
+
+static ADXL345_Sample_t Check_History[CHECK_MAX_SAMPLES];
+static ADXL345_Sample_t Check_Buffer[CHECK_MAX_SAMPLES];
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static uint32_t
+Check_Jitter(uint32_t Max)
+{
+  Check_Random ^= Check_Random << 13;
+  Check_Random ^= Check_Random >> 17;
+  Check_Random ^= Check_Random << 5;
+
+  return Max ? Check_Random % (Max + 1) : 0;
+}
+
+
+static void
+Check_Window(void *Context, ADXL345_CaptureWindow_t *Window)
+{
+  Check_Result_t *Result = (Check_Result_t *)Context;
+  uint32_t Index = 0;
+  double Phase = 0;
+  double Error = 0;
+  uint16_t i = 0;
+
+  Result->Windows++;
+
+  // The simulator outputs A*sin on X and A*cos on Y. The last pre-trigger
+  // sample is the one that fired the trigger.
+  for (i = 0; i < Window->PreCount + Window->PostCount; i++)
+  {
+    Index = Result->TriggerAt + 1 - Window->PreCount + i;
+    Phase = atan2(Window->Samples[i].RawX, Window->Samples[i].RawY);
+    Error = Phase - 2 * CHECK_PI * (Index % CHECK_CYCLE) / CHECK_CYCLE;
+    while (Error < -CHECK_PI)
+      Error += 2 * CHECK_PI;
+    while (Error >= CHECK_PI)
+      Error -= 2 * CHECK_PI;
+    if (fabs(Error) > CHECK_TOLERANCE)
+    {
+      Result->Misaligned++;
+      break;
+    }
+  }
+
+  if (Window->PreCount < Result->Case->PreSamples)
+    Result->ShortPre++;
+  if (Window->PostCount != Result->Case->PostSamples)
+    Result->ShortPost++;
+}
+
+
+static int
+Check_Run(const Check_Case_t *Case)
+{
+  ADXL345_Handler_t Handler;
+  ADXL345_Capture_t Capture;
+  ADXL345_CaptureConfig_t Config;
+  ADXL345_SimStats_t SimStats;
+  Check_Result_t Result;
+  uint32_t PeriodUs = ADXL345_ConvToData_RatePeriodUs(Case->Rate);
+  uint32_t EndUs = 0;
+  uint32_t NowUs = 0;
+  uint32_t PinUs = 0;
+  uint32_t ArmedUs = 0;
+  uint32_t RaiseUs = 0;
+  uint32_t ProcessUs = 0;
+  uint32_t Raised = 0;
+  uint32_t Missed = 0;
+  uint32_t Short = 0;
+  uint8_t Ready = 0;
+  uint8_t PinWas = 0;
+  uint8_t Pin = 0;
+  int16_t Device = 0;
+  int Failed = 0;
+
+  ADXL345_Sim_Reset();
+  memset(&Result, 0, sizeof(Check_Result_t));
+  Result.Case = Case;
+  Device = ADXL345_Sim_AddDevice(0x53, 0, 0,
+                                 ADXL345_ConvToData_RateMilliHz(Case->Rate) /
+                                 CHECK_CYCLE);
+
+  ADXL345_Platform_Init(&Handler);
+  if (ADXL345_Init(&Handler) != ADXL345_OK)
+    return -1;
+  ADXL345_SetAddressI2C(&Handler, 0);
+
+  memset(&Config, 0, sizeof(ADXL345_CaptureConfig_t));
+  Config.Rate = Case->Rate;
+  Config.Range = ADXL345_RANGE_16G;
+  Config.FullResolution = 1;
+  Config.Pin = ADXL345_INTERRUPT_PIN1;
+  Config.Events.Activity = 1;
+  Config.FifoSamples = Case->FifoSamples;
+  Config.PreSamples = Case->PreSamples;
+  Config.PostSamples = Case->PostSamples;
+
+  if (ADXL345_Capture_Init(&Capture, &Handler, &Config,
+                           Check_History, Check_Buffer) != ADXL345_OK)
+    return -1;
+  Capture.Callback = Check_Window;
+  Capture.Context = &Result;
+  Capture.GetTimeUs = ADXL345_Sim_GetTimeUs;
+
+  if (ADXL345_Capture_Start(&Capture) != ADXL345_OK)
+    return -1;
+
+  NowUs = ADXL345_Sim_GetTimeUs();
+  EndUs = NowUs + CHECK_RUN_US;
+  ArmedUs = NowUs;
+  RaiseUs = NowUs + (Case->ArmedSamples + Check_Jitter(CHECK_SPREAD)) *
+                    PeriodUs;
+  ProcessUs = NowUs + Case->ProcessEveryUs;
+
+  while ((int32_t)(NowUs - EndUs) < 0)
+  {
+    Pin = ADXL345_Sim_IntPin(Device, 1);
+    if (Pin && !PinWas)
+      PinUs = NowUs;
+    PinWas = Pin;
+
+    if (Pin && (NowUs - PinUs) >= Case->LatencyUs)
+    {
+      Ready = Capture.Ready;
+      Missed = Capture.Stats.MissedTriggers;
+      if (Case->UseIRQAt)
+        ADXL345_Capture_IRQAt(&Capture, PinUs);
+      else
+        ADXL345_Capture_IRQ(&Capture);
+
+      ADXL345_Sim_GetStats(Device, &SimStats);
+      if (!Ready && Capture.Ready)
+        Result.TriggerAt = SimStats.TriggerAt;
+
+      // Every trigger ends with a re-arm
+      if (Capture.Stats.MissedTriggers != Missed ||
+          (!Ready && Capture.Ready))
+      {
+        ArmedUs = ADXL345_Sim_GetTimeUs();
+        RaiseUs = ArmedUs + (Case->ArmedSamples +
+                             Check_Jitter(CHECK_SPREAD)) * PeriodUs;
+      }
+      PinWas = 0;
+    }
+
+    if (!Case->ProcessEveryUs ||
+        (int32_t)(ADXL345_Sim_GetTimeUs() - ProcessUs) >= 0)
+    {
+      ADXL345_Capture_Process(&Capture);
+      ProcessUs += Case->ProcessEveryUs;
+    }
+
+    // One trigger at a time, raised while FIFO has just been serviced. With
+    // delayed delivery the next ones are missed.
+    NowUs = ADXL345_Sim_GetTimeUs();
+    if (!Pin && (int32_t)(NowUs - RaiseUs) >= 0 &&
+        Raised == Result.Windows + Capture.Stats.MissedTriggers +
+                  Capture.Ready)
+    {
+      ADXL345_Sim_RaiseEvents(Device, 0x10);
+      Raised++;
+    }
+
+    ADXL345_Sim_AdvanceUs(1);
+    NowUs = ADXL345_Sim_GetTimeUs();
+  }
+
+  ADXL345_Capture_Process(&Capture);
+  ADXL345_Capture_Stop(&Capture);
+
+  // Triggers that come before PreSamples since arming give short windows.
+  // With history so does a trigger in the service latency, as FIFO drops
+  // the entries over FifoSamples.
+  Short = Result.Windows;
+  if (Case->ArmedSamples >= Case->PreSamples)
+    Short = (Case->PreSamples > Case->FifoSamples) ? Result.Windows / 4 : 0;
+
+  if (Result.Misaligned || Result.ShortPost || Result.Windows == 0 ||
+      Capture.Stats.BusErrors || Capture.Stats.Overruns ||
+      Result.ShortPre > Short ||
+      (Case->ProcessEveryUs && Capture.Stats.MissedTriggers == 0))
+    Failed = 1;
+
+  printf("%s %6.1f Hz fifo %2u pre %3u post %3u latency %4lu us %s: "
+         "%lu windows, %lu short pre, %lu short post, %lu misaligned, "
+         "%lu missed\n",
+         Failed ? "FAIL" : "ok  ",
+         ADXL345_ConvToData_RateMilliHz(Case->Rate) / 1000.0,
+         Case->FifoSamples, Case->PreSamples, Case->PostSamples,
+         (unsigned long)Case->LatencyUs, Case->UseIRQAt ? "IRQAt" : "IRQ  ",
+         (unsigned long)Result.Windows, (unsigned long)Result.ShortPre,
+         (unsigned long)Result.ShortPost, (unsigned long)Result.Misaligned,
+         (unsigned long)Capture.Stats.MissedTriggers);
+
+  ADXL345_DeInit(&Handler);
+
+  return Failed;
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+int
+main(void)
+{
+  int Failed = 0;
+  uint8_t i = 0;
+
+  for (i = 0; i < sizeof(Check_Cases) / sizeof(Check_Cases[0]); i++)
+  {
+    if (Check_Run(&Check_Cases[i]) != 0)
+      Failed = 1;
+  }
+
+  return Failed;
+}
@@ -0,0 +1,229 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_check_gaps.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Gap marker check of the streaming engine on the simulator
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include "ADXL345.h"
+#include "ADXL345_stream.h"
+#include "ADXL345_platform.h"
+
+
+/* Private Data Types -----------------------------------------------------------*/
+typedef struct Check_Case_s
+{
+  ADXL345_Rate_t Rate;
+  // Watermark 0 runs bypass mode
+  uint8_t Watermark;
+  // Host latency is drawn from 0..LatencyUs for each interrupt
+  uint32_t LatencyUs;
+  // Host stall every StallEveryUs (0 => none) long enough to overrun
+  uint32_t StallEveryUs;
+} Check_Case_t;
+
+typedef struct Check_Sink_s
+{
+  uint32_t NextSequence;
+  uint32_t Samples;
+  uint32_t Gaps;
+  uint32_t Lost;
+  uint32_t Errors;
+} Check_Sink_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static uint32_t Check_Random = 2463534242u;
+
+static const Check_Case_t Check_Cases[] =
+{
+  {ADXL345_RATE_100,   0,   20,      0},
+  {ADXL345_RATE_400,   0,   500,     0},
+  {ADXL345_RATE_100,   1,   20,      0},
+  {ADXL345_RATE_800,   16,  20,      0},
+  {ADXL345_RATE_800,   16,  500,     0},
+  {ADXL345_RATE_800,   24,  2000,    0},
+  {ADXL345_RATE_1600,  8,   50,      0},
+  {ADXL345_RATE_1600,  24,  20,      0},
+  {ADXL345_RATE_3200,  24,  20,      0},
+  {ADXL345_RATE_3200,  16,  1500,    0},
+  {ADXL345_RATE_800,   16,  20, 200000},
+  {ADXL345_RATE_1600,  16,  20, 300000},
+  {ADXL345_RATE_3200,  0,   20,      0},
+};
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static uint32_t
+Check_Jitter(uint32_t MaxUs)
+{
+  Check_Random ^= Check_Random << 13;
+  Check_Random ^= Check_Random >> 17;
+  Check_Random ^= Check_Random << 5;
+
+  return MaxUs ? Check_Random % (MaxUs + 1) : 0;
+}
+
+
+static void
+Check_Sink(void *SinkContext, ADXL345_Batch_t *Batch)
+{
+  Check_Sink_t *Sink = (Check_Sink_t *)SinkContext;
+
+  // Sequence numbers count the lost samples too, so they never overlap
+  if (Batch->Sequence != Sink->NextSequence + Batch->Gap)
+    Sink->Errors++;
+
+  if (Batch->Gap)
+  {
+    Sink->Gaps++;
+    Sink->Lost += Batch->Gap;
+  }
+
+  Sink->NextSequence = Batch->Sequence + Batch->Count;
+  Sink->Samples += Batch->Count;
+}
+
+
+static int
+Check_Run(const Check_Case_t *Case)
+{
+  static ADXL345_Handler_t Handler;
+  static ADXL345_Stream_t Stream;
+  ADXL345_StreamConfig_t Config;
+  ADXL345_SimStats_t SimStats;
+  Check_Sink_t Sink;
+  uint32_t EndUs = 0;
+  uint32_t StallUs = 0;
+  int16_t Device = 0;
+  int Failed = 0;
+
+  ADXL345_Sim_Reset();
+  Device = ADXL345_Sim_AddDevice(0x53, 0, 0, 50000);
+  ADXL345_Platform_Init(&Handler);
+  if (ADXL345_Init(&Handler) != ADXL345_OK)
+    return -1;
+  ADXL345_SetAddressI2C(&Handler, 0);
+
+  memset(&Config, 0, sizeof(ADXL345_StreamConfig_t));
+  Config.Rate = Case->Rate;
+  Config.Range = ADXL345_RANGE_16G;
+  Config.Mode = Case->Watermark ? ADXL345_MODE_STREAM : ADXL345_MODE_BYPASS;
+  Config.WatermarkSamples = Case->Watermark;
+  Config.Pin = ADXL345_INTERRUPT_PIN1;
+  if (ADXL345_Stream_Init(&Stream, &Handler, &Config) != ADXL345_OK)
+    return -1;
+
+  memset(&Sink, 0, sizeof(Check_Sink_t));
+  Stream.Sink = Check_Sink;
+  Stream.SinkContext = &Sink;
+  Stream.GetTimeUs = ADXL345_Sim_GetTimeUs;
+  if (ADXL345_Stream_Start(&Stream) != ADXL345_OK)
+    return -1;
+
+  EndUs = ADXL345_Sim_GetTimeUs() + 2000000;
+  StallUs = ADXL345_Sim_GetTimeUs() + Case->StallEveryUs;
+  while ((int32_t)(ADXL345_Sim_GetTimeUs() - EndUs) < 0)
+  {
+    if (Case->StallEveryUs &&
+        (int32_t)(ADXL345_Sim_GetTimeUs() - StallUs) >= 0)
+    {
+      // Twice the FIFO time, so the device overruns
+      ADXL345_Sim_AdvanceUs(2 * ADXL345_FIFO_SIZE *
+                            ADXL345_ConvToData_RatePeriodUs(Case->Rate));
+      StallUs += Case->StallEveryUs;
+    }
+
+    if (!ADXL345_Sim_IntPin(Device, 1))
+    {
+      ADXL345_Sim_AdvanceUs(1);
+      continue;
+    }
+
+    ADXL345_Sim_AdvanceUs(Check_Jitter(Case->LatencyUs));
+    if (ADXL345_Stream_IRQ(&Stream) != ADXL345_OK)
+      return -1;
+    ADXL345_Stream_Process(&Stream);
+  }
+
+  ADXL345_Stream_Stop(&Stream);
+  ADXL345_Stream_Process(&Stream);
+  ADXL345_Sim_GetStats(Device, &SimStats);
+
+  if (Sink.Errors)
+    Failed = 1;
+  // A clean stream has no gaps; a lossy one marks at least one per overrun
+  if (SimStats.Lost == 0 && (Sink.Gaps || Sink.Lost))
+    Failed = 1;
+  if (SimStats.Lost && (Sink.Gaps == 0 || Sink.Gaps < Stream.Stats.Overruns))
+    Failed = 1;
+
+  printf("%s %6.1f Hz wm %2u latency %4lu us stall %s: %lu samples, "
+         "%lu overruns, %lu lost; %lu gaps marked, %lu samples estimated\n",
+         Failed ? "FAIL" : "ok  ",
+         ADXL345_ConvToData_RateMilliHz(Case->Rate) / 1000.0,
+         Case->Watermark, (unsigned long)Case->LatencyUs,
+         Case->StallEveryUs ? "yes" : "no ",
+         (unsigned long)Sink.Samples, (unsigned long)Stream.Stats.Overruns,
+         (unsigned long)SimStats.Lost, (unsigned long)Sink.Gaps,
+         (unsigned long)Sink.Lost);
+
+  ADXL345_DeInit(&Handler);
+
+  return Failed;
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+int
+main(void)
+{
+  int Failed = 0;
+  uint8_t i = 0;
+
+  for (i = 0; i < sizeof(Check_Cases) / sizeof(Check_Cases[0]); i++)
+  {
+    if (Check_Run(&Check_Cases[i]) != 0)
+      Failed = 1;
+  }
+
+  return Failed;
+}
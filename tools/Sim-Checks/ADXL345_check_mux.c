@@ -0,0 +1,312 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_check_mux.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Two sensors behind one mux channel pair on the simulator
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "ADXL345.h"
+#include "ADXL345_stream.h"
+#include "ADXL345_manager.h"
+#include "ADXL345_platform.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define CHECK_MUX           0x70
+#define CHECK_SENSORS       2
+#define CHECK_PI            3.14159265358979323846
+// Phase step tolerance; a sample of the other sensor is far off
+#define CHECK_TOLERANCE     0.06
+
+
+/* Private Data Types -----------------------------------------------------------*/
+typedef struct Check_Case_s
+{
+  ADXL345_Rate_t Rate;
+  uint8_t Watermark;
+  // A configuration job on the other sensor every JobEveryUs (0 => none)
+  uint32_t JobEveryUs;
+} Check_Case_t;
+
+typedef struct Check_Sensor_s
+{
+  ADXL345_Handler_t Handler;
+  ADXL345_Stream_t Stream;
+  int16_t Device;
+  uint8_t Id;
+  uint32_t SignalMilliHz;
+  double Step;            // expected phase step per sample
+  double Phase;
+  uint8_t HasPhase;
+  uint32_t NextSequence;
+  uint32_t Samples;
+  uint32_t Gaps;
+  uint32_t Crossed;
+  uint32_t Jobs;
+} Check_Sensor_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static const Check_Case_t Check_Cases[] =
+{
+  {ADXL345_RATE_800,   16,      0},
+  {ADXL345_RATE_800,   16,   5000},
+  {ADXL345_RATE_1600,  8,    2000},
+  {ADXL345_RATE_1600,  20,   3000},
+  {ADXL345_RATE_1600,  16,   1000},
+  {ADXL345_RATE_400,   1,     700},
+};
+
+static ADXL345_Mux_t Check_Mux;
+static ADXL345_Manager_t Check_Manager;
+static Check_Sensor_t Check_Sensor[CHECK_SENSORS];
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static void
+Check_Sink(void *SinkContext, ADXL345_Batch_t *Batch)
+{
+  Check_Sensor_t *Sensor = (Check_Sensor_t *)SinkContext;
+  double Phase = 0;
+  double Step = 0;
+  uint8_t i = 0;
+
+  if (Batch->Gap || Batch->Sequence != Sensor->NextSequence)
+    Sensor->Gaps++;
+  Sensor->NextSequence = Batch->Sequence + Batch->Count;
+
+  // The simulator outputs A*sin on X and A*cos on Y. So every sample of
+  // this sensor moves the phase by 2*pi*f/ODR.
+  for (i = 0; i < Batch->Count; i++)
+  {
+    Phase = atan2(Batch->Samples[i].RawX, Batch->Samples[i].RawY);
+    if (Sensor->HasPhase)
+    {
+      Step = Phase - Sensor->Phase;
+      while (Step < -CHECK_PI)
+        Step += 2 * CHECK_PI;
+      while (Step >= CHECK_PI)
+        Step -= 2 * CHECK_PI;
+      if (fabs(Step - Sensor->Step) > CHECK_TOLERANCE)
+        Sensor->Crossed++;
+    }
+    Sensor->Phase = Phase;
+    Sensor->HasPhase = 1;
+  }
+
+  Sensor->Samples += Batch->Count;
+}
+
+
+static ADXL345_Result_t
+Check_Job(ADXL345_Handler_t *Handler, void *Context)
+{
+  ADXL345_FifoStatus_t FifoStatus;
+
+  ((Check_Sensor_t *)Context)->Jobs++;
+
+  return ADXL345_Get_FifoStatus(Handler, &FifoStatus);
+}
+
+
+static int
+Check_Setup(const Check_Case_t *Case)
+{
+  ADXL345_StreamConfig_t Config;
+  Check_Sensor_t *Sensor = NULL;
+  uint8_t i = 0;
+
+  ADXL345_Sim_Reset();
+  memset(Check_Sensor, 0, sizeof(Check_Sensor));
+  ADXL345_Mux_Init(&Check_Mux, CHECK_MUX);
+  if (ADXL345_Manager_Init(&Check_Manager, 1,
+                           ADXL345_Sim_GetTimeUs) != ADXL345_OK)
+    return -1;
+
+  memset(&Config, 0, sizeof(ADXL345_StreamConfig_t));
+  Config.Rate = Case->Rate;
+  Config.Range = ADXL345_RANGE_16G;
+  Config.FullResolution = 1;
+  Config.Mode = ADXL345_MODE_STREAM;
+  Config.WatermarkSamples = Case->Watermark;
+  Config.Pin = ADXL345_INTERRUPT_PIN1;
+
+  // Same address on both channels, so a missed switch reads the other one
+  for (i = 0; i < CHECK_SENSORS; i++)
+  {
+    Sensor = &Check_Sensor[i];
+    Sensor->SignalMilliHz = i ? 37000 : 10000;
+    Sensor->Step = 2 * CHECK_PI * Sensor->SignalMilliHz /
+                   ADXL345_ConvToData_RateMilliHz(Case->Rate);
+    Sensor->Device = ADXL345_Sim_AddDevice(0x53, CHECK_MUX, i,
+                                           Sensor->SignalMilliHz);
+
+    ADXL345_Platform_Init(&Sensor->Handler);
+    if (ADXL345_Init(&Sensor->Handler) != ADXL345_OK)
+      return -1;
+    ADXL345_SetAddressI2C(&Sensor->Handler, 0);
+    ADXL345_SetMux(&Sensor->Handler, &Check_Mux, i);
+
+    if (ADXL345_Stream_Init(&Sensor->Stream, &Sensor->Handler,
+                            &Config) != ADXL345_OK)
+      return -1;
+    Sensor->Stream.Sink = Check_Sink;
+    Sensor->Stream.SinkContext = Sensor;
+    Sensor->Stream.GetTimeUs = ADXL345_Sim_GetTimeUs;
+
+    if (ADXL345_Manager_AddSensor(&Check_Manager, &Sensor->Stream, 0, 0,
+                                  &Sensor->Id) != ADXL345_OK)
+      return -1;
+  }
+
+  for (i = 0; i < CHECK_SENSORS; i++)
+    if (ADXL345_Stream_Start(&Check_Sensor[i].Stream) != ADXL345_OK)
+      return -1;
+
+  return 0;
+}
+
+
+static int
+Check_Run(const Check_Case_t *Case)
+{
+  ADXL345_SimStats_t SimStats;
+  Check_Sensor_t *Sensor = NULL;
+  uint32_t EndUs = 0;
+  uint32_t JobUs = 0;
+  uint8_t Target = 0;
+  uint8_t Notified = 0;
+  uint8_t i = 0;
+  int Failed = 0;
+
+  if (Check_Setup(Case) != 0)
+    return -1;
+
+  EndUs = ADXL345_Sim_GetTimeUs() + 2000000;
+  JobUs = ADXL345_Sim_GetTimeUs() + Case->JobEveryUs;
+
+  while ((int32_t)(ADXL345_Sim_GetTimeUs() - EndUs) < 0)
+  {
+    // Configuration traffic alternates between the channels
+    if (Case->JobEveryUs && (int32_t)(ADXL345_Sim_GetTimeUs() - JobUs) >= 0)
+    {
+      ADXL345_Manager_Submit(&Check_Manager, Check_Sensor[Target].Id, 0, 0,
+                             Case->JobEveryUs / 2, Check_Job,
+                             &Check_Sensor[Target]);
+      Target ^= 1;
+      JobUs += Case->JobEveryUs;
+    }
+
+    Notified = 0;
+    for (i = 0; i < CHECK_SENSORS; i++)
+    {
+      if (ADXL345_Sim_IntPin(Check_Sensor[i].Device, 1))
+      {
+        ADXL345_Manager_Notify(&Check_Manager, Check_Sensor[i].Id);
+        Notified = 1;
+      }
+    }
+
+    if (!Notified && !ADXL345_Manager_Poll(&Check_Manager, 0))
+    {
+      ADXL345_Sim_AdvanceUs(1);
+      continue;
+    }
+
+    while (ADXL345_Manager_Poll(&Check_Manager, 0))
+    {
+      for (i = 0; i < CHECK_SENSORS; i++)
+        ADXL345_Stream_Process(&Check_Sensor[i].Stream);
+    }
+  }
+
+  printf("%6.1f Hz wm %2u job every %5lu us, %lu mux switches:\n",
+         ADXL345_ConvToData_RateMilliHz(Case->Rate) / 1000.0,
+         Case->Watermark, (unsigned long)Case->JobEveryUs,
+         (unsigned long)Check_Mux.Stats.Switches);
+
+  for (i = 0; i < CHECK_SENSORS; i++)
+  {
+    Sensor = &Check_Sensor[i];
+    ADXL345_Stream_Process(&Sensor->Stream);
+    ADXL345_Sim_GetStats(Sensor->Device, &SimStats);
+
+    // Every sample read from this device reached this stream and nothing
+    // else did
+    if (Sensor->Crossed || Sensor->Gaps || SimStats.Lost ||
+        SimStats.Read != Sensor->Samples || Sensor->Samples == 0 ||
+        (Case->JobEveryUs && Sensor->Jobs == 0))
+      Failed = 1;
+
+    printf("  %s ch %u: %lu samples, %lu read from device, %lu lost, "
+           "%lu gaps, %lu crossed, %lu jobs\n",
+           Failed ? "FAIL" : "ok  ", i, (unsigned long)Sensor->Samples,
+           (unsigned long)SimStats.Read, (unsigned long)SimStats.Lost,
+           (unsigned long)Sensor->Gaps, (unsigned long)Sensor->Crossed,
+           (unsigned long)Sensor->Jobs);
+  }
+
+  if (Check_Mux.Stats.Switches == 0)
+    Failed = 1;
+
+  for (i = 0; i < CHECK_SENSORS; i++)
+    ADXL345_DeInit(&Check_Sensor[i].Handler);
+
+  return Failed;
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+int
+main(void)
+{
+  int Failed = 0;
+  uint8_t i = 0;
+
+  for (i = 0; i < sizeof(Check_Cases) / sizeof(Check_Cases[0]); i++)
+  {
+    if (Check_Run(&Check_Cases[i]) != 0)
+      Failed = 1;
+  }
+
+  return Failed;
+}
@@ -0,0 +1,244 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_check_pollsched.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Polling scheduler checks against the simulator
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include "ADXL345.h"
+#include "ADXL345_stream.h"
+#include "ADXL345_platform.h"
+
+
+/* Private Data Types -----------------------------------------------------------*/
+typedef struct Check_Case_s
+{
+  ADXL345_Rate_t Rate;
+  // Watermark 0 runs bypass mode
+  uint8_t Watermark;
+  // Each poll starts 0..LatencyUs after its deadline
+  uint32_t LatencyUs;
+  // Error of the host clock against the ODR of the device in ppm
+  int32_t HostPpm;
+} Check_Case_t;
+
+typedef struct Check_Sink_s
+{
+  uint32_t NextSequence;
+  uint32_t Samples;
+  uint32_t Errors;
+} Check_Sink_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static uint32_t Check_Random = 2463534242u;
+static int32_t Check_HostPpm = 0;
+
+static const Check_Case_t Check_Cases[] =
+{
+  {ADXL345_RATE_100,   0,   0,       0},
+  {ADXL345_RATE_100,   0,   2000,    0},
+  {ADXL345_RATE_100,   0,   2000,    20000},
+  {ADXL345_RATE_100,   0,   2000,    -20000},
+  {ADXL345_RATE_400,   0,   500,     10000},
+  {ADXL345_RATE_800,   0,   200,     -10000},
+  {ADXL345_RATE_1600,  0,   100,     5000},
+  {ADXL345_RATE_100,   8,   2000,    -20000},
+  {ADXL345_RATE_800,   16,  200,     -10000},
+  {ADXL345_RATE_1600,  16,  100,     5000},
+};
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+static uint32_t
+Check_Jitter(uint32_t MaxUs)
+{
+  Check_Random ^= Check_Random << 13;
+  Check_Random ^= Check_Random >> 17;
+  Check_Random ^= Check_Random << 5;
+
+  return MaxUs ? Check_Random % (MaxUs + 1) : 0;
+}
+
+
+/**
+ * Host clock that runs Check_HostPpm faster than the simulated device
+ */
+static uint32_t
+Check_HostUs(void)
+{
+  return (uint32_t)((int64_t)ADXL345_Sim_GetTimeUs() *
+                    (1000000 + Check_HostPpm) / 1000000);
+}
+
+
+static void
+Check_Sink(void *SinkContext, ADXL345_Batch_t *Batch)
+{
+  Check_Sink_t *Sink = (Check_Sink_t *)SinkContext;
+
+  if (Batch->Sequence != Sink->NextSequence + Batch->Gap)
+    Sink->Errors++;
+
+  Sink->NextSequence = Batch->Sequence + Batch->Count;
+  Sink->Samples += Batch->Count;
+}
+
+
+static int
+Check_Run(const Check_Case_t *Case)
+{
+  static ADXL345_Handler_t Handler;
+  static ADXL345_Stream_t Stream;
+  ADXL345_StreamConfig_t Config;
+  ADXL345_SimStats_t SimStats;
+  ADXL345_PollSched_t Sched;
+  Check_Sink_t Sink;
+  uint32_t EndUs = 0;
+  uint32_t WakeUs = 0;
+  uint32_t MaxPolls = 0;
+  uint32_t Saved = 0;
+  int16_t Device = 0;
+  int Failed = 0;
+
+  ADXL345_Sim_Reset();
+  Device = ADXL345_Sim_AddDevice(0x53, 0, 0, 50000);
+  ADXL345_Platform_Init(&Handler);
+  if (ADXL345_Init(&Handler) != ADXL345_OK)
+    return -1;
+  ADXL345_SetAddressI2C(&Handler, 0);
+
+  memset(&Config, 0, sizeof(ADXL345_StreamConfig_t));
+  Config.Rate = Case->Rate;
+  Config.Range = ADXL345_RANGE_16G;
+  Config.Mode = Case->Watermark ? ADXL345_MODE_STREAM : ADXL345_MODE_BYPASS;
+  Config.WatermarkSamples = Case->Watermark;
+  Config.Pin = ADXL345_INTERRUPT_PIN1;
+  if (ADXL345_Stream_Init(&Stream, &Handler, &Config) != ADXL345_OK)
+    return -1;
+
+  Check_HostPpm = Case->HostPpm;
+  Check_Random = 2463534242u;
+  memset(&Sink, 0, sizeof(Check_Sink_t));
+  Stream.Sink = Check_Sink;
+  Stream.SinkContext = &Sink;
+  Stream.GetTimeUs = Check_HostUs;
+  if (ADXL345_Stream_Start(&Stream) != ADXL345_OK)
+    return -1;
+
+  ADXL345_PollSched_Init(&Sched, Case->Rate,
+                         Case->Watermark ? Case->Watermark : 1, Check_HostUs());
+
+  // No INT line: the host sleeps until each deadline and polls
+  EndUs = ADXL345_Sim_GetTimeUs() + 5000000;
+  while ((int32_t)(ADXL345_Sim_GetTimeUs() - EndUs) < 0)
+  {
+    WakeUs = Sched.DeadlineUs + Check_Jitter(Case->LatencyUs);
+    while ((int32_t)(Check_HostUs() - WakeUs) < 0)
+      ADXL345_Sim_AdvanceUs(1);
+
+    if (ADXL345_PollSched_Service(&Sched, &Stream) != ADXL345_OK)
+      return -1;
+  }
+
+  ADXL345_Stream_Stop(&Stream);
+  ADXL345_Stream_Process(&Stream);
+  ADXL345_Sim_GetStats(Device, &SimStats);
+
+  if (Sink.Errors)
+    Failed = 1;
+
+  if (Case->Watermark)
+  {
+    // With FIFO the polls must come at the watermark, not every sample
+    MaxPolls = Sched.Stats.NaivePolls / 2;
+    if (SimStats.Lost)
+      Failed = 1;
+  }
+  else
+  {
+    // Without FIFO one poll per sample of the device, and a few more while
+    // the period is found
+    MaxPolls = SimStats.Generated + 4;
+    if (SimStats.Lost > 4)
+      Failed = 1;
+  }
+  if (Sched.Stats.Polls > MaxPolls)
+    Failed = 1;
+
+  // Naive polls are counted on the host clock, so in bypass the difference
+  // only shows the clock error. A slow host clock would make it negative,
+  // while nothing is polled more than the device needs.
+  Saved = 0;
+  if (Sched.Stats.NaivePolls > Sched.Stats.Polls)
+    Saved = Sched.Stats.NaivePolls - Sched.Stats.Polls;
+
+  printf("%s %6.1f Hz wm %2u latency %4lu us host %+6ld ppm: %lu samples, "
+         "%lu lost, %lu polls (%lu saved), %lu early\n",
+         Failed ? "FAIL" : "ok  ",
+         ADXL345_ConvToData_RateMilliHz(Case->Rate) / 1000.0,
+         Case->Watermark, (unsigned long)Case->LatencyUs, (long)Case->HostPpm,
+         (unsigned long)Sink.Samples, (unsigned long)SimStats.Lost,
+         (unsigned long)Sched.Stats.Polls,
+         (unsigned long)Saved,
+         (unsigned long)Sched.Stats.EarlyPolls);
+
+  ADXL345_DeInit(&Handler);
+
+  return Failed;
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+int
+main(void)
+{
+  int Failed = 0;
+  uint8_t i = 0;
+
+  for (i = 0; i < sizeof(Check_Cases) / sizeof(Check_Cases[0]); i++)
+  {
+    if (Check_Run(&Check_Cases[i]) != 0)
+      Failed = 1;
+  }
+
+  return Failed;
+}
@@ -0,0 +1,300 @@
+/**
+ **********************************************************************************
+ * @file   ADXL345_check_stats.c
+ * @author Hossein.M (https://github.com/Hossein-M98)
+ * @brief  Fixed-point window statistics against the float path
+ **********************************************************************************
+ *
+ * Copyright (c) 2023 Mahda Embedded System (MIT License)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ **********************************************************************************
+ */
+
+/* Includes ---------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "ADXL345.h"
+#include "ADXL345_stats.h"
+
+
+/* Private Constants ------------------------------------------------------------*/
+#define CHECK_PI            3.14159265358979323846
+// Full resolution scale of the driver in g/LSB
+#define CHECK_G_PER_LSB     0.0039f
+// Cycles of the sine per sample, not a divisor of any window
+#define CHECK_CYCLES        0.01234
+#define CHECK_WINDOWS       4
+
+
+/* Private Data Types -----------------------------------------------------------*/
+typedef struct Check_Case_s
+{
+  uint16_t WindowSamples;
+  double OffsetLsb;       // DC offset of X; Y is -X and Z is X + 256 (1g)
+  double AmplitudeLsb;
+} Check_Case_t;
+
+typedef struct Check_Ref_s
+{
+  double Mean;
+  double Rms;
+  double PeakToPeak;
+  double CrestFactor;
+  double Kurtosis;
+} Check_Ref_t;
+
+// Worst error against the reference in LSB (Mean, Rms, PeakToPeak) or as is.
+// Crest factor of the Q path is a fraction of its rounding bound.
+typedef struct Check_Error_s
+{
+  double Mean;
+  double Rms;
+  double PeakToPeak;
+  double CrestFactor;
+  double Kurtosis;
+} Check_Error_t;
+
+
+/* Private Variables ------------------------------------------------------------*/
+static const Check_Case_t Check_Cases[] =
+{
+  {256,      0.0,   100.0},
+  {1024,   256.0,    50.0},
+  {1000,   300.0,     0.6},
+  {512,  -4000.0,     3.0},
+  {1024,  2000.0,  2000.0},
+  {2,        7.0,     1.0},
+};
+
+// Q path bounds: one unit of the output format. Float path bounds: a few
+// float ulps of the DC offset, and relative error for the ratios.
+static const Check_Error_t Check_LimitQ = {1.0 / 16, 1.0 / 16, 0, 1, 0.01};
+static const Check_Error_t Check_LimitF = {0.01, 0.01, 0.01, 0.005, 0.005};
+
+static ADXL345_Sample_t Check_Samples[ADXL345_STATSQ_MAX_WINDOW];
+static int16_t Check_Values[ADXL345_STATSQ_MAX_WINDOW];
+
+
+
+/**
+ ==================================================================================
+                           ##### Private Functions #####                           
+ ==================================================================================
+ */
+
+/**
+ * Two-pass statistics in double precision
+ */
+static void
+Check_Reference(const int16_t *Values, uint16_t Count, Check_Ref_t *Ref)
+{
+  double Sum = 0;
+  double M2 = 0;
+  double M4 = 0;
+  double d = 0;
+  double Peak = 0;
+  int16_t Min = Values[0];
+  int16_t Max = Values[0];
+  uint16_t i = 0;
+
+  for (i = 0; i < Count; i++)
+  {
+    Sum += Values[i];
+    if (Values[i] < Min)
+      Min = Values[i];
+    if (Values[i] > Max)
+      Max = Values[i];
+  }
+  Ref->Mean = Sum / Count;
+
+  for (i = 0; i < Count; i++)
+  {
+    d = Values[i] - Ref->Mean;
+    M2 += d * d;
+    M4 += d * d * d * d;
+  }
+
+  Ref->Rms = sqrt(M2 / Count);
+  Ref->PeakToPeak = Max - Min;
+  Peak = fmax(Max - Ref->Mean, Ref->Mean - Min);
+  Ref->CrestFactor = (Ref->Rms > 0) ? Peak / Ref->Rms : 0;
+  Ref->Kurtosis = (M2 > 0) ? Count * M4 / (M2 * M2) : 0;
+}
+
+
+static void
+Check_Worst(double *Worst, double Error)
+{
+  if (fabs(Error) > *Worst)
+    *Worst = fabs(Error);
+}
+
+
+static void
+Check_Compare(const Check_Ref_t *Ref, const ADXL345_AxisStatsQ_t *Q,
+              const ADXL345_AxisStatsF_t *F,
+              Check_Error_t *ErrorQ, Check_Error_t *ErrorF)
+{
+  double Ratio = 0;
+  double Bound = 0;
+
+  Check_Worst(&ErrorQ->Mean, Q->Mean / 16.0 - Ref->Mean);
+  Check_Worst(&ErrorQ->Rms, Q->Rms / 16.0 - Ref->Rms);
+  Check_Worst(&ErrorQ->PeakToPeak, Q->PeakToPeak - Ref->PeakToPeak);
+  // Peak and Rms are Q4, so small signals lose crest factor resolution
+  if (Ref->Rms > 0)
+  {
+    Bound = (Ref->CrestFactor + 1) / (16 * Ref->Rms) + 1.0 / 256;
+    Check_Worst(&ErrorQ->CrestFactor,
+                (Q->CrestFactor / 256.0 - Ref->CrestFactor) / Bound);
+  }
+  Check_Worst(&ErrorQ->Kurtosis, Q->Kurtosis / 256.0 - Ref->Kurtosis);
+
+  Check_Worst(&ErrorF->Mean, F->Mean / CHECK_G_PER_LSB - Ref->Mean);
+  Check_Worst(&ErrorF->Rms, F->Rms / CHECK_G_PER_LSB - Ref->Rms);
+  Check_Worst(&ErrorF->PeakToPeak,
+              F->PeakToPeak / CHECK_G_PER_LSB - Ref->PeakToPeak);
+  if (Ref->CrestFactor > 0)
+  {
+    Ratio = F->CrestFactor / Ref->CrestFactor - 1;
+    Check_Worst(&ErrorF->CrestFactor, Ratio);
+  }
+  if (Ref->Kurtosis > 0)
+  {
+    Ratio = F->Kurtosis / Ref->Kurtosis - 1;
+    Check_Worst(&ErrorF->Kurtosis, Ratio);
+  }
+}
+
+
+static uint8_t
+Check_Exceeds(const Check_Error_t *Error, const Check_Error_t *Limit)
+{
+  return (Error->Mean > Limit->Mean) || (Error->Rms > Limit->Rms) ||
+         (Error->PeakToPeak > Limit->PeakToPeak) ||
+         (Error->CrestFactor > Limit->CrestFactor) ||
+         (Error->Kurtosis > Limit->Kurtosis);
+}
+
+
+static int
+Check_Run(const Check_Case_t *Case)
+{
+  ADXL345_StatsQ_t StatsQ;
+  ADXL345_StatsF_t StatsF;
+  Check_Error_t ErrorQ;
+  Check_Error_t ErrorF;
+  Check_Ref_t Ref;
+  ADXL345_Sample_t *Sample = NULL;
+  uint32_t Index = 0;
+  uint16_t Windows = 0;
+  uint16_t i = 0;
+  uint8_t Axis = 0;
+  uint8_t DoneQ = 0;
+  uint8_t DoneF = 0;
+  int Failed = 0;
+
+  if (ADXL345_StatsQ_Init(&StatsQ, Case->WindowSamples) != ADXL345_OK ||
+      ADXL345_StatsF_Init(&StatsF, Case->WindowSamples) != ADXL345_OK)
+    return -1;
+
+  memset(&ErrorQ, 0, sizeof(Check_Error_t));
+  memset(&ErrorF, 0, sizeof(Check_Error_t));
+
+  for (Windows = 0; Windows < CHECK_WINDOWS; Windows++)
+  {
+    for (i = 0; i < Case->WindowSamples; i++, Index++)
+    {
+      Sample = &Check_Samples[i];
+      Sample->RawX = (int16_t)lround(Case->OffsetLsb + Case->AmplitudeLsb *
+                                     sin(2 * CHECK_PI * CHECK_CYCLES * Index));
+      Sample->RawY = (int16_t)-Sample->RawX;
+      Sample->RawZ = (int16_t)(Sample->RawX + 256);
+      Sample->AccelX = Sample->RawX * CHECK_G_PER_LSB;
+      Sample->AccelY = Sample->RawY * CHECK_G_PER_LSB;
+      Sample->AccelZ = Sample->RawZ * CHECK_G_PER_LSB;
+
+      DoneQ = ADXL345_StatsQ_Push(&StatsQ, Sample);
+      DoneF = ADXL345_StatsF_Push(&StatsF, Sample);
+    }
+
+    if (!DoneQ || !DoneF)
+      return -1;
+
+    for (Axis = 0; Axis < 3; Axis++)
+    {
+      for (i = 0; i < Case->WindowSamples; i++)
+        Check_Values[i] = (Axis == 0) ? Check_Samples[i].RawX :
+                          (Axis == 1) ? Check_Samples[i].RawY :
+                                        Check_Samples[i].RawZ;
+      Check_Reference(Check_Values, Case->WindowSamples, &Ref);
+
+      Check_Compare(&Ref,
+                    (Axis == 0) ? &StatsQ.Result.X :
+                    (Axis == 1) ? &StatsQ.Result.Y : &StatsQ.Result.Z,
+                    (Axis == 0) ? &StatsF.Result.X :
+                    (Axis == 1) ? &StatsF.Result.Y : &StatsF.Result.Z,
+                    &ErrorQ, &ErrorF);
+    }
+  }
+
+  Failed = Check_Exceeds(&ErrorQ, &Check_LimitQ) ||
+           Check_Exceeds(&ErrorF, &Check_LimitF);
+
+  printf("%s window %4u offset %7.1f amplitude %6.1f LSB (kurtosis %.3f)\n",
+         Failed ? "FAIL" : "ok  ", Case->WindowSamples, Case->OffsetLsb,
+         Case->AmplitudeLsb, Ref.Kurtosis);
+  printf("       Q: mean %.4f rms %.4f p-p %.4f LSB, crest %.2f of bound, "
+         "kurtosis %.4f\n",
+         ErrorQ.Mean, ErrorQ.Rms, ErrorQ.PeakToPeak, ErrorQ.CrestFactor,
+         ErrorQ.Kurtosis);
+  printf("   float: mean %.4f rms %.4f p-p %.4f LSB, crest %.2e kurtosis %.2e "
+         "(relative)\n",
+         ErrorF.Mean, ErrorF.Rms, ErrorF.PeakToPeak, ErrorF.CrestFactor,
+         ErrorF.Kurtosis);
+
+  return Failed;
+}
+
+
+
+/**
+ ==================================================================================
+                            ##### Public Functions #####                           
+ ==================================================================================
+ */
+
+int
+main(void)
+{
+  int Failed = 0;
+  uint8_t i = 0;
+
+  printf("Worst error against a double two-pass reference:\n");
+  for (i = 0; i < sizeof(Check_Cases) / sizeof(Check_Cases[0]); i++)
+  {
+    if (Check_Run(&Check_Cases[i]) != 0)
+      Failed = 1;
+  }
+
+  return Failed;
+}